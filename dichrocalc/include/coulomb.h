@@ -0,0 +1,25 @@
+// #################################################################################################
+//
+//  Header:       coulomb.h
+//
+//  Version:      $Revision$, $Date$
+//
+// #################################################################################################
+
+string CoulombKernel ( void );
+
+double CoulombInteraction ( const double* ix, const double* iy, const double* iz, const double* iq,
+                            int ni,
+                            const double* jx, const double* jy, const double* jz, const double* jq,
+                            int nj,
+                            double Threshold, int* Contacts, double* MinDistance );
+
+void   InverseDistances ( const double* ix, const double* iy, const double* iz, int ni,
+                          const double* jx, const double* jy, const double* jz, int nj,
+                          double Threshold, double* InvR, int* Contacts, double* MinDistance );
+
+void   CoulombBlock ( const double* InvR, int ni, int nj,
+                      const double* iq, int iTrans, const double* jq, int jTrans,
+                      double* Temp, double* Block );
+
+double DotProduct ( const double* a, const double* b, int n );
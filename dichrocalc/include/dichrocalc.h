@@ -18,6 +18,7 @@
 #include <regex.h>         // for the use of regular expressions
 #include <dirent.h>        // to read directory listings
 #include <errno.h>         // error handling
+#include <stdint.h>        // integers of fixed size for the binary files
 
 using namespace std;       // to abbreviate e.g. std::cout
 
@@ -27,6 +28,8 @@ using namespace std;       // to abbreviate e.g. std::cout
 #include <newmatio.h>      // matrix input output routines
 #include <newmatap.h>      // matrix input output routines
 
+#include "sparse.h"        // sparse Hamiltonian and partial eigensolver (needed in DC_Results)
+
 
 // ================================================================================
 // Class definition and declarations of object functions
@@ -69,9 +72,47 @@ class Dichro {
 		string DC_InFileBaseName;    // the base name of the input file
 		string DC_ParamsDefault;     // the default directory of parameter files
 		
+		class CalculationOptions {   // settings of the calculation, passed to the constructor
+			public:
+				string Eigensolver;     // method to diagonalize the Hamiltonian (eigensolver.cpp)
+				bool   CompareSolvers;  // compare the eigensystem with the Jacobi reference
+				int    Threads;         // threads for the matrix set-up, 0 = one per processor
+				double Cutoff;          // exact couplings within (Angstrom), multipoles beyond, 0 = off
+				double OuterCutoff;     // couplings beyond are neglected (Angstrom), 0 = off
+				bool   Window;          // sparse matrix, only states within MinWL--MaxWL
+				string Frames;          // trajectory mode: file or directory with the frames
+				bool   SvdFit;          // fit the parameter sets with the SVD instead of quaternions
+				string Assign;          // the dcinput switches for PDB input files (pdbinput.cpp)
+				bool   CTSelect;        // choose the CT parameter sets by phi and psi (ctselect.cpp)
+				int    Stride;          // trajectory mode: only every Stride-th frame is calculated
+				int    FirstFrame;      // trajectory mode: the first and the last frame (from 0),
+				int    LastFrame;       //    -1 = up to the last frame of the trajectory
+				string Bandshape;       // band shape of the spectra (bandshape.cpp), "" = line spectra only
+				double Bandwidth;       // the band width in nm
+				double BandStep;        // the interval of the wavelength grid in nm
+				double BandTolerance;   // contributions of a line below this are skipped, 0 = none
+				bool   Average;         // trajectory mode: only the average of the band spectra is written
+				double Disorder;        // ensemble: standard deviation of the site energies (cm-1), 0 = off
+				int    Realizations;    // ensemble: the number of disorder realizations
+				int    Seed;            // ensemble: the seed of the random site energies
+				string ShiftSet;        // ensemble: the parameter set whose energies are shifted, "" = off
+				int    ShiftTrans;      //    its transition (from 1), 0 = all transitions of the set
+				double ShiftFirst;      //    the first and the last shift and the interval (cm-1)
+				double ShiftLast;
+				double ShiftStep;
+				int    Repeats;         // the number of identical repeat units (symmetry.cpp), 0 = off
+				bool   Periodic;        //    open repeat units with periodic boundary conditions
+				double Components;      // connected components: the largest coupling (cm-1) between
+				                        //    them (components.cpp), < 0 = off
+				
+				CalculationOptions ( void );
+		} DC_Options;
+		
 		// general limits for the calculations
 		// the maximum number of transitions than can be on a group
 		static const int DC_MaxGroupTransitions = 20;
+		// monopoles closer than this (in Angstrom) are skipped in the interactions (matrix.cpp)
+		static const double DC_DistanceThreshold;
 		
 		// --------------------------------------------------------------------------
 		// classes for the data read from the input file (.inp)
@@ -100,9 +141,12 @@ class Dichro {
 		
 		class InputCoordinates {        // the $COORDINATES block
 			public:
-				vector< vector<double> > Groups;   // the xyz coordinates
+				vector<double>  XYZ;      // the x, y, z coordinates of all atoms, one after another
 				vector<string>  Labels;   // the PDB atom labels
 				vector<int>     Atoms;    // the array indices, identical to .Chromophores vector
+				
+				unsigned int  Number ( void ) { return Atoms.size(); }
+				double*       Coord ( unsigned int Atom ) { return &XYZ.at(3*Atom); }
 		};
 		
 		class Input { // combines all information read from the .inp file
@@ -113,6 +157,18 @@ class Dichro {
 				InputCoordinates   Coordinates;
 		} DC_Input;
 		
+		// the atom of a trajectory frame (PDB model or DCD) for each atom of DC_Input.Coordinates,
+		// set if the input is a PDB file (pdbinput.cpp), otherwise the frames have the same atoms
+		vector<int> DC_FrameAtoms;
+		
+		class ChargeTransferSets {      // the CT sets chosen by phi and psi (--ct-select)
+			public:
+				vector<int>    Sets;      // the indices of the CT sets in DC_Input.Parameters
+				vector<double> Phi, Psi;  // the angles of each CT set (chromophores.dat)
+				vector<int>    Groups;    // the CT chromophores (index in DC_Input.Chromophores)
+				vector<int>    CA;        // the C-alpha atom of each CT chromophore, -1 = none
+		} DC_ChargeTransfer;
+		
 		
 		// --------------------------------------------------------------------------
 		// variables for the parameter sets
@@ -131,6 +187,12 @@ class Dichro {
 				double Charge;             // the charge in 10^-19 esu
 		};
 		
+		class PackedMonopoles { // monopoles as separate arrays for the Coulomb kernels (coulomb.cpp)
+			public:
+				vector<double> X, Y, Z;    // the coordinates in Angstrom
+				vector<double> Charge;     // the charges in 10^-19 esu
+		};
+		
 		class ParSetTrans {     // a single transition in a ParSet class
 			public:
 				bool  Permanent;          // whether it is a permanent moment true/false
@@ -143,6 +205,16 @@ class Dichro {
 				vector<ParSetMonopole> Monopoles;  // coordinates and charges of the monopoles
 		};
 		
+		class ParSetFit {       // the parameter set side of the fitting, the same for all its groups
+			public:
+				bool   Ready;             // whether PrepareFit has been called
+				bool   Planar;            // whether a virtual atom has been added
+				Matrix Coordinates;       // atoms relative to the reference (+ virtual atom)
+				Matrix PseudoInverse;     // of Coordinates from its SVD, V * 1/W * U.t() (3 x atoms)
+				
+				ParSetFit ( void ) { Ready = false; Planar = false; }
+		};
+		
 		class ParSet {          // the class instantiated for each parameter set read from a .par
 			public:
 				string  Name;                // the name of the parameter set (also filename)
@@ -152,6 +224,7 @@ class Dichro {
 				vector<ParSetAtom> Atoms;    // atom coordinates and scale factors
 				vector<double> Reference;    // the reference coordinate for this chromophore
 				vector< vector<ParSetTrans> > States;
+				ParSetFit Fit;               // the fitting data of the atoms, see PrepareFit
 		};
 		
 		vector<ParSet> DC_ParSets;   // holds all information read from the .par files
@@ -173,6 +246,7 @@ class Dichro {
 			// trans   monopole
 				int NumberOfMonopoles;            // the number of monopoles of the transition
 				vector<ParSetMonopole> Monopoles; // coordinates and charges of the monopoles
+				PackedMonopoles Packed;           // the same monopoles packed by PackGroup
 		};
 		
 		class SystemGroup {
@@ -186,6 +260,21 @@ class Dichro {
 				vector<SystemTransition> Perm;   // all permanent moments of this group
 				vector< vector<double> > Atoms; // all atoms of this group
 				vector<int> AtomIndices;        // the indices in the DC_Input.Coordinates array
+				vector<int> Overlapping;        // all groups sharing atoms with it (incl. itself)
+			// site    coords
+				vector< vector<double> > Sites;  // distinct monopole positions of the transitions
+			// trans   mono
+				vector< vector<int> > SiteIndex; // the site of each monopole (used transitions only)
+			// site
+				vector<double> Potential;        // ground-state potential of all other groups
+			// site    coords
+				PackedMonopoles Coupling;        // distinct monopole positions of the matrix transitions
+			// trans   site
+				vector< vector<double> > CouplingCharges;  // charges of each matrix transition there
+			// trans   (moments of the matrix transitions about Reference, used beyond the cutoff)
+				vector<double> NetCharge;            // sum q
+				vector< vector<double> > Dipole;     // sum q r (3 elements)
+				vector< vector<double> > Quadrupole; // sum q r_a r_b (9 elements, row-wise)
 		};
 		
 		class System {       // all information necessary to describe the system
@@ -246,6 +335,23 @@ class Dichro {
 				vector< vector<double> > PolarizationVector; // polarization vectors
 		};
 		
+		class ResultsSpectra { // the spectra convoluted with band shapes (bandshape.cpp)
+			public:
+				vector<double> Wavelength;   // the wavelength grid in nm
+				vector<double> CD;           // the CD spectrum (.cd)
+				vector<double> Absorbance;   // the absorbance (.ab), only with --vec
+				vector<double> LD;           // the linear dichroism (.ld), only with --vec
+		};
+		
+		class ResultsMoments { // the moments of the eigenstates, set by MixEigenstates (dichroism.cpp)
+			public:
+				int States;                  // the number of eigenstates
+				int Types;                   // the maximum number of transitions on a group
+				vector<double> EDM;          // x, y, z columns with the EDM of each state
+				vector<double> MDM;          // x, y, z columns with the MDM of each state
+				vector<double> TypeEDM;      // x, y, z columns for each transition type in a.u.
+		};
+		
 		class Results {     // all data calculated from DC_System
 			public:
 				int NumberOfAtoms;        // number of atoms (not PDB but of all parameter sets)
@@ -253,17 +359,43 @@ class Dichro {
 				int NumberOfTransitions;  // the total number of transitions on all groups
 				int MatrixDimension;      // technically this is the same as the NumberOfTransitions
 				
-				SymmetricMatrix Hamiltonian;
+				SymmetricMatrix Hamiltonian;        // only kept with --mat or debug level 5
 				DiagonalMatrix  Eigenvalues;
-				Matrix          Eigenvectors;
+				Matrix          Eigenvectors;       // only kept with --mat or debug level 5
+				ResultsMoments  Moments;            // the moments of the eigenstates
+				SparseMatrix    SparseHamiltonian;  // instead of Hamiltonian in window mode
 				
 				vector<ResultsGroup> Groups;   // all information sorted for access by the group
 				ResultsTrans Trans;            // all information sorted for access by the trans.
 				
 				// results of a polarization calculation
 				vector< vector< vector<double> > > PolTensor; // the polarization tensor
+				
+				ResultsSpectra Spectra;   // the spectra convoluted with band shapes
 		} DC_Results;
 		
+		class SpectrumAverage {   // running mean and variance of the band spectra of all frames
+			public:
+				int Count;                       // the number of spectra added
+				vector<double> Wavelength;       // the wavelength grid in nm
+				vector< vector<double> > Mean;   // the mean of CD, absorbance and LD
+				vector< vector<double> > M2;     // the sums of the squared deviations from the mean
+				
+				SpectrumAverage ( void ) { Count = 0; }
+				void Add ( ResultsSpectra* Spectra );
+				void Merge ( SpectrumAverage* Other );
+		} DC_Average;
+		
+		class WarmStartState {    // the previous eigenvectors for the warm-started eigensolver (-e warm)
+			public:
+				Matrix Basis;      // the eigenvectors of the previous Hamiltonian (empty = cold start)
+				int    ColdSweeps; // the Jacobi sweeps of the last cold start
+				int    Sweeps;     // the Jacobi sweeps of the last diagonalization
+				bool   Warm;       // whether the last diagonalization started from Basis
+				
+				WarmStartState ( void ) { ColdSweeps = 0; Sweeps = 0; Warm = false; }
+		} DC_WarmStart;
+		
 		
 		// --------------------------------------------------------------------------
 		// declarations of the internal functions
@@ -298,32 +430,105 @@ class Dichro {
 		int  ReadInputSection ( ifstream *File, string CurrentBlock );
 		int  CheckInputData ( void );
 		int  ReadParameters ( void );
+		int  ReadParameterSetLines ( string Filename, ParSet* CurParSet );
 		int  ReadTransition ( vector<string> FileLines, vector< vector<string> > FileFields,
 		                      string ParSetName, unsigned int *FilePos, ParSetTrans *CurTrans,
 		                      int Trans, bool Permanent );
 		int  ColumnError (string ParSet, string Line, int Columns);
+		void OpenOutputFiles ( bool Results );
+		void CloseOutputFiles ( bool Results );
+		void Calculation ( void );
+		void PrintWarnings ( void );
+		
+		// parfile.cpp
+		int  ReadParameterSet ( string Filename, ParSet* CurParSet, int Type = -1 );
+		
+		// binaryinput.cpp
+		int  WriteBinaryInput ( string BinFile );
+		int  ReadBinaryInput ( void );
+		
+		// pdbinput.cpp
+		int  ReadPdbInput ( void );
+		
+		// ctselect.cpp
+		int  PrepareChargeTransfer ( void );
+		int  SelectChargeTransfer ( void );
+		
+		// parlibrary.cpp
+		int  WriteParameterLibrary ( string LibFile );
+		int  ReadParameterLibrary ( void );
+		
+		// trajectory.cpp
+		int  TrajectoryCalculation ( void );
+		int  TrajectoryFrame ( int Frame, string BaseName );
+		
+		// ensemble.cpp
+		int  EnsembleCalculation ( void );
+		int  EnsembleMember ( int Member, string BaseName, Results* Initial,
+		                      SymmetricMatrix* Couplings, vector<double>* Shift );
+		
+		// symmetry.cpp
+		int  RepeatSymmetry ( int* Central, bool* Periodic );
+		void RepeatHamiltonian ( Matrix* Stripe, SymmetricMatrix* Hamiltonian );
+		void RepeatToeplitz ( SymmetricMatrix* Hamiltonian );
+		int  RepeatEigensystem ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+		                         Matrix* Eigenvectors );
+		
+		// components.cpp
+		int  ComponentEigensystem ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+		                            Matrix* Eigenvectors );
 		
 		// fitparameters.cpp
 		int  FitParameters ( void );
-		int  RotationMatrix ( int Chrom, Matrix ParSetMatrix, Matrix GroupMatrix,
+		bool TransitionUsed ( int Type, int States, int State, int Trans );
+		int  PrepareFit ( ParSet* CurParSet );
+		int  RotationMatrix ( ParSetFit* Fit, Matrix* GroupMatrix,
 		                      Matrix *RotMatrixNonUnitary, Matrix* RotMatrixUnitary );
-		void CheckPlanar ( Matrix* ParSetMatrix, Matrix* GroupMatrix );
+		void AddVirtualAtom ( Matrix* CoordMatrix, string Label );
 		void Rotate ( vector<double> *In, vector<double> *Out, Matrix *RotMatrix );
+		void PackGroup ( SystemGroup* CurGroup );
 		
 		// matrix.cpp
-		int    HamiltonianMatrix ( void );
-		double SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans );
-		double DifferentGroupInteraction (int iGroup, int iTrans, int jGroup, int jTrans, bool Perm);
+		int    HamiltonianMatrix ( bool Diagonalize = true );
+		int    EigenstateCalculation ( SymmetricMatrix* Hamiltonian );
+		double HamiltonianElement ( int iGroup, int iTrans, int jGroup, int jTrans, int* Contacts,
+		                            double* MinDistance );
+		double SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans, int* Contacts,
+		                              double* MinDistance );
+		int    SameGroupTransition ( int iGroup, int iTrans, int jGroup, int jTrans, int* Group );
+		int    GroundStatePotential ( void );
+		void   GroupPotential ( int Group, int* Contacts, double* MinDistance );
+		double SitePotential ( vector<double>* Site, int jGroup, int* Contacts, double* MinDistance );
+		double DifferentGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans, bool Perm,
+		                                   int* Contacts, double* MinDistance );
+		void   CouplingBlock ( int iGroup, int jGroup, vector<double>* InvR, vector<double>* Temp,
+		                       vector<double>* Block, int* Contacts, double* MinDistance );
+		void   MultipoleBlock ( int iGroup, int jGroup, vector<double>* Block, double* Error );
 		bool   GroupsOverlap ( int iGroup, int jGroup );
+		int    DiagonalizeHamiltonian ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+		                                Matrix* Eigenvectors );
+		int    DiagonalizeWindow ( SparseMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+		                           Matrix* Eigenvectors );
+		string WarmStartReport ( void );
 		
 		// dichroism.cpp
 		int  CD_Calculation ( void );
+		void MixEigenstates ( Matrix* Eigenvectors );
+		void ConvertedMDM ( int Trans, double* MDM );
+		void MixTransitionMomentsLoops ( vector<double>* EDM, vector<double>* MDM );
 		int  LD_Calculation ( void );
 		void PrintPolarizationTensor ( vector< vector< vector<double> > >* PolTensor, int n );
 		
+		// bandshape.cpp
+		int  BandshapeCalculation ( void );
+		int  WriteSpectrum ( string Extension, vector<double>* Spectrum );
+		int  WriteAverage ( string Members = "frames" );
+	
 	public:
 		Dichro  ( string InFile, string Params, bool Verbose, int Debug,
-		          bool PrintVec = false, bool PrintPol = false, bool PrintMat = false );
+		          bool PrintVec = false, bool PrintPol = false, bool PrintMat = false,
+		          CalculationOptions Options = CalculationOptions() );
+		Dichro  ( string Params );
 		~Dichro ( void );
 };
 
@@ -332,4 +537,8 @@ class Dichro {
 
 
 #include "iolibrary.h"
+#include "eigensolver.h"
+#include "threads.h"
+#include "coulomb.h"
+#include "superpose.h"
 
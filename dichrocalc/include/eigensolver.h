@@ -0,0 +1,34 @@
+// #################################################################################################
+//
+//  Header:       eigensolver.h
+//
+//  Version:      $Revision$, $Date$
+//
+// #################################################################################################
+
+bool   EigensolverAvailable ( string Method );
+string EigensolverList ( void );
+int    SymmetricEigensystem ( string Method, SymmetricMatrix* InMatrix,
+                              DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors );
+
+int    DivideConquerEigensystem ( SymmetricMatrix* InMatrix, DiagonalMatrix* Eigenvalues,
+                                  Matrix* Eigenvectors );
+void   HouseholderTridiagonal ( int n, double* A, double* Diag, double* OffDiag, double* Tau );
+void   HouseholderBacktransform ( int n, double* A, double* Tau, double* Z, int Columns );
+int    TridiagonalQL ( int n, double* Diag, double* OffDiag, double* Z, int ldz );
+int    TridiagonalDivideConquer ( int n, double* Diag, double* OffDiag, double* Z, int ldz );
+int    CyclicJacobi ( int n, double* A, double* V, int* Sweeps );
+int    WarmStartEigensystem ( SymmetricMatrix* InMatrix, Matrix* Basis,
+                              DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors,
+                              int* Sweeps, bool* Warm );
+
+#ifdef DC_USE_LAPACK
+int    LapackEigensystem ( SymmetricMatrix* InMatrix, DiagonalMatrix* Eigenvalues,
+                           Matrix* Eigenvectors );
+#endif
+
+void   CompareEigensystems ( SymmetricMatrix* InMatrix,
+                             DiagonalMatrix* Eigenvalues,  Matrix* Eigenvectors,
+                             DiagonalMatrix* RefEigenvalues, Matrix* RefEigenvectors,
+                             double* ValueDeviation, double* VectorDeviation, double* Residual );
+
@@ -12,10 +12,14 @@ bool   FileExists    ( string FileName );
 bool   FileExtension ( string Filename, string Extension );
 bool   ReadDir ( string Dir, string Extension, vector<string>* Files );
 
+uint64_t Checksum ( const char* Data, uint64_t Size, uint64_t Hash = 14695981039346656037ULL );
+
 void   VectorDiff    (vector<double>* Vect1, vector<double>* Vect2, vector<double>* Diff);
 double VectorNorm (vector<double>* Vector);
 void   CrossProduct  (vector<double>* Vect1, vector<double>* Vect2, vector<double>* Cross);
 double PointDistance (vector<double>* Vect1, vector<double>* Vect2);
+double DihedralAngle ( const double* Atom1, const double* Atom2, const double* Atom3,
+                       const double* Atom4 );
 
 string tostring ( unsigned int Integer );
 string tostring ( int Integer );
@@ -49,6 +53,7 @@ void   PrintMatrix ( DiagonalMatrix* InMatrix, bool Indent = true );
 void   FilePrintMatrix ( FILE* File, Matrix* InMatrix );
 void   FilePrintMatrix ( FILE* File, SymmetricMatrix* InMatrix );
 void   FilePrintMatrix ( FILE* File, DiagonalMatrix* InMatrix, bool Indent = true );
+void   FilePrintMatrix ( FILE* File, SparseMatrix* InMatrix );
 
 void   dp ( string String  );
 void   dp ( int    Integer );
@@ -0,0 +1,38 @@
+// #################################################################################################
+//
+//  Header:       sparse.h
+//
+//  Version:      $Revision$, $Date$
+//
+// #################################################################################################
+
+class SparseMatrix {         // a symmetric matrix in compressed sparse row format (both triangles)
+	public:
+		int            Dimension;   // the number of rows and columns
+		vector<int>    RowStart;    // the first element of each row in Column/Value (Dimension+1)
+		vector<int>    Column;      // the column of each element, ascending within a row
+		vector<double> Value;       // the value of each element
+		
+		SparseMatrix ( void ) { Dimension = 0; }
+		
+		void   Build ( vector< vector<int> >* Columns, vector< vector<double> >* Values );
+		double Element ( int Row, int Col );
+		void   Multiply ( const double* In, double* Out, int Vectors = 1 );
+		void   Dense ( SymmetricMatrix* Out );
+};
+
+class WindowStatistics {     // information on the course of WindowEigensystem
+	public:
+		int    SubspaceSize;        // the final number of vectors iterated
+		int    Degree;              // the degree of the filter polynomial
+		int    Iterations;          // the number of filter iterations
+		double Residual;            // the largest residual |Hv - ev| of the returned eigenpairs
+		double Lower, Upper;        // the bounds of the spectrum (Gershgorin circles)
+};
+
+int    WindowEigensystem ( SparseMatrix* H, double Lower, double Upper, string Method,
+                           DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors,
+                           WindowStatistics* Statistics );
+void   WindowSelection ( DiagonalMatrix* AllEigenvalues, Matrix* AllEigenvectors,
+                         double Lower, double Upper,
+                         DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors );
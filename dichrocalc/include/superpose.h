@@ -0,0 +1,9 @@
+// #################################################################################################
+//
+//  Header:       superpose.h
+//
+//  Version:      $Revision$, $Date$
+//
+// #################################################################################################
+
+void QuaternionRotation ( const double* Correlation, double* Rotation );
@@ -0,0 +1,17 @@
+// #################################################################################################
+//
+//  Header:       threads.h
+//
+//  Version:      $Revision$, $Date$
+//
+// #################################################################################################
+
+class ParallelTask {         // a job that is split into independent, numbered parts
+	public:
+		virtual void Run ( int Part ) = 0;   // processes one part, may run in any thread
+		virtual ~ParallelTask ( void ) { }
+};
+
+int    AvailableThreads ( void );
+int    NumberOfThreads  ( int Requested, int Parts );
+int    RunParallel ( ParallelTask* Task, int Parts, int Threads );
@@ -0,0 +1,437 @@
+// #################################################################################################
+//
+//  Program:      bandshape.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Convolution of the line spectra with band shapes (--bandshape), replaces the
+//                post-processing of the .cdl and .vec files with scripts/bandshape, and the
+//                average of the spectra of a trajectory (--average)
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <algorithm>
+
+
+// The band shapes and scale factors are those of scripts/bandshape (and ashape): each line at
+// the wavelength L with the strength R adds at the grid wavelength x
+//
+//    Gaussian:                 R * L * sqrt(pi) / w * exp ( -((L - x) / w)^2 )
+//    Lorentzian:               R * w * L^2 * 2x / ( (L^2 - x^2)^2 + x^2 w^2 )
+//    approximate Lorentzian:   R * w * L / ( (L - x)^2 + w^2 )
+//
+// with the band width w, multiplied by 1.2848 * 3300 / Factor for CD and 1.2848 / Factor for
+// the absorbance. The wavelength grid runs from MinWL to MaxWL of $CONFIGURATION (150 to 350 nm
+// if not given) and is split into chunks which are calculated in parallel. A line only adds to
+// the grid points within the distance at which its contribution drops below
+// DC_Options.BandTolerance, a Gaussian band therefore only touches a few hundred points.
+
+class BandshapeGrid : public ParallelTask { // the spectra on the grid, one part per chunk
+	public:
+		int    Shape;                       // BandGaussian, BandLorentzian, BandApproxLorentzian
+		double Width;                       // the band width in nm
+		int    Chunk;                       // the number of grid points in each part
+		vector<double> Grid;                // the wavelengths of the grid points
+		vector<double> Lines;               // the wavelengths of the lines
+		vector<int>    First, Last;         // the grid points reached by each line
+		vector< vector<double> > Strengths; // the scaled strengths of the lines, one per spectrum
+		vector< vector<double> > Spectra;   // the resulting spectra on the grid
+		
+		void Run ( int Part );
+};
+
+enum BandShapes { BandApproxLorentzian = 1, BandLorentzian = 2, BandGaussian = 3 };
+
+
+// ================================================================================
+
+
+int Dichro::BandshapeCalculation ( void )
+// convolutes the rotational strengths (.cd) and, with --vec, the squared components of the
+// polarization vectors (.ab and .ld) of DC_Results with the band shape DC_Options.Bandshape
+{
+	const double SqrtPi = sqrt (3.141592654);   // as in scripts/bandshape
+	
+	BandshapeGrid Grid;
+	string Name;
+	double Min, Max, Step, Factor, Reach, Height;
+	int Points, Spectrum, Point, Threads, Skipped = 0;
+	unsigned int Trans;
+	
+	if      (DC_Options.Bandshape == "gauss")   { Grid.Shape = BandGaussian;         Name = "Gaussian";   }
+	else if (DC_Options.Bandshape == "lorentz") { Grid.Shape = BandLorentzian;       Name = "Lorentzian"; }
+	else if (DC_Options.Bandshape == "approx")  { Grid.Shape = BandApproxLorentzian; Name = "approximate Lorentzian"; }
+	else {
+		cerr << "\nERROR: Unknown band shape " << DC_Options.Bandshape
+		     << " (available: gauss, lorentz, approx).\n\n";
+		DC_Error     = "Unknown band shape";
+		DC_ErrorCode = 180;
+		return 180;
+	}
+	
+	Min  = (DC_Input.Configuration.MinWL > 0) ? DC_Input.Configuration.MinWL : 150;
+	Max  = (DC_Input.Configuration.MaxWL > 0) ? DC_Input.Configuration.MaxWL : 350;
+	Step = DC_Options.BandStep;
+	
+	if (DC_Options.Bandwidth <= 0 or Step <= 0 or Max <= Min) {
+		cerr << "\nERROR: Invalid band shape grid (" << Min << " to " << Max << " nm in steps of "
+		     << Step << " nm, band width " << DC_Options.Bandwidth << " nm).\n\n";
+		DC_Error     = "Invalid band shape grid";
+		DC_ErrorCode = 181;
+		return 181;
+	}
+	
+	// the scale factor is the number of residues, otherwise the number of groups is taken
+	Factor = DC_Input.Configuration.Factor;
+	
+	if (Factor <= 0) {
+		Factor = DC_System.NumberOfGroups;
+		Warnings.push_back ("--bandshape: no Factor in $CONFIGURATION, the number of groups ("
+		                    + tostring (DC_System.NumberOfGroups) + ") is used");
+	}
+	
+	Points = (int) ((Max - Min) / Step + 1.0E-6) + 1;
+	
+	Grid.Width = DC_Options.Bandwidth;
+	Grid.Chunk = 256;
+	Grid.Grid.resize (Points);
+	
+	for (Point = 0; Point < Points; Point++)
+		Grid.Grid.at(Point) = Min + Point * Step;
+	
+	if (DC_Verbose) {
+		Dichro::NewTask ( "Band Shapes" );
+		printf ("   %s, band width %.2f nm, %.1f to %.1f nm in steps of %.3f nm\n",
+		        Name.c_str(), Grid.Width, Min, Max, Step);
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	// CD and, if the polarization vectors are written, the absorbance along x, y and z
+	int Spectra = DC_PrintVec ? 4 : 1;
+	
+	Grid.Strengths.resize (Spectra);
+	
+	for (Trans = 0; Trans < DC_Results.Trans.Wavelength.size(); Trans++) {
+		double Wavelength = DC_Results.Trans.Wavelength.at(Trans);
+		vector<double> Strength (Spectra, 0.0);
+		
+		// negative wavelengths (negative eigenvalues) are skipped like by bandshape -force
+		if (Wavelength <= 0) {
+			++Skipped;
+			continue;
+		}
+		
+		Strength.at(0) = DC_Results.Trans.RotationalStrength.at(Trans) * 1.2848484848 * 3300 / Factor;
+		
+		for (Spectrum = 1; Spectrum < Spectra; Spectrum++)
+			Strength.at(Spectrum) = pow (DC_Results.Trans.PolarizationVector.at(Trans).at(Spectrum-1), 2)
+			                        * 1.2848484848 / Factor;
+		
+		// the factor of the band shape (before the wavelength dependent part)
+		for (Spectrum = 0; Spectrum < Spectra; Spectrum++) {
+			if (Grid.Shape == BandGaussian)
+				Strength.at(Spectrum) *= Wavelength * SqrtPi / Grid.Width;
+			else if (Grid.Shape == BandLorentzian)
+				Strength.at(Spectrum) *= 2 * Grid.Width * Wavelength * Wavelength;
+			else
+				Strength.at(Spectrum) *= Grid.Width * Wavelength;
+		}
+		
+		Height = 0.0;
+		
+		for (Spectrum = 0; Spectrum < Spectra; Spectrum++)
+			Height = max (Height, fabs (Strength.at(Spectrum)));
+		
+		if (Height == 0.0) continue;
+		
+		// the distance beyond which the contribution is smaller than the tolerance, for the
+		// Lorentzians |R w L^2 2x| / ((L-x)^2 (L+x)^2) <= |R w L 2| / (L-x)^2 is used
+		if (DC_Options.BandTolerance <= 0) {
+			Reach = Wavelength + Max;   // all grid points
+		}
+		else if (Grid.Shape == BandGaussian) {
+			if (Height <= DC_Options.BandTolerance) continue;
+			
+			Reach = Grid.Width * sqrt (log (Height / DC_Options.BandTolerance));
+		}
+		else if (Grid.Shape == BandLorentzian) {
+			Reach = sqrt (Height / Wavelength / DC_Options.BandTolerance);
+		}
+		else {
+			Reach = sqrt (Height / DC_Options.BandTolerance);
+		}
+		
+		if (Wavelength + Reach < Min or Wavelength - Reach > Max) continue;
+		
+		Grid.Lines.push_back (Wavelength);
+		Grid.First.push_back ((int) max (0.0, floor ((Wavelength - Reach - Min) / Step)));
+		Grid.Last.push_back  ((int) min (Points - 1.0, ceil ((Wavelength + Reach - Min) / Step)));
+		
+		for (Spectrum = 0; Spectrum < Spectra; Spectrum++)
+			Grid.Strengths.at(Spectrum).push_back (Strength.at(Spectrum));
+	}
+	
+	if (Skipped > 0)
+		Warnings.push_back ("--bandshape: " + tostring (Skipped) + " transition(s) with negative wavelengths skipped");
+	
+	Grid.Spectra.assign (Spectra, vector<double> (Points, 0.0));
+	
+	Threads = RunParallel (&Grid, (Points + Grid.Chunk - 1) / Grid.Chunk, DC_Options.Threads);
+	
+	if (DC_Verbose) {
+		printf ("      %d of %d lines within the grid", (int) Grid.Lines.size(),
+		        (int) DC_Results.Trans.Wavelength.size());
+		
+		if (Threads > 1) printf (", %d threads", Threads);
+		
+		printf ("\n");
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	DC_Results.Spectra.Wavelength = Grid.Grid;
+	DC_Results.Spectra.CD = Grid.Spectra.at(0);
+	DC_Results.Spectra.Absorbance.clear();
+	DC_Results.Spectra.LD.clear();
+	
+	if (DC_PrintVec) {
+		DC_Results.Spectra.Absorbance.resize (Points);
+		DC_Results.Spectra.LD.resize (Points);
+		
+		for (Point = 0; Point < Points; Point++) {
+			double x = Grid.Spectra.at(1).at(Point);
+			double y = Grid.Spectra.at(2).at(Point);
+			double z = Grid.Spectra.at(3).at(Point);
+			
+			// A(par) - A(perp), the plain LD of bandshape -ld
+			DC_Results.Spectra.Absorbance.at(Point) = x + y + z;
+			DC_Results.Spectra.LD.at(Point) = z - 0.5 * (x + y);
+		}
+	}
+	
+	// the spectra of the frames or members of an average are only accumulated (TrajectoryFrame,
+	// EnsembleMember)
+	if (DC_Options.Average and (DC_Options.Frames.size() > 0 or DC_Options.Disorder > 0.0
+	                            or DC_Options.ShiftSet.size() > 0)) return 0;
+	
+	if (WriteSpectrum (".cd", &DC_Results.Spectra.CD) != 0) return DC_ErrorCode;
+	
+	if (DC_PrintVec) {
+		if (WriteSpectrum (".ab", &DC_Results.Spectra.Absorbance) != 0) return DC_ErrorCode;
+		if (WriteSpectrum (".ld", &DC_Results.Spectra.LD) != 0) return DC_ErrorCode;
+	}
+	
+	return 0;
+} // of Dichro::BandshapeCalculation
+
+
+// ================================================================================
+
+
+int Dichro::WriteSpectrum ( string Extension, vector<double>* Spectrum )
+// writes a spectrum on the wavelength grid of DC_Results.Spectra to DC_InFileBaseName.Extension
+// in the format of scripts/bandshape (which writes the .ld files with narrower columns)
+{
+	string Filename = DC_InFileBaseName + Extension;
+	const char* Format = (Extension == ".ld") ? " %14.6f%14.6f\n" : "%16.6f %16.6f\n";
+	FILE* File = fopen (Filename.c_str(), "w");
+	
+	if (File == NULL) {
+		cerr << "\nERROR: Could not write the spectrum " << Filename << ".\n\n";
+		DC_Error     = "Unable to write spectrum";
+		DC_ErrorCode = 182;
+		return 182;
+	}
+	
+	for (unsigned int Point = 0; Point < Spectrum->size(); Point++)
+		fprintf (File, Format, DC_Results.Spectra.Wavelength.at(Point), Spectrum->at(Point));
+	
+	fclose (File);
+	
+	if (DC_Verbose) printf ("      Output written to %s\n", Filename.c_str());
+	
+	return 0;
+} // of Dichro::WriteSpectrum
+
+
+// ================================================================================
+
+
+int Dichro::WriteAverage ( string Members )
+// writes the mean of the spectra of all frames (or the Members of an ensemble) in DC_Average
+// with the standard error of the mean of each point to DC_InFileBaseName.avg.cd (.avg.ab, .avg.ld)
+{
+	const char* Extensions[] = { ".avg.cd", ".avg.ab", ".avg.ld" };
+	unsigned int Spectrum, Point;
+	double Error;
+	
+	for (Spectrum = 0; Spectrum < DC_Average.Mean.size(); Spectrum++) {
+		if (DC_Average.Mean.at(Spectrum).size() == 0) continue;
+		
+		string Filename = DC_InFileBaseName + Extensions[Spectrum];
+		FILE* File = fopen (Filename.c_str(), "w");
+		
+		if (File == NULL) {
+			cerr << "\nERROR: Could not write the spectrum " << Filename << ".\n\n";
+			DC_Error     = "Unable to write spectrum";
+			DC_ErrorCode = 182;
+			return 182;
+		}
+		
+		fprintf (File, "# average of %d %s: wavelength, mean, standard error of the mean\n",
+		         DC_Average.Count, Members.c_str());
+		
+		for (Point = 0; Point < DC_Average.Wavelength.size(); Point++) {
+			Error = 0.0;
+			
+			if (DC_Average.Count > 1)
+				Error = sqrt (DC_Average.M2.at(Spectrum).at(Point) / (DC_Average.Count - 1)
+				              / DC_Average.Count);
+			
+			fprintf (File, "%16.6f %16.6f %16.6f\n", DC_Average.Wavelength.at(Point),
+			         DC_Average.Mean.at(Spectrum).at(Point), Error);
+		}
+		
+		fclose (File);
+		
+		if (DC_Verbose)
+			printf ("   Average of %d %s written to %s\n", DC_Average.Count, Members.c_str(), Filename.c_str());
+	}
+	
+	return 0;
+} // of Dichro::WriteAverage
+
+
+// ================================================================================
+
+
+void Dichro::SpectrumAverage::Add ( ResultsSpectra* Spectra )
+// adds the spectra of one frame to the running mean and variance (Welford's algorithm)
+{
+	vector<double>* Values[] = { &Spectra->CD, &Spectra->Absorbance, &Spectra->LD };
+	unsigned int Spectrum, Point;
+	double Delta;
+	
+	if (Count == 0) {
+		Wavelength = Spectra->Wavelength;
+		Mean.assign (3, vector<double>());
+		M2.assign (3, vector<double>());
+		
+		for (Spectrum = 0; Spectrum < 3; Spectrum++) {
+			Mean.at(Spectrum).assign (Values[Spectrum]->size(), 0.0);
+			M2.at(Spectrum).assign (Values[Spectrum]->size(), 0.0);
+		}
+	}
+	
+	++Count;
+	
+	for (Spectrum = 0; Spectrum < 3; Spectrum++) {
+		double* x = Values[Spectrum]->size() > 0 ? &Values[Spectrum]->at(0) : NULL;
+		double* m = Mean.at(Spectrum).size() > 0 ? &Mean.at(Spectrum).at(0) : NULL;
+		double* s = M2.at(Spectrum).size() > 0 ? &M2.at(Spectrum).at(0) : NULL;
+		
+		for (Point = 0; Point < Mean.at(Spectrum).size(); Point++) {
+			Delta = x[Point] - m[Point];
+			m[Point] += Delta / Count;
+			s[Point] += Delta * (x[Point] - m[Point]);
+		}
+	}
+} // of Dichro::SpectrumAverage::Add
+
+
+// ================================================================================
+
+
+void Dichro::SpectrumAverage::Merge ( SpectrumAverage* Other )
+// adds the frames of another average, e.g. of another thread (Chan et al.)
+{
+	unsigned int Spectrum, Point;
+	double Delta;
+	
+	if (Other->Count == 0) return;
+	
+	if (Count == 0) {
+		*this = *Other;
+		return;
+	}
+	
+	int Total = Count + Other->Count;
+	
+	for (Spectrum = 0; Spectrum < Mean.size(); Spectrum++) {
+		for (Point = 0; Point < Mean.at(Spectrum).size(); Point++) {
+			Delta = Other->Mean.at(Spectrum).at(Point) - Mean.at(Spectrum).at(Point);
+			
+			Mean.at(Spectrum).at(Point) += Delta * Other->Count / Total;
+			M2.at(Spectrum).at(Point)   += Other->M2.at(Spectrum).at(Point)
+			                               + Delta * Delta * Count * Other->Count / Total;
+		}
+	}
+	
+	Count = Total;
+} // of Dichro::SpectrumAverage::Merge
+
+
+// ================================================================================
+
+
+void BandshapeGrid::Run ( int Part )
+// adds all lines reaching the grid points of the chunk Part to the spectra
+{
+	int Start = Part * Chunk;
+	int End   = min (Start + Chunk, (int) Grid.size()) - 1;
+	int Count = Spectra.size();
+	
+	// the band of one line on the chunk, added to all spectra
+	vector<double> Band (Chunk);
+	
+	for (unsigned int Line = 0; Line < Lines.size(); Line++) {
+		if (Last.at(Line) < Start or First.at(Line) > End) continue;
+		
+		int    From = max (Start, First.at(Line));
+		int    To   = min (End,   Last.at(Line));
+		int    n    = To - From + 1;
+		double L    = Lines.at(Line);
+		double* x   = &Grid.at(From);
+		double* b   = &Band.at(0);
+		int    i;
+		
+		// plain loops over the points, which the compiler can vectorize
+		if (Shape == BandGaussian) {
+			for (i = 0; i < n; i++) {
+				double d = (L - x[i]) / Width;
+				b[i] = exp (-d * d);
+			}
+		}
+		else if (Shape == BandLorentzian) {
+			for (i = 0; i < n; i++) {
+				double d = L * L - x[i] * x[i];
+				b[i] = x[i] / (d * d + x[i] * x[i] * Width * Width);
+			}
+		}
+		else {
+			for (i = 0; i < n; i++) {
+				double d = L - x[i];
+				b[i] = 1.0 / (d * d + Width * Width);
+			}
+		}
+		
+		for (int Spectrum = 0; Spectrum < Count; Spectrum++) {
+			double  R = Strengths.at(Spectrum).at(Line);
+			double* s = &Spectra.at(Spectrum).at(From);
+			
+			for (i = 0; i < n; i++)
+				s[i] += R * b[i];
+		}
+	}
+} // of BandshapeGrid::Run
+
+
+// ================================================================================
+
@@ -0,0 +1,287 @@
+// #################################################################################################
+//
+//  Program:      binaryinput.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Binary version of the input file (.inb), written from a .inp file with
+//                --binary-input and read instead of it without parsing any text
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+
+// Layout of a binary input file (native byte order, the version has to be increased on any change):
+//
+//    InbHeader                       magic, version, the $CONFIGURATION block, the numbers below
+//                                    and the checksum of everything after the header
+//    InbParameter [Parameters]       the $PARAMETERS block
+//    int32_t  [Chromophores]         the $CHROMOPHORES block: the types,
+//    int32_t  [Chromophores]            the number of atoms of each chromophore,
+//    int32_t  [ChromophoreAtoms]        the atom indices of all chromophores (counted from 0)
+//    double   [Atoms][3]             the $COORDINATES block: x, y, z of all atoms,
+//    int32_t  [Atoms]                   the atom numbers (counted from 0),
+//    char     [Atoms][8]                the atom labels
+//
+// The coordinates and atom numbers are read directly into the arrays of DC_Input.Coordinates.
+
+static const char     InbMagic[8] = { 'D', 'C', 'I', 'N', 'P', 'B', 'I', 'N' };
+static const uint32_t InbVersion  = 1;
+static const int      InbLabel    = 8;     // the length of the atom labels including the '\0'
+
+struct InbHeader {
+	char     Magic[8];
+	uint32_t Version;
+	int32_t  BBTrans;
+	int32_t  CTTrans;
+	int32_t  Factor;
+	int32_t  MinWL;
+	int32_t  MaxWL;
+	int32_t  Parameters;
+	int32_t  Chromophores;
+	int32_t  ChromophoreAtoms;
+	int32_t  Atoms;
+	uint64_t Checksum;
+};
+
+struct InbParameter {
+	char     Name[32];       // '\0'-terminated
+	int32_t  Trans;
+	int32_t  Unused;
+};
+
+
+static bool WriteBlock ( FILE* File, const void* Data, size_t Size, uint64_t* Hash )
+{
+	if (Size == 0) return true;
+	
+	*Hash = Checksum ((const char*) Data, Size, *Hash);
+	
+	return fwrite (Data, 1, Size, File) == Size;
+}
+
+
+static bool ReadBlock ( FILE* File, void* Data, size_t Size, uint64_t* Hash )
+{
+	if (Size == 0) return true;
+	
+	if (fread (Data, 1, Size, File) != Size) return false;
+	
+	*Hash = Checksum ((const char*) Data, Size, *Hash);
+	
+	return true;
+}
+
+
+// ================================================================================
+
+
+int Dichro::WriteBinaryInput ( string BinFile )
+// writes the data of the input file in DC_Input to the binary input file BinFile
+{
+	unsigned int Group, Atom;
+	InbHeader Header;
+	vector<InbParameter> Parameters (DC_Input.Parameters.Name.size());
+	vector<int32_t> Types, AtomCounts, AtomIndices, Atoms;
+	vector<char> Labels (InbLabel * DC_Input.Coordinates.Number(), '\0');
+	uint64_t Hash = 14695981039346656037ULL;
+	bool Written;
+	
+	memset (&Header, 0, sizeof (Header));
+	memcpy (Header.Magic, InbMagic, sizeof (InbMagic));
+	Header.Version          = InbVersion;
+	Header.BBTrans          = DC_Input.Configuration.BBTrans;
+	Header.CTTrans          = DC_Input.Configuration.CTTrans;
+	Header.Factor           = DC_Input.Configuration.Factor;
+	Header.MinWL            = DC_Input.Configuration.MinWL;
+	Header.MaxWL            = DC_Input.Configuration.MaxWL;
+	Header.Parameters       = DC_Input.Parameters.Name.size();
+	Header.Chromophores     = DC_Input.Chromophores.Type.size();
+	Header.Atoms            = DC_Input.Coordinates.Number();
+	
+	for (Group = 0; Group < Parameters.size(); Group++) {
+		if (DC_Input.Parameters.Name.at(Group).size() >= sizeof (Parameters.at(Group).Name)) {
+			cerr << "\nERROR: The name of parameter set " << DC_Input.Parameters.Name.at(Group)
+			     << " is too long.\n\n";
+			DC_Error = "Error writing binary input file";
+			DC_ErrorCode = 104;
+			return 104;
+		}
+		
+		strcpy (Parameters.at(Group).Name, DC_Input.Parameters.Name.at(Group).c_str());
+		Parameters.at(Group).Trans = DC_Input.Parameters.Trans.at(Group);
+	}
+	
+	for (Group = 0; Group < DC_Input.Chromophores.Type.size(); Group++) {
+		vector<int>* GroupAtoms = &DC_Input.Chromophores.Atoms.at(Group);
+		
+		Types.push_back (DC_Input.Chromophores.Type.at(Group));
+		AtomCounts.push_back (GroupAtoms->size());
+		AtomIndices.insert (AtomIndices.end(), GroupAtoms->begin(), GroupAtoms->end());
+	}
+	
+	Header.ChromophoreAtoms = AtomIndices.size();
+	
+	Atoms.assign (DC_Input.Coordinates.Atoms.begin(), DC_Input.Coordinates.Atoms.end());
+	
+	for (Atom = 0; Atom < DC_Input.Coordinates.Number(); Atom++)
+		strncpy (&Labels.at(InbLabel * Atom), DC_Input.Coordinates.Labels.at(Atom).c_str(),
+		         InbLabel - 1);
+	
+	// --------------------------------------------------------------------------------
+	
+	FILE* File = fopen (BinFile.c_str(), "wb");
+	
+	if (File == NULL) {
+		cerr << "\nERROR: Could not write the binary input file " << BinFile << ".\n\n";
+		DC_Error = "Error writing binary input file";
+		DC_ErrorCode = 104;
+		return 104;
+	}
+	
+	// the header is written again with the checksum at the end
+	Written = (fwrite (&Header, sizeof (Header), 1, File) == 1);
+	
+	Written = Written and
+	          WriteBlock (File, Parameters.data(),  Parameters.size()  * sizeof (InbParameter), &Hash) and
+	          WriteBlock (File, Types.data(),       Types.size()       * sizeof (int32_t), &Hash) and
+	          WriteBlock (File, AtomCounts.data(),  AtomCounts.size()  * sizeof (int32_t), &Hash) and
+	          WriteBlock (File, AtomIndices.data(), AtomIndices.size() * sizeof (int32_t), &Hash) and
+	          WriteBlock (File, DC_Input.Coordinates.XYZ.data(),
+	                      DC_Input.Coordinates.XYZ.size() * sizeof (double), &Hash) and
+	          WriteBlock (File, Atoms.data(),       Atoms.size()       * sizeof (int32_t), &Hash) and
+	          WriteBlock (File, Labels.data(),      Labels.size(), &Hash);
+	
+	Header.Checksum = Hash;
+	
+	Written = Written and fseek (File, 0, SEEK_SET) == 0;
+	Written = Written and fwrite (&Header, sizeof (Header), 1, File) == 1;
+	
+	if (fclose (File) != 0 or not Written) {
+		cerr << "\nERROR: Could not write the binary input file " << BinFile << ".\n\n";
+		DC_Error = "Error writing binary input file";
+		DC_ErrorCode = 104;
+		return 104;
+	}
+	
+	if (DC_Verbose)
+		printf ("   %d parameter sets, %d chromophores and %d atoms written to %s\n",
+		        Header.Parameters, Header.Chromophores, Header.Atoms, BinFile.c_str());
+	
+	return 0;
+} // of Dichro::WriteBinaryInput
+
+
+// ================================================================================
+
+
+int Dichro::ReadBinaryInput ( void )
+// reads the binary input file DC_InFile (see WriteBinaryInput) into DC_Input
+{
+	int Group, Atom, Count;
+	InbHeader Header;
+	vector<InbParameter> Parameters;
+	vector<int32_t> AtomCounts, AtomIndices, Atoms;
+	vector<char> Labels;
+	uint64_t Hash = 14695981039346656037ULL;
+	bool Read;
+	
+	FILE* File = fopen (DC_InFile.c_str(), "rb");
+	
+	if (File == NULL) {
+		printf ("\nERROR: Could not open file %s.\n\n", DC_InFile.c_str());
+		DC_Error = "Unable to open input file";
+		DC_ErrorCode = 100;
+		return 100;
+	}
+	
+	Read = (fread (&Header, sizeof (Header), 1, File) == 1) and
+	       memcmp (Header.Magic, InbMagic, sizeof (InbMagic)) == 0 and Header.Version == InbVersion and
+	       Header.Parameters >= 0 and Header.Chromophores >= 0 and
+	       Header.ChromophoreAtoms >= 0 and Header.Atoms >= 0;
+	
+	if (Read) {
+		DC_Input.Configuration.BBTrans = Header.BBTrans;
+		DC_Input.Configuration.CTTrans = Header.CTTrans;
+		DC_Input.Configuration.Factor  = Header.Factor;
+		DC_Input.Configuration.MinWL   = Header.MinWL;
+		DC_Input.Configuration.MaxWL   = Header.MaxWL;
+		
+		Parameters.resize (Header.Parameters);
+		DC_Input.Chromophores.Type.resize (Header.Chromophores);
+		AtomCounts.resize (Header.Chromophores);
+		AtomIndices.resize (Header.ChromophoreAtoms);
+		
+		// the coordinates go straight into their array
+		DC_Input.Coordinates.XYZ.resize (3 * Header.Atoms);
+		Atoms.resize (Header.Atoms);
+		Labels.resize (InbLabel * Header.Atoms);
+		
+		Read = ReadBlock (File, Parameters.data(), Parameters.size() * sizeof (InbParameter), &Hash) and
+		       ReadBlock (File, DC_Input.Chromophores.Type.data(),
+		                  DC_Input.Chromophores.Type.size() * sizeof (int32_t), &Hash) and
+		       ReadBlock (File, AtomCounts.data(),  AtomCounts.size()  * sizeof (int32_t), &Hash) and
+		       ReadBlock (File, AtomIndices.data(), AtomIndices.size() * sizeof (int32_t), &Hash) and
+		       ReadBlock (File, DC_Input.Coordinates.XYZ.data(),
+		                  DC_Input.Coordinates.XYZ.size() * sizeof (double), &Hash) and
+		       ReadBlock (File, Atoms.data(),       Atoms.size()       * sizeof (int32_t), &Hash) and
+		       ReadBlock (File, Labels.data(),      Labels.size(), &Hash) and
+		       Hash == Header.Checksum;
+	}
+	
+	fclose (File);
+	
+	// the atom counts of the chromophores have to add up to the atom indices
+	for (Group = 0, Count = 0; Read and Group < Header.Chromophores; Group++) {
+		Read   = (AtomCounts.at(Group) >= 0);
+		Count += AtomCounts.at(Group);
+	}
+	
+	if ( not Read or Count != Header.ChromophoreAtoms ) {
+		cerr << "\nERROR: " << DC_InFile << " is not a binary input file of this version of\n"
+		     <<   "       DichroCalc or it is damaged, it has to be created again with --binary-input.\n\n";
+		DC_Input.Chromophores.Type.clear();
+		DC_Input.Coordinates.XYZ.clear();
+		DC_Error = "Invalid binary input file";
+		DC_ErrorCode = 104;
+		return 104;
+	}
+	
+	for (Group = 0; Group < Header.Parameters; Group++) {
+		Parameters.at(Group).Name[sizeof (Parameters.at(Group).Name) - 1] = '\0';
+		DC_Input.Parameters.Name.push_back  (Parameters.at(Group).Name);
+		DC_Input.Parameters.Trans.push_back (Parameters.at(Group).Trans);
+	}
+	
+	DC_Input.Chromophores.Atoms.resize (Header.Chromophores);
+	
+	for (Group = 0, Count = 0; Group < Header.Chromophores; Group++) {
+		DC_Input.Chromophores.Atoms.at(Group).assign (AtomIndices.begin() + Count,
+		                                             AtomIndices.begin() + Count + AtomCounts.at(Group));
+		Count += AtomCounts.at(Group);
+	}
+	
+	DC_Input.Coordinates.Atoms.assign (Atoms.begin(), Atoms.end());
+	DC_Input.Coordinates.Labels.resize (Header.Atoms);
+	
+	for (Atom = 0; Atom < Header.Atoms; Atom++) {
+		Labels.at(InbLabel * Atom + InbLabel - 1) = '\0';
+		DC_Input.Coordinates.Labels.at(Atom) = &Labels.at(InbLabel * Atom);
+	}
+	
+	if (DC_Verbose)
+		printf ("   Binary input file, %d chromophores, %d atoms\n", Header.Chromophores, Header.Atoms);
+	
+	if (DC_Debug > 3) Dichro::OutputInputClass();
+	
+	return 0;
+} // of Dichro::ReadBinaryInput
+
+
+// ================================================================================
+
@@ -0,0 +1,168 @@
+// #################################################################################################
+//
+//  Program:      cdbench
+//
+//  Function:     Benchmark of the mixing of the transition dipole moments in CD_Calculation:
+//                calculates the moments of all eigenstates of a random system with the original
+//                loops over groups and transitions (MixTransitionMomentsLoops) and with the
+//                matrix product of MixEigenstates (which also calculates the moments for the
+//                LD), checks that both give the same moments and compares the times
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string.h>
+#include <vector>
+#include <sys/time.h>
+
+using namespace std;
+
+#include "../include/dichrocalc.h"
+
+// ================================================================================
+
+
+double Seconds ( void );
+double Random ( void );
+void   RandomSystem ( Dichro* DC, int Groups, int Transitions );
+
+
+// ================================================================================
+
+
+double Seconds ( void )
+// the wall-clock time in seconds
+{
+	struct timeval Time;
+	
+	gettimeofday (&Time, NULL);
+	
+	return Time.tv_sec + 1E-6 * Time.tv_usec;
+} // of Seconds
+
+
+// ================================================================================
+
+
+double Random ( void )
+// a random number between -1 and 1
+{
+	return 2.0 * rand() / RAND_MAX - 1.0;
+} // of Random
+
+
+// ================================================================================
+
+
+void RandomSystem ( Dichro* DC, int Groups, int Transitions )
+// sets up DC_System and DC_Results like HamiltonianMatrix and the eigensolver, with random
+// moments and eigenvectors and energies between 40000 and 80000 cm^-1 (the reference vectors
+// are zero, the magnetic moments are therefore not changed by the conversion)
+{
+	int Group, Trans, Coord, Row, Col;
+	int n = Groups * Transitions;
+	
+	DC->DC_System.NumberOfGroups      = Groups;
+	DC->DC_System.NumberOfTransitions = n;
+	DC->DC_System.Groups.resize (Groups);
+	
+	DC->DC_Results.Trans.EDM.clear();
+	DC->DC_Results.Trans.MDMconv.clear();
+	DC->DC_Results.Trans.Energy.clear();
+	DC->DC_Results.Trans.Reference.clear();
+	
+	for (Group = 0; Group < Groups; Group++) {
+		Dichro::SystemGroup* CurGroup = &DC->DC_System.Groups.at(Group);
+		
+		CurGroup->NumberOfTransitions = Transitions;
+		CurGroup->Trans.resize (Transitions);
+		
+		for (Trans = 0; Trans < Transitions; Trans++) {
+			CurGroup->Trans.at(Trans).Energy = 60000 + 20000 * Random();
+			CurGroup->Trans.at(Trans).EDM.resize (3);
+			CurGroup->Trans.at(Trans).MDM.resize (3);
+			
+			for (Coord = 0; Coord < 3; Coord++) {
+				CurGroup->Trans.at(Trans).EDM.at(Coord) = Random();
+				CurGroup->Trans.at(Trans).MDM.at(Coord) = Random();
+			}
+			
+			DC->DC_Results.Trans.EDM.push_back (CurGroup->Trans.at(Trans).EDM);
+			DC->DC_Results.Trans.MDMconv.push_back (CurGroup->Trans.at(Trans).MDM);
+			DC->DC_Results.Trans.Energy.push_back (CurGroup->Trans.at(Trans).Energy);
+			DC->DC_Results.Trans.Reference.push_back (vector<double> (3, 0.0));
+		}
+	}
+	
+	DC->DC_Results.Eigenvalues.resize (n);
+	DC->DC_Results.Eigenvectors.resize (n, n);
+	
+	for (Row = 0; Row < n; Row++) {
+		DC->DC_Results.Eigenvalues.element(Row) = 60000 + 20000 * Random();
+		
+		for (Col = 0; Col < n; Col++)
+			DC->DC_Results.Eigenvectors.element(Row, Col) = Random() / sqrt ((double) n);
+	}
+} // of RandomSystem
+
+
+// ================================================================================
+
+
+int main ( int argc, char **argv )
+{
+	int    Groups  = 2500;
+	int    Threads = 1;
+	unsigned int Element;
+	double Start, TimeLoops, TimeProduct, Difference = 0.0, Largest = 0.0;
+	vector<double> LoopsEDM, LoopsMDM;
+	
+	if (argc > 1) Groups  = atoi (argv[1]);
+	if (argc > 2) Threads = atoi (argv[2]);
+	
+	if (argc > 3 or Groups < 1 or Threads < 0) {
+		cout << "\nUsage: cdbench [groups with two transitions, default 2500] [threads]\n\n";
+		return 1;
+	}
+	
+	Dichro DC ("");
+	
+	DC.DC_Options.Threads = Threads;
+	
+	srand (1);
+	RandomSystem (&DC, Groups, 2);
+	
+	Start = Seconds ();
+	DC.MixTransitionMomentsLoops (&LoopsEDM, &LoopsMDM);
+	TimeLoops = Seconds () - Start;
+	
+	Start = Seconds ();
+	DC.MixEigenstates (&DC.DC_Results.Eigenvectors);
+	TimeProduct = Seconds () - Start;
+	
+	vector<double>* ProductEDM = &DC.DC_Results.Moments.EDM;
+	vector<double>* ProductMDM = &DC.DC_Results.Moments.MDM;
+	
+	// both have to give the same moments apart from the rounding
+	for (Element = 0; Element < LoopsEDM.size(); Element++) {
+		Difference = max (Difference, fabs (LoopsEDM.at(Element) - ProductEDM->at(Element)));
+		Difference = max (Difference, fabs (LoopsMDM.at(Element) - ProductMDM->at(Element)));
+		Largest    = max (Largest, max (fabs (LoopsEDM.at(Element)), fabs (LoopsMDM.at(Element))));
+	}
+	
+	printf ("\n   %d transitions, %d eigenstates\n\n", DC.DC_System.NumberOfTransitions,
+	        (int) DC.DC_Results.Eigenvalues.Nrows());
+	printf ("   Loops (MixTransitionMomentsLoops):   %10.2f ms\n", 1000 * TimeLoops);
+	printf ("   Product (MixEigenstates, CD and LD): %10.2f ms\n", 1000 * TimeProduct);
+	printf ("   Speed-up:                            %10.1f\n", TimeLoops / TimeProduct);
+	printf ("   Largest difference of the moments:   %10.2e  (largest moment %.2e)\n\n",
+	        Difference, Largest);
+	
+	return (Difference > 1E-10 * max (1.0, Largest)) ? 1 : 0;
+} // of main
@@ -0,0 +1,238 @@
+// #################################################################################################
+//
+//  Program:      components.cpp
+//
+//  Function:     Part of DichroCalc:
+//                The connected components of the Hamiltonian (--components): groups that are not
+//                coupled to each other, e.g. separate chains or groups beyond the outer cutoff,
+//                are diagonalized independently in smaller blocks
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// Two groups are connected if any coupling between their transitions is larger than
+// DC_Options.Components (in cm-1). The groups connected directly or via other groups form a
+// component, whose transitions are not mixed with those of any other component: after reordering
+// the rows the Hamiltonian is block-diagonal and each block can be diagonalized on its own, which
+// replaces one diagonalization of dimension n by a sum of much smaller ones. The eigenvectors of
+// the blocks are put back into the rows of their transitions (all other elements are zero), so
+// that everything after the diagonalization is unchanged.
+//
+// With the threshold 0 only couplings that are exactly zero separate the groups, e.g. those beyond
+// the outer cutoff (--outer-cutoff), and the eigenstates are exact. A larger threshold neglects
+// the weak couplings between the components, which the verbose output reports.
+
+
+class ComponentBlocks : public ParallelTask {   // the components, one part per component
+	public:
+		string                  Method;         // the eigensolver
+		vector< vector<int> >   Rows;           // the rows of the Hamiltonian of each component
+		vector<SymmetricMatrix> Block;          // the Hamiltonian of each component
+		vector<DiagonalMatrix>  Values;         // its eigenvalues
+		vector<Matrix>          Vectors;        // and eigenvectors
+		vector<int>             Failed;         // the return value of the eigensolver
+		
+		void Run ( int Part );
+};
+
+
+static int  ComponentRoot ( vector<int>* Parent, int Group );
+static bool LargerComponent ( const vector<int>& First, const vector<int>& Second );
+
+
+// ================================================================================
+
+
+static int ComponentRoot ( vector<int>* Parent, int Group )
+// the group representing the component of Group (union-find), shortens the path on the way
+{
+	while (Parent->at(Group) != Group) {
+		Parent->at(Group) = Parent->at(Parent->at(Group));
+		Group = Parent->at(Group);
+	}
+	
+	return Group;
+} // of ComponentRoot
+
+
+// ================================================================================
+
+
+static bool LargerComponent ( const vector<int>& First, const vector<int>& Second )
+// sorts the components by decreasing size, so that the threads start with the largest ones
+{
+	return First.size() > Second.size();
+} // of LargerComponent
+
+
+// ================================================================================
+
+
+int Dichro::ComponentEigensystem ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+                                   Matrix* Eigenvectors )
+// diagonalizes the connected components of the Hamiltonian independently, returns 1 without
+// changing the eigensystem if all groups are connected (the matrix is diagonalized as a whole)
+{
+	int Group, Row, Col, i, j, Part;
+	int N = Hamiltonian->Nrows();
+	int Groups = DC_System.NumberOfGroups;
+	double Threshold = DC_Options.Components;
+	
+	// the group of each row of the Hamiltonian
+	vector<int> RowGroup;
+	
+	for (Group = 0; Group < Groups; Group++)
+		RowGroup.insert (RowGroup.end(), DC_System.Groups.at(Group).NumberOfTransitions, Group);
+	
+	if (Groups < 2 or (int) RowGroup.size() != N) return 1;
+	
+	// join the groups of all couplings above the threshold
+	vector<int> Parent (Groups);
+	Real* Packed = Hamiltonian->Store();
+	
+	for (Group = 0; Group < Groups; Group++) Parent.at(Group) = Group;
+	
+	for (Row = 0; Row < N; Row++) {
+		for (Col = 0; Col < Row; Col++) {
+			if (RowGroup[Row] == RowGroup[Col] or fabs (Packed[Row*(Row+1)/2 + Col]) <= Threshold)
+				continue;
+			
+			int RowRoot = ComponentRoot (&Parent, RowGroup[Row]);
+			int ColRoot = ComponentRoot (&Parent, RowGroup[Col]);
+			
+			if (RowRoot != ColRoot) Parent.at(max (RowRoot, ColRoot)) = min (RowRoot, ColRoot);
+		}
+	}
+	
+	vector<int> Root (Groups);
+	
+	for (Group = 0; Group < Groups; Group++) Root.at(Group) = ComponentRoot (&Parent, Group);
+	
+	// the largest coupling left out between the components (only with a threshold)
+	double Neglected = 0.0;
+	
+	if (Threshold > 0.0) {
+		for (Row = 0; Row < N; Row++)
+			for (Col = 0; Col < Row; Col++)
+				if (Root[RowGroup[Row]] != Root[RowGroup[Col]])
+					Neglected = max (Neglected, (double) fabs (Packed[Row*(Row+1)/2 + Col]));
+	}
+	
+	// the rows of each component, in the order of the groups
+	vector<int> Component (Groups, -1);
+	ComponentBlocks Task;
+	
+	for (Row = 0; Row < N; Row++) {
+		Group = Root.at(RowGroup[Row]);
+		
+		if (Component.at(Group) < 0) {
+			Component.at(Group) = Task.Rows.size();
+			Task.Rows.push_back (vector<int> ());
+		}
+		
+		Task.Rows.at(Component.at(Group)).push_back (Row);
+	}
+	
+	int Parts = Task.Rows.size();
+	
+	if (Parts == 1) {
+		if (DC_Verbose) printf ("      All groups connected, no components\n");
+		return 1;
+	}
+	
+	stable_sort (Task.Rows.begin(), Task.Rows.end(), LargerComponent);
+	
+	Task.Method = DC_Options.Eigensolver;
+	Task.Block.resize (Parts);
+	Task.Values.resize (Parts);
+	Task.Vectors.resize (Parts);
+	Task.Failed.assign (Parts, 0);
+	
+	for (Part = 0; Part < Parts; Part++) {
+		vector<int>* Rows = &Task.Rows.at(Part);
+		SymmetricMatrix* Block = &Task.Block.at(Part);
+		
+		Block->ReSize (Rows->size());
+		
+		for (i = 0; i < (int) Rows->size(); i++)
+			for (j = 0; j <= i; j++)
+				Block->element (i, j) = Packed[Rows->at(i)*(Rows->at(i)+1)/2 + Rows->at(j)];
+	}
+	
+	int Threads = RunParallel (&Task, Parts, DC_Options.Threads);
+	
+	for (Part = 0; Part < Parts; Part++)
+		if (Task.Failed.at(Part) != 0) return Task.Failed.at(Part);
+	
+	if (DC_Verbose) {
+		printf ("      %d components of up to %d states, %d thread(s)\n", Parts,
+		        (int) Task.Rows.at(0).size(), Threads);
+		
+		if (Neglected > 0.0)
+			printf ("      Couplings up to %.3g cm-1 between the components neglected\n", Neglected);
+	}
+	
+	// all eigenvalues in ascending order, ties in the order of the components
+	vector< pair<double, int> > Order;
+	vector<int> First (Parts, 0);
+	
+	for (Part = 0; Part < Parts; Part++) {
+		if (Part > 0) First.at(Part) = First.at(Part-1) + Task.Rows.at(Part-1).size();
+		
+		for (i = 0; i < Task.Values.at(Part).Nrows(); i++)
+			Order.push_back (make_pair ((double) Task.Values.at(Part).element(i), First.at(Part) + i));
+	}
+	
+	stable_sort (Order.begin(), Order.end());
+	
+	// the component and the state within it of each position in Order
+	vector<int> StatePart (N), State (N);
+	
+	for (Part = 0; Part < Parts; Part++) {
+		for (i = 0; i < (int) Task.Rows.at(Part).size(); i++) {
+			StatePart.at(First.at(Part) + i) = Part;
+			State.at(First.at(Part) + i) = i;
+		}
+	}
+	
+	Eigenvalues->ReSize (N);
+	Eigenvectors->ReSize (N, N);
+	*Eigenvectors = 0.0;
+	
+	Real* Out = Eigenvectors->Store();
+	
+	for (Col = 0; Col < N; Col++) {
+		Part = StatePart.at(Order.at(Col).second);
+		i    = State.at(Order.at(Col).second);
+		
+		vector<int>* Rows = &Task.Rows.at(Part);
+		Matrix* Vectors = &Task.Vectors.at(Part);
+		
+		Eigenvalues->element(Col) = Order.at(Col).first;
+		
+		for (j = 0; j < (int) Rows->size(); j++)
+			Out[Rows->at(j)*N + Col] = Vectors->element (j, i);
+	}
+	
+	return 0;
+} // of Dichro::ComponentEigensystem
+
+
+// ================================================================================
+
+
+void ComponentBlocks::Run ( int Part )
+{
+	Failed.at(Part) = SymmetricEigensystem (Method, &Block.at(Part), &Values.at(Part),
+	                                        &Vectors.at(Part));
+} // of ComponentBlocks::Run
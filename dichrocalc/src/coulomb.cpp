@@ -0,0 +1,345 @@
+// #################################################################################################
+//
+//  Program:      coulomb.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Kernels for the Coulomb interaction of monopole charges
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <math.h>
+#include <float.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// The monopoles are passed as separate arrays of the x, y, z coordinates and the charges, the
+// inner loops then run over contiguous memory and are vectorized with AVX-512 (8 doubles) or
+// AVX2 (4 doubles), if the compiler was told to use them (make SIMD=avx512 or SIMD=avx2).
+// Otherwise the plain loops are used. Pairs of monopoles closer than the threshold are skipped
+// and only counted, the caller reports them.
+
+
+#if defined(__AVX512F__)
+static inline __m512d SquareRoot8 ( __m512d x );
+static inline double  Sum8 ( __m512d x );
+#endif
+
+
+// ================================================================================
+
+
+string CoulombKernel ( void )
+// returns the instruction set the kernels were compiled for
+{
+#if defined(__AVX512F__)
+	return "avx512";
+#elif defined(__AVX2__)
+	return "avx2";
+#else
+	return "scalar";
+#endif
+} // of CoulombKernel
+
+
+#if defined(__AVX512F__)
+
+// ================================================================================
+
+
+static inline __m512d SquareRoot8 ( __m512d x )
+// the square roots of 8 doubles, with x as the source of the (unused) masked lanes instead of the
+// undefined register of _mm512_sqrt_pd, which GCC reports as used uninitialized
+{
+	return _mm512_mask_sqrt_pd (x, (__mmask8) 0xFF, x);
+} // of SquareRoot8
+
+
+// ================================================================================
+
+
+static inline double Sum8 ( __m512d x )
+// the sum of 8 doubles, via the two halves like the AVX2 kernels (_mm512_reduce_add_pd extracts
+// them with an undefined source register, see SquareRoot8)
+{
+	__m256d Zero    = _mm256_setzero_pd ();
+	__m256d Quarter = _mm256_add_pd (_mm512_mask_extractf64x4_pd (Zero, (__mmask8) 0xF, x, 0),
+	                                 _mm512_mask_extractf64x4_pd (Zero, (__mmask8) 0xF, x, 1));
+	__m128d Half    = _mm_add_pd (_mm256_castpd256_pd128 (Quarter), _mm256_extractf128_pd (Quarter, 1));
+	
+	return _mm_cvtsd_f64 (_mm_add_sd (Half, _mm_unpackhi_pd (Half, Half)));
+} // of Sum8
+
+#endif
+
+
+// ================================================================================
+
+
+static inline void AddContact ( double Distance, int* Contacts, double* MinDistance )
+// counts a pair of monopoles below the distance threshold
+{
+	++*Contacts;
+	if (Distance < *MinDistance) *MinDistance = Distance;
+} // of AddContact
+
+
+// ================================================================================
+
+
+static inline double Distance ( double x1, double y1, double z1, double x2, double y2, double z2 )
+{
+	return sqrt ( (x2-x1) * (x2-x1) + (y2-y1) * (y2-y1) + (z2-z1) * (z2-z1) );
+} // of Distance
+
+
+// ================================================================================
+
+
+double CoulombInteraction ( const double* ix, const double* iy, const double* iz, const double* iq,
+                            int ni,
+                            const double* jx, const double* jy, const double* jz, const double* jq,
+                            int nj,
+                            double Threshold, int* Contacts, double* MinDistance )
+// the Coulomb interaction sum(i) sum(j) q(i) q(j) / r(ij) of two sets of monopoles
+{
+	int a, b;
+	double Interaction, Temp, r;
+	
+	Interaction = 0.0;
+	
+	for (a = 0; a < ni; a++) {
+		Temp = 0.0;
+		b = 0;
+
+#if defined(__AVX512F__)
+		__m512d xa  = _mm512_set1_pd (ix[a]);
+		__m512d ya  = _mm512_set1_pd (iy[a]);
+		__m512d za  = _mm512_set1_pd (iz[a]);
+		__m512d Thr = _mm512_set1_pd (Threshold);
+		__m512d Sum = _mm512_setzero_pd ();
+		
+		for ( ; b + 8 <= nj; b += 8) {
+			__m512d dx = _mm512_sub_pd (_mm512_loadu_pd (jx+b), xa);
+			__m512d dy = _mm512_sub_pd (_mm512_loadu_pd (jy+b), ya);
+			__m512d dz = _mm512_sub_pd (_mm512_loadu_pd (jz+b), za);
+			__m512d r2 = _mm512_mul_pd (dx, dx);
+			r2 = _mm512_fmadd_pd (dy, dy, r2);
+			r2 = _mm512_fmadd_pd (dz, dz, r2);
+			__m512d rv = SquareRoot8 (r2);
+			
+			__mmask8 Close = _mm512_cmp_pd_mask (rv, Thr, _CMP_LT_OQ);
+			Sum = _mm512_mask_add_pd (Sum, (__mmask8) ~Close, Sum,
+			                          _mm512_div_pd (_mm512_loadu_pd (jq+b), rv));
+			
+			if (Close) {
+				for (int Lane = 0; Lane < 8; Lane++)
+					if (Close & (1 << Lane))
+						AddContact (Distance (ix[a], iy[a], iz[a], jx[b+Lane], jy[b+Lane], jz[b+Lane]),
+						            Contacts, MinDistance);
+			}
+		}
+		
+		Temp = Sum8 (Sum);
+#elif defined(__AVX2__)
+		__m256d xa  = _mm256_set1_pd (ix[a]);
+		__m256d ya  = _mm256_set1_pd (iy[a]);
+		__m256d za  = _mm256_set1_pd (iz[a]);
+		__m256d Thr = _mm256_set1_pd (Threshold);
+		__m256d Sum = _mm256_setzero_pd ();
+		
+		for ( ; b + 4 <= nj; b += 4) {
+			__m256d dx = _mm256_sub_pd (_mm256_loadu_pd (jx+b), xa);
+			__m256d dy = _mm256_sub_pd (_mm256_loadu_pd (jy+b), ya);
+			__m256d dz = _mm256_sub_pd (_mm256_loadu_pd (jz+b), za);
+			__m256d r2 = _mm256_mul_pd (dx, dx);
+			r2 = _mm256_fmadd_pd (dy, dy, r2);
+			r2 = _mm256_fmadd_pd (dz, dz, r2);
+			__m256d rv = _mm256_sqrt_pd (r2);
+			
+			__m256d Close = _mm256_cmp_pd (rv, Thr, _CMP_LT_OQ);
+			Sum = _mm256_add_pd (Sum,
+			         _mm256_andnot_pd (Close, _mm256_div_pd (_mm256_loadu_pd (jq+b), rv)));
+			
+			int Mask = _mm256_movemask_pd (Close);
+			
+			if (Mask) {
+				for (int Lane = 0; Lane < 4; Lane++)
+					if (Mask & (1 << Lane))
+						AddContact (Distance (ix[a], iy[a], iz[a], jx[b+Lane], jy[b+Lane], jz[b+Lane]),
+						            Contacts, MinDistance);
+			}
+		}
+		
+		__m128d Half = _mm_add_pd (_mm256_castpd256_pd128 (Sum), _mm256_extractf128_pd (Sum, 1));
+		Temp = _mm_cvtsd_f64 (_mm_add_sd (Half, _mm_unpackhi_pd (Half, Half)));
+#endif
+
+		for ( ; b < nj; b++) {
+			r = Distance (ix[a], iy[a], iz[a], jx[b], jy[b], jz[b]);
+			
+			if (r < Threshold)
+				AddContact (r, Contacts, MinDistance);
+			else
+				Temp += jq[b] / r;
+		}
+		
+		Interaction += iq[a] * Temp;
+	}
+	
+	return Interaction;
+} // of CoulombInteraction
+
+
+// ================================================================================
+
+
+void InverseDistances ( const double* ix, const double* iy, const double* iz, int ni,
+                        const double* jx, const double* jy, const double* jz, int nj,
+                        double Threshold, double* InvR, int* Contacts, double* MinDistance )
+// fills the ni x nj matrix InvR (row-wise) with the inverse distances of two sets of points,
+// pairs closer than the threshold are set to 0
+{
+	int a, b;
+	double r;
+	
+	for (a = 0; a < ni; a++) {
+		double* Row = &InvR[a * nj];
+		b = 0;
+
+#if defined(__AVX512F__)
+		__m512d xa  = _mm512_set1_pd (ix[a]);
+		__m512d ya  = _mm512_set1_pd (iy[a]);
+		__m512d za  = _mm512_set1_pd (iz[a]);
+		__m512d Thr = _mm512_set1_pd (Threshold);
+		__m512d One = _mm512_set1_pd (1.0);
+		
+		for ( ; b + 8 <= nj; b += 8) {
+			__m512d dx = _mm512_sub_pd (_mm512_loadu_pd (jx+b), xa);
+			__m512d dy = _mm512_sub_pd (_mm512_loadu_pd (jy+b), ya);
+			__m512d dz = _mm512_sub_pd (_mm512_loadu_pd (jz+b), za);
+			__m512d r2 = _mm512_mul_pd (dx, dx);
+			r2 = _mm512_fmadd_pd (dy, dy, r2);
+			r2 = _mm512_fmadd_pd (dz, dz, r2);
+			__m512d rv = SquareRoot8 (r2);
+			
+			__mmask8 Close = _mm512_cmp_pd_mask (rv, Thr, _CMP_LT_OQ);
+			_mm512_storeu_pd (Row+b, _mm512_mask_div_pd (_mm512_setzero_pd (), (__mmask8) ~Close, One, rv));
+			
+			if (Close) {
+				for (int Lane = 0; Lane < 8; Lane++)
+					if (Close & (1 << Lane))
+						AddContact (Distance (ix[a], iy[a], iz[a], jx[b+Lane], jy[b+Lane], jz[b+Lane]),
+						            Contacts, MinDistance);
+			}
+		}
+#elif defined(__AVX2__)
+		__m256d xa  = _mm256_set1_pd (ix[a]);
+		__m256d ya  = _mm256_set1_pd (iy[a]);
+		__m256d za  = _mm256_set1_pd (iz[a]);
+		__m256d Thr = _mm256_set1_pd (Threshold);
+		__m256d One = _mm256_set1_pd (1.0);
+		
+		for ( ; b + 4 <= nj; b += 4) {
+			__m256d dx = _mm256_sub_pd (_mm256_loadu_pd (jx+b), xa);
+			__m256d dy = _mm256_sub_pd (_mm256_loadu_pd (jy+b), ya);
+			__m256d dz = _mm256_sub_pd (_mm256_loadu_pd (jz+b), za);
+			__m256d r2 = _mm256_mul_pd (dx, dx);
+			r2 = _mm256_fmadd_pd (dy, dy, r2);
+			r2 = _mm256_fmadd_pd (dz, dz, r2);
+			__m256d rv = _mm256_sqrt_pd (r2);
+			
+			__m256d Close = _mm256_cmp_pd (rv, Thr, _CMP_LT_OQ);
+			_mm256_storeu_pd (Row+b, _mm256_andnot_pd (Close, _mm256_div_pd (One, rv)));
+			
+			int Mask = _mm256_movemask_pd (Close);
+			
+			if (Mask) {
+				for (int Lane = 0; Lane < 4; Lane++)
+					if (Mask & (1 << Lane))
+						AddContact (Distance (ix[a], iy[a], iz[a], jx[b+Lane], jy[b+Lane], jz[b+Lane]),
+						            Contacts, MinDistance);
+			}
+		}
+#endif
+
+		for ( ; b < nj; b++) {
+			r = Distance (ix[a], iy[a], iz[a], jx[b], jy[b], jz[b]);
+			
+			if (r < Threshold) {
+				AddContact (r, Contacts, MinDistance);
+				Row[b] = 0.0;
+			}
+			else
+				Row[b] = 1.0 / r;
+		}
+	}
+} // of InverseDistances
+
+
+// ================================================================================
+
+
+double DotProduct ( const double* a, const double* b, int n )
+// the dot product of two arrays
+{
+	int i = 0;
+	double Sum = 0.0;
+
+#if defined(__AVX512F__)
+	__m512d Partial = _mm512_setzero_pd ();
+	
+	for ( ; i + 8 <= n; i += 8)
+		Partial = _mm512_fmadd_pd (_mm512_loadu_pd (a+i), _mm512_loadu_pd (b+i), Partial);
+	
+	Sum = Sum8 (Partial);
+#elif defined(__AVX2__)
+	__m256d Sum4 = _mm256_setzero_pd ();
+	
+	for ( ; i + 4 <= n; i += 4)
+		Sum4 = _mm256_fmadd_pd (_mm256_loadu_pd (a+i), _mm256_loadu_pd (b+i), Sum4);
+	
+	__m128d Half = _mm_add_pd (_mm256_castpd256_pd128 (Sum4), _mm256_extractf128_pd (Sum4, 1));
+	Sum = _mm_cvtsd_f64 (_mm_add_sd (Half, _mm_unpackhi_pd (Half, Half)));
+#endif
+
+	for ( ; i < n; i++) Sum += a[i] * b[i];
+	
+	return Sum;
+} // of DotProduct
+
+
+// ================================================================================
+
+
+void CoulombBlock ( const double* InvR, int ni, int nj,
+                    const double* iq, int iTrans, const double* jq, int jTrans,
+                    double* Temp, double* Block )
+// Calculates the interactions of all transitions of two groups at once. The charges of each
+// transition are given at all sites of its group (iq is iTrans x ni, jq is jTrans x nj, row-
+// wise), InvR holds the inverse distances of the sites. Temp needs jTrans x ni elements, the
+// iTrans x jTrans interactions are returned in Block (row-wise).
+{
+	int a, t, u;
+	
+	// the potential of each transition of the second group at the sites of the first one
+	for (u = 0; u < jTrans; u++)
+		for (a = 0; a < ni; a++)
+			Temp[u*ni + a] = DotProduct (&InvR[a*nj], &jq[u*nj], nj);
+	
+	for (t = 0; t < iTrans; t++)
+		for (u = 0; u < jTrans; u++)
+			Block[t*jTrans + u] = DotProduct (&iq[t*ni], &Temp[u*ni], ni);
+} // of CoulombBlock
+
+
+// ================================================================================
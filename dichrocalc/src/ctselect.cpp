@@ -0,0 +1,240 @@
+// #################################################################################################
+//
+//  Program:      ctselect.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Selection of the charge-transfer parameter sets by the backbone dihedral angles
+//                of the current coordinates (--ct-select)
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <map>
+#include <algorithm>
+
+
+// Each CT parameter set in chromophores.dat belongs to a pair of phi and psi angles and dcinput
+// assigns the closest one to each dipeptide. With --ct-select all CT sets of chromophores.dat
+// are read once together with the sets of the input file and the set of each CT chromophore is
+// chosen again from its phi and psi, for the input coordinates or for each frame of a
+// trajectory. The C-alpha atom needed for the angles is taken from the coordinates, the other
+// atoms (C, N of both peptide bonds) are those of the chromophore.
+
+
+// ================================================================================
+
+
+int Dichro::PrepareChargeTransfer ( void )
+// reads the CT sets of chromophores.dat, adds them to DC_Input.Parameters and finds the CT
+// chromophores and their C-alpha atoms
+{
+	map<string, vector<double> > Angles;
+	map<string, vector<double> >::iterator Set;
+	vector<string> Fields;
+	string Filename = "chromophores.dat";
+	string Line;
+	unsigned int Group, Type, Atom;
+	int Trans = -1;
+	
+	DC_ChargeTransfer.Sets.clear();
+	DC_ChargeTransfer.Phi.clear();
+	DC_ChargeTransfer.Psi.clear();
+	DC_ChargeTransfer.Groups.clear();
+	DC_ChargeTransfer.CA.clear();
+	
+	if (DC_Verbose) Dichro::NewTask ( "Selecting Charge-Transfer Parameters" );
+	
+	// the CT chromophores and the number of transitions used for them in the input file
+	for (Group = 0; Group < DC_Input.Chromophores.Type.size(); Group++) {
+		Type = DC_Input.Chromophores.Type.at(Group);
+		
+		// an invalid type is reported by CheckInputData
+		if (Type >= DC_Input.Parameters.Name.size()) continue;
+		
+		if (DC_Input.Parameters.Name.at(Type).substr (0, 2) != "CT") continue;
+		if (DC_Input.Chromophores.Atoms.at(Group).size() != 6) continue;
+		
+		if (Trans < 0) Trans = DC_Input.Parameters.Trans.at(Type);
+		
+		DC_ChargeTransfer.Groups.push_back (Group);
+	}
+	
+	if (DC_ChargeTransfer.Groups.size() == 0) {
+		Warnings.push_back ("--ct-select: no charge-transfer chromophores in the input file");
+		if (DC_Verbose) printf ("   No charge-transfer chromophores\n");
+		return 0;
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	// like dcinput, chromophores.dat is read from the current directory or ~/bin
+	if ( not FileExists (Filename) and getenv ("HOME") != NULL )
+		Filename = string (getenv ("HOME")) + "/bin/chromophores.dat";
+	
+	ifstream File (Filename.c_str(), ios::in);
+	
+	if ( not File ) {
+		cerr << "\nERROR: chromophores.dat with the CT parameter sets was not found (--ct-select).\n\n";
+		DC_Error     = "chromophores.dat not found";
+		DC_ErrorCode = 170;
+		return 170;
+	}
+	
+	while (getline (File, Line)) {
+		TrimSpaces (&Line);
+		
+		if (Line.size() == 0 or Line.at(0) == '#') continue;
+		
+		SplitString (Line, Fields, " \t");
+		
+		if (Fields.size() < 5 or Fields.at(1) != "CTR") continue;
+		
+		Angles[Fields.at(0)].assign (1, atof (Fields.at(3).c_str()));
+		Angles[Fields.at(0)].push_back (atof (Fields.at(4).c_str()));
+	}
+	
+	File.close();
+	
+	if (Angles.size() == 0) {
+		cerr << "\nERROR: No CT parameter sets (type CTR) found in " << Filename << ".\n\n";
+		DC_Error     = "No CT parameter sets in chromophores.dat";
+		DC_ErrorCode = 170;
+		return 170;
+	}
+	
+	// the sets sorted by name, the first one of equally close sets is taken (as by dcinput)
+	for (Set = Angles.begin(); Set != Angles.end(); ++Set) {
+		Type = find (DC_Input.Parameters.Name.begin(), DC_Input.Parameters.Name.end(), Set->first)
+		       - DC_Input.Parameters.Name.begin();
+		
+		// the sets not in the input file are read with the same number of transitions
+		if (Type == DC_Input.Parameters.Name.size()) {
+			DC_Input.Parameters.Name.push_back (Set->first);
+			DC_Input.Parameters.Trans.push_back (Trans);
+		}
+		
+		DC_ChargeTransfer.Sets.push_back (Type);
+		DC_ChargeTransfer.Phi.push_back (Set->second.at(0));
+		DC_ChargeTransfer.Psi.push_back (Set->second.at(1));
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	// the C-alpha between the N of the first and the C of the second peptide bond
+	for (Group = 0; Group < DC_ChargeTransfer.Groups.size(); Group++) {
+		vector<int>* Atoms = &DC_Input.Chromophores.Atoms.at(DC_ChargeTransfer.Groups.at(Group));
+		double Smallest = 4.0;   // N-CA + CA-C is about 3 Angstrom
+		int CA = -1;
+		
+		if (Atoms->at(2) >= (int) DC_Input.Coordinates.Number() or
+		    Atoms->at(3) >= (int) DC_Input.Coordinates.Number()) {
+			DC_ChargeTransfer.CA.push_back (-1);
+			continue;
+		}
+		
+		double* N = DC_Input.Coordinates.Coord (Atoms->at(2));
+		double* C = DC_Input.Coordinates.Coord (Atoms->at(3));
+		
+		for (Atom = 0; Atom < DC_Input.Coordinates.Number(); Atom++) {
+			if (DC_Input.Coordinates.Labels.at(Atom) != "CA") continue;
+			
+			double* Coord = DC_Input.Coordinates.Coord (Atom);
+			double Distance = 0.0;
+			
+			for (int Pair = 0; Pair < 2; Pair++) {
+				double* Peptide = (Pair == 0) ? N : C;
+				
+				Distance += sqrt ( pow (Coord[0] - Peptide[0], 2) + pow (Coord[1] - Peptide[1], 2)
+				                 + pow (Coord[2] - Peptide[2], 2) );
+			}
+			
+			if (Distance < Smallest) {
+				Smallest = Distance;
+				CA = Atom;
+			}
+		}
+		
+		if (CA < 0)
+			Warnings.push_back ("--ct-select: no C-alpha atom found for chromophore "
+			                    + tostring (DC_ChargeTransfer.Groups.at(Group) + 1)
+			                    + ", its parameter set is kept");
+		
+		DC_ChargeTransfer.CA.push_back (CA);
+	}
+	
+	if (DC_Verbose)
+		printf ("   %d CT chromophores, %d CT parameter sets in %s\n",
+		        (int) DC_ChargeTransfer.Groups.size(), (int) DC_ChargeTransfer.Sets.size(),
+		        Filename.c_str());
+	
+	return 0;
+} // of Dichro::PrepareChargeTransfer
+
+
+// ================================================================================
+
+
+int Dichro::SelectChargeTransfer ( void )
+// assigns the CT parameter set closest in phi and psi to each CT chromophore and returns the
+// number of chromophores whose set has changed
+{
+	unsigned int Group, Set;
+	int Changed = 0;
+	
+	for (Group = 0; Group < DC_ChargeTransfer.Groups.size(); Group++) {
+		int Chromophore = DC_ChargeTransfer.Groups.at(Group);
+		int CA = DC_ChargeTransfer.CA.at(Group);
+		vector<int>* Atoms = &DC_Input.Chromophores.Atoms.at(Chromophore);
+		
+		if (CA < 0 or CA >= (int) DC_Input.Coordinates.Number()) continue;
+		if (*max_element (Atoms->begin(), Atoms->end()) >= (int) DC_Input.Coordinates.Number()) continue;
+		
+		// phi: C(i-1) N(i) CA(i) C(i), psi: N(i) CA(i) C(i) N(i+1)
+		double Phi = DihedralAngle (DC_Input.Coordinates.Coord (Atoms->at(0)),
+		                            DC_Input.Coordinates.Coord (Atoms->at(2)),
+		                            DC_Input.Coordinates.Coord (CA),
+		                            DC_Input.Coordinates.Coord (Atoms->at(3)));
+		double Psi = DihedralAngle (DC_Input.Coordinates.Coord (Atoms->at(2)),
+		                            DC_Input.Coordinates.Coord (CA),
+		                            DC_Input.Coordinates.Coord (Atoms->at(3)),
+		                            DC_Input.Coordinates.Coord (Atoms->at(5)));
+		
+		if (Phi > 180 or Psi > 180) continue;
+		
+		double Smallest = 100000;
+		int Best = -1;
+		
+		for (Set = 0; Set < DC_ChargeTransfer.Sets.size(); Set++) {
+			double dPhi = fabs (Phi - DC_ChargeTransfer.Phi.at(Set));
+			double dPsi = fabs (Psi - DC_ChargeTransfer.Psi.at(Set));
+			
+			if (dPhi > 180) dPhi = 360 - dPhi;
+			if (dPsi > 180) dPsi = 360 - dPsi;
+			
+			if (dPhi + dPsi < Smallest) {
+				Smallest = dPhi + dPsi;
+				Best = DC_ChargeTransfer.Sets.at(Set);
+			}
+		}
+		
+		if (Best != DC_Input.Chromophores.Type.at(Chromophore)) {
+			DC_Input.Chromophores.Type.at(Chromophore) = Best;
+			++Changed;
+		}
+	}
+	
+	if (DC_Verbose and DC_ChargeTransfer.Groups.size() > 0)
+		printf ("   %d of %d CT parameter sets changed\n", Changed, (int) DC_ChargeTransfer.Groups.size());
+	
+	return Changed;
+} // of Dichro::SelectChargeTransfer
+
+
+// ================================================================================
+
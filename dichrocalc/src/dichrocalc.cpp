@@ -45,6 +45,10 @@ class CommandLineArguments {
 		bool   PrintMat;
 		string InFile;
 		string Params;
+		string Library;                       // --compile-params: the library to write
+		string BinaryInput;                   // --binary-input: the binary input file to write
+		
+		Dichro::CalculationOptions Options;   // settings of the calculation itself
 };
 
 CommandLineArguments GlobalArgs;
@@ -63,6 +67,28 @@ void PrintArguments ( void )
 	     << "PrintPol = " << GlobalArgs.PrintPol << endl
 	     << "PrintMat = " << GlobalArgs.PrintMat << endl
 	     << "Debug    = " << GlobalArgs.Debug    << endl
+	     << "Solver   = " << GlobalArgs.Options.Eigensolver << endl
+	     << "Threads  = " << GlobalArgs.Options.Threads << endl
+	     << "Cutoff   = " << GlobalArgs.Options.Cutoff << " / " << GlobalArgs.Options.OuterCutoff << endl
+	     << "Window   = " << GlobalArgs.Options.Window << endl
+	     << "Frames   = " << GlobalArgs.Options.Frames << endl
+	     << "SvdFit   = " << GlobalArgs.Options.SvdFit << endl
+	     << "Assign   = " << GlobalArgs.Options.Assign << endl
+	     << "CTSelect = " << GlobalArgs.Options.CTSelect << endl
+	     << "Stride   = " << GlobalArgs.Options.Stride << " (" << GlobalArgs.Options.FirstFrame
+	                      << " - " << GlobalArgs.Options.LastFrame << ")" << endl
+	     << "Bands    = " << GlobalArgs.Options.Bandshape << " (" << GlobalArgs.Options.Bandwidth
+	                      << " nm, " << GlobalArgs.Options.BandStep << " nm)" << endl
+	     << "Average  = " << GlobalArgs.Options.Average << endl
+	     << "Disorder = " << GlobalArgs.Options.Disorder << " (" << GlobalArgs.Options.Realizations
+	                      << " realizations, seed " << GlobalArgs.Options.Seed << ")" << endl
+	     << "Shift    = " << GlobalArgs.Options.ShiftSet << " " << GlobalArgs.Options.ShiftTrans
+	                      << " (" << GlobalArgs.Options.ShiftFirst << " - " << GlobalArgs.Options.ShiftLast
+	                      << ", " << GlobalArgs.Options.ShiftStep << ")" << endl
+	     << "Repeats  = " << GlobalArgs.Options.Repeats << " (periodic " << GlobalArgs.Options.Periodic << ")" << endl
+	     << "Comps    = " << GlobalArgs.Options.Components << endl
+	     << "Library  = " << GlobalArgs.Library << endl
+	     << "Binary   = " << GlobalArgs.BinaryInput << endl
 	     << "\n\n";
 	return;
 } // of PrintArguments
@@ -82,6 +108,50 @@ int Usage ( void )
 	cout << "            --vec              create .vec file (for absorbance/LD)\n";
 	cout << "            --pol              create .pol file (transition polarizations)\n";
 	cout << "            --mat              create .mat file (matrix, eigenvectors, eigenvalues)\n";
+	cout << "       -e , --eigensolver m    method to diagonalize the Hamiltonian:\n";
+	cout << "                               " << EigensolverList () << " (default jacobi)\n";
+	cout << "            --compare          compare the eigensystem with the Jacobi reference\n";
+	cout << "       -t , --threads n        threads to set up the matrix (default 1, 0 = all cores)\n";
+	cout << "       -c , --cutoff r         exact couplings only within r Angstrom, multipoles beyond\n";
+	cout << "            --outer-cutoff r   neglect couplings beyond r Angstrom\n";
+	cout << "       -w , --window           sparse matrix, only the states within MinWL-MaxWL\n";
+	cout << "       -f , --frames file|dir  trajectory: the coordinates of all frames, a file with\n";
+	cout << "                               $COORDINATES blocks or a directory with .inp files,\n";
+	cout << "                               a PDB file with several models or a DCD file\n";
+	cout << "            --stride n         trajectory: calculate only every n-th frame\n";
+	cout << "            --range first:last  trajectory: the frames to calculate (from 0), e.g.\n";
+	cout << "                               100:199, 100: or :199\n";
+	cout << "            --bandshape type   convolute the line spectra with gauss, lorentz or approx\n";
+	cout << "                               (approximate Lorentzian) bands to .cd (and .ab, .ld\n";
+	cout << "                               with --vec) from MinWL to MaxWL (default 150-350)\n";
+	cout << "            --bandwidth w      the band width in nm (default 12.5)\n";
+	cout << "            --band-step s      the interval of the wavelengths in nm (default 0.1)\n";
+	cout << "            --average          trajectory: write only the average of the band spectra\n";
+	cout << "                               of all frames with the standard error (.avg.cd)\n";
+	cout << "            --disorder w       average over Gaussian site energies with the standard\n";
+	cout << "                               deviation w in cm-1, the couplings are calculated once\n";
+	cout << "            --realizations n   disorder: the number of realizations (default 100)\n";
+	cout << "            --seed s           disorder: the seed of the random energies (default 1)\n";
+	cout << "            --shift set:trans:first:last:step  the spectra with the energy of transition\n";
+	cout << "                               trans (from 1, 0 = all) of a parameter set shifted from\n";
+	cout << "                               first to last cm-1, e.g. NMA4FIT2:1:-1000:1000:250\n";
+	cout << "            --repeats n        the groups are n identical units of a ring, helix or\n";
+	cout << "                               fibril: only the couplings of one unit are calculated\n";
+	cout << "                               and a ring is diagonalized in blocks (FFT)\n";
+	cout << "            --periodic         repeats: an open helix or fibril is treated as periodic\n";
+	cout << "                               (no end effects) and diagonalized in blocks as well\n";
+	cout << "            --components t     diagonalize the groups not coupled to each other (by\n";
+	cout << "                               more than t cm-1, 0 = exact) in separate blocks\n";
+	cout << "            --svd-fit          fit the parameter sets with the SVD (original method)\n";
+	cout << "            --ct-select        choose the CT parameter sets by phi and psi of the\n";
+	cout << "                               coordinates (of each frame), see chromophores.dat\n";
+	cout << "            --compile-params file  write all parameter sets of the directory given\n";
+	cout << "                               with -p to a binary library, which can then be used\n";
+	cout << "                               instead of the directory (-p file)\n";
+	cout << "            --binary-input file  convert the input file given with -i to a binary\n";
+	cout << "                               input file (.inb), which can then be used with -i\n";
+	cout << "            --assign \"switches\"  the dcinput switches to assign the chromophores of a\n";
+	cout << "                               PDB file given with -i (e.g. --assign \"-ct -sc\")\n";
 	cout << "       -h , --help, -?         usage output\n";
 	cout << "\n";
 	return 0;
@@ -95,8 +165,10 @@ int ProcessCommandLineOptions ( int argc, char **argv )
 {
 	int NextOption;
 	vector<string> FileNames;
+	string Range;
+	vector<string> Fields;
 	
-	const char *const ShortOptions = "h?vd:i:p:";
+	const char *const ShortOptions = "h?vwd:i:p:e:t:c:f:";
 	const struct option LongOptions[] = {
 		// if NULL is given in the 3rd column, the value in the 4th column is returned if the
 		// long option is found
@@ -108,6 +180,31 @@ int ProcessCommandLineOptions ( int argc, char **argv )
 		{ "vec",     no_argument,       NULL,  1  },
 		{ "pol",     no_argument,       NULL,  2  },
 		{ "mat",     no_argument,       NULL,  3  },
+		{ "eigensolver", required_argument, NULL, 'e' },
+		{ "compare",     no_argument,       NULL,  4  },
+		{ "threads",     required_argument, NULL, 't' },
+		{ "cutoff",       required_argument, NULL, 'c' },
+		{ "outer-cutoff", required_argument, NULL,  5  },
+		{ "window",       no_argument,       NULL, 'w' },
+		{ "frames",       required_argument, NULL, 'f' },
+		{ "svd-fit",      no_argument,       NULL,  6  },
+		{ "compile-params", required_argument, NULL,  7  },
+		{ "binary-input",   required_argument, NULL,  8  },
+		{ "assign",         required_argument, NULL,  9  },
+		{ "ct-select",      no_argument,       NULL, 10  },
+		{ "stride",         required_argument, NULL, 11  },
+		{ "range",          required_argument, NULL, 12  },
+		{ "bandshape",      required_argument, NULL, 13  },
+		{ "bandwidth",      required_argument, NULL, 14  },
+		{ "band-step",      required_argument, NULL, 15  },
+		{ "average",        no_argument,       NULL, 16  },
+		{ "disorder",       required_argument, NULL, 17  },
+		{ "realizations",   required_argument, NULL, 18  },
+		{ "seed",           required_argument, NULL, 19  },
+		{ "shift",          required_argument, NULL, 20  },
+		{ "repeats",        required_argument, NULL, 21  },
+		{ "components",     required_argument, NULL, 22  },
+		{ "periodic",       no_argument,       NULL, 23  },
 		{ NULL,      no_argument,       NULL,  0  },
 	};
 	
@@ -124,6 +221,131 @@ int ProcessCommandLineOptions ( int argc, char **argv )
 			case 3:
 				GlobalArgs.PrintMat = true;
 				break;
+			case 4:
+				GlobalArgs.Options.CompareSolvers = true;
+				break;
+			case 'e':
+				GlobalArgs.Options.Eigensolver = string (optarg);
+				
+				if ( ! EigensolverAvailable ( GlobalArgs.Options.Eigensolver ) ) {
+					cerr << "\nERROR: Unknown eigensolver " << GlobalArgs.Options.Eigensolver
+					     << " (available: " << EigensolverList () << ").\n\n";
+					return 20;
+				}
+				
+				break;
+			case 't':
+				GlobalArgs.Options.Threads = atoi (optarg);
+				break;
+			case 'c':
+				GlobalArgs.Options.Cutoff = atof (optarg);
+				break;
+			case 5:
+				GlobalArgs.Options.OuterCutoff = atof (optarg);
+				break;
+			case 'w':
+				GlobalArgs.Options.Window = true;
+				break;
+			case 'f':
+				GlobalArgs.Options.Frames = string (optarg);
+				break;
+			case 6:
+				GlobalArgs.Options.SvdFit = true;
+				break;
+			case 7:
+				GlobalArgs.Library = string (optarg);
+				break;
+			case 8:
+				GlobalArgs.BinaryInput = string (optarg);
+				break;
+			case 9:
+				GlobalArgs.Options.Assign = string (optarg);
+				break;
+			case 10:
+				GlobalArgs.Options.CTSelect = true;
+				break;
+			case 11:
+				GlobalArgs.Options.Stride = atoi (optarg);
+				break;
+			case 12:
+				Range = string (optarg);
+				
+				if (Range.find (":") == string::npos) {
+					cerr << "\nERROR: The frames have to be given as first:last (--range).\n\n";
+					return 20;
+				}
+				
+				if (Range.find (":") > 0)
+					GlobalArgs.Options.FirstFrame = atoi (Range.substr (0, Range.find (":")).c_str());
+				
+				if (Range.find (":") < Range.size() - 1)
+					GlobalArgs.Options.LastFrame  = atoi (Range.substr (Range.find (":") + 1).c_str());
+				
+				break;
+			case 13:
+				GlobalArgs.Options.Bandshape = string (optarg);
+				
+				if (GlobalArgs.Options.Bandshape != "gauss" and GlobalArgs.Options.Bandshape != "lorentz"
+				    and GlobalArgs.Options.Bandshape != "approx") {
+					cerr << "\nERROR: Unknown band shape " << GlobalArgs.Options.Bandshape
+					     << " (available: gauss, lorentz, approx).\n\n";
+					return 20;
+				}
+				
+				break;
+			case 14:
+				GlobalArgs.Options.Bandwidth = atof (optarg);
+				break;
+			case 15:
+				GlobalArgs.Options.BandStep = atof (optarg);
+				break;
+			case 16:
+				GlobalArgs.Options.Average = true;
+				break;
+			case 17:
+				GlobalArgs.Options.Disorder = atof (optarg);
+				break;
+			case 18:
+				GlobalArgs.Options.Realizations = atoi (optarg);
+				break;
+			case 19:
+				GlobalArgs.Options.Seed = atoi (optarg);
+				break;
+			case 20:
+				SplitString (string (optarg), Fields, ":");
+				
+				if (Fields.size() != 5) {
+					cerr << "\nERROR: The shifts have to be given as set:trans:first:last:step (--shift).\n\n";
+					return 20;
+				}
+				
+				GlobalArgs.Options.ShiftSet   = Fields.at(0);
+				GlobalArgs.Options.ShiftTrans = atoi (Fields.at(1).c_str());
+				GlobalArgs.Options.ShiftFirst = atof (Fields.at(2).c_str());
+				GlobalArgs.Options.ShiftLast  = atof (Fields.at(3).c_str());
+				GlobalArgs.Options.ShiftStep  = atof (Fields.at(4).c_str());
+				break;
+			case 21:
+				GlobalArgs.Options.Repeats = atoi (optarg);
+				
+				if (GlobalArgs.Options.Repeats < 2) {
+					cerr << "\nERROR: At least two repeat units are needed (--repeats).\n\n";
+					return 20;
+				}
+				
+				break;
+			case 22:
+				GlobalArgs.Options.Components = atof (optarg);
+				
+				if (GlobalArgs.Options.Components < 0.0) {
+					cerr << "\nERROR: The coupling threshold of the components cannot be negative (--components).\n\n";
+					return 20;
+				}
+				
+				break;
+			case 23:
+				GlobalArgs.Options.Periodic = true;
+				break;
 			case 'i':
 				GlobalArgs.InFile = string (optarg);
 				
@@ -158,11 +380,38 @@ int ProcessCommandLineOptions ( int argc, char **argv )
 	} while (NextOption != -1);
 	
 	// check for mandatory parameters
-	if (GlobalArgs.InFile == "")  {
+	if (GlobalArgs.InFile == "" and GlobalArgs.Library == "")  {
 		cerr << "\nERROR: No input file given via -i or --input.\n\n";
 		return 15;
 	}
 	
+	if (GlobalArgs.Options.Frames.size() > 0 and
+	    (GlobalArgs.Options.Disorder > 0.0 or GlobalArgs.Options.ShiftSet.size() > 0)) {
+		cerr << "\nERROR: --disorder and --shift cannot be combined with a trajectory (--frames).\n\n";
+		return 20;
+	}
+	
+	if (GlobalArgs.Options.Average and GlobalArgs.Options.Frames.size() == 0 and
+	    GlobalArgs.Options.Disorder <= 0.0 and GlobalArgs.Options.ShiftSet.size() == 0) {
+		cerr << "\nERROR: --average needs a trajectory (--frames) or an ensemble (--disorder, --shift).\n\n";
+		return 20;
+	}
+	
+	if (GlobalArgs.Options.Periodic and GlobalArgs.Options.Repeats == 0) {
+		cerr << "\nERROR: --periodic needs the repeat units (--repeats).\n\n";
+		return 20;
+	}
+	
+	if (GlobalArgs.Options.Repeats > 0 and GlobalArgs.Options.Window) {
+		cerr << "\nERROR: --repeats cannot be combined with the window mode (--window).\n\n";
+		return 20;
+	}
+	
+	if (GlobalArgs.Options.Components >= 0.0 and GlobalArgs.Options.Window) {
+		cerr << "\nERROR: --components cannot be combined with the window mode (--window).\n\n";
+		return 20;
+	}
+	
 	return 0;
 } // of ProcessCommandLineOptions
 
@@ -191,6 +440,29 @@ int main ( int argc, char **argv )
 	
 	// PrintArguments ();
 	
+	// only the parameter library is written, no calculation
+	if (GlobalArgs.Library.size() > 0) {
+		if (GlobalArgs.Verbose) cout << "\nCompiling Parameter Library\n\n";
+		
+		Dichro Library (GlobalArgs.Params);
+		Library.DC_Verbose = GlobalArgs.Verbose;
+		
+		return (Library.WriteParameterLibrary (GlobalArgs.Library) == 0) ? 0 : 30;
+	}
+	
+	// only the input file is converted, no calculation
+	if (GlobalArgs.BinaryInput.size() > 0) {
+		Dichro Converter (GlobalArgs.Params);
+		Converter.DC_Verbose = GlobalArgs.Verbose;
+		Converter.DC_InFile  = GlobalArgs.InFile;
+		Converter.DC_Options = GlobalArgs.Options;
+		
+		if (Converter.ReadInput () != 0) return 30;
+		
+		return (Converter.WriteBinaryInput (GlobalArgs.BinaryInput) == 0) ? 0 : 30;
+	}
+	
+	
 	if (GlobalArgs.Verbose) {
 		cout << "\nMatrix Method Calculations\n";
 		cout <<   "==========================\n";
@@ -203,10 +475,18 @@ int main ( int argc, char **argv )
 	// construct the object with the required parameters
 	DichroCalc = new Dichro ( GlobalArgs.InFile,  GlobalArgs.Params,    GlobalArgs.Verbose,
 	                          GlobalArgs.Debug,   GlobalArgs.PrintVec,  GlobalArgs.PrintPol,
-	                          GlobalArgs.PrintMat );
+	                          GlobalArgs.PrintMat,  GlobalArgs.Options );
 	
 	if (GlobalArgs.Verbose) cout << "\n\n";
 		
+	// the results of the frames of a trajectory or the members of an ensemble are only written
+	// to the files
+	if (GlobalArgs.Options.Frames.size() > 0) return 0;
+	if (GlobalArgs.Options.Disorder > 0.0 or GlobalArgs.Options.ShiftSet.size() > 0) return 0;
+	
+	// the matrices are only kept with --mat (see Dichro::HamiltonianMatrix)
+	if ( not GlobalArgs.PrintMat ) return 0;
+	
 	cout << "Hamiltonian\n\n"  << setw(15) << DichroCalc->DC_Results.Hamiltonian  << "\n\n";
 	cout << "Eigenvectors\n\n" << setw(15) << DichroCalc->DC_Results.Eigenvectors << "\n\n";
 	cout << "Eigenvalues\n\n"  << setw(15) << DichroCalc->DC_Results.Eigenvalues  << "\n\n";
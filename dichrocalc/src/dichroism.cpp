@@ -22,27 +22,343 @@
 
 #include "../include/dichrocalc.h"
 
+#include <algorithm>
+
+
+// The moments of all eigenstates are calculated in one pass over the eigenvectors right after
+// the diagonalization (MixEigenstates, called by HamiltonianMatrix), the eigenvector matrix is
+// then only kept for the .mat file. The pass is the product of the transposed eigenvector
+// matrix (n transitions x m states) with the moments of the monomer transitions: EDM * Energy
+// and the converted MDM for the CD (6 columns) and the EDM in a.u. in the three columns of the
+// transition type (the first, second, ... transition on the groups) for the LD. The product is
+// split into blocks of states, each block reads its part of all rows of the (row-major)
+// eigenvector matrix once and updates the result columns of the block, which stay in the
+// cache. The blocks are independent and calculated in parallel. With LAPACK=1, dgemm of the
+// system BLAS is used.
+
+#ifdef DC_USE_LAPACK
+extern "C" {
+	void dgemm_ ( const char* TransA, const char* TransB, const int* m, const int* n, const int* k,
+	              const double* Alpha, const double* A, const int* lda, const double* B,
+	              const int* ldb, const double* Beta, double* C, const int* ldc );
+}
+#endif
+
+class EigenstateBlocks : public ParallelTask { // Vectors^T * Moments, one part per block of states
+	public:
+		int Transitions;           // the number of rows of the eigenvector matrix
+		int States;                // the number of eigenstates (columns) to mix
+		int Columns;               // the row length of the eigenvector matrix in memory
+		int Types;                 // the number of transition types
+		int Block;                 // the number of states in each part
+		const double* Vectors;     // the eigenvectors, row-major
+		const double* Moments;     // the monomer moments for the CD, column-major, 6 columns
+		const double* EDM;         // the EDM of each transition (3 values each) for the LD
+		const int*    Type;        // the transition type of each transition
+		double* Mixed;             // the mixed moments, column-major, 6 + 3 * Types columns
+		
+		void Run ( int Part );
+};
+
+class PolarizationBlocks : public ParallelTask { // the LD of each state, one part per block of states
+	public:
+		int States;                // the number of eigenstates
+		int Strengths;             // the number of oscillator strengths of each state
+		int Block;                 // the number of states in each part
+		const double* TypeEDM;     // the moments of the transition types (DC_Results.Moments)
+		vector<int>    Summed;     // the number of types summed to the polarization of each state
+		vector<double> Energy;     // the energy of each state in a.u.
+		
+		vector<double> PolVec;     // the polarization vector of each state
+		vector<double> OscillatorStrength;       // Strengths values per state
+		vector<double> TotalOscillatorStrength;  // one value per state
+		
+		void Run ( int Part );
+};
+
 
 // ================================================================================
 
 
-int  Dichro::CD_Calculation ( void )
+void EigenstateBlocks::Run ( int Part )
+{
+	int First = Part * Block;
+	int Last  = min (States, First + Block);
+	int Trans, State, Column;
+	
+	for (Column = 0; Column < 6 + 3 * Types; Column++)
+		for (State = First; State < Last; State++)
+			Mixed[Column * States + State] = 0.0;
+	
+	double* Ex = Mixed + First;
+	double* Ey = Ex + States;
+	double* Ez = Ey + States;
+	double* Mx = Ez + States;
+	double* My = Mx + States;
+	double* Mz = My + States;
+	
+	for (Trans = 0; Trans < Transitions; Trans++) {
+		const double* Row = Vectors + (long) Trans * Columns + First;
+		
+		double ax = Moments[Trans];
+		double ay = Moments[Trans +     Transitions];
+		double az = Moments[Trans + 2 * Transitions];
+		double bx = Moments[Trans + 3 * Transitions];
+		double by = Moments[Trans + 4 * Transitions];
+		double bz = Moments[Trans + 5 * Transitions];
+		
+		for (State = 0; State < Last - First; State++) {
+			double v = Row[State];
+			
+			Ex[State] += v * ax;
+			Ey[State] += v * ay;
+			Ez[State] += v * az;
+			Mx[State] += v * bx;
+			My[State] += v * by;
+			Mz[State] += v * bz;
+		}
+		
+		// the moment of the transition type in a.u.
+		double* Dx = Mixed + (6 + 3 * Type[Trans]) * States + First;
+		double* Dy = Dx + States;
+		double* Dz = Dy + States;
+		const double* e = EDM + 3 * Trans;
+		
+		for (State = 0; State < Last - First; State++) {
+			// convert from Debye to a.u.
+			// 1 a.u. = 8.4784E-30 Cm = 2.5417 D
+			double Coefficient = Row[State] / 2.5417477;
+			
+			Dx[State] += Coefficient * e[0];
+			Dy[State] += Coefficient * e[1];
+			Dz[State] += Coefficient * e[2];
+		}
+	}
+} // of EigenstateBlocks::Run
+
+
+// ================================================================================
+
+
+void PolarizationBlocks::Run ( int Part )
+{
+	int First = Part * Block;
+	int Last  = min (States, First + Block);
+	int Type, State, Coord;
+	
+	for (State = First; State < Last; State++) {
+		const double* D = TypeEDM + State;
+		double* P = &PolVec[3 * State];
+		double  TotalPolarization = 0.0;
+		
+		for (Type = 0; Type < Summed[State]; Type++)
+			for (Coord = 0; Coord < 3; Coord++)
+				P[Coord] += D[(3 * Type + Coord) * States];
+		
+		for (Type = 0; Type < Strengths; Type++) {
+			double x = D[3 * Type * States];
+			double y = D[(3 * Type + 1) * States];
+			double z = D[(3 * Type + 2) * States];
+			
+			OscillatorStrength[State * Strengths + Type] = 2 * sqrt (x*x + y*y + z*z) / (3 * Energy[State]);
+		}
+		
+		TotalPolarization = sqrt (P[0] * P[0] + P[1] * P[1] + P[2] * P[2]);
+		TotalOscillatorStrength[State] = 2 * TotalPolarization / (3 * Energy[State]);
+	}
+} // of PolarizationBlocks::Run
+
+
+// ================================================================================
+
+
+void Dichro::ConvertedMDM ( int Trans, double* MDM )
+// the magnetic transition dipole moment of a monomer transition in DC_Results.Trans converted
+// with the magic number (see CD_Calculation)
 {
 	const double MagicNumber = 3.3879E-6;
 	
-	int Trans, iGroup, iTrans, jGroup, jTrans, Coord, iCount, jCount;
-	double RotationalStrength, DipoleStrength, Wavelength;
-	double RotationalSum = 0;
+	vector<double>* EDM       = &DC_Results.Trans.EDM.at(Trans);
+	vector<double>* Reference = &DC_Results.Trans.Reference.at(Trans);
+	double Energy = DC_Results.Trans.Energy.at(Trans);
+	
+	MDM[0] = DC_Results.Trans.MDMconv.at(Trans).at(0) + (
+	   MagicNumber * Energy * ( Reference->at(1) * EDM->at(2) - Reference->at(2) * EDM->at(1) ) );
+	
+	MDM[1] = DC_Results.Trans.MDMconv.at(Trans).at(1) + (
+	   MagicNumber * Energy * ( Reference->at(2) * EDM->at(0) - Reference->at(0) * EDM->at(2) ) );
+	
+	MDM[2] = DC_Results.Trans.MDMconv.at(Trans).at(2) + (
+	   MagicNumber * Energy * ( Reference->at(0) * EDM->at(1) - Reference->at(1) * EDM->at(0) ) );
+} // of Dichro::ConvertedMDM
+
+
+// ================================================================================
+
+
+void Dichro::MixEigenstates ( Matrix* Eigenvectors )
+// the electric and magnetic transition dipole moments of all eigenstates and the electric moments
+// of each transition type (DC_Results.Moments) from the monomer moments and the eigenvectors
+{
+	ResultsMoments* Mix = &DC_Results.Moments;
+	
+	int Transitions = DC_System.NumberOfTransitions;
+	int States      = DC_Results.Eigenvalues.Nrows();
+	int Group, Trans, Coord, Types = 0, Count = 0;
+	
+	for (Group = 0; Group < DC_System.NumberOfGroups; Group++)
+		Types = max (Types, DC_System.Groups.at(Group).NumberOfTransitions);
+	
+	int Mixed = 6 + 3 * Types;
+	
+	vector<double> Moments (6 * Transitions), EDM (3 * Transitions);
+	vector<int>    Type (Transitions);
+	vector<double> Product (Mixed * States);
+	double Converted[3];
+	
+	for (Group = 0; Group < DC_System.NumberOfGroups; Group++) {
+		SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+		
+		for (Trans = 0; Trans < CurGroup->NumberOfTransitions; Trans++) {
+			SystemTransition* CurTrans = &CurGroup->Trans.at(Trans);
+			
+			Dichro::ConvertedMDM (Count, Converted);
+			
+			for (Coord = 0; Coord < 3; Coord++) {
+				Moments[Coord * Transitions + Count] = CurTrans->EDM.at(Coord) * CurTrans->Energy;
+				Moments[(Coord + 3) * Transitions + Count] = Converted[Coord];
+				EDM[3 * Count + Coord] = CurTrans->EDM.at(Coord);
+			}
+			
+			Type[Count] = Trans;
+			++Count;
+		}
+	}
+	
+	if (States > 0 and Transitions > 0) {
+#ifdef DC_USE_LAPACK
+		// the row-major n x m eigenvector matrix is the column-major m x n matrix V^T, the
+		// moments are the n x (6 + 3 * Types) matrix with the EDM of each type in its columns
+		const int Columns = Eigenvectors->Ncols();
+		const double One = 1.0, Zero = 0.0;
+		
+		vector<double> Packed (Mixed * Transitions, 0.0);
+		
+		copy (Moments.begin(), Moments.end(), Packed.begin());
+		
+		for (Trans = 0; Trans < Transitions; Trans++)
+			for (Coord = 0; Coord < 3; Coord++)
+				Packed[(6 + 3 * Type[Trans] + Coord) * Transitions + Trans] = EDM[3 * Trans + Coord] / 2.5417477;
+		
+		dgemm_ ("N", "N", &States, &Mixed, &Transitions, &One, Eigenvectors->Store(), &Columns,
+		        &Packed[0], &Transitions, &Zero, &Product[0], &States);
+#else
+		EigenstateBlocks Blocks;
+		
+		Blocks.Transitions = Transitions;
+		Blocks.States      = States;
+		Blocks.Columns     = Eigenvectors->Ncols();
+		Blocks.Types       = Types;
+		Blocks.Block       = 256;
+		Blocks.Vectors     = Eigenvectors->Store();
+		Blocks.Moments     = &Moments[0];
+		Blocks.EDM         = &EDM[0];
+		Blocks.Type        = &Type[0];
+		Blocks.Mixed       = &Product[0];
+		
+		RunParallel (&Blocks, (States + Blocks.Block - 1) / Blocks.Block, DC_Options.Threads);
+#endif
+	}
+	
+	Mix->States = States;
+	Mix->Types  = Types;
+	Mix->EDM.resize (3 * States);
+	Mix->MDM.resize (3 * States);
+	Mix->TypeEDM.assign (Product.begin() + 6 * States, Product.end());
+	
+	for (Coord = 0; Coord < 3; Coord++) {
+		for (int State = 0; State < States; State++) {
+			Mix->EDM.at(Coord * States + State) = Product[Coord * States + State]
+			                                      / DC_Results.Eigenvalues.element(State);
+			Mix->MDM.at(Coord * States + State) = Product[(Coord + 3) * States + State];
+		}
+	}
+} // of Dichro::MixEigenstates
+
+
+// ================================================================================
+
+
+void Dichro::MixTransitionMomentsLoops ( vector<double>* EDM, vector<double>* MDM )
+// the loops over all groups and transitions which were used for the mixing in CD_Calculation
+// before MixEigenstates, kept for the comparison in cdbench
+{
+	DiagonalMatrix* Eigenvalues  = &DC_Results.Eigenvalues;
+	Matrix*         Eigenvectors = &DC_Results.Eigenvectors;
+	
+	int iGroup, iTrans, jGroup, jTrans, Coord, iCount, jCount;
+	int NumberOfStates = Eigenvalues->Nrows();
 	
 	SystemGroup* iCurGroup;
 	SystemGroup* jCurGroup;
 	SystemTransition* jCurTrans;
 	
+	EDM->assign (3 * NumberOfStates, 0.0);
+	MDM->assign (3 * NumberOfStates, 0.0);
+	
+	iCount = 0;
+	
+	for (iGroup = 0; iGroup < DC_System.NumberOfGroups; iGroup++) {
+		iCurGroup = &DC_System.Groups.at(iGroup);
+		
+		for (iTrans = 0; iTrans < iCurGroup->NumberOfTransitions and
+		                 iCount < NumberOfStates; iTrans++) {
+			jCount = 0;
+			
+			for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++) {
+				jCurGroup = &DC_System.Groups.at(jGroup);
+				
+				for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++) {
+					jCurTrans = &jCurGroup->Trans.at(jTrans);
+					
+					for (Coord = 0; Coord < 3; Coord++) {
+						MDM->at(Coord * NumberOfStates + iCount) +=
+						   ( Eigenvectors->element(jCount,iCount) *
+						            DC_Results.Trans.MDMconv.at(jCount).at(Coord) );
+						
+						EDM->at(Coord * NumberOfStates + iCount) +=
+						   ( Eigenvectors->element(jCount,iCount) * jCurTrans->EDM.at(Coord) *
+						        jCurTrans->Energy / Eigenvalues->element(iCount) );
+					}
+					
+					++jCount;
+				} // of for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
+			} // of for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++)
+			
+			++iCount;
+		}
+	}
+} // of Dichro::MixTransitionMomentsLoops
+
+
+// ================================================================================
+
+
+int  Dichro::CD_Calculation ( void )
+{
+	int Trans, iGroup, iTrans, Coord, iCount;
+	double RotationalStrength, DipoleStrength, Wavelength;
+	double RotationalSum = 0;
+	
+	SystemGroup* iCurGroup;
+	
 	DiagonalMatrix* Eigenvalues  = &DC_Results.Eigenvalues;
-	Matrix*         Eigenvectors = &DC_Results.Eigenvectors;
 	
 	int NumberOfTransitions = DC_System.NumberOfTransitions;
 	
+	// the number of eigenstates, smaller than the number of transitions in window mode
+	int NumberOfStates = Eigenvalues->Nrows();
+	
 	// define and initialize the required vectors
 	vector<double> EDM (3, 0.0);
 	vector<double> MDM (3, 0.0);
@@ -52,24 +368,13 @@ int  Dichro::CD_Calculation ( void )
 		printf ("   Calculating CD\n");
 	}
 	
+	// the conversion is the same as in MixEigenstates, where the moments of the eigenstates
+	// have already been calculated
 	for (Trans = 0; Trans < NumberOfTransitions; Trans++) {
-		DC_Results.Trans.MDMconv.at(Trans).at(0) += (
-		   MagicNumber * DC_Results.Trans.Energy.at(Trans) *
-		      ( DC_Results.Trans.Reference.at(Trans).at(1) * DC_Results.Trans.EDM.at(Trans).at(2) -
-		          DC_Results.Trans.Reference.at(Trans).at(2) * DC_Results.Trans.EDM.at(Trans).at(1) )
-		);
-		
-		DC_Results.Trans.MDMconv.at(Trans).at(1) += (
-		   MagicNumber * DC_Results.Trans.Energy.at(Trans) *
-		      ( DC_Results.Trans.Reference.at(Trans).at(2) * DC_Results.Trans.EDM.at(Trans).at(0) -
-		          DC_Results.Trans.Reference.at(Trans).at(0) * DC_Results.Trans.EDM.at(Trans).at(2) )
-		);
+		double Converted[3];
 		
-		DC_Results.Trans.MDMconv.at(Trans).at(2) += (
-		   MagicNumber * DC_Results.Trans.Energy.at(Trans) *
-		      ( DC_Results.Trans.Reference.at(Trans).at(0) * DC_Results.Trans.EDM.at(Trans).at(1) -
-		          DC_Results.Trans.Reference.at(Trans).at(1) * DC_Results.Trans.EDM.at(Trans).at(0) )
-		);
+		Dichro::ConvertedMDM (Trans, Converted);
+		DC_Results.Trans.MDMconv.at(Trans).assign (Converted, Converted + 3);
 	}
 	
 	
@@ -95,62 +400,48 @@ int  Dichro::CD_Calculation ( void )
 		fprintf (DC_DbgFile, "\n");
 	}
 	
-	iCount = 0;
+	// the moments of all eigenstates, 3 x NumberOfStates each (see MixEigenstates)
+	vector<double>* MixedEDM = &DC_Results.Moments.EDM;
+	vector<double>* MixedMDM = &DC_Results.Moments.MDM;
 	
 	if (DC_Verbose and DC_PrintCdl)
 		printf ("      Output written to %s\n", DC_CdlFilename.c_str());
 	
+	// the results are written into vectors of the final size, for each transition and for the
+	// states of each group
+	DC_Results.Trans.RotationalStrength.resize (NumberOfStates);
+	DC_Results.Trans.DipoleStrength.resize (NumberOfStates);
+	DC_Results.Trans.Wavelength.resize (NumberOfStates);
+	DC_Results.Trans.Reference.reserve (DC_Results.Trans.Reference.size() + NumberOfStates);
+	
+	iCount = 0;
+	
 	for (iGroup = 0; iGroup < DC_System.NumberOfGroups; iGroup++) {
 		iCurGroup = &DC_System.Groups.at(iGroup);
+		ResultsGroup* Group = &DC_Results.Groups.at(iGroup);
+		int States = min (iCurGroup->NumberOfTransitions, max (0, NumberOfStates - iCount));
 		
-		for (iTrans = 0; iTrans < iCurGroup->NumberOfTransitions; iTrans++) {
+		Group->EDM.resize (States);
+		Group->MDM.resize (States);
+		Group->Energy.resize (States);
+		Group->Wavelength.resize (States);
+		Group->RotationalStrength.resize (States);
+		Group->DipoleStrength.resize (States);
+		Group->Reference = iCurGroup->Reference;
+		Group->ParameterSet = iCurGroup->ParameterSet;
+		Group->NumberOfTransitions = iCurGroup->NumberOfTransitions;
+		Group->ChargeTransfer = iCurGroup->ChargeTransfer;
+		
+		for (iTrans = 0; iTrans < States; iTrans++) {
+			double Energy = Eigenvalues->element(iCount);
 			
 			RotationalStrength = 0.0;
 			DipoleStrength     = 0.0;
 			
 			for (Coord = 0; Coord < 3; Coord++) {
-				EDM.at(Coord) = 0.0;
-				MDM.at(Coord) = 0.0;
-			}
-			
-			jCount = 0;
-			
-			for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++) {
-				jCurGroup = &DC_System.Groups.at(jGroup);
+				EDM.at(Coord) = MixedEDM->at(Coord * NumberOfStates + iCount);
+				MDM.at(Coord) = MixedMDM->at(Coord * NumberOfStates + iCount);
 				
-				for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++) {
-					jCurTrans = &jCurGroup->Trans.at(jTrans);
-					// DEBUG OUTPUT
-					// printf ("iGroup %2d  iTrans %2d  -  jGroup %2d  jTrans %2d\n",
-					//                 iGroup,     iTrans,        jGroup,     jTrans);
-					
-					// DEBUG OUTPUT
-					// printf ("Input-EDM: %8.3f %8.3f %8.3f\n",
-					//        jCurTrans->EDM.at(0),  jCurTrans->EDM.at(1),  jCurTrans->EDM.at(2));
-					// printf ("Input-MDM: %8.3f %8.3f %8.3f\n",
-					//        DC_Results.Trans.MDMconv.at(jCount).at(0),
-					//        DC_Results.Trans.MDMconv.at(jCount).at(1),
-					//        DC_Results.Trans.MDMconv.at(jCount).at(2));
-					
-					for (Coord = 0; Coord < 3; Coord++) {
-						MDM.at(Coord) +=
-						   ( Eigenvectors->element(jCount,iCount) *
-						            DC_Results.Trans.MDMconv.at(jCount).at(Coord) );
-						
-						EDM.at(Coord) +=
-						   ( Eigenvectors->element(jCount,iCount) * jCurTrans->EDM.at(Coord) *
-						        jCurTrans->Energy / Eigenvalues->element(iCount) );
-					}
-					
-					++jCount;
-				} // of for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
-			} // of for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++)
-			
-			// DEBUG OUTPUT
-			// printf ("Final EDM:  %8.3f %8.3f %8.3f\n", EDM.at(0), EDM.at(1), EDM.at(2));
-			// printf ("Final MDM:  %8.3f %8.3f %8.3f\n", MDM.at(0), MDM.at(1), MDM.at(2));
-			
-			for (Coord = 0; Coord < 3; Coord++) {
 				// Rosenfeld equation:
 				// calculate the dot product of the elec. and mag. dipole moment:
 				RotationalStrength += (EDM.at(Coord) * MDM.at(Coord));
@@ -162,7 +453,7 @@ int  Dichro::CD_Calculation ( void )
 			RotationalSum += RotationalStrength;
 			
 			// convert the wavelength to nanometer
-			Wavelength = 1E7 / Eigenvalues->element(iCount);
+			Wavelength = 1E7 / Energy;
 			
 			if (DC_PrintCdl)
 				fprintf (DC_CdlFile, "%14.8f %14.8f\n", Wavelength, RotationalStrength);
@@ -172,29 +463,30 @@ int  Dichro::CD_Calculation ( void )
 			// monomer data with the result for the interacting system).
 			DC_Results.Trans.EDM.at(iCount) = EDM;
 			DC_Results.Trans.MDM.at(iCount) = MDM;
-			DC_Results.Trans.Energy.at(iCount) = Eigenvalues->element(iCount);
-			DC_Results.Trans.RotationalStrength.push_back (RotationalStrength);
-			DC_Results.Trans.DipoleStrength.push_back (DipoleStrength);
-			DC_Results.Trans.Wavelength.push_back (Wavelength);
+			DC_Results.Trans.Energy.at(iCount) = Energy;
+			DC_Results.Trans.RotationalStrength.at(iCount) = RotationalStrength;
+			DC_Results.Trans.DipoleStrength.at(iCount) = DipoleStrength;
+			DC_Results.Trans.Wavelength.at(iCount) = Wavelength;
 			DC_Results.Trans.Reference.push_back (iCurGroup->Reference);
-			 
-			// add the results for access via the group count (the vectors have been initialized
+			
+			// the results for access via the group count (the vectors have been initialized
 			// in Dichro::HamiltonianMatrix during setting up the group/transition sequence)
-			DC_Results.Groups.at(iGroup).EDM.push_back (EDM);
-			DC_Results.Groups.at(iGroup).MDM.push_back (MDM);
-			DC_Results.Groups.at(iGroup).Energy.push_back (Eigenvalues->element(iCount));
-			DC_Results.Groups.at(iGroup).Wavelength.push_back (Wavelength);
-			DC_Results.Groups.at(iGroup).RotationalStrength.push_back (RotationalStrength);
-			DC_Results.Groups.at(iGroup).DipoleStrength.push_back (DipoleStrength);
-			DC_Results.Groups.at(iGroup).Reference = iCurGroup->Reference;
-			DC_Results.Groups.at(iGroup).ParameterSet = iCurGroup->ParameterSet;
-			DC_Results.Groups.at(iGroup).NumberOfTransitions = iCurGroup->NumberOfTransitions;
-			DC_Results.Groups.at(iGroup).ChargeTransfer = iCurGroup->ChargeTransfer;
+			Group->EDM.at(iTrans) = EDM;
+			Group->MDM.at(iTrans) = MDM;
+			Group->Energy.at(iTrans) = Energy;
+			Group->Wavelength.at(iTrans) = Wavelength;
+			Group->RotationalStrength.at(iTrans) = RotationalStrength;
+			Group->DipoleStrength.at(iTrans) = DipoleStrength;
 			
 			++iCount;
-		} // of for (iTrans = 0; iTrans < CurGroup->NumberOfTransitions; Trans++)
+		} // of for (iTrans = 0; iTrans < States; iTrans++)
 	}	// of for (iGroup = 0; iGroup < DC_System.NumberOfGroups; iGroup++)
 	
+	// in window mode, the monomer data beyond the calculated states is removed
+	DC_Results.Trans.EDM.resize (NumberOfStates);
+	DC_Results.Trans.MDM.resize (NumberOfStates);
+	DC_Results.Trans.Energy.resize (NumberOfStates);
+	
 	return 0;
 } // of Dichro::CD_Calculation
 
@@ -204,13 +496,11 @@ int  Dichro::CD_Calculation ( void )
 
 int  Dichro::LD_Calculation ( void )
 {
-	int iGroup, iTrans, jGroup, jTrans;
-	double Wavelength, Energy, Coefficient, TotalPolarization, TotalOscillatorStrength;
-	int i, j, k, iCount, jCount, Coord;
+	int iGroup, iTrans, iCount, Type, Coord, i, j, k;
+	double Wavelength, Energy, TotalOscillatorStrength;
 	SystemGroup* iCurGroup;
-	SystemGroup* jCurGroup;
 	
-	vector< vector< vector<double> > > PolTensor; // the polarization tensor
+	PolarizationBlocks Blocks;
 	
 	if (DC_Verbose) printf ("   Calculating LD\n");
 	if (DC_Debug > 2) Dichro::NewFileTask (DC_DbgFile, "Linear Dichroism Calculation");
@@ -223,23 +513,54 @@ int  Dichro::LD_Calculation ( void )
 		if (MaxNumberOfTransitions < DC_System.Groups.at(iGroup).NumberOfTransitions)
 			MaxNumberOfTransitions = DC_System.Groups.at(iGroup).NumberOfTransitions;
 	
-	//PolTensor = &DC_Results.PolTensor;
-	
 	// Used in publications PCCP 2002, 4, 4051-4057 and PCCP 2007, 9, 2020-2035
 	
 	// initialize the polarization tensor
 	// CAUTION: k was changed to the maximum number of transitions on one group, before it was
 	// limited to only 2 transitions in general
-	for (k = 0; k < MaxNumberOfTransitions+1; k++) {
-		// create a vector of 3 vectors, all initialized with MaxNumberOfTransitions+2 of zeroes
-		vector< vector<double> > Dim2 (3, vector<double>(MaxNumberOfTransitions+2, 0.0));
-		// push it into the polarization tensor to create the third dimension
-		PolTensor.push_back (Dim2);
+	vector< vector< vector<double> > >* PolTensor = &DC_Results.PolTensor;
+	
+	PolTensor->assign (MaxNumberOfTransitions+1,
+	                   vector< vector<double> > (3, vector<double>(MaxNumberOfTransitions+2, 0.0)));
+	
+	// the moments of all transitions of one type (the n-th transition on each group) for each
+	// eigenstate are in DC_Results.Moments (see MixEigenstates), the polarization vectors and
+	// oscillator strengths are calculated in parallel for blocks of states
+	ResultsMoments* Mix = &DC_Results.Moments;
+	
+	Blocks.States  = min ((int) DC_Results.Trans.Wavelength.size(), Mix->States);
+	Blocks.Block   = 256;
+	Blocks.TypeEDM = (Mix->TypeEDM.size() > 0) ? &Mix->TypeEDM[0] : NULL;
+	
+	// Dtot and the oscillator strengths have the number of transitions of the last group
+	Blocks.Strengths = (DC_System.NumberOfGroups > 0) ?
+	                   DC_System.Groups.at(DC_System.NumberOfGroups-1).NumberOfTransitions : 0;
+	
+	for (iGroup = 0; iGroup < DC_System.NumberOfGroups; iGroup++)
+		for (iTrans = 0; iTrans < DC_System.Groups.at(iGroup).NumberOfTransitions and
+		                 (int) Blocks.Summed.size() < Blocks.States; iTrans++)
+			Blocks.Summed.push_back (DC_System.Groups.at(iGroup).NumberOfTransitions);
+	
+	Blocks.PolVec.assign (Blocks.States * 3, 0.0);
+	Blocks.Energy.assign (Blocks.States, 0.0);
+	Blocks.OscillatorStrength.assign (Blocks.States * max (1, Blocks.Strengths), 0.0);
+	Blocks.TotalOscillatorStrength.assign (Blocks.States, 0.0);
+	
+	for (iCount = 0; iCount < Blocks.States; iCount++) {
+		// Planck      h = 6.62608 E-34 Js = m^2 kg s^-1
+		// lightspeed  c = 2.997924 E+8 m s^-1
+		// Joule       J = 2.29271276 E+17 Hartree
+		
+		// Energy in a.u.
+		// Energy  = 45.563421 / Wavelength
+		Blocks.Energy.at(iCount) = 2.29371276 * 6.62608 * 2.997924 / DC_Results.Trans.Wavelength.at(iCount);
 	}
 	
-	vector< vector<double> > OscillatorStrength
-	           (DC_System.NumberOfGroups * MaxNumberOfTransitions, // this is a 'safe' value
-	                   vector<double>(MaxNumberOfTransitions, 0.0));
+	// the moments of the types of one state, the last one is always zero
+	vector<double> Dxyz ((MaxNumberOfTransitions+1) * 3, 0.0);
+	
+	if (Blocks.States > 0)
+		RunParallel (&Blocks, (Blocks.States + Blocks.Block - 1) / Blocks.Block, DC_Options.Threads);
 	
 	if (DC_PrintPol) {
 		if (DC_Verbose) printf ("      Output written to %s\n", DC_PolFilename.c_str());
@@ -254,123 +575,71 @@ int  Dichro::LD_Calculation ( void )
 		fprintf (DC_PolFile, "    Total     Norm\n");
 	}
 	
+	DC_Results.Trans.PolarizationVector.resize (Blocks.States);
+	DC_Results.Trans.OscillatorStrength.resize (Blocks.States);
+	
+	// The contributions of the states are added to the polarization tensor in their order, the
+	// tensor (and the partial sums in the .pol file) do not depend on the number of threads.
 	iCount = 0;
 	
 	for (iGroup = 0; iGroup < DC_System.NumberOfGroups; iGroup++) {
 		iCurGroup = &DC_System.Groups.at(iGroup);
+		ResultsGroup* Group = &DC_Results.Groups.at(iGroup);
+		int States = min (iCurGroup->NumberOfTransitions, max (0, Blocks.States - iCount));
 		
-		for (iTrans = 0; iTrans < iCurGroup->NumberOfTransitions; iTrans++) {
-			Wavelength = DC_Results.Trans.Wavelength.at(iCount);
-			
-			// Planck      h = 6.62608 E-34 Js = m^2 kg s^-1
-			// lightspeed  c = 2.997924 E+8 m s^-1
-			// Joule       J = 2.29271276 E+17 Hartree
-			
-			// Energy in a.u.
-			// Energy  = 45.563421 / Wavelength
-			// Energy  = ->Energy.at(Trans);
-			Energy  = 2.29371276 * 6.62608 * 2.997924 /  Wavelength;
-			// printf ("Energy: %12.6f\n", Energy);
-			
-			// First get the total transition dipole moment for the Trans-th transition.
-			// For the moment these are kept separated into the individual contributions
-			// 
-			// 
-			
-			// initialize the polarization vector for each transition of this group
-			vector< vector<double> > Dxyz (MaxNumberOfTransitions*3, vector<double>(3, 0.0)); // DMR 20180601 iCurGroup->NumberOfTransitions to MaxNumberOfTransitions
-			
-			jCount = 0;
-			
-			for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++) {
-				jCurGroup = &DC_System.Groups.at(jGroup);
-				
-				for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++) {
-					// convert from Debye to a.u.
-					// 1 a.u. = 8.4784E-30 Cm = 2.5417 D
-					Coefficient = DC_Results.Eigenvectors.element(jCount, iCount) / 2.5417477;
-					
-					// DEBUG OUTPUT
-					// printf ("Coefficient:  %12.6f\n", Coefficient);
-					// printf ("EDM:          %12.6f %12.6f %12.6f\n",
-					//         jCurGroup->Trans.at(jTrans).EDM.at(0),
-					//         jCurGroup->Trans.at(jTrans).EDM.at(1),
-					//         jCurGroup->Trans.at(jTrans).EDM.at(2));
-					
-					for (Coord = 0; Coord < 3; Coord++)
-						Dxyz.at(jTrans).at(Coord) +=
-						                (Coefficient * jCurGroup->Trans.at(jTrans).EDM.at(Coord));
-					
-					jCount++;
-				} // of for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
-			} // of for (jGroup = 0; jGroup < DC_System.Groups.size(); jGroup++)
-			
-			// initialize a fresh vector for every new transition
-			vector<double> PolVec (3, 0.0);
+		Group->PolarizationVector.resize (States);
+		Group->OscillatorStrength.resize (States);
+		
+		for (iTrans = 0; iTrans < States; iTrans++) {
+			double* PolVec = &Blocks.PolVec.at(iCount * 3);
 			
-			// PolVec contains the polarization vector of the iCount-th transition
-			for (jTrans = 0; jTrans < iCurGroup->NumberOfTransitions; jTrans++) {
-				if (DC_Debug > 2) {
-					fprintf (DC_DbgFile, "   jTrans: %2d  %12.6f%12.6f%12.6f\n", jTrans,
-					       Dxyz.at(jTrans).at(0), Dxyz.at(jTrans).at(1), Dxyz.at(jTrans).at(2));
-				}
-				
+			for (Type = 0; Type < MaxNumberOfTransitions; Type++)
 				for (Coord = 0; Coord < 3; Coord++)
-					PolVec.at(Coord) += Dxyz.at(jTrans).at(Coord);
-			}
+					Dxyz.at(3*Type + Coord) = Mix->TypeEDM.at((3*Type + Coord) * Mix->States + iCount);
+			
+			Wavelength = DC_Results.Trans.Wavelength.at(iCount);
+			Energy     = Blocks.Energy.at(iCount);
+			TotalOscillatorStrength = Blocks.TotalOscillatorStrength.at(iCount);
 			
 			if (DC_Debug > 2) {
+				for (Type = 0; Type < iCurGroup->NumberOfTransitions; Type++)
+					fprintf (DC_DbgFile, "   jTrans: %2d  %12.6f%12.6f%12.6f\n", Type,
+					       Dxyz.at(3*Type), Dxyz.at(3*Type+1), Dxyz.at(3*Type+2));
+				
 				fprintf (DC_DbgFile, "   iCount: %2d  %12.6f%12.6f%12.6f\n\n", iCount,
-				       PolVec.at(0), PolVec.at(1), PolVec.at(2));
+				       PolVec[0], PolVec[1], PolVec[2]);
 			}
 			
-			// 
-			// TotalPolarization = total
-			// Dtot.at(0) = nPi*
-			// Dtot.at(1) = PiPi*
-			
-			vector<double> Dtot (jCurGroup->NumberOfTransitions, 0.0);
-			
-			for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
-				Dtot.at(jTrans) = VectorNorm (&Dxyz.at(jTrans));
-				
-			TotalPolarization = VectorNorm (&PolVec);
-			
 			// The total TDM's for the iCount'th transition are in Dtot, these are also broken
 			// down into the components from each type of transition. Now we are in a position
 			// to add the contribution from this state to the polarization tensor.
 			for (j = 0; j < 3; j++)
 				for (i = 0; i < 3; i++)
 					for (k = 1; k < MaxNumberOfTransitions+1; k++)
-						PolTensor.at(k).at(i).at(j) =
-						       PolTensor.at(k).at(i).at(j)
-						     + ( 2 * Dxyz.at(k).at(i) * Dxyz.at(k).at(j) / Energy );
+						PolTensor->at(k).at(i).at(j) =
+						       PolTensor->at(k).at(i).at(j)
+						     + ( 2 * Dxyz.at(3*k+i) * Dxyz.at(3*k+j) / Energy );
 			
 			for (j = 0; j < 3; j++)
 				for (i = 0; i < 3; i++)
-						PolTensor.at(0).at(i).at(j) =
-						       PolTensor.at(0).at(i).at(j)
-						     + ( 2 * PolVec.at(i) * PolVec.at(j) / Energy );
-			
-			for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
-				OscillatorStrength.at(iCount).at(jTrans) = 2 * Dtot.at(jTrans) / (3 * Energy);
-			
-			TotalOscillatorStrength = 2 * TotalPolarization / (3 * Energy);
+						PolTensor->at(0).at(i).at(j) =
+						       PolTensor->at(0).at(i).at(j)
+						     + ( 2 * PolVec[i] * PolVec[j] / Energy );
 			
 			// --------------------------------------------------------------------------------
 			
 			if (DC_PrintPol) {
 				// write the data for the current transition to the .pol file
 				fprintf (DC_PolFile, "  %5d %10.3f %12.6f %12.6f %12.6f",
-						iCount, Wavelength, PolVec.at(0), PolVec.at(1), PolVec.at(2));
+						iCount, Wavelength, PolVec[0], PolVec[1], PolVec[2]);
 				
-				for (jTrans = 0; jTrans < jCurGroup->NumberOfTransitions; jTrans++)
-					fprintf (DC_PolFile, " %12.6f", OscillatorStrength.at(iCount).at(jTrans));
+				for (Type = 0; Type < Blocks.Strengths; Type++)
+					fprintf (DC_PolFile, " %12.6f", Blocks.OscillatorStrength.at(iCount * Blocks.Strengths + Type));
 				
 				fprintf (DC_PolFile, " %12.6f\n", TotalOscillatorStrength);
 				
 				if ((iCount+1) % DC_System.NumberOfGroups == 0)
-					Dichro::PrintPolarizationTensor (&PolTensor, MaxNumberOfTransitions);
+					Dichro::PrintPolarizationTensor (PolTensor, MaxNumberOfTransitions);
 			}
 			
 			// --------------------------------------------------------------------------------
@@ -378,17 +647,17 @@ int  Dichro::LD_Calculation ( void )
 			if (DC_PrintVec) {
 				// write the .vec file (just the information required for absobance spectra)
 				fprintf (DC_VecFile, "%8.3f %12.6f %12.6f %12.6f\n",
-				        Wavelength, PolVec.at(0), PolVec.at(1), PolVec.at(2));
+				        Wavelength, PolVec[0], PolVec[1], PolVec[2]);
 			}
 			
-			DC_Results.Trans.PolarizationVector.push_back (PolVec);
-			DC_Results.Trans.OscillatorStrength.push_back (TotalOscillatorStrength);
+			DC_Results.Trans.PolarizationVector.at(iCount).assign (PolVec, PolVec + 3);
+			DC_Results.Trans.OscillatorStrength.at(iCount) = TotalOscillatorStrength;
 			
-			DC_Results.Groups.at(iGroup).PolarizationVector.push_back (PolVec);
-			DC_Results.Groups.at(iGroup).OscillatorStrength.push_back (TotalOscillatorStrength);
+			Group->PolarizationVector.at(iTrans).assign (PolVec, PolVec + 3);
+			Group->OscillatorStrength.at(iTrans) = TotalOscillatorStrength;
 			
 			iCount++;
-		} // of for (iTrans = 0; iTrans < iCurGroup->NumberOfTransitions; iTrans++) {
+		} // of for (iTrans = 0; iTrans < States; iTrans++)
 	} // of for (iGroup = 0; iGroup < DC_System.Groups.size(); iGroup++)
 	
 	if (DC_Verbose and DC_PrintVec) printf ("      Output written to %s\n", DC_VecFilename.c_str());
@@ -0,0 +1,1303 @@
+// #################################################################################################
+//
+//  Program:      eigensolver.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Routines to diagonalize the (real, symmetric) Hamiltonian matrix
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+
+// The matrices in this file are plain column-major arrays, i.e. element (i,j) of a matrix with
+// the leading dimension ld is found at A[i + j*ld]. Columns of the eigenvector matrices are the
+// eigenvectors, exactly as in the NewMat Matrix returned by Jacobi ().
+
+// below this size the divide-and-conquer recursion is stopped and the tridiagonal matrix is
+// diagonalized with the implicit QL algorithm
+static const int DivideConquerMinSize = 25;
+
+// the cyclic Jacobi method stops when all off-diagonal elements are below this fraction of the
+// largest diagonal element (the first sweeps skip the small elements altogether), the warm start
+// is abandoned if the off-diagonal elements in the basis of the previous eigenvectors are larger
+// than this fraction of those of the matrix itself
+static const double JacobiTolerance       = 1.0E-14;
+static const int    JacobiThresholdSweeps = 3;
+static const int    JacobiMaxSweeps       = 50;
+static const double WarmStartLimit        = 0.25;
+
+
+#ifdef DC_USE_LAPACK
+extern "C" {
+	void dsyevr_ ( const char* JobZ, const char* Range, const char* UpLo, const int* n,
+	               double* A, const int* lda, const double* vl, const double* vu,
+	               const int* il, const int* iu, const double* AbsTol, int* m, double* w,
+	               double* Z, const int* ldz, int* ISuppZ, double* Work, const int* lWork,
+	               int* iWork, const int* liWork, int* Info );
+	void dgemm_ ( const char* TransA, const char* TransB, const int* m, const int* n, const int* k,
+	              const double* Alpha, const double* A, const int* lda, const double* B,
+	              const int* ldb, const double* Beta, double* C, const int* ldc );
+}
+#endif
+
+
+// ================================================================================
+
+
+bool EigensolverAvailable ( string Method )
+// checks whether the given eigensolver can be used with this binary
+{
+	if (Method == "jacobi")      return true;
+	if (Method == "householder") return true;
+	if (Method == "divide")      return true;
+	if (Method == "warm")        return true;
+
+#ifdef DC_USE_LAPACK
+	if (Method == "lapack")      return true;
+#endif
+	
+	return false;
+} // of EigensolverAvailable
+
+
+// ================================================================================
+
+
+string EigensolverList ( void )
+// returns the names of all eigensolvers compiled into the binary
+{
+	string List = "jacobi, householder, divide, warm";
+
+#ifdef DC_USE_LAPACK
+	List += ", lapack";
+#endif
+	
+	return List;
+} // of EigensolverList
+
+
+// ================================================================================
+
+
+int SymmetricEigensystem ( string Method, SymmetricMatrix* InMatrix,
+                           DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors )
+// Diagonalizes a symmetric matrix with the given method. All methods return the eigenvalues in
+// ascending order and the normalized eigenvectors as columns of Eigenvectors.
+//    jacobi        NewMat's Jacobi rotations (extremely reliable but slow, the reference)
+//    householder   NewMat's Householder tridiagonalization followed by QL iterations
+//    divide        Householder tridiagonalization followed by Cuppen's divide-and-conquer
+//    warm          cyclic Jacobi rotations, here without a previous basis (WarmStartEigensystem)
+//    lapack        LAPACK's dsyevr (relatively robust representations), if compiled in
+{
+	int n = InMatrix->Nrows();
+	
+	if (Method == "jacobi") {
+		SymmetricMatrix WorkSpace (n);
+		Jacobi (*InMatrix, *Eigenvalues, WorkSpace, *Eigenvectors);
+		return 0;
+	}
+	
+	if (Method == "householder") {
+		eigenvalues (*InMatrix, *Eigenvalues, *Eigenvectors);
+		return 0;
+	}
+	
+	if (Method == "divide")
+		return DivideConquerEigensystem (InMatrix, Eigenvalues, Eigenvectors);
+	
+	if (Method == "warm") {
+		int Sweeps;
+		bool Warm;
+		
+		return WarmStartEigensystem (InMatrix, NULL, Eigenvalues, Eigenvectors, &Sweeps, &Warm);
+	}
+
+#ifdef DC_USE_LAPACK
+	if (Method == "lapack")
+		return LapackEigensystem (InMatrix, Eigenvalues, Eigenvectors);
+#endif
+	
+	return 1;
+} // of SymmetricEigensystem
+
+
+// ================================================================================
+
+
+int DivideConquerEigensystem ( SymmetricMatrix* InMatrix, DiagonalMatrix* Eigenvalues,
+                               Matrix* Eigenvectors )
+// diagonalizes a symmetric matrix by reducing it to tridiagonal form and solving the
+// tridiagonal eigenproblem with the divide-and-conquer algorithm
+{
+	int n = InMatrix->Nrows();
+	int i, j, ErrorCode;
+	
+	Eigenvalues->resize (n);
+	Eigenvectors->resize (n, n);
+	
+	if (n == 0) return 0;
+	
+	// the lower triangle of the NewMat matrix is stored row-wise, copy it into a column-major
+	// array, only the lower triangle is referenced
+	vector<double> A (n * n, 0.0);
+	Real* Packed = InMatrix->Store();
+	
+	for (i = 0; i < n; i++)
+		for (j = 0; j <= i; j++)
+			A[i + j*n] = Packed[i*(i+1)/2 + j];
+	
+	vector<double> Diag (n), OffDiag (n, 0.0), Tau (n, 0.0);
+	vector<double> Z (n * n, 0.0);
+	
+	HouseholderTridiagonal (n, &A[0], &Diag[0], &OffDiag[0], &Tau[0]);
+	
+	ErrorCode = TridiagonalDivideConquer (n, &Diag[0], &OffDiag[0], &Z[0], n);
+	if (ErrorCode != 0) return ErrorCode;
+	
+	HouseholderBacktransform (n, &A[0], &Tau[0], &Z[0], n);
+	
+	// NewMat matrices are stored row-wise
+	Real* Values  = Eigenvalues->Store();
+	Real* Vectors = Eigenvectors->Store();
+	
+	for (j = 0; j < n; j++) {
+		Values[j] = Diag[j];
+		
+		for (i = 0; i < n; i++)
+			Vectors[i*n + j] = Z[i + j*n];
+	}
+	
+	return 0;
+} // of DivideConquerEigensystem
+
+
+// ================================================================================
+
+
+void HouseholderTridiagonal ( int n, double* A, double* Diag, double* OffDiag, double* Tau )
+// Reduces the symmetric matrix A (n x n, column-major, lower triangle referenced) to tridiagonal
+// form T = Q^T A Q with Q = H(0) H(1) ... H(n-3) and H(k) = I - Tau(k) v v^T. The vectors v are
+// stored below the subdiagonal of A (v(k+1) = 1 is implicit), the diagonal of T in Diag and its
+// subdiagonal in OffDiag(0 ... n-2).
+{
+	int i, j, k, m;
+	double Alpha, Beta, Norm, Scale, Dot, Temp;
+	vector<double> w (n);
+	
+	for (k = 0; k < n-2; k++) {
+		double* x = &A[(k+1) + k*n];    // the column below the diagonal
+		m = n - k - 1;                  // its length
+		
+		Alpha = x[0];
+		Norm  = 0.0;
+		for (i = 1; i < m; i++) Norm += x[i] * x[i];
+		
+		Diag[k] = A[k + k*n];
+		
+		if (Norm == 0.0) {              // nothing to eliminate in this column
+			Tau[k]     = 0.0;
+			OffDiag[k] = Alpha;
+			continue;
+		}
+		
+		Norm  = sqrt (Norm);
+		Beta  = -copysign (hypot (Alpha, Norm), Alpha);
+		Tau[k] = (Beta - Alpha) / Beta;
+		Scale = 1.0 / (Alpha - Beta);
+		
+		for (i = 1; i < m; i++) x[i] *= Scale;
+		
+		x[0] = 1.0;
+		OffDiag[k] = Beta;
+		
+		// w = Tau * A22 * v with A22 = A(k+1:n, k+1:n), using the lower triangle only
+		double* A22 = &A[(k+1) + (k+1)*n];
+		
+		for (i = 0; i < m; i++) w[i] = 0.0;
+		
+		// two columns at a time, the second one starts one row further down
+		for (j = 0; j + 1 < m; j += 2) {
+			double* Col0 = &A22[j*n];
+			double* Col1 = &A22[(j+1)*n];
+			double  x0   = x[j];
+			double  x1   = x[j+1];
+			double  Dot0 = Col0[j] * x0 + Col0[j+1] * x[j+1];
+			double  Dot1 = Col1[j+1] * x1;
+			
+			w[j+1] += Col0[j+1] * x0;
+			
+			for (i = j+2; i < m; i++) {
+				w[i] += Col0[i] * x0 + Col1[i] * x1;
+				Dot0 += Col0[i] * x[i];
+				Dot1 += Col1[i] * x[i];
+			}
+			
+			w[j]   += Dot0;
+			w[j+1] += Dot1;
+		}
+		
+		if (j < m) w[j] += A22[j + j*n] * x[j];
+		
+		Dot = 0.0;
+		for (i = 0; i < m; i++) {
+			w[i] *= Tau[k];
+			Dot  += w[i] * x[i];
+		}
+		
+		// w = w - 1/2 Tau (w^T v) v, then the rank-2 update A22 = A22 - v w^T - w v^T
+		Temp = -0.5 * Tau[k] * Dot;
+		for (i = 0; i < m; i++) w[i] += Temp * x[i];
+		
+		for (j = 0; j < m; j++) {
+			double* Col = &A22[j*n];
+			double xj = x[j];
+			double wj = w[j];
+			
+			for (i = j; i < m; i++)
+				Col[i] -= x[i] * wj + w[i] * xj;
+		}
+		
+		x[0] = Beta;
+	}
+	
+	// the last 2x2 block is already tridiagonal
+	if (n > 1) {
+		Diag[n-2]    = A[(n-2) + (n-2)*n];
+		OffDiag[n-2] = A[(n-1) + (n-2)*n];
+		Tau[n-2]     = 0.0;
+	}
+	
+	Diag[n-1] = A[(n-1) + (n-1)*n];
+	OffDiag[n-1] = 0.0;
+} // of HouseholderTridiagonal
+
+
+// ================================================================================
+
+
+void HouseholderBacktransform ( int n, double* A, double* Tau, double* Z, int Columns )
+// multiplies the n x Columns matrix Z with the Q of HouseholderTridiagonal (Z = Q Z), this turns
+// the eigenvectors of the tridiagonal matrix into those of the original one
+{
+	int i, k, Col, First, Last;
+	
+	// all reflectors are applied to a panel of columns at a time, which stays in the cache,
+	// and within the panel to four columns at once (independent sums for the pipeline)
+	const int Panel = 32;
+	
+	for (First = 0; First < Columns; First += Panel) {
+		Last = min (First + Panel, Columns);
+		
+		for (k = n-3; k >= 0; k--) {
+			if (Tau[k] == 0.0) continue;
+			
+			double* v = &A[(k+1) + k*n];     // v(0) = 1 is implicit, v(0) holds the subdiagonal
+			int m = n - k - 1;
+			
+			for (Col = First; Col + 3 < Last; Col += 4) {
+				double* z0 = &Z[(k+1) + Col*n];
+				double* z1 = z0 + n;
+				double* z2 = z1 + n;
+				double* z3 = z2 + n;
+				
+				double s0 = z0[0], s1 = z1[0], s2 = z2[0], s3 = z3[0];
+				
+				for (i = 1; i < m; i++) {
+					s0 += v[i] * z0[i];
+					s1 += v[i] * z1[i];
+					s2 += v[i] * z2[i];
+					s3 += v[i] * z3[i];
+				}
+				
+				s0 *= Tau[k];  s1 *= Tau[k];  s2 *= Tau[k];  s3 *= Tau[k];
+				
+				z0[0] -= s0;  z1[0] -= s1;  z2[0] -= s2;  z3[0] -= s3;
+				
+				for (i = 1; i < m; i++) {
+					z0[i] -= s0 * v[i];
+					z1[i] -= s1 * v[i];
+					z2[i] -= s2 * v[i];
+					z3[i] -= s3 * v[i];
+				}
+			}
+			
+			for ( ; Col < Last; Col++) {
+				double* z = &Z[(k+1) + Col*n];
+				double Sum = z[0];
+				
+				for (i = 1; i < m; i++) Sum += v[i] * z[i];
+				
+				Sum *= Tau[k];
+				
+				z[0] -= Sum;
+				for (i = 1; i < m; i++) z[i] -= Sum * v[i];
+			}
+		}
+	}
+} // of HouseholderBacktransform
+
+
+// ================================================================================
+
+
+static void SortEigensystem ( int n, double* Values, double* Z, int ldz )
+// sorts the eigenvalues in ascending order and swaps the eigenvector columns accordingly
+{
+	int i, j, Min;
+	
+	for (i = 0; i < n-1; i++) {
+		Min = i;
+		
+		for (j = i+1; j < n; j++)
+			if (Values[j] < Values[Min]) Min = j;
+		
+		if (Min == i) continue;
+		
+		swap (Values[i], Values[Min]);
+		
+		for (j = 0; j < n; j++)
+			swap (Z[j + i*ldz], Z[j + Min*ldz]);
+	}
+} // of SortEigensystem
+
+
+// ================================================================================
+
+
+int TridiagonalQL ( int n, double* Diag, double* OffDiag, double* Z, int ldz )
+// Diagonalizes a symmetric tridiagonal matrix with the implicit QL algorithm. The rotations are
+// accumulated into the n rows of Z (pass the unit matrix to obtain the eigenvectors of the
+// tridiagonal matrix). The eigenvalues are returned in Diag in ascending order.
+{
+	int i, k, l, m, Iter;
+	double b, c, f, g, p, r, s, dd;
+	vector<double> e (n, 0.0);
+	
+	for (i = 0; i < n-1; i++) e[i] = OffDiag[i];
+	
+	for (l = 0; l < n; l++) {
+		Iter = 0;
+		
+		do {
+			// look for a single small subdiagonal element to split the matrix
+			for (m = l; m < n-1; m++) {
+				dd = fabs (Diag[m]) + fabs (Diag[m+1]);
+				if (fabs (e[m]) <= DBL_EPSILON * dd) break;
+			}
+			
+			if (m != l) {
+				if (Iter++ == 60) return 1;
+				
+				g = (Diag[l+1] - Diag[l]) / (2.0 * e[l]);
+				r = hypot (g, 1.0);
+				g = Diag[m] - Diag[l] + e[l] / (g + copysign (r, g));
+				s = 1.0;
+				c = 1.0;
+				p = 0.0;
+				
+				for (i = m-1; i >= l; i--) {
+					f = s * e[i];
+					b = c * e[i];
+					r = hypot (f, g);
+					e[i+1] = r;
+					
+					if (r == 0.0) {    // recover from underflow
+						Diag[i+1] -= p;
+						e[m] = 0.0;
+						break;
+					}
+					
+					s = f / r;
+					c = g / r;
+					g = Diag[i+1] - p;
+					r = (Diag[i] - g) * s + 2.0 * c * b;
+					p = s * r;
+					Diag[i+1] = g + p;
+					g = c * r - b;
+					
+					double* zi  = &Z[i * ldz];
+					double* zi1 = &Z[(i+1) * ldz];
+					
+					for (k = 0; k < n; k++) {
+						f      = zi1[k];
+						zi1[k] = s * zi[k] + c * f;
+						zi[k]  = c * zi[k] - s * f;
+					}
+				}
+				
+				if (r == 0.0 and i >= l) continue;
+				
+				Diag[l] -= p;
+				e[l] = g;
+				e[m] = 0.0;
+			}
+		} while (m != l);
+	}
+	
+	SortEigensystem (n, Diag, Z, ldz);
+	
+	return 0;
+} // of TridiagonalQL
+
+
+// ================================================================================
+
+
+static double SecularRoot ( int K, int i, double* d, double* z, double Rho, int* Origin )
+// Finds the i-th root of the secular equation  1/Rho + sum_j z(j)^2 / (d(j) - x) = 0  with
+// d(0) < d(1) < ... < d(K-1), Rho > 0. The root is returned as an offset to d(Origin), which
+// is the closer one of the two poles enclosing it, to keep the differences d(j) - x accurate.
+{
+	int j, Iter;
+	double Lower, Upper, Tau, Mid, Gap, f, Psi, dPsi, Phi, dPhi, Delta, Temp, ErrorBound;
+	double InvRho = 1.0 / Rho;
+	
+	if (i == K-1) {
+		// the last root lies between d(K-1) and d(K-1) + Rho |z|^2
+		double Norm = 0.0;
+		for (j = 0; j < K; j++) Norm += z[j] * z[j];
+		
+		*Origin = K-1;
+		Lower   = 0.0;
+		Upper   = Rho * Norm;
+	}
+	else {
+		// decide which half of the interval the root is in, f(x) is increasing in it
+		Gap = d[i+1] - d[i];
+		Mid = 0.5 * Gap;
+		f   = InvRho;
+		
+		for (j = 0; j < K; j++)
+			f += z[j] * z[j] / ((d[j] - d[i]) - Mid);
+		
+		if (f >= 0.0) {
+			*Origin = i;
+			Lower   = 0.0;
+			Upper   = Mid;
+		}
+		else {
+			*Origin = i+1;
+			Lower   = -Mid;
+			Upper   = 0.0;
+		}
+	}
+	
+	double dOrigin = d[*Origin];
+	Tau = 0.5 * (Lower + Upper);
+	
+	for (Iter = 0; Iter < 200; Iter++) {
+		// split the sum into the poles left (Psi) and right (Phi) of the root
+		Psi = 0.0;  dPsi = 0.0;
+		Phi = 0.0;  dPhi = 0.0;
+		
+		for (j = 0; j <= i; j++) {
+			Delta = (d[j] - dOrigin) - Tau;
+			Temp  = z[j] / Delta;
+			Psi  += z[j] * Temp;
+			dPsi += Temp * Temp;
+		}
+		
+		for (j = i+1; j < K; j++) {
+			Delta = (d[j] - dOrigin) - Tau;
+			Temp  = z[j] / Delta;
+			Phi  += z[j] * Temp;
+			dPhi += Temp * Temp;
+		}
+		
+		f = InvRho + Psi + Phi;
+		
+		ErrorBound = 8.0 * (InvRho + fabs (Psi) + fabs (Phi)) + fabs (Tau) * (dPsi + dPhi);
+		if (fabs (f) <= DBL_EPSILON * ErrorBound) break;
+		
+		if (f < 0.0) Lower = Tau;
+		else         Upper = Tau;
+		
+		if (Upper - Lower <= 2.0 * DBL_EPSILON * max (fabs (Lower), fabs (Upper))) break;
+		
+		// Model f by c + s/(a - x) + S/(b - x) around the current point, matching the value and
+		// the derivatives of both parts of the sum, and solve for the step x. This converges
+		// quadratically and in most cases takes less than five steps.
+		double a = (d[i] - dOrigin) - Tau;
+		double s = dPsi * a * a;
+		double Step  = 0.0;
+		bool   Valid = false;
+		
+		if (i < K-1) {
+			double b = (d[i+1] - dOrigin) - Tau;
+			double S = dPhi * b * b;
+			double c = f - s/a - S/b;
+			
+			// c (a-x)(b-x) + s (b-x) + S (a-x) = 0
+			double qa = c;
+			double qb = -(c * (a + b) + s + S);
+			double qc = c * a * b + s * b + S * a;
+			
+			if (qa == 0.0) {
+				if (qb != 0.0) {
+					Step  = -qc / qb;
+					Valid = true;
+				}
+			}
+			else {
+				double Disc = qb * qb - 4.0 * qa * qc;
+				
+				if (Disc >= 0.0) {
+					double q  = -0.5 * (qb + copysign (sqrt (Disc), qb));
+					double x1 = q / qa;
+					double x2 = (q != 0.0) ? qc / q : x1;
+					
+					// take the root that keeps Tau inside the bracket
+					if (Tau + x1 > Lower and Tau + x1 < Upper) {
+						Step  = x1;
+						Valid = true;
+					}
+					else if (Tau + x2 > Lower and Tau + x2 < Upper) {
+						Step  = x2;
+						Valid = true;
+					}
+				}
+			}
+		}
+		else {
+			double c = f - s/a;
+			
+			if (c != 0.0) {
+				Step  = a + s/c;
+				Valid = true;
+			}
+		}
+		
+		if (Valid and Tau + Step > Lower and Tau + Step < Upper and Step == Step)
+			Tau = Tau + Step;
+		else
+			Tau = 0.5 * (Lower + Upper);      // fall back to bisection
+	}
+	
+	return Tau;
+} // of SecularRoot
+
+
+// ================================================================================
+
+
+static void MergeRankOne ( int n, int m, double* d, double Rho, double Sign, double* Z, int ldz )
+// Merges the eigensystems of the two halves (rows/columns 0 ... m-1 and m ... n-1, held in d
+// and the diagonal blocks of Z) of a tridiagonal matrix that has been split by a rank-one
+// modification Rho v v^T with v = e(m-1) + Sign e(m).
+{
+	int i, j, r, p, K;
+	vector<double> z (n);
+	vector<int> Perm (n), RowStart (n), RowEnd (n);
+	
+	// the rank-one vector in the eigenvector basis of the two halves: the last row of the
+	// upper and the first row of the lower eigenvector block
+	for (i = 0; i < m; i++) {
+		z[i] = Z[(m-1) + i*ldz];
+		RowStart[i] = 0;
+		RowEnd[i]   = m;
+	}
+	
+	for (i = m; i < n; i++) {
+		z[i] = Sign * Z[m + i*ldz];
+		RowStart[i] = m;
+		RowEnd[i]   = n;
+	}
+	
+	// z consists of two unit vectors, normalize it and move the factor into Rho
+	for (i = 0; i < n; i++) z[i] /= sqrt (2.0);
+	Rho *= 2.0;
+	
+	// sort the poles in ascending order
+	for (i = 0; i < n; i++) Perm[i] = i;
+	
+	for (i = 1; i < n; i++) {         // insertion sort, both halves are already sorted
+		int Cur = Perm[i];
+		for (j = i-1; j >= 0 and d[Perm[j]] > d[Cur]; j--) Perm[j+1] = Perm[j];
+		Perm[j+1] = Cur;
+	}
+	
+	double MaxD = 0.0;
+	for (i = 0; i < n; i++) MaxD = max (MaxD, fabs (d[i]));
+	
+	double Tolerance = 8.0 * DBL_EPSILON * max (MaxD, Rho);
+	
+	// Deflation: an eigenpair of the halves is an eigenpair of the merged matrix if its
+	// component in z is negligible. Two (nearly) equal poles can be rotated such that one of
+	// the two components vanishes.
+	vector<int>  Kept, Deflated;
+	vector<bool> IsDeflated (n, false);
+	int Last = -1;
+	
+	for (i = 0; i < n; i++) {
+		int Cur = Perm[i];
+		
+		if (Rho * fabs (z[Cur]) <= Tolerance) {
+			Deflated.push_back (Cur);
+			IsDeflated[Cur] = true;
+			continue;
+		}
+		
+		if (Last >= 0) {
+			double s = z[Last];
+			double c = z[Cur];
+			double t = hypot (c, s);
+			c =  c / t;
+			s = -s / t;
+			
+			if (fabs ((d[Cur] - d[Last]) * c * s) <= Tolerance) {
+				// rotate the two eigenvectors, the pole Last leaves the secular equation
+				z[Cur]  = t;
+				z[Last] = 0.0;
+				
+				double* x = &Z[Last * ldz];
+				double* y = &Z[Cur  * ldz];
+				
+				int Start = min (RowStart[Last], RowStart[Cur]);
+				int End   = max (RowEnd[Last],   RowEnd[Cur]);
+				
+				for (r = Start; r < End; r++) {
+					double Temp = c * x[r] + s * y[r];
+					y[r] = c * y[r] - s * x[r];
+					x[r] = Temp;
+				}
+				
+				RowStart[Last] = RowStart[Cur] = Start;
+				RowEnd[Last]   = RowEnd[Cur]   = End;
+				
+				double Temp = d[Last] * c * c + d[Cur] * s * s;
+				d[Cur]  = d[Last] * s * s + d[Cur] * c * c;
+				d[Last] = Temp;
+				
+				Deflated.push_back (Last);
+				IsDeflated[Last] = true;
+			}
+			else
+				Kept.push_back (Last);
+		}
+		
+		Last = Cur;
+	}
+	
+	if (Last >= 0) Kept.push_back (Last);
+	
+	K = Kept.size();
+	
+	// the secular equation for the remaining poles
+	vector<double> dK (K), zK (K), Lambda (K);
+	vector<int> Origin (K);
+	
+	for (i = 0; i < K; i++) {
+		dK[i] = d[Kept[i]];
+		zK[i] = z[Kept[i]];
+	}
+	
+	// U(j,i) = dK(j) - Lambda(i), computed relative to the closer pole
+	vector<double> U ((size_t) K * K);
+	
+	for (i = 0; i < K; i++) {
+		double Tau = SecularRoot (K, i, &dK[0], &zK[0], Rho, &Origin[i]);
+		Lambda[i] = dK[Origin[i]] + Tau;
+		
+		for (j = 0; j < K; j++)
+			U[j + (size_t) i*K] = (dK[j] - dK[Origin[i]]) - Tau;
+	}
+	
+	// Recompute z from the computed roots (Gu and Eisenstat), this guarantees orthogonal
+	// eigenvectors even if the roots are close to the poles
+	for (j = 0; j < K; j++) {
+		double Prod = -U[j + (size_t) (K-1)*K] / Rho;
+		
+		for (i = 0; i < K-1; i++) {
+			if (i < j) Prod *= -U[j + (size_t) i*K] / (dK[i]   - dK[j]);
+			else       Prod *= -U[j + (size_t) i*K] / (dK[i+1] - dK[j]);
+		}
+		
+		zK[j] = copysign (sqrt (fabs (Prod)), zK[j]);
+	}
+	
+	// the eigenvectors of the secular equation
+	for (i = 0; i < K; i++) {
+		double* u = &U[(size_t) i*K];
+		double Norm = 0.0;
+		
+		for (j = 0; j < K; j++) {
+			u[j] = zK[j] / u[j];
+			Norm += u[j] * u[j];
+		}
+		
+		Norm = sqrt (Norm);
+		for (j = 0; j < K; j++) u[j] /= Norm;
+	}
+	
+	// work copies of the eigenvectors of the halves, Z is overwritten with the result
+	vector<double> QKept ((size_t) n * K), QDeflated ((size_t) n * (n-K));
+	
+	for (i = 0; i < K; i++)
+		for (r = 0; r < n; r++)
+			QKept[r + (size_t) i*n] = Z[r + Kept[i]*ldz];
+	
+	for (i = 0; i < n-K; i++)
+		for (r = 0; r < n; r++)
+			QDeflated[r + (size_t) i*n] = Z[r + Deflated[i]*ldz];
+	
+	// collect all eigenvalues and sort them to get the final column of each eigenvector
+	vector< pair<double, int> > Values;
+	
+	for (i = 0; i < K; i++)   Values.push_back (make_pair (Lambda[i], i));
+	for (i = 0; i < n-K; i++) Values.push_back (make_pair (d[Deflated[i]], K + i));
+	
+	sort (Values.begin(), Values.end());
+	
+	// the new eigenvectors QKept * U, four columns at a time to reuse each column of QKept
+	vector<double> QNew ((size_t) n * K, 0.0);
+	
+	for (i = 0; i < K; i += 4) {
+		int Width = min (4, K - i);
+		double* Out = &QNew[(size_t) i*n];
+		double* u   = &U[(size_t) i*K];
+		
+		for (j = 0; j < K; j++) {
+			double* In  = &QKept[(size_t) j*n];
+			int     End = RowEnd[Kept[j]];
+			
+			// skip the rows known to be zero in this column
+			if (Width == 4) {
+				double f0 = u[j], f1 = u[j + K], f2 = u[j + 2*K], f3 = u[j + 3*K];
+				
+				for (r = RowStart[Kept[j]]; r < End; r++) {
+					double x = In[r];
+					Out[r]       += f0 * x;
+					Out[r + n]   += f1 * x;
+					Out[r + 2*n] += f2 * x;
+					Out[r + 3*n] += f3 * x;
+				}
+			}
+			else {
+				for (p = 0; p < Width; p++) {
+					double Factor = u[j + (size_t) p*K];
+					for (r = RowStart[Kept[j]]; r < End; r++)
+						Out[r + (size_t) p*n] += Factor * In[r];
+				}
+			}
+		}
+	}
+	
+	for (p = 0; p < n; p++) {
+		double* Out = &Z[p * ldz];
+		double* In;
+		int Index = Values[p].second;
+		
+		d[p] = Values[p].first;
+		
+		if (Index >= K) In = &QDeflated[(size_t) (Index-K) * n];
+		else            In = &QNew[(size_t) Index * n];
+		
+		for (r = 0; r < n; r++) Out[r] = In[r];
+	}
+} // of MergeRankOne
+
+
+// ================================================================================
+
+
+int TridiagonalDivideConquer ( int n, double* Diag, double* OffDiag, double* Z, int ldz )
+// Diagonalizes a symmetric tridiagonal matrix (Cuppen's divide-and-conquer method). The matrix
+// is torn into two halves by a rank-one modification, both are diagonalized recursively and the
+// results merged by solving the secular equation. The eigenvalues are returned in Diag in
+// ascending order, the eigenvectors in the n x n block Z, OffDiag is destroyed.
+{
+	int i, j, m, ErrorCode;
+	
+	if (n <= DivideConquerMinSize) {
+		for (j = 0; j < n; j++)
+			for (i = 0; i < n; i++)
+				Z[i + j*ldz] = (i == j) ? 1.0 : 0.0;
+		
+		return TridiagonalQL (n, Diag, OffDiag, Z, ldz);
+	}
+	
+	m = n / 2;
+	
+	double Rho  = OffDiag[m-1];
+	double Sign = (Rho >= 0.0) ? 1.0 : -1.0;
+	
+	Rho = fabs (Rho);
+	Diag[m-1] -= Rho;
+	Diag[m]   -= Rho;
+	
+	ErrorCode = TridiagonalDivideConquer (m, Diag, OffDiag, Z, ldz);
+	if (ErrorCode != 0) return ErrorCode;
+	
+	ErrorCode = TridiagonalDivideConquer (n-m, Diag+m, OffDiag+m, Z + m + m*ldz, ldz);
+	if (ErrorCode != 0) return ErrorCode;
+	
+	// the off-diagonal blocks are zero
+	for (j = 0; j < m; j++)
+		for (i = m; i < n; i++) Z[i + j*ldz] = 0.0;
+	
+	for (j = m; j < n; j++)
+		for (i = 0; i < m; i++) Z[i + j*ldz] = 0.0;
+	
+	if (Rho == 0.0) {
+		SortEigensystem (n, Diag, Z, ldz);
+		return 0;
+	}
+	
+	MergeRankOne (n, m, Diag, Rho, Sign, Z, ldz);
+	
+	return 0;
+} // of TridiagonalDivideConquer
+
+
+// ================================================================================
+
+
+static void TransposedProduct ( int n, const double* A, const double* B, double* C )
+// C = A^T B for column-major n x n matrices, each element is the dot product of two columns,
+// 4 x 4 of them are calculated at once to read each column only once for four products
+{
+#ifdef DC_USE_LAPACK
+	const double One = 1.0, Zero = 0.0;
+	
+	dgemm_ ("T", "N", &n, &n, &n, &One, A, &n, B, &n, &Zero, C, &n);
+#else
+	int i, j, k, a, b;
+	
+	for (j = 0; j < n; j += 4) {
+		int jb = min (4, n - j);
+		
+		for (i = 0; i < n; i += 4) {
+			int ib = min (4, n - i);
+			double Sum[4][4] = { { 0.0 } };
+			
+			if (ib == 4 and jb == 4) {
+				const double *a0 = &A[i*n], *a1 = a0 + n, *a2 = a1 + n, *a3 = a2 + n;
+				const double *b0 = &B[j*n], *b1 = b0 + n, *b2 = b1 + n, *b3 = b2 + n;
+				
+				for (k = 0; k < n; k++) {
+					Sum[0][0] += a0[k] * b0[k];   Sum[0][1] += a0[k] * b1[k];
+					Sum[0][2] += a0[k] * b2[k];   Sum[0][3] += a0[k] * b3[k];
+					Sum[1][0] += a1[k] * b0[k];   Sum[1][1] += a1[k] * b1[k];
+					Sum[1][2] += a1[k] * b2[k];   Sum[1][3] += a1[k] * b3[k];
+					Sum[2][0] += a2[k] * b0[k];   Sum[2][1] += a2[k] * b1[k];
+					Sum[2][2] += a2[k] * b2[k];   Sum[2][3] += a2[k] * b3[k];
+					Sum[3][0] += a3[k] * b0[k];   Sum[3][1] += a3[k] * b1[k];
+					Sum[3][2] += a3[k] * b2[k];   Sum[3][3] += a3[k] * b3[k];
+				}
+			}
+			else {
+				for (a = 0; a < ib; a++)
+					for (b = 0; b < jb; b++)
+						for (k = 0; k < n; k++)
+							Sum[a][b] += A[k + (i+a)*n] * B[k + (j+b)*n];
+			}
+			
+			for (a = 0; a < ib; a++)
+				for (b = 0; b < jb; b++)
+					C[(i+a) + (j+b)*n] = Sum[a][b];
+		}
+	}
+#endif
+} // of TransposedProduct
+
+
+// ================================================================================
+
+
+int CyclicJacobi ( int n, double* A, double* V, int* Sweeps )
+// Diagonalizes the symmetric matrix A (n x n, column-major, both triangles) with cyclic Jacobi
+// rotations, which are also applied to the columns of V. The eigenvalues are left on the diagonal
+// of A. Each sweep is done in the round-robin order of a tournament: the n-1 rounds rotate n/2
+// disjoint pairs at once, so that the columns and then the rows of all pairs are updated in one
+// pass through the matrix each instead of with strided row updates after every rotation.
+// Elements below the tolerance are skipped, in the first JacobiThresholdSweeps sweeps also those
+// below a fifth of the mean off-diagonal element. The iteration stops after the first sweep
+// without a rotation. Returns 1 if it has not converged after JacobiMaxSweeps sweeps.
+{
+	int m = n + n % 2;             // an odd number of columns gets a dummy partner
+	int Round, Pair, k;
+	double Scale = 0.0;
+	
+	// the pairs of a round with their rotations (plain arrays for the inner loops)
+	vector<int>    PairIndex (m);
+	vector<double> Rotation (3 * m / 2), Diagonal (m);
+	int*    P = &PairIndex[0];
+	int*    Q = P + m / 2;
+	double* C = &Rotation[0];
+	double* S = C + m / 2;
+	double* T = S + m / 2;
+	
+	*Sweeps = 0;
+	
+	for (k = 0; k < n; k++) Scale = max (Scale, fabs (A[k + k*n]));
+	
+	double Threshold = JacobiTolerance * max (Scale, DBL_MIN);
+	
+	while (*Sweeps < JacobiMaxSweeps) {
+		bool   Rotated = false;
+		double Current = Threshold;
+		
+		// the first sweeps only rotate the larger elements (one fifth of the mean and above)
+		if (*Sweeps < JacobiThresholdSweeps) {
+			double Sum = 0.0;
+			
+			for (Round = 1; Round < n; Round++)
+				for (k = 0; k < Round; k++)
+					Sum += fabs (A[k + Round*n]);
+			
+			Current = max (Threshold, 0.2 * Sum / ((double) n * n));
+		}
+		
+		for (Round = 0; Round < m - 1; Round++) {
+			int Pairs = 0;
+			
+			// the rotations of this round, calculated from the 2x2 blocks of the pairs
+			for (k = 0; k < m / 2; k++) {
+				int p = (k == 0) ? m - 1 : (Round + k) % (m - 1);
+				int q = (Round - k + m - 1) % (m - 1);
+				
+				if (p > q) swap (p, q);
+				if (q >= n) continue;
+				
+				double apq = A[p + q*n];
+				
+				if (fabs (apq) <= Current) continue;
+				
+				double Theta = (A[q + q*n] - A[p + p*n]) / (2.0 * apq);
+				double t     = ((Theta >= 0.0) ? 1.0 : -1.0) / (fabs (Theta) + sqrt (Theta * Theta + 1.0));
+				
+				P[Pairs] = p;
+				Q[Pairs] = q;
+				T[Pairs] = t;
+				C[Pairs] = 1.0 / sqrt (t * t + 1.0);
+				S[Pairs] = t * C[Pairs];
+				++Pairs;
+			}
+			
+			if (Pairs == 0) continue;
+			
+			Rotated = true;
+			
+			for (Pair = 0; Pair < Pairs; Pair++) {
+				double apq = A[P[Pair] + Q[Pair]*n];
+				Diagonal[2*Pair]   = A[P[Pair] + P[Pair]*n] - T[Pair] * apq;
+				Diagonal[2*Pair+1] = A[Q[Pair] + Q[Pair]*n] + T[Pair] * apq;
+			}
+			
+			// the columns p and q of A and V (A J, V J)
+			for (Pair = 0; Pair < Pairs; Pair++) {
+				double c = C[Pair], s = S[Pair];
+				double* Ap = &A[P[Pair]*n];
+				double* Aq = &A[Q[Pair]*n];
+				double* Vp = &V[P[Pair]*n];
+				double* Vq = &V[Q[Pair]*n];
+				
+				for (k = 0; k < n; k++) {
+					double akp = Ap[k], akq = Aq[k];
+					Ap[k] = c * akp - s * akq;
+					Aq[k] = s * akp + c * akq;
+					
+					double vkp = Vp[k], vkq = Vq[k];
+					Vp[k] = c * vkp - s * vkq;
+					Vq[k] = s * vkp + c * vkq;
+				}
+			}
+			
+			// the rows p and q (J^T A J), column by column
+			for (k = 0; k < n; k++) {
+				double* Ak = &A[k*n];
+				
+				for (Pair = 0; Pair < Pairs; Pair++) {
+					double c = C[Pair], s = S[Pair];
+					double apk = Ak[P[Pair]], aqk = Ak[Q[Pair]];
+					Ak[P[Pair]] = c * apk - s * aqk;
+					Ak[Q[Pair]] = s * apk + c * aqk;
+				}
+			}
+			
+			// the 2x2 blocks are diagonal apart from rounding
+			for (Pair = 0; Pair < Pairs; Pair++) {
+				int p = P[Pair], q = Q[Pair];
+				A[p + p*n] = Diagonal[2*Pair];
+				A[q + q*n] = Diagonal[2*Pair+1];
+				A[p + q*n] = A[q + p*n] = 0.0;
+			}
+		}
+		
+		if ( not Rotated ) return 0;
+		
+		++*Sweeps;
+	}
+	
+	return 1;
+} // of CyclicJacobi
+
+
+// ================================================================================
+
+
+int WarmStartEigensystem ( SymmetricMatrix* InMatrix, Matrix* Basis,
+                           DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors,
+                           int* Sweeps, bool* Warm )
+// Diagonalizes a symmetric matrix starting from the eigenvectors of a similar matrix, e.g. of the
+// previous frame of a trajectory: the matrix is transformed into this basis (V^T H V) and the
+// remaining off-diagonal elements are removed by Jacobi sweeps (CyclicJacobi), the eigenvectors
+// are the basis rotated by the same sweeps. Without a basis of the same size (Basis NULL or
+// empty), or if the off-diagonal elements in the basis are larger than WarmStartLimit times
+// those of the matrix itself, the Jacobi sweeps start from the unit matrix (Warm false).
+// Sweeps returns the number of sweeps needed.
+{
+	int n = InMatrix->Nrows();
+	int i, j;
+	
+	*Sweeps = 0;
+	*Warm   = false;
+	
+	Eigenvalues->resize (n);
+	Eigenvectors->resize (n, n);
+	
+	if (n == 0) return 0;
+	
+	// the full matrix in column-major order
+	vector<double> H (n * n), V (n * n, 0.0);
+	Real* Packed = InMatrix->Store();
+	double OffDiagonal = 0.0;
+	
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < i; j++) {
+			H[i + j*n] = H[j + i*n] = Packed[i*(i+1)/2 + j];
+			OffDiagonal += 2.0 * H[i + j*n] * H[i + j*n];
+		}
+		
+		H[i + i*n] = Packed[i*(i+1)/2 + i];
+	}
+	
+	if (Basis != NULL and Basis->Nrows() == n and Basis->Ncols() == n) {
+		vector<double> HV (n * n), A (n * n);
+		Real* Previous = Basis->Store();
+		double Remaining = 0.0;
+		
+		for (i = 0; i < n; i++)
+			for (j = 0; j < n; j++)
+				V[i + j*n] = Previous[i*n + j];
+		
+		// A = V^T (H V), H is symmetric
+		TransposedProduct (n, &H[0], &V[0], &HV[0]);
+		TransposedProduct (n, &V[0], &HV[0], &A[0]);
+		
+		// the product is symmetric apart from rounding
+		for (j = 0; j < n; j++) {
+			for (i = j+1; i < n; i++) {
+				A[i + j*n] = A[j + i*n] = 0.5 * (A[i + j*n] + A[j + i*n]);
+				Remaining += 2.0 * A[i + j*n] * A[i + j*n];
+			}
+		}
+		
+		if (Remaining <= WarmStartLimit * WarmStartLimit * OffDiagonal) {
+			H.swap (A);
+			*Warm = true;
+		}
+	}
+	
+	if ( not *Warm ) {
+		V.assign (n * n, 0.0);
+		for (i = 0; i < n; i++) V[i + i*n] = 1.0;
+	}
+	
+	if (CyclicJacobi (n, &H[0], &V[0], Sweeps) != 0) return 1;
+	
+	vector<double> Values (n);
+	for (i = 0; i < n; i++) Values[i] = H[i + i*n];
+	
+	SortEigensystem (n, &Values[0], &V[0], n);
+	
+	Real* OutValues  = Eigenvalues->Store();
+	Real* OutVectors = Eigenvectors->Store();
+	
+	for (j = 0; j < n; j++) {
+		OutValues[j] = Values[j];
+		
+		for (i = 0; i < n; i++)
+			OutVectors[i*n + j] = V[i + j*n];
+	}
+	
+	return 0;
+} // of WarmStartEigensystem
+
+
+// ================================================================================
+
+
+#ifdef DC_USE_LAPACK
+
+int LapackEigensystem ( SymmetricMatrix* InMatrix, DiagonalMatrix* Eigenvalues,
+                        Matrix* Eigenvectors )
+// diagonalizes a symmetric matrix with LAPACK's dsyevr
+{
+	int n = InMatrix->Nrows();
+	int i, j, Found, Info;
+	
+	Eigenvalues->resize (n);
+	Eigenvectors->resize (n, n);
+	
+	if (n == 0) return 0;
+	
+	// the NewMat lower triangle (row-wise) is the upper triangle in column-major order
+	vector<double> A (n * n, 0.0);
+	Real* Packed = InMatrix->Store();
+	
+	for (i = 0; i < n; i++)
+		for (j = 0; j <= i; j++)
+			A[j + i*n] = Packed[i*(i+1)/2 + j];
+	
+	vector<double> Values (n), Z (n * n);
+	vector<int> ISuppZ (2 * n);
+	double vl = 0.0, vu = 0.0, AbsTol = 0.0, WorkSize;
+	int il = 0, iu = 0, lWork = -1, liWork = -1, iWorkSize;
+	
+	// workspace query
+	dsyevr_ ("V", "A", "U", &n, &A[0], &n, &vl, &vu, &il, &iu, &AbsTol, &Found, &Values[0],
+	         &Z[0], &n, &ISuppZ[0], &WorkSize, &lWork, &iWorkSize, &liWork, &Info);
+	
+	if (Info != 0) return Info;
+	
+	lWork  = (int) WorkSize;
+	liWork = iWorkSize;
+	vector<double> Work (lWork);
+	vector<int> iWork (liWork);
+	
+	dsyevr_ ("V", "A", "U", &n, &A[0], &n, &vl, &vu, &il, &iu, &AbsTol, &Found, &Values[0],
+	         &Z[0], &n, &ISuppZ[0], &Work[0], &lWork, &iWork[0], &liWork, &Info);
+	
+	if (Info != 0) return Info;
+	
+	Real* OutValues  = Eigenvalues->Store();
+	Real* OutVectors = Eigenvectors->Store();
+	
+	for (j = 0; j < n; j++) {
+		OutValues[j] = Values[j];
+		
+		for (i = 0; i < n; i++)
+			OutVectors[i*n + j] = Z[i + j*n];
+	}
+	
+	return 0;
+} // of LapackEigensystem
+
+#endif
+
+
+// ================================================================================
+
+
+void CompareEigensystems ( SymmetricMatrix* InMatrix,
+                           DiagonalMatrix* Eigenvalues,  Matrix* Eigenvectors,
+                           DiagonalMatrix* RefEigenvalues, Matrix* RefEigenvectors,
+                           double* ValueDeviation, double* VectorDeviation, double* Residual )
+// Compares an eigensystem with a reference solution of the same matrix:
+//    ValueDeviation    the largest deviation of an eigenvalue
+//    VectorDeviation   the largest deviation of an eigenvector, measured as the distance of the
+//                      eigenvectors from the space spanned by the reference eigenvectors of the
+//                      same eigenvalue (degenerate eigenvectors are not unique)
+//    Residual          the largest norm |Hv - ev| of the (non-reference) eigensystem
+// Both eigensystems may also consist of the same selection of m < n eigenpairs (n x m vectors).
+{
+	int n = InMatrix->Nrows();
+	int m = Eigenvalues->Nrows();
+	int i, j, k, r, Start, End;
+	
+	*ValueDeviation  = 0.0;
+	*VectorDeviation = 0.0;
+	*Residual        = 0.0;
+	
+	if (n == 0) return;
+	
+	Real* Values    = Eigenvalues->Store();
+	Real* RefValues = RefEigenvalues->Store();
+	Real* Packed    = InMatrix->Store();
+	
+	double MaxValue = 0.0;
+	
+	for (i = 0; i < m; i++) {
+		*ValueDeviation = max (*ValueDeviation, fabs (Values[i] - RefValues[i]));
+		MaxValue = max (MaxValue, fabs (RefValues[i]));
+	}
+	
+	// column-major copies of the eigenvectors and the full matrix
+	vector<double> V (n * m), W (n * m), H (n * n);
+	Real* Vectors    = Eigenvectors->Store();
+	Real* RefVectors = RefEigenvectors->Store();
+	
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < m; j++) {
+			V[i + j*n] = Vectors[i*m + j];
+			W[i + j*n] = RefVectors[i*m + j];
+		}
+		
+		for (j = 0; j <= i; j++)
+			H[i + j*n] = H[j + i*n] = Packed[i*(i+1)/2 + j];
+	}
+	
+	// eigenvalues closer than this are treated as degenerate
+	double ClusterTolerance = 1.0E-6 * max (1.0, MaxValue);
+	
+	for (Start = 0; Start < m; Start = End) {
+		End = Start + 1;
+		while (End < m and RefValues[End] - RefValues[End-1] <= ClusterTolerance) End++;
+		
+		// the residual v - W W^T v of each eigenvector v of the cluster, calculated directly
+		// (k - |W^T V|^2 cancels to the rounding error of the dot products, about 1e-7)
+		int Size = End - Start;
+		vector<double> Dots (Size * Size), Rest (n);
+		
+		for (i = 0; i < Size; i++) {
+			for (j = 0; j < Size; j++) {
+				double Dot = 0.0;
+				for (r = 0; r < n; r++) Dot += W[r + (Start+i)*n] * V[r + (Start+j)*n];
+				Dots[i + j*Size] = Dot;
+			}
+		}
+		
+		for (j = 0; j < Size; j++) {
+			for (r = 0; r < n; r++) Rest[r] = V[r + (Start+j)*n];
+			
+			for (i = 0; i < Size; i++)
+				for (r = 0; r < n; r++) Rest[r] -= Dots[i + j*Size] * W[r + (Start+i)*n];
+			
+			double Norm = 0.0;
+			for (r = 0; r < n; r++) Norm += Rest[r] * Rest[r];
+			
+			*VectorDeviation = max (*VectorDeviation, sqrt (Norm));
+		}
+	}
+	
+	vector<double> Hv (n);
+	
+	for (j = 0; j < m; j++) {
+		for (r = 0; r < n; r++) Hv[r] = -Values[j] * V[r + j*n];
+		
+		for (k = 0; k < n; k++) {
+			double Factor = V[k + j*n];
+			for (r = 0; r < n; r++) Hv[r] += H[r + k*n] * Factor;
+		}
+		
+		double Norm = 0.0;
+		for (r = 0; r < n; r++) Norm += Hv[r] * Hv[r];
+		
+		*Residual = max (*Residual, sqrt (Norm));
+	}
+} // of CompareEigensystems
+
+
+// ================================================================================
+
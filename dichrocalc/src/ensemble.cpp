@@ -0,0 +1,384 @@
+// #################################################################################################
+//
+//  Program:      ensemble.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Calculation of the spectra of many sets of site energies of the same system,
+//                diagonal disorder (--disorder) and shifts of the energies of one parameter set
+//                (--shift), the couplings are calculated only once
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <pthread.h>
+#include <algorithm>
+#include <cmath>
+
+
+// Only the diagonal of the Hamiltonian, the excitation energies of the transitions, differs
+// between the members of an ensemble. The parameter sets are fitted and the couplings are
+// calculated once (HamiltonianMatrix without the diagonalization), each member then adds its
+// shifts to the diagonal of a copy of this matrix and to the energies of the transitions and
+// is diagonalized, mixed and convoluted like a frame of a trajectory (trajectory.cpp).
+//
+// With --disorder, each member is a realization of independent Gaussian shifts of all
+// transitions, with --shift, the energy of one transition (or all) of a parameter set is shifted
+// by the values of a grid. The random shifts of a realization only depend on the seed and on
+// the number of the realization, not on the thread it is calculated on.
+
+class EnsembleMembers : public ParallelTask { // the members of the ensemble, one part per thread
+	public:
+		Dichro*         DC;           // the object with the couplings (DC_Results.Hamiltonian)
+		string          BaseName;     // the output files are BaseName.member.cdl etc.
+		int             Members;      // the number of members
+		int             Threads;      // the number of threads calculating members
+		int             NextMember;   // the next member to calculate
+		int             Processed;    // the number of members calculated
+		int             ErrorMember;  // the member which failed (-1 = none)
+		int             WarmStarts;   // the members diagonalized with a warm start (-e warm)
+		int             SavedSweeps;  // the Jacobi sweeps saved by the warm starts
+		pthread_mutex_t Lock;         // protects the counters and DC
+		
+		void Run ( int Part );
+		void Shifts ( int Member, Dichro* Worker, vector<double>* Shift );
+};
+
+
+static unsigned long long MemberSeed ( int Seed, int Member )
+// the start of the random numbers of a member (the SplitMix64 finalizer, neighbouring seeds
+// and members give unrelated sequences)
+{
+	unsigned long long State = ((unsigned long long) (unsigned int) Seed << 32) + (unsigned int) Member;
+	
+	State = (State ^ (State >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	State = (State ^ (State >> 27)) * 0x94d049bb133111ebULL;
+	
+	return State ^ (State >> 31);
+}
+
+
+static double UniformNumber ( unsigned long long* State )
+// a random number in (0, 1), the linear congruential generator of sparse.cpp
+{
+	*State = *State * 6364136223846793005ULL + 1442695040888963407ULL;
+	
+	return ((double) (*State >> 11) + 0.5) / 9007199254740992.0;
+}
+
+
+// ================================================================================
+
+
+int Dichro::EnsembleCalculation ( void )
+// calculates the spectra of all members of the ensemble given by DC_Options
+{
+	EnsembleMembers Ensemble;
+	bool Disorder = (DC_Options.Disorder > 0.0);
+	int  Group, Found = 0;
+	
+	if (DC_Verbose) Dichro::NewTask ( "Ensemble" );
+	
+	if (Disorder) {
+		Ensemble.Members = DC_Options.Realizations;
+		
+		if (DC_Options.ShiftSet.size() > 0 or Ensemble.Members < 1) {
+			cerr << "\nERROR: Invalid ensemble (" << Ensemble.Members << " realizations, "
+			     << "--disorder and --shift cannot be combined).\n\n";
+			DC_Error = "Invalid ensemble";
+			DC_ErrorCode = 190;
+			return 190;
+		}
+		
+		// the realizations are only of interest as an average
+		DC_Options.Average = true;
+	}
+	else {
+		double Range = DC_Options.ShiftLast - DC_Options.ShiftFirst;
+		
+		if (Range < 0.0 or (Range > 0.0 and DC_Options.ShiftStep <= 0.0)) {
+			cerr << "\nERROR: Invalid shifts " << DC_Options.ShiftFirst << " to " << DC_Options.ShiftLast
+			     << " cm-1 in steps of " << DC_Options.ShiftStep << " cm-1.\n\n";
+			DC_Error = "Invalid ensemble";
+			DC_ErrorCode = 190;
+			return 190;
+		}
+		
+		// the last shift is included if the range is a multiple of the step
+		Ensemble.Members = (Range > 0.0) ? (int) floor (Range / DC_Options.ShiftStep + 1E-9) + 1 : 1;
+	}
+	
+	// the average is taken of the band spectra, Gaussian bands if none are given
+	if (DC_Options.Average and DC_Options.Bandshape.size() == 0) DC_Options.Bandshape = "gauss";
+	
+	DC_Average = SpectrumAverage ();
+	
+	// the couplings are set up once, they are kept in DC_Results.Hamiltonian (or
+	// DC_Results.SparseHamiltonian) with the unshifted energies on the diagonal
+	if (DC_Error == "") { FitParameters ();           }
+	if (DC_Error == "") { HamiltonianMatrix (false);  }
+	
+	if (DC_Error != "") return DC_ErrorCode;
+	
+	if ( not Disorder ) {
+		for (Group = 0; Group < DC_System.NumberOfGroups; Group++) {
+			SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+			
+			if (CurGroup->ParameterSet != DC_Options.ShiftSet) continue;
+			
+			if (DC_Options.ShiftTrans < 0 or DC_Options.ShiftTrans > CurGroup->NumberOfTransitions) {
+				cerr << "\nERROR: Parameter set " << DC_Options.ShiftSet << " has no transition "
+				     << DC_Options.ShiftTrans << " (--shift).\n\n";
+				DC_Error = "Invalid ensemble";
+				DC_ErrorCode = 190;
+				return 190;
+			}
+			
+			++Found;
+		}
+		
+		if (Found == 0) {
+			cerr << "\nERROR: No group uses the parameter set " << DC_Options.ShiftSet << " (--shift).\n\n";
+			DC_Error = "Parameter set not used";
+			DC_ErrorCode = 191;
+			return 191;
+		}
+	}
+	
+	Ensemble.DC          = this;
+	Ensemble.BaseName    = DC_InFileBaseName;
+	Ensemble.Threads     = NumberOfThreads (DC_Options.Threads, Ensemble.Members);
+	Ensemble.NextMember  = 0;
+	Ensemble.Processed   = 0;
+	Ensemble.ErrorMember = -1;
+	Ensemble.WarmStarts  = 0;
+	Ensemble.SavedSweeps = 0;
+	pthread_mutex_init (&Ensemble.Lock, NULL);
+	
+	if (DC_Verbose) {
+		if (Disorder)
+			printf ("   %d realizations of Gaussian disorder, %.2f cm-1 (seed %d)\n",
+			        Ensemble.Members, DC_Options.Disorder, DC_Options.Seed);
+		else
+			printf ("   %d shift(s) of %s (%d groups), transition %s, %.2f to %.2f cm-1\n",
+			        Ensemble.Members, DC_Options.ShiftSet.c_str(), Found,
+			        (DC_Options.ShiftTrans == 0) ? "all" : tostring (DC_Options.ShiftTrans).c_str(),
+			        DC_Options.ShiftFirst, DC_Options.ShiftLast);
+		
+		printf ("   %d thread(s)\n", Ensemble.Threads);
+	}
+	
+	RunParallel (&Ensemble, Ensemble.Threads, Ensemble.Threads);
+	
+	pthread_mutex_destroy (&Ensemble.Lock);
+	
+	if (Ensemble.ErrorMember >= 0) {
+		cerr << "\nERROR: Calculation of member " << Ensemble.ErrorMember << " of the ensemble failed ("
+		     << DC_Error << "), " << Ensemble.Processed << " members calculated before.\n\n";
+		return DC_ErrorCode;
+	}
+	
+	if (DC_Verbose) printf ("   %d members calculated\n", Ensemble.Processed);
+	
+	if (DC_Verbose and DC_Options.Eigensolver == "warm")
+		printf ("   %d members with a warm start, %d Jacobi sweeps saved\n", Ensemble.WarmStarts,
+		        Ensemble.SavedSweeps);
+	
+	if (DC_Options.Average) return WriteAverage (Disorder ? "realizations" : "shifts");
+	
+	return 0;
+} // of Dichro::EnsembleCalculation
+
+
+// ================================================================================
+
+
+void EnsembleMembers::Run ( int Part )
+// calculates members until none are left, the couplings are copied only once per thread
+{
+	int Member;
+	vector<double> Shift;
+	
+	// DC is only read under the lock, another thread may already report an error
+	pthread_mutex_lock (&Lock);
+	Dichro* Worker = new Dichro (*DC);
+	pthread_mutex_unlock (&Lock);
+	
+	Worker->DC_Verbose = false;
+	
+	// the eigensystem of a member is calculated on a single thread if the members run in parallel
+	if (Threads > 1) Worker->DC_Options.Threads = 1;
+	
+	// the couplings and the unmixed transitions, from which each member starts
+	SymmetricMatrix Couplings;
+	Worker->DC_Results.Hamiltonian.release();
+	Couplings = Worker->DC_Results.Hamiltonian;
+	
+	Dichro::Results Initial = Worker->DC_Results;
+	
+	while (true) {
+		pthread_mutex_lock (&Lock);
+		Member = (ErrorMember < 0 and NextMember < Members) ? NextMember++ : -1;
+		pthread_mutex_unlock (&Lock);
+		
+		if (Member < 0) break;
+		
+		Shifts (Member, Worker, &Shift);
+		Worker->EnsembleMember (Member, BaseName, &Initial, &Couplings, &Shift);
+		
+		pthread_mutex_lock (&Lock);
+		
+		if (Worker->DC_Error == "") {
+			++Processed;
+			
+			if (Worker->DC_Options.Eigensolver == "warm" and Worker->DC_WarmStart.Warm) {
+				++WarmStarts;
+				SavedSweeps += Worker->DC_WarmStart.ColdSweeps - Worker->DC_WarmStart.Sweeps;
+			}
+			
+			string Report = Worker->WarmStartReport ();
+			
+			if (Report.size() > 0) Report = ", " + Report;
+			
+			if (DC->DC_Verbose) {
+				if (DC->DC_Options.Disorder > 0.0)
+					printf ("      Realization %5d: %d states%s\n", Member,
+					        Worker->DC_Results.Eigenvalues.Nrows(), Report.c_str());
+				else
+					printf ("      Shift %10.2f cm-1: %d states%s\n",
+					        DC->DC_Options.ShiftFirst + Member * DC->DC_Options.ShiftStep,
+					        Worker->DC_Results.Eigenvalues.Nrows(), Report.c_str());
+			}
+		}
+		else if (ErrorMember < 0) {
+			ErrorMember = Member;
+			DC->DC_Error     = Worker->DC_Error;
+			DC->DC_ErrorCode = Worker->DC_ErrorCode;
+		}
+		
+		pthread_mutex_unlock (&Lock);
+	}
+	
+	// the averages of the threads are combined, the order does not matter (up to rounding)
+	pthread_mutex_lock (&Lock);
+	DC->DC_Average.Merge (&Worker->DC_Average);
+	pthread_mutex_unlock (&Lock);
+	
+	delete Worker;
+} // of EnsembleMembers::Run
+
+
+// ================================================================================
+
+
+void EnsembleMembers::Shifts ( int Member, Dichro* Worker, vector<double>* Shift )
+// the shifts of the energies of all transitions (in the sequence along the diagonal) of a member
+{
+	Dichro::CalculationOptions* Options = &Worker->DC_Options;
+	unsigned long long State = MemberSeed (Options->Seed, Member);
+	int Group, Trans, Count = 0;
+	
+	Shift->assign (Worker->DC_System.NumberOfTransitions, 0.0);
+	
+	for (Group = 0; Group < Worker->DC_System.NumberOfGroups; Group++) {
+		Dichro::SystemGroup* CurGroup = &Worker->DC_System.Groups.at(Group);
+		bool Shifted = (CurGroup->ParameterSet == Options->ShiftSet);
+		
+		for (Trans = 0; Trans < CurGroup->NumberOfTransitions; Trans++) {
+			if (Options->Disorder > 0.0) {
+				// Box-Muller, two uniform random numbers for each transition
+				double u = UniformNumber (&State);
+				double v = UniformNumber (&State);
+				
+				Shift->at(Count) = Options->Disorder * sqrt (-2.0 * log (u)) * cos (2.0 * M_PI * v);
+			}
+			else if (Shifted and (Options->ShiftTrans == 0 or Options->ShiftTrans == Trans + 1)) {
+				Shift->at(Count) = Options->ShiftFirst + Member * Options->ShiftStep;
+			}
+			
+			++Count;
+		}
+	}
+} // of EnsembleMembers::Shifts
+
+
+// ================================================================================
+
+
+int Dichro::EnsembleMember ( int Member, string BaseName, Results* Initial,
+                             SymmetricMatrix* Couplings, vector<double>* Shift )
+// calculates the spectra of one member of the ensemble from the couplings and the unmixed
+// transitions (Initial) with the energies of the transitions shifted by Shift
+{
+	char Suffix[20];
+	int Group, Trans, Count = 0;
+	
+	sprintf (Suffix, ".%05d", Member);
+	DC_InFileBaseName = BaseName + Suffix;
+	
+	DC_Error     = "";
+	DC_ErrorCode = 0;
+	Warnings.clear();
+	
+	// the results of the previous member are overwritten
+	DC_Results = *Initial;
+	
+	SymmetricMatrix Hamiltonian;
+	SparseMatrix* Sparse = &DC_Results.SparseHamiltonian;
+	
+	if ( not DC_Options.Window ) Hamiltonian = *Couplings;
+	
+	// the shifts are added to the diagonal and to the energies of the transitions, which are
+	// used for the mixing of the moments as well
+	for (Group = 0; Group < DC_System.NumberOfGroups; Group++) {
+		SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+		
+		for (Trans = 0; Trans < CurGroup->NumberOfTransitions; Trans++) {
+			double Energy = Initial->Trans.Energy.at(Count) + Shift->at(Count);
+			
+			CurGroup->Trans.at(Trans).Energy     = Energy;
+			CurGroup->Trans.at(Trans).Wavelength = 1E7 / Energy;
+			DC_Results.Trans.Energy.at(Count)    = Energy;
+			
+			if (DC_Options.Window) {
+				int Element = lower_bound (Sparse->Column.begin() + Sparse->RowStart.at(Count),
+				                           Sparse->Column.begin() + Sparse->RowStart.at(Count+1), Count)
+				              - Sparse->Column.begin();
+				
+				Sparse->Value.at(Element) += Shift->at(Count);
+			}
+			else {
+				Hamiltonian.element (Count, Count) += Shift->at(Count);
+			}
+			
+			++Count;
+		}
+	}
+	
+	Dichro::OpenOutputFiles (true);
+	
+	if (DC_Error == "") { EigenstateCalculation (&Hamiltonian); }
+	if (DC_Error == "") { CD_Calculation ();     }
+	if (DC_Error == "") { LD_Calculation ();     }
+	
+	if (DC_Error == "" and DC_Options.Bandshape.size() > 0) { BandshapeCalculation (); }
+	
+	if (DC_Debug > 1) Dichro::OutputSystemClass  ();
+	if (DC_Debug > 0) Dichro::OutputResultsClass ();
+	
+	Dichro::PrintWarnings ();
+	Dichro::CloseOutputFiles (true);
+	
+	if (DC_Error == "" and DC_Options.Average) DC_Average.Add (&DC_Results.Spectra);
+	
+	return DC_ErrorCode;
+} // of Dichro::EnsembleMember
+
+
+// ================================================================================
+
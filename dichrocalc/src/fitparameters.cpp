@@ -42,6 +42,12 @@ int Dichro::FitParameters ( void )
 	int    AtomNumber = 0;
 	string ParSetName, Origin;
 	
+	// the closed-form fitting (QuaternionRotation), all 3x3 matrices are row-major
+	vector<double> GroupCoords;   // the centered chromophore atoms (atoms x 3)
+	double Correlation[9], Rotation[9];
+	double Diff12[3], Diff32[3];
+	int    Rows;
+	
 	if (DC_Verbose) Dichro::NewTask ( "Fitting Parameters" );
 	
 	if (DC_Debug > 2) {
@@ -95,50 +101,25 @@ int Dichro::FitParameters ( void )
 		// this variable counts all parameter set atoms, i.e. not the number of atoms in the PDB!
 		DC_System.NumberOfAtoms += AtomNumParSet;
 		
-		// the position vector for moving the parameter set atoms to the origin
-		vector<double> PosVecParSet = DC_ParSets.at(Type).Reference;
-		
-		// create a vector with the coordinates of the parameter set atoms
-		vector< vector<double> > CoordParSet;
-		vector< vector<double> > CoordParSetOrigin (AtomNumParSet, vector<double>(3, 0.0));
-		
-		for (Atom = 0; Atom < AtomNumParSet; Atom++) {
-			CoordParSet.push_back (DC_ParSets.at(Type).Atoms.at(Atom).Coord);
-			
-			// Translate each coordinate about the respective reference coordinate.
-			// This moves the parameter set atoms (as well as later on the chromophore atoms)
-			// to the origin, this is needed for the fitting.
-			for (Coord = 0; Coord < 3; Coord++)
-				CoordParSetOrigin.at(Atom).at(Coord) = CoordParSet.at(Atom).at(Coord)
-				                                         - PosVecParSet.at(Coord);
+		// The parameter set atoms translated to the origin and their pseudo inverse do not depend
+		// on the chromophore and are only calculated for the first group of each type.
+		if ( not DC_ParSets.at(Type).Fit.Ready ) {
+			if (Dichro::PrepareFit (&DC_ParSets.at(Type)) != 0) return DC_ErrorCode;
 		}
 		
-		// DEBUG OUTPUT
-		// printf ("\n\n%s\n", ParSetName.c_str());
+		ParSetFit* Fit = &DC_ParSets.at(Type).Fit;
 		
 		if (DC_Debug > 4) {
 			Dichro::NewFileTask (DC_FitFile, "Chromophore " + tostring(Group));
 			
-			fprintf (DC_FitFile, "   Original position of the %d atoms in the %s parameter set:",
-			                     AtomNumParSet, DC_ParSets.at(Type).Name.c_str() );
-			for ( Atom = 0; Atom < AtomNumParSet; Atom++ ) {
-				fprintf (DC_FitFile, "\n      Atom %2d:  ", Atom);
-				
-				for ( Coord = 0; Coord < 3; Coord++ )
-					fprintf (DC_FitFile, "    %12.6f", CoordParSet.at(Atom).at(Coord));
-			}
-			
-			fprintf (DC_FitFile, "\n\n   Position vector: %12.6f    %12.6f    %12.6f\n",
-			         PosVecParSet.at(0), PosVecParSet.at(1), PosVecParSet.at(2));
-			fprintf (DC_FitFile, "\n");
-			
-			fprintf (DC_FitFile, "   Translated to the origin:");
+			fprintf (DC_FitFile, "   Parameter set %s, %d atoms translated to the origin:",
+			                     DC_ParSets.at(Type).Name.c_str(), AtomNumParSet);
 			
 			for ( Atom = 0; Atom < AtomNumParSet; Atom++ ) {
 				fprintf (DC_FitFile, "\n      Atom %2d:  ", Atom);
 				
 				for ( Coord = 0; Coord < 3; Coord++ )
-					fprintf (DC_FitFile, "    %12.6f", CoordParSetOrigin.at(Atom).at(Coord));
+					fprintf (DC_FitFile, "    %12.6f", Fit->Coordinates.element(Atom, Coord));
 			}
 			
 			fprintf (DC_FitFile, "\n\n");
@@ -171,10 +152,11 @@ int Dichro::FitParameters ( void )
 		for (Atom = 0; Atom < AtomNumGroup; Atom++) {
 			// the atom index of the group, e.g. the "3" in "3  4  6"
 			AtomIndex = DC_Input.Chromophores.Atoms.at(Group).at(Atom);
-			CoordGroup.push_back (DC_Input.Coordinates.Groups.at(AtomIndex));
+			double* AtomCoord = DC_Input.Coordinates.Coord (AtomIndex);
+			CoordGroup.push_back (vector<double> (AtomCoord, AtomCoord + 3));
 			
 			for (Coord = 0; Coord < 3; Coord++)
-				PosVecGroup.at(Coord) += DC_Input.Coordinates.Groups.at(AtomIndex).at(Coord);
+				PosVecGroup.at(Coord) += AtomCoord[Coord];
 		}
 		
 		// divide every coordinate by the number of atoms (similar to the center of mass)
@@ -226,22 +208,74 @@ int Dichro::FitParameters ( void )
 			return 140;
 		}
 		
-		// the matrix with the coordinates of the parameter set atoms
-		Matrix ParSetMatrix (AtomNumParSet, 3);   ParSetMatrix = 0.0;  // initialize to zero
-		// the matrix with the coordinates of the chromophore read from the input file
-		Matrix GroupMatrix  (AtomNumGroup, 3);    GroupMatrix = 0.0;  // initialize to zero
+		Matrix RotMatrixUnitary (3, 3);
+		Matrix RotMatrixNonUnitary (3, 3);
 		
-		for (Atom = 0; Atom < AtomNumParSet; Atom++) { // the rows are the atoms
-			for (Coord = 0; Coord < 3; Coord++) {          // the cols are the xyz coordinates
-				// M(r,c) starts counting at 1, M.element(r,c) starts counting at 0
-				ParSetMatrix.element(Atom, Coord) = CoordParSetOrigin.at(Atom).at(Coord);
-				GroupMatrix.element(Atom, Coord)  = CoordGroupOrigin.at(Atom).at(Coord);
+		if (DC_Options.SvdFit) {
+			// the matrix with the coordinates of the chromophore read from the input file
+			Matrix GroupMatrix (AtomNumGroup, 3);
+			
+			for (Atom = 0; Atom < AtomNumGroup; Atom++)    // the rows are the atoms
+				for (Coord = 0; Coord < 3; Coord++)        // the cols are the xyz coordinates
+					GroupMatrix.element(Atom, Coord) = CoordGroupOrigin.at(Atom).at(Coord);
+			
+			if (DC_Debug > 4) {
+				fprintf (DC_FitFile, "\n   Matrix of chromophore atom coordinates:\n");
+				FilePrintMatrix (DC_FitFile, &GroupMatrix);
+			}
+			
+			// the chromophore gets the same virtual atom as a planar parameter set
+			if (Fit->Planar) Dichro::AddVirtualAtom (&GroupMatrix, "Group");
+			
+			RotationMatrix (Fit, &GroupMatrix, &RotMatrixNonUnitary, &RotMatrixUnitary);
+		}
+		else {
+			// the chromophore atoms, a planar parameter set has an additional virtual atom
+			Rows = Fit->Coordinates.nrows();
+			GroupCoords.resize (3 * Rows);
+			
+			for (Atom = 0; Atom < AtomNumGroup; Atom++)
+				for (Coord = 0; Coord < 3; Coord++)
+					GroupCoords.at(3*Atom + Coord) = CoordGroupOrigin.at(Atom).at(Coord);
+			
+			if (Fit->Planar) { // the same point as in AddVirtualAtom
+				for (Coord = 0; Coord < 3; Coord++) {
+					Diff12[Coord] = GroupCoords.at(Coord)     - GroupCoords.at(3 + Coord);
+					Diff32[Coord] = GroupCoords.at(6 + Coord) - GroupCoords.at(3 + Coord);
+				}
+				
+				GroupCoords.at(3*Rows - 3) = Diff12[1] * Diff32[2] - Diff12[2] * Diff32[1];
+				GroupCoords.at(3*Rows - 2) = Diff12[2] * Diff32[0] - Diff12[0] * Diff32[2];
+				GroupCoords.at(3*Rows - 1) = Diff12[0] * Diff32[1] - Diff12[1] * Diff32[0];
+				
+				for (Coord = 0; Coord < 3; Coord++)
+					GroupCoords.at(3*Rows - 3 + Coord) += GroupCoords.at(3 + Coord);
+			}
+			
+			// the pseudo inverse of the parameter set (3 x Rows) times the chromophore (Rows x 3),
+			// this is the transposed non-unitary rotation matrix of RotationMatrix
+			const double* PseudoInverse = Fit->PseudoInverse.Store();
+			
+			for (k = 0; k < 3; k++) {
+				for (l = 0; l < 3; l++) {
+					Correlation[3*k + l] = 0.0;
+					
+					for (Atom = 0; Atom < Rows; Atom++)
+						Correlation[3*k + l] += PseudoInverse[k*Rows + Atom]
+						                        * GroupCoords.at(3*Atom + l);
+				}
+			}
+			
+			QuaternionRotation (Correlation, Rotation);
+			
+			// the matrices are applied transposed (see Rotate)
+			for (k = 0; k < 3; k++) {
+				for (l = 0; l < 3; l++) {
+					RotMatrixNonUnitary.element(k, l) = Correlation[3*k + l];
+					RotMatrixUnitary.element(k, l)    = Rotation[3*l + k];
+				}
 			}
 		}
-		
-		Matrix RotMatrixUnitary (3, 3);
-		Matrix RotMatrixNonUnitary (3, 3);
-		RotationMatrix (Group, ParSetMatrix, GroupMatrix, &RotMatrixNonUnitary, &RotMatrixUnitary);
 		
 		ParSetName = DC_ParSets.at(Type).Name;                // parset name as string
 		ChargeTransfer = DC_ParSets.at(Type).ChargeTransfer;  // CT? - true/false
@@ -267,12 +301,12 @@ int Dichro::FitParameters ( void )
 		int State;             // excitation from ground state to pi* is state 0
 		int StateTransNum;     // the number of transitions to be read from the current state
 		
-		ParSet CurParSet;                // a shortcut to the current parameter set
-		ParSetTrans CurTransParSet;      // a shortcut to the current transition
+		ParSet* CurParSet;               // a shortcut to the current parameter set
+		ParSetTrans* CurTransParSet;     // a shortcut to the current transition
 		
-		CurParSet = DC_ParSets.at(Type);
+		CurParSet = &DC_ParSets.at(Type);
 		
-		AtomNumber += CurParSet.NumberOfAtoms; // count the atoms of all groups
+		AtomNumber += CurParSet->NumberOfAtoms; // count the atoms of all groups
 		
 		// Rotation of the atoms. This is not needed for the actual calculation but
 		// to calculate the fitting accuracy/fitting errors/fitting deviations (pick one).
@@ -281,7 +315,7 @@ int Dichro::FitParameters ( void )
 		for (k = 0; k < 3; k++){
 			for (l = 0; l < 3; l++) {
 				PosVecGroup.at(k) = PosVecGroup.at(k) -
-				                  ( RotMatrixUnitary.element(l, k) * CurParSet.Reference.at(l) );
+				                  ( RotMatrixUnitary.element(l, k) * CurParSet->Reference.at(l) );
 			}
 		}
 		
@@ -292,11 +326,11 @@ int Dichro::FitParameters ( void )
 		vector<SystemTransition> GroupTrans;
 		CurGroup.Trans = GroupTrans;
 		
-		for (Atom = 0; Atom < CurParSet.NumberOfAtoms; Atom++) {
+		for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++) {
 			// create a fresh vector for each atom
 			vector<double> AtomCoords (3, 0.0);
 			// rotate the atom around the origin
-			Rotate (&CurParSet.Atoms.at(Atom).Coord, &AtomCoords, &RotMatrixUnitary);
+			Rotate (&CurParSet->Atoms.at(Atom).Coord, &AtomCoords, &RotMatrixUnitary);
 			
 			for (Coord = 0; Coord < 3; Coord++)
 				// move it to the position of the chromophore
@@ -324,24 +358,24 @@ int Dichro::FitParameters ( void )
 		
 		if (DC_Debug > 4) {
 			fprintf (DC_FitFile, "   Group atoms to be matched:\n");
-			for (Atom = 0; Atom < CurParSet.NumberOfAtoms; Atom++) {
-				FilePrintCoord (DC_FitFile,
-				                &DC_Input.Coordinates.Groups.at( GroupAtomIndices.at(Atom) ));
+			for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++) {
+				double* AtomCoord = DC_Input.Coordinates.Coord (GroupAtomIndices.at(Atom));
+				vector<double> GroupAtom (AtomCoord, AtomCoord + 3);
 				
-				if (DC_PrintXyzFiles)
-					FilePrintCoord (CoordinatesGroup,
-					                &DC_Input.Coordinates.Groups.at( GroupAtomIndices.at(Atom) ));
+				FilePrintCoord (DC_FitFile, &GroupAtom);
+				
+				if (DC_PrintXyzFiles) FilePrintCoord (CoordinatesGroup, &GroupAtom);
 			}
 			
 			fprintf (DC_FitFile, "\n   Position vector:   \n");
 			FilePrintCoord (DC_FitFile, &PosVecGroup);
 			
 			fprintf (DC_FitFile, "\n   Parameter set atoms before:\n");
-			for (Atom = 0; Atom < CurParSet.NumberOfAtoms; Atom++)
-				FilePrintCoord (DC_FitFile, &CurParSet.Atoms.at(Atom).Coord);
+			for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++)
+				FilePrintCoord (DC_FitFile, &CurParSet->Atoms.at(Atom).Coord);
 			
 			fprintf (DC_FitFile, "\n   Parameter set atoms after:\n");
-			for (Atom = 0; Atom < CurParSet.NumberOfAtoms; Atom++) {
+			for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++) {
 				FilePrintCoord (DC_FitFile, &CurGroup.Atoms.at(Atom));
 				
 				if (DC_PrintXyzFiles)
@@ -406,7 +440,7 @@ int Dichro::FitParameters ( void )
 			else { // if it is the permanent moments
 				Permanent = true;
 				// jump to the last state, which are the permanent moments
-				State = CurParSet.States.size() - 1;
+				State = CurParSet->States.size() - 1;
 				
 				// if a specific backbone transition was requested and this is the first parameter set
 				// type (i.e. the backbone parameters)
@@ -439,22 +473,22 @@ int Dichro::FitParameters ( void )
 				                      " - Transition " + tostring (Trans);
 				
 				// a shortcut to the original data from the parset
-				CurTransParSet = CurParSet.States.at(State).at(Trans);
+				CurTransParSet = &CurParSet->States.at(State).at(Trans);
 				// instantiate a new vector for the chromophore
 				SystemTransition CurTransGroup;
 				
 				// DEBUG OUTPUT
 				// if (not Permanent)
 				// 	printf ("State %d,   Transition %d   Energy %8.3f  Wavelength %8.3f\n",
-				// 	         State, Trans, CurTransParSet.Energy, CurTransParSet.Wavelength);
+				// 	         State, Trans, CurTransParSet->Energy, CurTransParSet->Wavelength);
 				// else
 				// 	printf ("Permanent Moments,   Transition %d\n", Trans);
 				// printf ("     %s\n", Origin.c_str());
 				
 				CurTransGroup.Origin     = Origin;
 				CurTransGroup.Permanent  = Permanent;
-				CurTransGroup.Energy     = CurTransParSet.Energy;
-				CurTransGroup.Wavelength = CurTransParSet.Wavelength;
+				CurTransGroup.Energy     = CurTransParSet->Energy;
+				CurTransGroup.Wavelength = CurTransParSet->Wavelength;
 				
 				// Note that there is no .at(Trans).
 				// This takes the state separation out of the equation, i.e. State.Trans for 3 trans
@@ -465,12 +499,12 @@ int Dichro::FitParameters ( void )
 				
 				// rotation of the transition dipole moments
 				vector<double> EDM;
-				Rotate (&CurTransParSet.EDM, &EDM, &RotMatrixUnitary);
+				Rotate (&CurTransParSet->EDM, &EDM, &RotMatrixUnitary);
 				CurTransGroup.EDM = EDM;
 				
 				if (DC_Debug > 4) {
 					fprintf (DC_FitFile, "   Elec. dipole moment before:  ");
-					FilePrintCoord (DC_FitFile, &CurTransParSet.EDM, true);
+					FilePrintCoord (DC_FitFile, &CurTransParSet->EDM, true);
 					fprintf (DC_FitFile, "   Elec. dipole moment after:   ");
 					FilePrintCoord (DC_FitFile, &EDM, true);
 					fprintf (DC_FitFile, "\n");
@@ -478,12 +512,12 @@ int Dichro::FitParameters ( void )
 				
 				if (not Permanent) {
 					vector<double> MDM;
-					Rotate (&CurTransParSet.MDM, &MDM, &RotMatrixUnitary);
+					Rotate (&CurTransParSet->MDM, &MDM, &RotMatrixUnitary);
 					CurTransGroup.MDM = MDM;
 					
 					if (DC_Debug > 4) {
 						fprintf (DC_FitFile, "   Mag. dipole moment before:   ");
-						FilePrintCoord (DC_FitFile, &CurTransParSet.MDM, true);
+						FilePrintCoord (DC_FitFile, &CurTransParSet->MDM, true);
 						fprintf (DC_FitFile, "   Mag. dipole moment after:    ");
 						FilePrintCoord (DC_FitFile, &MDM, true);
 						fprintf (DC_FitFile, "\n");
@@ -494,15 +528,15 @@ int Dichro::FitParameters ( void )
 				vector<ParSetMonopole> Monopoles;
 				
 				// rotation and translation of the monopoles
-				for (Mono = 0; Mono < CurParSet.States.at(State).at(Trans).NumberOfMonopoles; Mono++) {
+				for (Mono = 0; Mono < CurParSet->States.at(State).at(Trans).NumberOfMonopoles; Mono++) {
 					ParSetMonopole Monopole;
 					
-					Rotate (&CurTransParSet.Monopoles.at(Mono).Coord, &Monopole.Coord, &RotMatrixUnitary);
+					Rotate (&CurTransParSet->Monopoles.at(Mono).Coord, &Monopole.Coord, &RotMatrixUnitary);
 					
 					for (Coord = 0; Coord < 3; Coord++)
 						Monopole.Coord.at(Coord) += PosVecGroup.at(Coord);
 					
-					Monopole.Charge = CurTransParSet.Monopoles.at(Mono).Charge;
+					Monopole.Charge = CurTransParSet->Monopoles.at(Mono).Charge;
 					Monopoles.push_back (Monopole);
 				}
 				
@@ -511,7 +545,7 @@ int Dichro::FitParameters ( void )
 				
 				CurTransGroup.Monopoles = Monopoles;
 				CurTransGroup.NumberOfMonopoles =
-						CurParSet.States.at(State).at(Trans).NumberOfMonopoles;
+						CurParSet->States.at(State).at(Trans).NumberOfMonopoles;
 				
 				if (not Permanent)
 					CurGroup.Trans.push_back (CurTransGroup);
@@ -546,6 +580,8 @@ int Dichro::FitParameters ( void )
 					Dichro::OutputFileSeparator (DC_DbgFile, 3);
 		}
 		
+		Dichro::PackGroup (&CurGroup);
+		
 		DC_System.Groups.push_back (CurGroup);
 	} // of for (Group = 0; Group < NumberOfGroups; Group++)
 	
@@ -574,100 +610,141 @@ int Dichro::FitParameters ( void )
 // ================================================================================
 
 
-int Dichro::RotationMatrix ( int Group, Matrix ParSetMatrix, Matrix GroupMatrix,
-                             Matrix* RotMatrixNonUnitary, Matrix* RotMatrixUnitary  )
-// calculated the rotation matrix to turn the second set of atoms into the first one
+bool Dichro::TransitionUsed ( int Type, int States, int State, int Trans )
+// whether FitParameters uses transition Trans of state State of the parameter set Type (the index
+// in DC_Input.Parameters) with States states, has to follow the loops over the states there
 {
-	int Atom;
-	int Cols = ParSetMatrix.ncols();
-	int Rows = ParSetMatrix.nrows();
-	
-	//	printf ("RotationMatrix for Group %d\n", Group);
+	int  GroupTransNum = DC_Input.Parameters.Trans.at(Type);
+	int  Selected = -1;    // the single transition selected by BBTrans or CTTrans
+	bool ChargeTransfer = (DC_Input.Parameters.Name.at(Type).substr (0, 2) == "CT");
 	
-	// adds an additional atom, if a planar system is found
-	Dichro::CheckPlanar ( &ParSetMatrix, &GroupMatrix );
+	if (ChargeTransfer) GroupTransNum = GroupTransNum + 4;
 	
-	// ================================================================================
+	if (DC_Input.Configuration.BBTrans > -1 and Type == 0)
+		Selected = DC_Input.Configuration.BBTrans;
+	else if (DC_Input.Configuration.CTTrans > -1 and ChargeTransfer)
+		Selected = DC_Input.Configuration.CTTrans;
 	
-	if ( (GroupMatrix.ncols() != ParSetMatrix.ncols()) or
-	      (GroupMatrix.nrows() != ParSetMatrix.nrows() ) ) {
-		printf ("\nERROR: Matrix dimensions do not match:\n\n");
-		printf (  "       Chromophore:   %2d x %-2d\n", GroupMatrix.nrows(), GroupMatrix.ncols());
-		printf (  "       Parameter set: %2d x %-2d\n", ParSetMatrix.nrows(), ParSetMatrix.ncols());
-		printf ("\n\n");
-		DC_Error = "Error during parameter fitting";
-		DC_ErrorCode = 143;
-		return 143;
+	// the transitions from the first GroupTransNum states, one less from each state
+	if (State < GroupTransNum) {
+		if (Selected > -1 and Trans == Selected)             return true;
+		if (Selected < 0  and Trans < GroupTransNum - State) return true;
 	}
 	
-	// cout << "Group matrix\n";
-	// cout << setw(15) << GroupMatrix << "\n\n";
-	// cout << "Parameter set matrix\n";
-	// cout << setw(15) << ParSetMatrix << "\n\n";
-	
-	Matrix U (Rows, Cols);
-	Matrix V (Cols, Cols);
-	DiagonalMatrix W (Cols);
-	DiagonalMatrix Winv (Cols);
+	// the permanent moments in the last state
+	if (State == States - 1) {
+		if (Selected > -1 and Trans == 0)             return true;
+		if (Selected < 0  and Trans < GroupTransNum) return true;
+	}
 	
-	SVD (ParSetMatrix, W, U, V);
-	 
-	for (Atom = 0; Atom < 3; ++Atom) {
-		if (W.element(Atom) == 0) {
-			cerr << "\nERROR: The W matrix contains one or more 0 values, cannot perform the\n"
-			     << "       the determination of the rotation matrix.\n\n";
-			DC_Error = "SVD error during group fitting.";
-			DC_ErrorCode = 146;
-			return 146;
+	return false;
+} // of Dichro::TransitionUsed
+
+
+// ================================================================================
+
+
+void Dichro::PackGroup ( SystemGroup* CurGroup )
+// Copies the monopoles of all transitions and permanent moments into the packed arrays used by
+// the Coulomb kernels. In addition, the distinct monopole positions of the transitions in the
+// matrix are collected with the charge of each transition at each of them (0 if a transition
+// has no monopole there), so that all interactions of two groups are calculated at once.
+{
+	unsigned int Trans, Mono;
+	int MatrixTrans, Site;
+	SystemTransition* CurTrans;
+	
+	for (Trans = 0; Trans < CurGroup->Trans.size() + CurGroup->Perm.size(); Trans++) {
+		if (Trans < CurGroup->Trans.size())
+			CurTrans = &CurGroup->Trans.at(Trans);
+		else
+			CurTrans = &CurGroup->Perm.at(Trans - CurGroup->Trans.size());
+		
+		PackedMonopoles Packed;
+		
+		for (Mono = 0; Mono < CurTrans->Monopoles.size(); Mono++) {
+			Packed.X.push_back      (CurTrans->Monopoles.at(Mono).Coord.at(0));
+			Packed.Y.push_back      (CurTrans->Monopoles.at(Mono).Coord.at(1));
+			Packed.Z.push_back      (CurTrans->Monopoles.at(Mono).Coord.at(2));
+			Packed.Charge.push_back (CurTrans->Monopoles.at(Mono).Charge);
 		}
 		
-		Winv.element(Atom) = 1/W.element(Atom);
+		CurTrans->Packed = Packed;
 	}
 	
-	Matrix PseudoInverse (Cols, Rows);
-	PseudoInverse = (V * Winv) * U.t();
-	
-// cout << "Pseudo inverse = ( V.t * Winv )  *  U.t\n";
-// cout << setw(15) << PseudoInverse << "\n\n";
+	// the matrix transitions of CT groups follow the four monomer transitions
+	int Offset = 0;
+	if (CurGroup->ChargeTransfer) Offset = 4;
 	
-	// the original matrix is (m x n) = (atoms x 3)
-	// the pseudo inverse is (m x n), its transpose (n x m) = (3 x atoms)
-	Matrix RNonUnitary (3, 3);
+	PackedMonopoles* Sites = &CurGroup->Coupling;
+	vector< vector<int> > SiteIndex (CurGroup->NumberOfTransitions);
 	
-	RNonUnitary = GroupMatrix.t() * PseudoInverse.t();
-	
-// cout << "Non-unitary RotMatrix = matrix of atoms * pseudo inverse\n";
-// cout << setw(15) << RNonUnitary << "\n\n";
-	
-	// RNonUnitary is (atoms x atoms)
-	Matrix U_rot (Rows, Rows);    U_rot = 0.0;  // initialize to zero
-	Matrix V_rot (Rows, Rows);    V_rot = 0.0;  // initialize to zero
-	DiagonalMatrix W_rot (Rows);  W_rot = 0.0;  // initialize to zero
-	
-	SVD (RNonUnitary, W_rot, U_rot, V_rot);
+	for (MatrixTrans = 0; MatrixTrans < CurGroup->NumberOfTransitions; MatrixTrans++) {
+		CurTrans = &CurGroup->Trans.at(MatrixTrans + Offset);
+		
+		for (Mono = 0; Mono < CurTrans->Packed.X.size(); Mono++) {
+			for (Site = 0; Site < (int) Sites->X.size(); Site++)
+				if (Sites->X.at(Site) == CurTrans->Packed.X.at(Mono) and
+				    Sites->Y.at(Site) == CurTrans->Packed.Y.at(Mono) and
+				    Sites->Z.at(Site) == CurTrans->Packed.Z.at(Mono)) break;
+			
+			if (Site == (int) Sites->X.size()) {
+				Sites->X.push_back (CurTrans->Packed.X.at(Mono));
+				Sites->Y.push_back (CurTrans->Packed.Y.at(Mono));
+				Sites->Z.push_back (CurTrans->Packed.Z.at(Mono));
+			}
+			
+			SiteIndex.at(MatrixTrans).push_back (Site);
+		}
+	}
 	
-	Matrix RUnitary (3, 3);
-	RUnitary = U_rot * V_rot.t();
+	CurGroup->CouplingCharges.assign (CurGroup->NumberOfTransitions,
+	                                  vector<double> (Sites->X.size(), 0.0));
 	
-// cout << "R unitary:\n";
-// cout << setw(15) << RUnitary << "\n\n";
+	for (MatrixTrans = 0; MatrixTrans < CurGroup->NumberOfTransitions; MatrixTrans++)
+		for (Mono = 0; Mono < SiteIndex.at(MatrixTrans).size(); Mono++)
+			CurGroup->CouplingCharges.at(MatrixTrans).at(SiteIndex.at(MatrixTrans).at(Mono)) +=
+				CurGroup->Trans.at(MatrixTrans + Offset).Packed.Charge.at(Mono);
 	
-	*RotMatrixNonUnitary = RNonUnitary.t();
-	*RotMatrixUnitary = RUnitary.t();
+	// the multipole moments about the reference point, used for couplings beyond the cutoff
+	CurGroup->NetCharge.assign  (CurGroup->NumberOfTransitions, 0.0);
+	CurGroup->Dipole.assign     (CurGroup->NumberOfTransitions, vector<double> (3, 0.0));
+	CurGroup->Quadrupole.assign (CurGroup->NumberOfTransitions, vector<double> (9, 0.0));
 	
-	return 0;
-} // of Dichro::RotationMatrix
+	for (MatrixTrans = 0; MatrixTrans < CurGroup->NumberOfTransitions; MatrixTrans++) {
+		for (Site = 0; Site < (int) Sites->X.size(); Site++) {
+			double Charge = CurGroup->CouplingCharges.at(MatrixTrans).at(Site);
+			double r[3];
+			int a, b;
+			
+			r[0] = Sites->X.at(Site) - CurGroup->Reference.at(0);
+			r[1] = Sites->Y.at(Site) - CurGroup->Reference.at(1);
+			r[2] = Sites->Z.at(Site) - CurGroup->Reference.at(2);
+			
+			CurGroup->NetCharge.at(MatrixTrans) += Charge;
+			
+			for (a = 0; a < 3; a++) {
+				CurGroup->Dipole.at(MatrixTrans).at(a) += Charge * r[a];
+				
+				for (b = 0; b < 3; b++)
+					CurGroup->Quadrupole.at(MatrixTrans).at(3*a + b) += Charge * r[a] * r[b];
+			}
+		}
+	}
+} // of Dichro::PackGroup
 
 
 // ================================================================================
 
 
-void Dichro::CheckPlanar ( Matrix* ParSetMatrix, Matrix* GroupMatrix )
+int Dichro::PrepareFit ( ParSet* CurParSet )
+// Prepares the parameter set side of the fitting: the atoms are moved to the origin and the pseudo
+// inverse of their matrix is calculated, this only depends on the .par file. A planar parameter
+// set is extended by a virtual atom, which has to be added to its chromophores as well.
 {
-	int Atom;
-	int AtomNumParSet = ParSetMatrix->nrows();
-	int AtomNumGroup  = GroupMatrix->nrows();
-	bool Planar = false;
+	int Atom, Coord;
+	int AtomNumParSet = CurParSet->Atoms.size();
+	ParSetFit* Fit = &CurParSet->Fit;
 	
 	/*
 	From http://mathworld.wolfram.com/SingularValueDecomposition.html:
@@ -675,26 +752,41 @@ void Dichro::CheckPlanar ( Matrix* ParSetMatrix, Matrix* GroupMatrix )
 	Press et al. (1992) define    U as (m x n), W as (n x n), and V as (n x n).
 	Mathematica [& Wikip.] define U as (m x m), W as (m x n), and V as (n x n).
 	*/
-	Matrix U (AtomNumParSet, 3); U = 0.0;  // initialize to zero, m x n, unitary
-	Matrix V (3, 3);             V = 0.0;  // initialize to zero, n x n, unitary
-	DiagonalMatrix W (3);        W = 0.0;  // initialize to zero, n x n, diagonal
+	Matrix U (AtomNumParSet, 3);   U = 0.0;  // initialize to zero, m x n, unitary
+	Matrix V (3, 3);               V = 0.0;  // initialize to zero, n x n, unitary
+	DiagonalMatrix W (3);          W = 0.0;  // initialize to zero, n x n, diagonal
+	DiagonalMatrix Winv (3);
 	
-	// the product U x W x V
-	Matrix UWV (AtomNumParSet, 3);   UWV = 0.0;  // initialize to zero
+	// translate each atom about the reference coordinate (the chromophore atoms are moved to
+	// their center), this is needed for the fitting
+	Fit->Coordinates.ReSize (AtomNumParSet, 3);
 	
-	// the pseudoinverse (U x 1/W x V)
-	Matrix PseudoInverse (3, AtomNumParSet);   PseudoInverse = 0;  // initialize to zero
+	for (Atom = 0; Atom < AtomNumParSet; Atom++)
+		for (Coord = 0; Coord < 3; Coord++)
+			Fit->Coordinates.element(Atom, Coord) = CurParSet->Atoms.at(Atom).Coord.at(Coord)
+			                                        - CurParSet->Reference.at(Coord);
 	
 	if (DC_Debug > 4) {
-		fprintf (DC_FitFile, "\n   Matrix of chromophore atom coordinates:\n");
-		FilePrintMatrix (DC_FitFile, GroupMatrix);
+		Dichro::NewFileTask (DC_FitFile, "Parameter set " + CurParSet->Name);
+		
+		fprintf (DC_FitFile, "   Original position of the %d atoms in the %s parameter set:",
+		                     AtomNumParSet, CurParSet->Name.c_str() );
+		for ( Atom = 0; Atom < AtomNumParSet; Atom++ ) {
+			fprintf (DC_FitFile, "\n      Atom %2d:  ", Atom);
+			
+			for ( Coord = 0; Coord < 3; Coord++ )
+				fprintf (DC_FitFile, "    %12.6f", CurParSet->Atoms.at(Atom).Coord.at(Coord));
+		}
+		
+		fprintf (DC_FitFile, "\n\n   Position vector: %12.6f    %12.6f    %12.6f\n",
+		         CurParSet->Reference.at(0), CurParSet->Reference.at(1), CurParSet->Reference.at(2));
 		
 		fprintf (DC_FitFile, "\n   Matrix of the parameter set coordinates:\n");
-		FilePrintMatrix (DC_FitFile, ParSetMatrix);
+		FilePrintMatrix (DC_FitFile, &Fit->Coordinates);
 	}
 	
 	// perform a singular value decomposition
-	SVD (*ParSetMatrix, W, U, V);
+	SVD (Fit->Coordinates, W, U, V);
 	
 	if (DC_Debug > 4) {
 		fprintf (DC_FitFile, "\n   Matrix U (parameter set):\n");
@@ -720,87 +812,122 @@ void Dichro::CheckPlanar ( Matrix* ParSetMatrix, Matrix* GroupMatrix )
 	// IMPORTANT: a planar system would run into a division by zero
 	// W has always 3 columns as the initial matrix has 3 (x, y, z)
 	for (Atom = 0; Atom < 3; Atom++)
-		if (W.element(Atom) == 0) Planar = true;
+		if (W.element(Atom) == 0) Fit->Planar = true;
 	
-	if (Planar) {
+	if (Fit->Planar) {
 		if (DC_Debug > 4) {
 			fprintf (DC_FitFile, "\n   Planar system found, adding virtual atom\n");
 			fprintf (DC_FitFile,   "   ----------------------------------------\n\n");
 		}
 		
-		// ================================================================================
-		// Add an additional point to the parameter set atoms
-		// ================================================================================
+		Dichro::AddVirtualAtom (&Fit->Coordinates, "ParSet");
 		
-		// vectors needed for planar systems
-		Matrix Diff12 (1, 3);
-		Matrix Diff32 (1, 3);
-		Matrix Cross  (1, 3);
-		
-		// calculate the difference between the 1st and 2nd point
-		Diff12 = ParSetMatrix->row(1) - ParSetMatrix->row(2);
-		// calulate the difference between the 2nd and 3rd point
-		Diff32 = ParSetMatrix->row(3) - ParSetMatrix->row(2);
-		// calculate the cross product between the difference vectors
-		Cross  = crossproduct (Diff12, Diff32);
-		Cross  = Cross + ParSetMatrix->row(2);
-		
-		if (DC_Debug > 4) {
-			fprintf (DC_FitFile, "   ParSet diff 1-2:     ");
-			FilePrintMatrix (DC_FitFile, &Diff12);
-			fprintf (DC_FitFile, "   ParSet diff 2-3:     ");
-			FilePrintMatrix (DC_FitFile, &Diff32);
-			fprintf (DC_FitFile, "   ParSet crossproduct: ");
-			FilePrintMatrix (DC_FitFile, &Cross);
-		}
-		
-		// add another row to the matrix
-		++AtomNumParSet;  // the virtual atom
-		// (V is still 3x3, 3 being the columns of the original matrix, i.e. x,y,z)
-		ParSetMatrix->resize_keep (AtomNumParSet, 3);  // an additional row
-		Matrix U (AtomNumParSet, 3); U = 0.0;
-		PseudoInverse.resize_keep (3, AtomNumParSet); // an additional column
-		
-		// add the cross product as 'virtual' additional point to the array
-		ParSetMatrix->row(AtomNumParSet) = Cross;
-		
-		
-		// ================================================================================
-		// Add an additional point to the chromophore atoms
-		// ================================================================================
-		
-		// calculate the difference between the 1st and 2nd point
-		Diff12 = GroupMatrix->row(1) - GroupMatrix->row(2);
-		// calulate the difference between the 2nd and 3rd point
-		Diff32 = GroupMatrix->row(3) - GroupMatrix->row(2);
-		// calculate the cross product between the difference vectors
-		Cross  = crossproduct (Diff12, Diff32);
-		Cross  = Cross + GroupMatrix->row(2);
-		
-		if (DC_Debug > 4) {
-			fprintf (DC_FitFile, "\n\n");
-			fprintf (DC_FitFile, "   Group diff 1-2:      ");
-			FilePrintMatrix (DC_FitFile, &Diff12);
-			fprintf (DC_FitFile, "   Group diff 2-3:      ");
-			FilePrintMatrix (DC_FitFile, &Diff32);
-			fprintf (DC_FitFile, "   Group crossproduct:  ");
-			FilePrintMatrix (DC_FitFile, &Cross);
+		SVD (Fit->Coordinates, W, U, V);
+	}
+	
+	for (Atom = 0; Atom < 3; ++Atom) {
+		if (W.element(Atom) == 0) {
+			cerr << "\nERROR: The W matrix contains one or more 0 values, cannot perform the\n"
+			     << "       the determination of the rotation matrix.\n\n";
+			DC_Error = "SVD error during group fitting.";
+			DC_ErrorCode = 146;
+			return 146;
 		}
 		
-		// add another row to the matrix
-		GroupMatrix->resize_keep (AtomNumGroup+1, 3);
-		
-		// add the cross product as 'virtual' additional point to the array
-		GroupMatrix->row(AtomNumParSet) = Cross;
-		
-		++AtomNumGroup;  // the virtual atom
-		
-		if (DC_Debug > 4) {
-			fprintf (DC_FitFile, "\n   Extended matrix of chromophore atom coordinates:\n");
-			FilePrintMatrix (DC_FitFile, GroupMatrix);
-		}
-	} // of if (Planar)
-} // of Dichro::CheckPlanar
+		Winv.element(Atom) = 1/W.element(Atom);
+	}
+	
+	Fit->PseudoInverse = (V * Winv) * U.t();
+	Fit->Ready = true;
+	
+	return 0;
+} // of Dichro::PrepareFit
+
+
+// ================================================================================
+
+
+int Dichro::RotationMatrix ( ParSetFit* Fit, Matrix* GroupMatrix,
+                             Matrix* RotMatrixNonUnitary, Matrix* RotMatrixUnitary  )
+// calculated the rotation matrix to turn the second set of atoms into the first one, the
+// parameter set side is taken from PrepareFit, only a 3x3 SVD is left for each chromophore
+{
+	if ( (GroupMatrix->ncols() != Fit->Coordinates.ncols()) or
+	      (GroupMatrix->nrows() != Fit->Coordinates.nrows() ) ) {
+		printf ("\nERROR: Matrix dimensions do not match:\n\n");
+		printf (  "       Chromophore:   %2d x %-2d\n", GroupMatrix->nrows(), GroupMatrix->ncols());
+		printf (  "       Parameter set: %2d x %-2d\n", Fit->Coordinates.nrows(),
+		                                               Fit->Coordinates.ncols());
+		printf ("\n\n");
+		DC_Error = "Error during parameter fitting";
+		DC_ErrorCode = 143;
+		return 143;
+	}
+	
+	// the original matrix is (m x n) = (atoms x 3)
+	// the pseudo inverse is (m x n), its transpose (n x m) = (3 x atoms)
+	Matrix RNonUnitary (3, 3);
+	
+	RNonUnitary = GroupMatrix->t() * Fit->PseudoInverse.t();
+	
+	Matrix U_rot (3, 3);
+	Matrix V_rot (3, 3);
+	DiagonalMatrix W_rot (3);
+	
+	SVD (RNonUnitary, W_rot, U_rot, V_rot);
+	
+	Matrix RUnitary (3, 3);
+	RUnitary = U_rot * V_rot.t();
+	
+	*RotMatrixNonUnitary = RNonUnitary.t();
+	*RotMatrixUnitary = RUnitary.t();
+	
+	return 0;
+} // of Dichro::RotationMatrix
+
+
+// ================================================================================
+
+
+void Dichro::AddVirtualAtom ( Matrix* CoordMatrix, string Label )
+// adds the cross product of the atoms 1-2 and 3-2 as an additional row to the matrix of a planar
+// set of atoms, Label only names it in the debug output
+{
+	int Atoms = CoordMatrix->nrows();
+	
+	// vectors needed for planar systems
+	Matrix Diff12 (1, 3);
+	Matrix Diff32 (1, 3);
+	Matrix Cross  (1, 3);
+	
+	// calculate the difference between the 1st and 2nd point
+	Diff12 = CoordMatrix->row(1) - CoordMatrix->row(2);
+	// calulate the difference between the 2nd and 3rd point
+	Diff32 = CoordMatrix->row(3) - CoordMatrix->row(2);
+	// calculate the cross product between the difference vectors
+	Cross  = crossproduct (Diff12, Diff32);
+	Cross  = Cross + CoordMatrix->row(2);
+	
+	if (DC_Debug > 4) {
+		fprintf (DC_FitFile, "   %-6s diff 1-2:     ", Label.c_str());
+		FilePrintMatrix (DC_FitFile, &Diff12);
+		fprintf (DC_FitFile, "   %-6s diff 2-3:     ", Label.c_str());
+		FilePrintMatrix (DC_FitFile, &Diff32);
+		fprintf (DC_FitFile, "   %-6s crossproduct: ", Label.c_str());
+		FilePrintMatrix (DC_FitFile, &Cross);
+	}
+	
+	// add another row to the matrix
+	CoordMatrix->resize_keep (Atoms + 1, 3);
+	
+	// add the cross product as 'virtual' additional point to the array
+	CoordMatrix->row(Atoms + 1) = Cross;
+	
+	if (DC_Debug > 4) {
+		fprintf (DC_FitFile, "\n   Extended matrix of %s atom coordinates:\n", Label.c_str());
+		FilePrintMatrix (DC_FitFile, CoordMatrix);
+	}
+} // of Dichro::AddVirtualAtom
 
 
 // ================================================================================
@@ -48,10 +48,10 @@ bool FileExists ( string FileName )
 bool FileExtension ( string Filename, string Extension )
 // checks a filename for a given file extension
 {
-	int Length = Filename.size();
+	unsigned int Length = Filename.size();
 	unsigned int ExtLength = Extension.size();
 	
-	if ( Filename.rfind(".par") == Length-ExtLength )
+	if ( Length >= ExtLength and Filename.rfind(Extension) == Length-ExtLength )
 		return true;
 	else
 		return false;
@@ -85,6 +85,21 @@ bool ReadDir ( string Dir, string Extension, vector<string>* Files )
 // ================================================================================
 
 
+uint64_t Checksum ( const char* Data, uint64_t Size, uint64_t Hash )
+// 64 bit FNV-1a hash of the binary files, to continue a checksum pass the previous hash
+{
+	for (uint64_t i = 0; i < Size; i++) {
+		Hash ^= (unsigned char) Data[i];
+		Hash *= 1099511628211ULL;
+	}
+	
+	return Hash;
+} // of Checksum
+
+
+// ================================================================================
+
+
 void VectorDiff (vector<double>* Vect1, vector<double>* Vect2, vector<double>* DiffVector)
 // calculates the difference between two vectors
 {
@@ -135,6 +150,50 @@ double PointDistance (vector<double>* Vect1, vector<double>* Vect2)
 // ================================================================================
 
 
+double DihedralAngle ( const double* Atom1, const double* Atom2, const double* Atom3,
+                       const double* Atom4 )
+// calculates the dihedral angle (in degrees) of four points like ParsePDB.pm, which returns
+// 360 if it is undefined (e.g. for three points on a line)
+{
+	double V12[3], V23[3], V43[3], P[3], X[3], Y[3];
+	double DotX, DotY, PX, PY;
+	int i;
+	
+	for (i = 0; i < 3; i++) {
+		V12[i] = Atom1[i] - Atom2[i];
+		V23[i] = Atom2[i] - Atom3[i];
+		V43[i] = Atom4[i] - Atom3[i];
+	}
+	
+	P[0] = V23[1] * V12[2] - V12[1] * V23[2];
+	P[1] = V23[2] * V12[0] - V12[2] * V23[0];
+	P[2] = V23[0] * V12[1] - V12[0] * V23[1];
+	
+	X[0] = V23[1] * V43[2] - V43[1] * V23[2];
+	X[1] = V23[2] * V43[0] - V43[2] * V23[0];
+	X[2] = V23[0] * V43[1] - V43[0] * V23[1];
+	
+	Y[0] = V23[1] * X[2] - X[1] * V23[2];
+	Y[1] = V23[2] * X[0] - X[2] * V23[0];
+	Y[2] = V23[0] * X[1] - X[0] * V23[1];
+	
+	DotX = X[0] * X[0] + X[1] * X[1] + X[2] * X[2];
+	DotY = Y[0] * Y[0] + Y[1] * Y[1] + Y[2] * Y[2];
+	
+	if (DotX <= 0.0 or DotY <= 0.0) return 360.0;
+	
+	PX = (P[0] * X[0] + P[1] * X[1] + P[2] * X[2]) / sqrt (DotX);
+	PY = (P[0] * Y[0] + P[1] * Y[1] + P[2] * Y[2]) / sqrt (DotY);
+	
+	if (PX == 0.0 or PY == 0.0) return 360.0;
+	
+	return atan2 (PY, PX) * 57.29578;
+} // of DihedralAngle
+
+
+// ================================================================================
+
+
 string tostring ( unsigned int Integer )
 // cast to a string
 {
@@ -465,7 +524,7 @@ void Dichro::OutputInputChromophoresClass ( void )
 
 void Dichro::OutputInputCoordinatesClass ( void )
 {
-	unsigned int Groups = DC_Input.Coordinates.Groups.size();
+	unsigned int Groups = DC_Input.Coordinates.Number();
 	unsigned int Group, j;
 	
 	if (DC_Debug < 1) {
@@ -480,8 +539,8 @@ void Dichro::OutputInputCoordinatesClass ( void )
 	
 	for (Group = 0; Group < Groups; Group++) {
 		// print each coodinate
-		for (j = 0; j < DC_Input.Coordinates.Groups.at(Group).size(); j++)
-			fprintf (DC_DbgFile, "   %12f", DC_Input.Coordinates.Groups.at(Group).at(j));
+		for (j = 0; j < 3; j++)
+			fprintf (DC_DbgFile, "   %12f", DC_Input.Coordinates.Coord(Group)[j]);
 			
 			fprintf (DC_DbgFile, "     %4d     %3s\n",
 			         DC_Input.Coordinates.Atoms.at(Group),
@@ -563,7 +622,8 @@ void Dichro::OutputParSetTransClass ( ParSetTrans* CurTrans, int Trans, int Stat
 		fprintf (DC_DbgFile,
 		         "\n            x               y               z                 Charge\n");
 		
-		for (Mono = 0; Mono < CurTrans->NumberOfMonopoles; Mono++)
+		// only the monopoles of the used transitions are read (ReadParameterSet)
+		for (Mono = 0; Mono < (int) CurTrans->Monopoles.size(); Mono++)
 			Dichro::OutputParSetMonopoleClass ( &CurTrans->Monopoles.at(Mono) );
 		
 		fprintf (DC_DbgFile, "\n");
@@ -975,8 +1035,15 @@ void Dichro::OutputResultsClass ( void )
 	
 	if (DC_Debug > 4) {
 		// the Hamiltonian matrix
-		Dichro::OutputFileHeadline (DC_DbgFile, "$DC_Results.Hamiltonian: Hamiltonian Matrix");
-		FilePrintMatrix (DC_DbgFile, &DC_Results.Hamiltonian);
+		if (DC_Options.Window) {
+			Dichro::OutputFileHeadline (DC_DbgFile,
+			                            "$DC_Results.SparseHamiltonian: Hamiltonian Matrix");
+			FilePrintMatrix (DC_DbgFile, &DC_Results.SparseHamiltonian);
+		}
+		else {
+			Dichro::OutputFileHeadline (DC_DbgFile, "$DC_Results.Hamiltonian: Hamiltonian Matrix");
+			FilePrintMatrix (DC_DbgFile, &DC_Results.Hamiltonian);
+		}
 		
 		// the eigenvectors
 		Dichro::OutputFileHeadline (DC_DbgFile, "$DC_Results.Eigenvectors: Eigenvectors");
@@ -1250,6 +1317,20 @@ void FilePrintMatrix ( FILE* File, DiagonalMatrix* InMatrix, bool Indent )
 } // of FilePrintMatrix
 
 
+void FilePrintMatrix ( FILE* File, SparseMatrix* InMatrix )
+// prints the stored elements of the lower triangle as row, column, value
+{
+	int row, Element;
+	
+	for (row = 0; row < InMatrix->Dimension; row++) {
+		for (Element = InMatrix->RowStart.at(row); Element < InMatrix->RowStart.at(row+1); Element++)
+			if (InMatrix->Column.at(Element) <= row)
+				fprintf (File, "%6d %6d %17f\n", row, InMatrix->Column.at(Element),
+				         InMatrix->Value.at(Element));
+	}
+} // of FilePrintMatrix
+
+
 // ================================================================================
 
 
@@ -22,11 +22,76 @@
 
 #include "../include/dichrocalc.h"
 
+#include <algorithm>
+
+
+const double Dichro::DC_DistanceThreshold = 0.01;
+
+
+class MonopoleContacts {   // monopoles of two groups closer than the distance threshold
+	public:
+		int    iGroup, jGroup;  // the two groups
+		int    Count;           // the number of skipped pairs of monopole positions
+		double MinDistance;     // the shortest distance found
+		bool   SameGroup;       // in the ground-state terms of overlapping groups
+};
+
+class GroupCells {          // cell list of the group reference points
+	public:
+		double Size;                     // edge length of the cells in Angstrom
+		int    Cells[3];                 // the number of cells along x, y, z
+		double Origin[3];                // the lower corner of the first cell
+		vector< vector<int> > Members;   // the groups in each cell
+		vector<int> GroupCell;           // the cell of each group
+		
+		void Build ( vector<Dichro::SystemGroup>* Groups, double CellSize );
+		void Neighbours ( int Group, vector<int>* List );
+};
+
+class HamiltonianBlocks : public ParallelTask { // the Hamiltonian, one part per group (row block)
+	public:
+		Dichro*          DC;             // the object with the system to calculate
+		SymmetricMatrix* Hamiltonian;    // the matrix to fill
+		vector< vector<int> >*    Columns;  // instead in window mode: the columns of each row
+		vector< vector<double> >* Values;   // and the values (lower triangle, zeros skipped)
+		vector<int>*     GroupStart;     // the first row/column of each group
+		GroupCells*      Cells;          // only if couplings beyond the outer cutoff are neglected
+		double           ExactRadius;    // monopole sums within, multipoles beyond (0 = all exact)
+		double           OuterRadius;    // couplings beyond are neglected (0 = none)
+		vector< vector<MonopoleContacts> > Contacts;  // close monopoles found in each part
+		vector<int>      ExactPairs;     // the number of group pairs of each kind in each part
+		vector<int>      MultipolePairs;
+		vector<int>      NeglectedPairs;
+		vector<double>   MaxError;       // the largest estimated error of the multipole couplings
+		int              FirstRow;       // only the rows of these groups are calculated,
+		int              LastRow;
+		int              FirstPartner;   //    each only with these groups
+		int              LastPartner;
+		Matrix*          Stripe;         // instead for repeat units: rows and columns from
+		int              StripeStart;    //    StripeStart on (symmetry.cpp)
+		int              UnitGroups;     // open repeat units: the groups of a unit, each row only
+		                                 //    with the first and its own unit (0 = off)
+		
+		void Run ( int iGroup );
+		void Store ( int Row, int Col, double Value );
+};
+
+class GroundStateGroups : public ParallelTask {  // the ground-state potential, one part per group
+	public:
+		Dichro*        DC;              // the object with the system to calculate
+		vector<int>    Contacts;        // the skipped monopole pairs of each group
+		vector<double> MinDistance;     // and the shortest distance found
+		
+		void Run ( int Group );
+};
+
 
 // ================================================================================
 
 
-int  Dichro::HamiltonianMatrix ( void )
+int  Dichro::HamiltonianMatrix ( bool Diagonalize )
+// sets up the Hamiltonian and, if Diagonalize is set, calculates the eigenstates, otherwise the
+// matrix is only stored in DC_Results (in window mode it is in DC_Results.SparseHamiltonian)
 {
 	// The diagonal are the excitation energies, each transition is represented by
 	// one element on the diagonal. That is, the total number of transitions in the
@@ -46,7 +111,31 @@ int  Dichro::HamiltonianMatrix ( void )
 	if (DC_Debug > 2)
 		Dichro::NewFileTask (DC_DbgFile, "Setting up Hamiltonian Matrix");
 	
-	SymmetricMatrix Hamiltonian (MatrixDimension);
+	double Cutoff      = DC_Options.Cutoff;
+	double OuterCutoff = DC_Options.OuterCutoff;
+	bool   Window      = DC_Options.Window;
+	
+	if (Window and (DC_Input.Configuration.MinWL <= 0 or
+	                DC_Input.Configuration.MaxWL <= DC_Input.Configuration.MinWL)) {
+		cerr << "\nERROR: The window mode requires MinWL and MaxWL in the $CONFIGURATION section"
+		     << " of the input file.\n\n";
+		DC_Error = "No wavelength window";
+		DC_ErrorCode = 153;
+		return 153;
+	}
+	
+	if (Cutoff < 0.0 or OuterCutoff < 0.0 or (OuterCutoff > 0.0 and Cutoff > OuterCutoff)) {
+		cerr << "\nERROR: Invalid coupling cutoff " << Cutoff << " / " << OuterCutoff
+		     << " Angstrom (the outer cutoff has to be larger).\n\n";
+		DC_Error = "Invalid coupling cutoff";
+		DC_ErrorCode = 152;
+		return 152;
+	}
+	
+	// in window mode, only the non-zero elements are stored (in DC_Results.SparseHamiltonian)
+	SymmetricMatrix Hamiltonian (Window ? 0 : MatrixDimension);
+	vector< vector<int> >    SparseColumns (Window ? MatrixDimension : 0);
+	vector< vector<double> > SparseValues  (Window ? MatrixDimension : 0);
 	
 	Hamiltonian = 0.0;
 	// PrintMatrix (&Hamiltonian);
@@ -121,60 +210,198 @@ int  Dichro::HamiltonianMatrix ( void )
 		fprintf (DC_DbgFile, "\n\n");
 	}
 	
-	if (DC_Debug > 2)
-		fprintf (DC_DbgFile,
-			"                  row , col   =   group - trans / group - trans        Interaction\n");
+	if (Dichro::GroundStatePotential () != 0) return DC_ErrorCode;
 	
-	// the two for loops run over the lower triangle of the matrix (including the diagonal)
-	for (row = 0; row < NumberOfTransitions; row++) {
-		for (col = 0; col <= row; col++) {
-			iGroup = GroupSeq.at(row);
-			iTrans = TransSeq.at(row);
-			
-			jGroup = GroupSeq.at(col);
-			jTrans = TransSeq.at(col);
-			
-			Interaction = 0.0;
+	// the first row (and column) of each group along the diagonal
+	vector<int> GroupStart (NumberOfGroups, 0);
+	
+	for (Group = 1; Group < NumberOfGroups; Group++)
+		GroupStart.at(Group) = GroupStart.at(Group-1) + DC_System.Groups.at(Group-1).NumberOfTransitions;
+	
+	// The elements are independent of each other and are calculated in blocks of two groups on
+	// DC_Options.Threads threads, one part is the lower triangle of the rows of one group. Each
+	// row is written by exactly one thread, the result does not depend on the number of threads.
+	HamiltonianBlocks Blocks;
+	Blocks.DC          = this;
+	Blocks.Hamiltonian = &Hamiltonian;
+	Blocks.Columns     = Window ? &SparseColumns : NULL;
+	Blocks.Values      = Window ? &SparseValues  : NULL;
+	Blocks.GroupStart  = &GroupStart;
+	Blocks.Cells       = NULL;
+	Blocks.ExactRadius = Cutoff;
+	Blocks.OuterRadius = OuterCutoff;
+	Blocks.Contacts.resize (NumberOfGroups);
+	Blocks.ExactPairs.assign     (NumberOfGroups, 0);
+	Blocks.MultipolePairs.assign (NumberOfGroups, 0);
+	Blocks.NeglectedPairs.assign (NumberOfGroups, 0);
+	Blocks.MaxError.assign       (NumberOfGroups, 0.0);
+	Blocks.FirstRow     = 0;
+	Blocks.LastRow      = NumberOfGroups - 1;
+	Blocks.FirstPartner = 0;
+	Blocks.LastPartner  = NumberOfGroups - 1;
+	Blocks.Stripe       = NULL;
+	Blocks.StripeStart  = 0;
+	Blocks.UnitGroups   = 0;
+	
+	if (Cutoff == 0.0) Blocks.ExactRadius = OuterCutoff;
+	
+	// for a ring of repeat units (or with --periodic) only the couplings of the central unit with
+	// itself and the following half of the units are calculated, the matrix is assembled from
+	// them; for an open system the couplings of the first unit with all others and the blocks of
+	// each unit with itself, the other blocks are copies (symmetry.cpp)
+	int Repeats = DC_Options.Repeats;
+	int Central = 0;
+	bool Periodic = false;
+	Matrix Stripe;
+	
+	if (Repeats > 0 and Dichro::RepeatSymmetry (&Central, &Periodic) != 0) return DC_ErrorCode;
+	
+	if (Repeats > 0 and not Periodic) {
+		Blocks.UnitGroups = NumberOfGroups / Repeats;
+	}
+	else if (Repeats > 0) {
+		int UnitGroups = NumberOfGroups / Repeats;
+		int UnitTrans  = NumberOfTransitions / Repeats;
+		
+		Stripe.ReSize ((Repeats / 2 + 1) * UnitTrans, UnitTrans);
+		Stripe = 0.0;
+		
+		Blocks.FirstRow     = Central * UnitGroups;
+		Blocks.LastRow      = (Central + Repeats / 2 + 1) * UnitGroups - 1;
+		Blocks.FirstPartner = Central * UnitGroups;
+		Blocks.LastPartner  = (Central + 1) * UnitGroups - 1;
+		Blocks.Stripe       = &Stripe;
+		Blocks.StripeStart  = Central * UnitTrans;
+	}
+	
+	// with an outer cutoff only the groups in the surrounding cells are considered at all
+	GroupCells Cells;
+	
+	if (OuterCutoff > 0.0) {
+		Cells.Build (&DC_System.Groups, OuterCutoff);
+		Blocks.Cells = &Cells;
+	}
+	
+	int Threads = RunParallel (&Blocks, Blocks.LastRow + 1, DC_Options.Threads);
+	
+	if (Repeats > 0 and not Periodic) {
+		Dichro::RepeatToeplitz (&Hamiltonian);
+	}
+	else if (Repeats > 0) {
+		Dichro::RepeatHamiltonian (&Stripe, &Hamiltonian);
+		Stripe.CleanUp();
+	}
+	
+	if (Window) {
+		DC_Results.SparseHamiltonian.Build (&SparseColumns, &SparseValues);
+		SparseColumns.clear();
+		SparseValues.clear();
+		
+		if (DC_Verbose)
+			printf ("      Sparse matrix: %d non-zero elements (%.2f %%)\n",
+			        (int) DC_Results.SparseHamiltonian.Value.size(),
+			        100.0 * DC_Results.SparseHamiltonian.Value.size()
+			        / max (1.0, (double) MatrixDimension * MatrixDimension));
+	}
+	
+	if (DC_Verbose and Threads > 1) printf ("      %d threads\n", Threads);
+	if (DC_Verbose and CoulombKernel() != "scalar")
+		printf ("      Coulomb kernel: %s\n", CoulombKernel().c_str());
+	
+	if (Cutoff > 0.0 or OuterCutoff > 0.0) {
+		int ExactPairs = 0, MultipolePairs = 0, NeglectedPairs = 0;
+		double MaxError = 0.0, OuterError = 0.0;
+		
+		for (Group = 0; Group < NumberOfGroups; Group++) {
+			ExactPairs     += Blocks.ExactPairs.at(Group);
+			MultipolePairs += Blocks.MultipolePairs.at(Group);
+			NeglectedPairs += Blocks.NeglectedPairs.at(Group);
+			MaxError        = max (MaxError, Blocks.MaxError.at(Group));
+		}
+		
+		// Beyond the outer cutoff, the largest neglected coupling is estimated with the largest
+		// moments of all transitions at the outer cutoff
+		if (OuterCutoff > 0.0 and NeglectedPairs > 0) {
+			double Q = 0.0, p = 0.0, S = 0.0, R = OuterCutoff;
 			
-			// if it is a diagonal element (this is equal to row == col)
-			if (iGroup == jGroup && iTrans == jTrans) {
-				if (DC_System.Groups.at(iGroup).ChargeTransfer) iTrans = iTrans + 4;
-				if (DC_System.Groups.at(jGroup).ChargeTransfer) jTrans = jTrans + 4;
+			for (Group = 0; Group < NumberOfGroups; Group++) {
+				CurGroup = &DC_System.Groups.at(Group);
 				
-				Hamiltonian.element (row, col) =
-					DC_System.Groups.at(iGroup).Trans.at(iTrans).Energy;
+				for (Trans = 0; Trans < CurGroup->NumberOfTransitions; Trans++) {
+					Q = max (Q, fabs (CurGroup->NetCharge.at(Trans)));
+					p = max (p, VectorNorm (&CurGroup->Dipole.at(Trans)));
+					
+					double Norm = 0.0;
+					for (int Element = 0; Element < 9; Element++)
+						Norm += pow (CurGroup->Quadrupole.at(Trans).at(Element), 2);
+					
+					S = max (S, sqrt (Norm));
+				}
 			}
 			
-			// if it is an interaction between transitions on the same group
-			else if ( GroupsOverlap (iGroup, jGroup) ) {
-				Interaction = Dichro::SameGroupInteraction (iGroup, iTrans, jGroup, jTrans );
-				Hamiltonian.element (row, col) = Interaction;
-//				printf ("+ Interaction = %12.8f\n", Interaction);
+			OuterError = Q*Q / R + 2.0 * Q*p / pow (R, 2) + (2.0 * p*p + 3.0 * Q*S) / pow (R, 3)
+			           + 9.0 * p*S / pow (R, 4) + 9.0 * S*S / pow (R, 5);
+		}
+		
+		printf ("\n   Coupling cutoff %.2f / %.2f Angstrom (group pairs):\n", Cutoff, OuterCutoff);
+		printf ("      Exact: %d   Multipole: %d   Neglected: %d\n",
+		        ExactPairs, MultipolePairs, NeglectedPairs);
+		printf ("      Max. estimated error (multipole):     %12.4e cm-1\n", MaxError * 5036.0);
+		printf ("      Max. estimated error (outer cutoff):  %12.4e cm-1\n\n", OuterError * 5036.0);
+		
+		if (DC_Debug > 0) {
+			fprintf (DC_DbgFile, "\n   Coupling cutoff %.2f / %.2f Angstrom (group pairs):\n",
+			         Cutoff, OuterCutoff);
+			fprintf (DC_DbgFile, "      Exact: %d   Multipole: %d   Neglected: %d\n",
+			         ExactPairs, MultipolePairs, NeglectedPairs);
+			fprintf (DC_DbgFile, "      Max. estimated error (multipole):     %12.4e cm-1\n",
+			         MaxError * 5036.0);
+			fprintf (DC_DbgFile, "      Max. estimated error (outer cutoff):  %12.4e cm-1\n\n",
+			         OuterError * 5036.0);
+		}
+	}
+	
+	// the skipped monopoles are reported after the loop, in the order of the groups
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		for (unsigned int Contact = 0; Contact < Blocks.Contacts.at(Group).size(); Contact++) {
+			MonopoleContacts* Close = &Blocks.Contacts.at(Group).at(Contact);
+			
+			printf ("WARNING: Monopole distance below %f Angstrom for the calculation of\n",
+			        DC_DistanceThreshold);
+			printf ("         the interaction on %s. Skipped.\n",
+			        Close->SameGroup ? "the same group" : "different groups");
+			printf ("         Group 1 = %4d  -  Group 2 = %4d,  %d monopole pairs\n",
+			        Close->iGroup, Close->jGroup, Close->Count);
+			printf ("         Distance %8.3f Angstrom\n", Close->MinDistance);
+		}
+	}
+	
+	if (DC_Debug > 2) {
+		fprintf (DC_DbgFile,
+			"                  row , col   =   group - trans / group - trans        Interaction\n");
+		
+		// printed afterwards to keep the sequence of the lines independent of the threads
+		for (row = 0; row < NumberOfTransitions; row++) {
+			for (col = 0; col < row; col++) {
+				iGroup = GroupSeq.at(row);   iTrans = TransSeq.at(row);
+				jGroup = GroupSeq.at(col);   jTrans = TransSeq.at(col);
+				
+				if (Window) Interaction = DC_Results.SparseHamiltonian.Element (row, col);
+				else        Interaction = Hamiltonian.element (row, col);
 				
-				if (DC_Debug > 2)
+				if ( GroupsOverlap (iGroup, jGroup) ) {
 					fprintf (DC_DbgFile,
 					"   Overlap:       %3d , %-3d   =     %3d - %-3d   /   %3d - %-3d   =   %14.6f\n",
 					                   row,  col,      iGroup,  iTrans , jGroup, jTrans , Interaction);
-			}
-			
-			// if it is an interaction between transitions on different groups
-			else if ( not GroupsOverlap (iGroup, jGroup) ) {
-				if (DC_System.Groups.at(iGroup).ChargeTransfer) iTrans = iTrans + 4;
-				if (DC_System.Groups.at(jGroup).ChargeTransfer) jTrans = jTrans + 4;
-				
-				Interaction = Dichro::DifferentGroupInteraction
-				                      (iGroup, iTrans, jGroup, jTrans, false );
-				Hamiltonian.element (row, col) = Interaction;
-//				printf ("+ Interaction = %12.8f\n", Interaction);
-				
-				if (DC_Debug > 2)
+				}
+				else {
+					if (DC_System.Groups.at(iGroup).ChargeTransfer) iTrans = iTrans + 4;
+					if (DC_System.Groups.at(jGroup).ChargeTransfer) jTrans = jTrans + 4;
+					
 					fprintf (DC_DbgFile,
 					"   Non-overlap:   %3d , %-3d   =     %3d - %-3d   /   %3d - %-3d   =   %12.4f\n",
 					                    row,  col,      iGroup,  iTrans , jGroup, jTrans , Interaction);
-			}
-			
-			else {
-				cerr << "\nERROR\n";
+				}
 			}
 		}
 	}
@@ -182,23 +409,66 @@ int  Dichro::HamiltonianMatrix ( void )
 	// printf ("\nHamiltonian matrix in J:\n\n");
 	// PrintMatrix (&Hamiltonian);
 	
-	for (row = 0; row < NumberOfTransitions; row++) {
-		for (col = 0; col < row; col++) {
-			// convert the off-diagonal elements from Joule to cm-1
-			Hamiltonian.element (row, col) *= 5036.0;
-		}
+	// convert the off-diagonal elements from Joule to cm-1
+	if (Window) {
+		SparseMatrix* Sparse = &DC_Results.SparseHamiltonian;
+		
+		for (row = 0; row < NumberOfTransitions; row++)
+			for (int Element = Sparse->RowStart.at(row); Element < Sparse->RowStart.at(row+1); Element++)
+				if (Sparse->Column.at(Element) != row) Sparse->Value.at(Element) *= 5036.0;
+	}
+	else {
+		for (row = 0; row < NumberOfTransitions; row++)
+			for (col = 0; col < row; col++)
+				Hamiltonian.element (row, col) *= 5036.0;
 	}
 	
+	// the matrix is kept for several diagonal energies (ensemble.cpp), handed over without a copy
+	if ( not Diagonalize ) {
+		Hamiltonian.release();
+		DC_Results.Hamiltonian = Hamiltonian;
+		return 0;
+	}
+	
+	return Dichro::EigenstateCalculation (&Hamiltonian);
+} // of Dichro::HamiltonianMatrix
+
+
+// ================================================================================
+
+
+int Dichro::EigenstateCalculation ( SymmetricMatrix* Hamiltonian )
+// diagonalizes the Hamiltonian in cm-1 (DC_Results.SparseHamiltonian in window mode) and
+// calculates the moments of the eigenstates, the matrix is released afterwards
+{
+	int MatrixDimension = DC_System.MatrixDimension;
+	int NumberOfGroups  = DC_System.NumberOfGroups;
+	bool Window         = DC_Options.Window;
+	int Group, row, col;
+	
 	if (DC_Verbose) printf ("   Diagonalizing\n");
 	
-	Matrix Eigenvectors (MatrixDimension, MatrixDimension);
-	SymmetricMatrix WorkSpace (MatrixDimension);
-	DiagonalMatrix Eigenvalues (MatrixDimension);
+	// the results of the diagonalization are stored directly in DC_Results
+	Matrix*         Eigenvectors = &DC_Results.Eigenvectors;
+	DiagonalMatrix* Eigenvalues  = &DC_Results.Eigenvalues;
+	
+	// the complete matrices are only kept for the .mat file and the debug output, otherwise
+	// they are released as soon as the moments of the eigenstates have been calculated
+	bool KeepMatrices = (DC_PrintMat or DC_Debug > 4);
 	
-	// diagonalize the Hamiltonian using the Jacobi mechanism (extremly reliable but slower)
-	Jacobi (Hamiltonian, Eigenvalues, WorkSpace, Eigenvectors);
-	// diagonalize using the householder mechanism (faster)
-	// eigenvalues (Hamiltonian, Eigenvalues, Eigenvectors);
+	// diagonalize the Hamiltonian with the selected eigensolver (Jacobi by default), in window
+	// mode only the states within the wavelength range are calculated
+	if (Window) {
+		if (Dichro::DiagonalizeWindow (&DC_Results.SparseHamiltonian, Eigenvalues, Eigenvectors) != 0)
+			return DC_ErrorCode;
+	}
+	else {
+		Eigenvectors->ReSize (MatrixDimension, MatrixDimension);
+		Eigenvalues->ReSize (MatrixDimension);
+		
+		if (Dichro::DiagonalizeHamiltonian (Hamiltonian, Eigenvalues, Eigenvectors) != 0)
+			return DC_ErrorCode;
+	}
 	
 	row = 0;
 	col = 0;
@@ -216,7 +486,11 @@ int  Dichro::HamiltonianMatrix ( void )
 			col = StartCol; // reset the column to the start column of the submatrix
 			
 			for (CurCol = 0; CurCol <= CurRow; CurCol++) {
-				Submatrix.element(CurRow, CurCol) = Hamiltonian.element(row, col);
+				if (Window)
+					Submatrix.element(CurRow, CurCol) = DC_Results.SparseHamiltonian.Element(row, col);
+				else
+					Submatrix.element(CurRow, CurCol) = Hamiltonian->element(row, col);
+				
 				col++;
 			}
 			row++;
@@ -225,10 +499,18 @@ int  Dichro::HamiltonianMatrix ( void )
 		DC_Results.Groups.at(Group).Submatrix = Submatrix;
 	}
 	
-	// the actual results of the diagonalization
-	DC_Results.Hamiltonian         = Hamiltonian;
-	DC_Results.Eigenvalues         = Eigenvalues;
-	DC_Results.Eigenvectors        = Eigenvectors;
+	// the Hamiltonian is handed over to DC_Results without a copy (release)
+	if (KeepMatrices) {
+		Hamiltonian->release();
+		DC_Results.Hamiltonian = *Hamiltonian;
+	}
+	else {
+		Hamiltonian->CleanUp();
+		DC_Results.Hamiltonian.CleanUp();
+	}
+	
+	// the moments of the eigenstates needed for CD and LD in one pass over the eigenvectors
+	Dichro::MixEigenstates (Eigenvectors);
 	
 	// copy some information on the system to DC_Results
 	DC_Results.MatrixDimension     = DC_System.MatrixDimension;
@@ -240,8 +522,15 @@ int  Dichro::HamiltonianMatrix ( void )
 		if (DC_Verbose) printf ("      Output written to %s\n", DC_MatFilename.c_str());
 		
 		// the Hamiltonian matrix
-		Dichro::OutputFileHeadline (DC_MatFile, "$DC_Results.Hamiltonian: Hamiltonian Matrix", false);
-		FilePrintMatrix (DC_MatFile, &DC_Results.Hamiltonian);
+		if (Window) {
+			Dichro::OutputFileHeadline (DC_MatFile,
+			                            "$DC_Results.SparseHamiltonian: Hamiltonian Matrix", false);
+			FilePrintMatrix (DC_MatFile, &DC_Results.SparseHamiltonian);
+		}
+		else {
+			Dichro::OutputFileHeadline (DC_MatFile, "$DC_Results.Hamiltonian: Hamiltonian Matrix", false);
+			FilePrintMatrix (DC_MatFile, &DC_Results.Hamiltonian);
+		}
 		
 		// the eigenvectors
 		Dichro::OutputFileHeadline (DC_MatFile, "$DC_Results.Eigenvectors: Eigenvectors");
@@ -252,8 +541,476 @@ int  Dichro::HamiltonianMatrix ( void )
 		FilePrintMatrix (DC_MatFile, &DC_Results.Eigenvalues, false );
 	}
 	
+	if ( not KeepMatrices ) Eigenvectors->CleanUp();
+	
 	return 0;
-} // of Dichro::HamiltonianMatrix
+} // of Dichro::EigenstateCalculation
+
+
+// ================================================================================
+
+
+void HamiltonianBlocks::Run ( int iGroup )
+// calculates the lower triangle of the rows of one group (including the diagonal)
+{
+	int jGroup, iTrans, jTrans, Row, Col, Count, Partner;
+	double MinDistance, Distance, Error;
+	vector<double> InvR, Temp, Block;
+	vector<int> Partners;
+	
+	if (iGroup < FirstRow or iGroup > LastRow) return;
+	
+	Dichro::SystemGroup* iCurGroup = &DC->DC_System.Groups.at(iGroup);
+	int iTransNumber = iCurGroup->NumberOfTransitions;
+	
+	// the groups to calculate the blocks with (all others are neglected)
+	if (Cells == NULL) {
+		for (jGroup = FirstPartner; jGroup <= min (iGroup, LastPartner); jGroup++)
+			Partners.push_back (jGroup);
+	}
+	else {
+		Cells->Neighbours (iGroup, &Partners);
+		Partners.insert (Partners.end(), iCurGroup->Overlapping.begin(), iCurGroup->Overlapping.end());
+		sort (Partners.begin(), Partners.end());
+		Partners.erase (unique (Partners.begin(), Partners.end()), Partners.end());
+		Partners.erase (upper_bound (Partners.begin(), Partners.end(), iGroup), Partners.end());
+	}
+	
+	Partners.erase (upper_bound (Partners.begin(), Partners.end(), LastPartner), Partners.end());
+	Partners.erase (Partners.begin(), lower_bound (Partners.begin(), Partners.end(), FirstPartner));
+	
+	int Candidates = min (iGroup, LastPartner) + 1 - FirstPartner;
+	
+	// the blocks of an open system with the other units are copied (RepeatToeplitz)
+	if (UnitGroups > 0) {
+		int Own = (iGroup / UnitGroups) * UnitGroups;
+		vector<int> Kept;
+		
+		for (Partner = 0; Partner < (int) Partners.size(); Partner++)
+			if (Partners.at(Partner) < UnitGroups or Partners.at(Partner) >= Own)
+				Kept.push_back (Partners.at(Partner));
+		
+		Partners.swap (Kept);
+		Candidates = min (iGroup + 1, UnitGroups) + ((Own > 0) ? iGroup + 1 - Own : 0);
+	}
+	
+	NeglectedPairs.at(iGroup) = Candidates - Partners.size();
+	
+	for (Partner = 0; Partner < (int) Partners.size(); Partner++) {
+		jGroup = Partners.at(Partner);
+		int jTransNumber = DC->DC_System.Groups.at(jGroup).NumberOfTransitions;
+		
+		// the interactions of overlapping groups are calculated one by one
+		if ( DC->GroupsOverlap (iGroup, jGroup) ) {
+			Count = 0;
+			MinDistance = DC->DC_DistanceThreshold;
+			
+			for (iTrans = 0; iTrans < iTransNumber; iTrans++) {
+				Row = GroupStart->at(iGroup) + iTrans;
+				
+				for (jTrans = 0; jTrans < jTransNumber; jTrans++) {
+					Col = GroupStart->at(jGroup) + jTrans;
+					if (Col > Row) break;
+					
+					Store (Row, Col, DC->HamiltonianElement (iGroup, iTrans, jGroup, jTrans, &Count,
+					                                         &MinDistance));
+				}
+			}
+			
+			if (Count > 0) {
+				MonopoleContacts Close;
+				Close.iGroup      = iGroup;
+				Close.jGroup      = jGroup;
+				Close.Count       = Count;
+				Close.MinDistance = MinDistance;
+				Close.SameGroup   = true;
+				Contacts.at(iGroup).push_back (Close);
+			}
+			
+			continue;
+		}
+		
+		if (ExactRadius > 0.0 or OuterRadius > 0.0) {
+			Distance = PointDistance (&iCurGroup->Reference, &DC->DC_System.Groups.at(jGroup).Reference);
+			
+			if (OuterRadius > 0.0 and Distance >= OuterRadius) {
+				++NeglectedPairs.at(iGroup);
+				continue;
+			}
+			
+			if (ExactRadius > 0.0 and Distance >= ExactRadius) {
+				DC->MultipoleBlock (iGroup, jGroup, &Block, &Error);
+				
+				++MultipolePairs.at(iGroup);
+				if (Error > MaxError.at(iGroup)) MaxError.at(iGroup) = Error;
+			}
+		}
+		
+		if (Block.size() == 0) {
+			Count = 0;
+			MinDistance = DC->DC_DistanceThreshold;
+			
+			DC->CouplingBlock (iGroup, jGroup, &InvR, &Temp, &Block, &Count, &MinDistance);
+			
+			++ExactPairs.at(iGroup);
+			
+			if (Count > 0) {
+				MonopoleContacts Close;
+				Close.iGroup      = iGroup;
+				Close.jGroup      = jGroup;
+				Close.Count       = Count;
+				Close.MinDistance = MinDistance;
+				Close.SameGroup   = false;
+				Contacts.at(iGroup).push_back (Close);
+			}
+		}
+		
+		for (iTrans = 0; iTrans < iTransNumber; iTrans++)
+			for (jTrans = 0; jTrans < jTransNumber; jTrans++)
+				Store (GroupStart->at(iGroup) + iTrans, GroupStart->at(jGroup) + jTrans,
+				       Block.at(iTrans * jTransNumber + jTrans));
+		
+		Block.clear();
+	}
+} // of HamiltonianBlocks::Run
+
+
+// ================================================================================
+
+
+void HamiltonianBlocks::Store ( int Row, int Col, double Value )
+// writes an element of the lower triangle, in window mode only non-zero ones are kept (and the
+// diagonal), the elements of each row arrive in ascending order of the columns
+{
+	if (Stripe != NULL) {
+		Stripe->element (Row - StripeStart, Col - StripeStart) = Value;
+		return;
+	}
+	
+	if (Columns == NULL) {
+		Hamiltonian->element (Row, Col) = Value;
+		return;
+	}
+	
+	if (Value == 0.0 and Row != Col) return;
+	
+	Columns->at(Row).push_back (Col);
+	Values->at(Row).push_back (Value);
+} // of HamiltonianBlocks::Store
+
+
+// ================================================================================
+
+
+void GroupCells::Build ( vector<Dichro::SystemGroup>* Groups, double CellSize )
+// sorts the reference points of the groups into cubic cells of the given size
+{
+	int Group, Coord, Cell;
+	double Lower[3], Upper[3];
+	
+	for (Coord = 0; Coord < 3; Coord++) {
+		Lower[Coord] =  1.0E30;
+		Upper[Coord] = -1.0E30;
+	}
+	
+	for (Group = 0; Group < (int) Groups->size(); Group++) {
+		for (Coord = 0; Coord < 3; Coord++) {
+			Lower[Coord] = min (Lower[Coord], Groups->at(Group).Reference.at(Coord));
+			Upper[Coord] = max (Upper[Coord], Groups->at(Group).Reference.at(Coord));
+		}
+	}
+	
+	// very sparse systems would create a huge number of empty cells, the cells are enlarged then
+	Size = CellSize;
+	
+	for (Coord = 0; Coord < 3; Coord++)
+		while ( (Upper[Coord] - Lower[Coord]) / Size > 200.0 ) Size = Size * 2.0;
+	
+	for (Coord = 0; Coord < 3; Coord++) {
+		Origin[Coord] = Lower[Coord];
+		Cells[Coord]  = (int) ((Upper[Coord] - Lower[Coord]) / Size) + 1;
+	}
+	
+	Members.assign (Cells[0] * Cells[1] * Cells[2], vector<int> ());
+	GroupCell.assign (Groups->size(), 0);
+	
+	for (Group = 0; Group < (int) Groups->size(); Group++) {
+		int Index[3];
+		
+		for (Coord = 0; Coord < 3; Coord++)
+			Index[Coord] = (int) ((Groups->at(Group).Reference.at(Coord) - Origin[Coord]) / Size);
+		
+		Cell = (Index[2] * Cells[1] + Index[1]) * Cells[0] + Index[0];
+		Members.at(Cell).push_back (Group);
+		GroupCell.at(Group) = Cell;
+	}
+} // of GroupCells::Build
+
+
+// ================================================================================
+
+
+void GroupCells::Neighbours ( int Group, vector<int>* List )
+// returns all groups in the cell of a group and the 26 surrounding ones
+{
+	int Cell = GroupCell.at(Group);
+	int x = Cell % Cells[0];
+	int y = (Cell / Cells[0]) % Cells[1];
+	int z = Cell / (Cells[0] * Cells[1]);
+	int dx, dy, dz;
+	
+	List->clear();
+	
+	for (dz = max (z-1, 0); dz <= min (z+1, Cells[2]-1); dz++)
+		for (dy = max (y-1, 0); dy <= min (y+1, Cells[1]-1); dy++)
+			for (dx = max (x-1, 0); dx <= min (x+1, Cells[0]-1); dx++) {
+				vector<int>* Groups = &Members.at((dz * Cells[1] + dy) * Cells[0] + dx);
+				List->insert (List->end(), Groups->begin(), Groups->end());
+			}
+} // of GroupCells::Neighbours
+
+
+// ================================================================================
+
+
+double Dichro::HamiltonianElement ( int iGroup, int iTrans, int jGroup, int jTrans, int* Contacts,
+                                    double* MinDistance )
+// calculates a single element of the Hamiltonian, the diagonal in cm-1, the interactions in J,
+// monopoles closer than DC_DistanceThreshold are skipped and added to Contacts
+{
+	// if it is a diagonal element (this is equal to row == col)
+	if (iGroup == jGroup && iTrans == jTrans) {
+		if (DC_System.Groups.at(iGroup).ChargeTransfer) iTrans = iTrans + 4;
+		
+		return DC_System.Groups.at(iGroup).Trans.at(iTrans).Energy;
+	}
+	
+	// if it is an interaction between transitions on the same group
+	if ( GroupsOverlap (iGroup, jGroup) )
+		return Dichro::SameGroupInteraction (iGroup, iTrans, jGroup, jTrans, Contacts, MinDistance);
+	
+	// if it is an interaction between transitions on different groups
+	if (DC_System.Groups.at(iGroup).ChargeTransfer) iTrans = iTrans + 4;
+	if (DC_System.Groups.at(jGroup).ChargeTransfer) jTrans = jTrans + 4;
+	
+	return Dichro::DifferentGroupInteraction (iGroup, iTrans, jGroup, jTrans, false, Contacts,
+	                                          MinDistance);
+} // of Dichro::HamiltonianElement
+
+
+// ================================================================================
+
+
+int Dichro::DiagonalizeHamiltonian ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+                                     Matrix* Eigenvectors )
+// diagonalizes the Hamiltonian with the eigensolver given in DC_Options and optionally compares
+// the result with the Jacobi reference
+{
+	string Method = DC_Options.Eigensolver;
+	
+	if ( not EigensolverAvailable (Method) ) {
+		cerr << "\nERROR: Unknown eigensolver " << Method << " (available: "
+		     << EigensolverList () << ").\n\n";
+		DC_Error = "Unknown eigensolver";
+		DC_ErrorCode = 150;
+		return 150;
+	}
+	
+	if (DC_Verbose and Method != "jacobi")
+		printf ("      Eigensolver: %s\n", Method.c_str());
+	
+	int Failed;
+	
+	// repeat units are diagonalized in the blocks of the wave vectors if the matrix is still
+	// block-circulant, groups that are not coupled in separate blocks, the warm start uses the
+	// eigenvectors of the previous call (e.g. of the previous frame)
+	if (DC_Options.Repeats > 0 and RepeatEigensystem (Hamiltonian, Eigenvalues, Eigenvectors) == 0) {
+		Failed = 0;
+		Method = Method + " in blocks";
+		DC_WarmStart.Basis.CleanUp();
+	}
+	else if (DC_Options.Components >= 0.0 and
+	         ComponentEigensystem (Hamiltonian, Eigenvalues, Eigenvectors) == 0) {
+		Failed = 0;
+		Method = Method + " in components";
+		DC_WarmStart.Basis.CleanUp();
+	}
+	else if (Method == "warm") {
+		Failed = WarmStartEigensystem (Hamiltonian, &DC_WarmStart.Basis, Eigenvalues, Eigenvectors,
+		                               &DC_WarmStart.Sweeps, &DC_WarmStart.Warm);
+		
+		if (Failed == 0) {
+			if ( not DC_WarmStart.Warm ) DC_WarmStart.ColdSweeps = DC_WarmStart.Sweeps;
+			
+			DC_WarmStart.Basis = *Eigenvectors;
+			
+			if (DC_Verbose) printf ("      %s\n", WarmStartReport ().c_str());
+		}
+	}
+	else {
+		Failed = SymmetricEigensystem (Method, Hamiltonian, Eigenvalues, Eigenvectors);
+	}
+	
+	if (Failed != 0) {
+		cerr << "\nERROR: Diagonalization of the Hamiltonian failed (" << Method << ").\n\n";
+		DC_Error = "Diagonalization failed";
+		DC_ErrorCode = 151;
+		return 151;
+	}
+	
+	if (DC_Options.CompareSolvers) {
+		int MatrixDimension = Hamiltonian->Nrows();
+		double ValueDeviation, VectorDeviation, Residual;
+		
+		Matrix RefEigenvectors (MatrixDimension, MatrixDimension);
+		DiagonalMatrix RefEigenvalues (MatrixDimension);
+		
+		SymmetricEigensystem ("jacobi", Hamiltonian, &RefEigenvalues, &RefEigenvectors);
+		
+		CompareEigensystems (Hamiltonian, Eigenvalues, Eigenvectors,
+		                     &RefEigenvalues, &RefEigenvectors,
+		                     &ValueDeviation, &VectorDeviation, &Residual);
+		
+		printf ("\n   Eigensolver comparison (%s vs. jacobi, dimension %d):\n",
+		        Method.c_str(), MatrixDimension);
+		printf ("      Max. eigenvalue deviation:    %12.4e cm-1\n", ValueDeviation);
+		printf ("      Max. eigenvector deviation:   %12.4e\n",      VectorDeviation);
+		printf ("      Max. residual |Hv - ev|:      %12.4e cm-1\n\n", Residual);
+		
+		if (DC_Debug > 0) {
+			fprintf (DC_DbgFile, "\n   Eigensolver comparison (%s vs. jacobi):\n", Method.c_str());
+			fprintf (DC_DbgFile, "      Max. eigenvalue deviation:    %12.4e cm-1\n", ValueDeviation);
+			fprintf (DC_DbgFile, "      Max. eigenvector deviation:   %12.4e\n",      VectorDeviation);
+			fprintf (DC_DbgFile, "      Max. residual |Hv - ev|:      %12.4e cm-1\n\n", Residual);
+		}
+	}
+	
+	return 0;
+} // of Dichro::DiagonalizeHamiltonian
+
+
+// ================================================================================
+
+
+string Dichro::WarmStartReport ( void )
+// the Jacobi sweeps of the last diagonalization with -e warm and the sweeps saved compared to
+// the last cold start, empty for the other eigensolvers and matrices diagonalized in blocks
+{
+	char Report[100];
+	
+	if (DC_Options.Eigensolver != "warm" or DC_WarmStart.Basis.Nrows() == 0) return "";
+	
+	if (DC_WarmStart.Warm)
+		sprintf (Report, "%d Jacobi sweeps (warm start, %d saved)", DC_WarmStart.Sweeps,
+		         DC_WarmStart.ColdSweeps - DC_WarmStart.Sweeps);
+	else
+		sprintf (Report, "%d Jacobi sweeps (cold start)", DC_WarmStart.Sweeps);
+	
+	return string (Report);
+} // of Dichro::WarmStartReport
+
+
+// ================================================================================
+
+
+int Dichro::DiagonalizeWindow ( SparseMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+                                Matrix* Eigenvectors )
+// calculates the eigenpairs with energies within the wavelength range MinWL--MaxWL of the input
+// file (sparse.cpp), falls back to the diagonalization of the dense matrix if the window covers
+// a large part of the spectrum or the iteration does not converge
+{
+	string Method = DC_Options.Eigensolver;
+	int MatrixDimension = Hamiltonian->Dimension;
+	
+	if ( not EigensolverAvailable (Method) ) {
+		cerr << "\nERROR: Unknown eigensolver " << Method << " (available: "
+		     << EigensolverList () << ").\n\n";
+		DC_Error = "Unknown eigensolver";
+		DC_ErrorCode = 150;
+		return 150;
+	}
+	
+	// the wavelengths in nm as energies in cm-1
+	double Lower = 1.0E7 / DC_Input.Configuration.MaxWL;
+	double Upper = 1.0E7 / DC_Input.Configuration.MinWL;
+	
+	WindowStatistics Statistics;
+	int Status = WindowEigensystem (Hamiltonian, Lower, Upper, Method,
+	                                Eigenvalues, Eigenvectors, &Statistics);
+	
+	if (DC_Verbose) {
+		printf ("      Window %d-%d nm (%.0f-%.0f cm-1), spectrum %.0f to %.0f cm-1\n",
+		        DC_Input.Configuration.MinWL, DC_Input.Configuration.MaxWL, Lower, Upper,
+		        Statistics.Lower, Statistics.Upper);
+		
+		if (Status == 0)
+			printf ("      %d states, %d iterations, subspace %d, degree %d, residual %.2e cm-1\n",
+			        Eigenvalues->Nrows(), Statistics.Iterations, Statistics.SubspaceSize,
+			        Statistics.Degree, Statistics.Residual);
+	}
+	
+	if (Status == 1) {
+		printf ("WARNING: The eigenvalues within the wavelength window did not converge.\n");
+		printf ("         The complete Hamiltonian is diagonalized instead.\n");
+	}
+	
+	SymmetricMatrix Dense;
+	
+	if (Status != 0 or DC_Options.CompareSolvers) Hamiltonian->Dense (&Dense);
+	
+	if (Status != 0) {
+		if (DC_Verbose and Status == 2)
+			printf ("      Large window, full diagonalization (%s)\n", Method.c_str());
+		
+		Matrix AllEigenvectors (MatrixDimension, MatrixDimension);
+		DiagonalMatrix AllEigenvalues (MatrixDimension);
+		
+		if (SymmetricEigensystem (Method, &Dense, &AllEigenvalues, &AllEigenvectors) != 0) {
+			cerr << "\nERROR: Diagonalization of the Hamiltonian failed (" << Method << ").\n\n";
+			DC_Error = "Diagonalization failed";
+			DC_ErrorCode = 151;
+			return 151;
+		}
+		
+		WindowSelection (&AllEigenvalues, &AllEigenvectors, Lower, Upper, Eigenvalues, Eigenvectors);
+	}
+	
+	if (DC_Options.CompareSolvers) {
+		double ValueDeviation = 0.0, VectorDeviation = 0.0, Residual = 0.0;
+		
+		Matrix AllEigenvectors (MatrixDimension, MatrixDimension), RefEigenvectors;
+		DiagonalMatrix AllEigenvalues (MatrixDimension), RefEigenvalues;
+		
+		SymmetricEigensystem ("jacobi", &Dense, &AllEigenvalues, &AllEigenvectors);
+		WindowSelection (&AllEigenvalues, &AllEigenvectors, Lower, Upper,
+		                 &RefEigenvalues, &RefEigenvectors);
+		
+		if (RefEigenvalues.Nrows() == Eigenvalues->Nrows())
+			CompareEigensystems (&Dense, Eigenvalues, Eigenvectors,
+			                     &RefEigenvalues, &RefEigenvectors,
+			                     &ValueDeviation, &VectorDeviation, &Residual);
+		
+		printf ("\n   Eigensolver comparison (window, %s vs. jacobi, dimension %d):\n",
+		        Method.c_str(), MatrixDimension);
+		printf ("      States in the window:         %6d / %d\n",
+		        Eigenvalues->Nrows(), RefEigenvalues.Nrows());
+		printf ("      Max. eigenvalue deviation:    %12.4e cm-1\n", ValueDeviation);
+		printf ("      Max. eigenvector deviation:   %12.4e\n",      VectorDeviation);
+		printf ("      Max. residual |Hv - ev|:      %12.4e cm-1\n\n", Residual);
+		
+		if (DC_Debug > 0) {
+			fprintf (DC_DbgFile, "\n   Eigensolver comparison (window, %s vs. jacobi):\n",
+			         Method.c_str());
+			fprintf (DC_DbgFile, "      States in the window:         %6d / %d\n",
+			         Eigenvalues->Nrows(), RefEigenvalues.Nrows());
+			fprintf (DC_DbgFile, "      Max. eigenvalue deviation:    %12.4e cm-1\n", ValueDeviation);
+			fprintf (DC_DbgFile, "      Max. eigenvector deviation:   %12.4e\n",      VectorDeviation);
+			fprintf (DC_DbgFile, "      Max. residual |Hv - ev|:      %12.4e cm-1\n\n", Residual);
+		}
+	}
+	
+	return 0;
+} // of Dichro::DiagonalizeWindow
 
 
 // ================================================================================
@@ -264,6 +1021,12 @@ bool Dichro::GroupsOverlap ( int iGroup, int jGroup )
 {
 	if (iGroup == jGroup) return true;
 	
+	// the list is filled by GroundStatePotential, before that the atoms are compared
+	vector<int>* Overlapping = &DC_System.Groups.at(iGroup).Overlapping;
+	
+	if (Overlapping->size() > 0)
+		return binary_search (Overlapping->begin(), Overlapping->end(), jGroup);
+	
 	unsigned int iAtom, jAtom;
 	
 	// if it is a charge-transfer chromophore, the group numbers will be different and
@@ -282,94 +1045,212 @@ bool Dichro::GroupsOverlap ( int iGroup, int jGroup )
 // ================================================================================
 
 
-double Dichro::DifferentGroupInteraction (int iGroup, int iTrans, int jGroup, int jTrans, bool Perm)
-// calculates the interaction of transitions on different groups
+double Dichro::DifferentGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans, bool Perm,
+                                           int* Contacts, double* MinDistance )
+// calculates the interaction of transitions on different groups, the skipped monopole pairs are
+// counted in Contacts (reported by the caller, which may run on several threads)
 {
-	vector<ParSetMonopole>* iMonopoles = &DC_System.Groups.at(iGroup).Trans.at(iTrans).Monopoles;
-	vector<ParSetMonopole>* jMonopoles;
+	PackedMonopoles* iMonopoles = &DC_System.Groups.at(iGroup).Trans.at(iTrans).Packed;
+	PackedMonopoles* jMonopoles;
 	
 	if (not Perm)
-		jMonopoles = &DC_System.Groups.at(jGroup).Trans.at(jTrans).Monopoles;
+		jMonopoles = &DC_System.Groups.at(jGroup).Trans.at(jTrans).Packed;
 	else
-		jMonopoles = &DC_System.Groups.at(jGroup).Perm.at(jTrans).Monopoles;
+		jMonopoles = &DC_System.Groups.at(jGroup).Perm.at(jTrans).Packed;
 	
-	double DistanceThreshold = 0.01;
+	return CoulombInteraction (iMonopoles->X.data(), iMonopoles->Y.data(),
+	                           iMonopoles->Z.data(), iMonopoles->Charge.data(),
+	                           iMonopoles->X.size(),
+	                           jMonopoles->X.data(), jMonopoles->Y.data(),
+	                           jMonopoles->Z.data(), jMonopoles->Charge.data(),
+	                           jMonopoles->X.size(),
+	                           DC_DistanceThreshold, Contacts, MinDistance);
+} // of Dichro::DifferentGroupInteraction
+
+
+// ================================================================================
+
+
+void Dichro::CouplingBlock ( int iGroup, int jGroup, vector<double>* InvR, vector<double>* Temp,
+                             vector<double>* Block, int* Contacts, double* MinDistance )
+// Calculates the interactions of all transitions of two non-overlapping groups in the matrix,
+// Block is filled row-wise with iTrans x jTrans elements. The inverse distances of the
+// monopole positions (see PackGroup) are calculated once for all pairs of transitions.
+{
+	SystemGroup* iCurGroup = &DC_System.Groups.at(iGroup);
+	SystemGroup* jCurGroup = &DC_System.Groups.at(jGroup);
+	PackedMonopoles* iSites = &iCurGroup->Coupling;
+	PackedMonopoles* jSites = &jCurGroup->Coupling;
 	
-	unsigned int iMono, jMono;
-	double Distance, TempInt, Interaction;
+	int iTransNumber = iCurGroup->NumberOfTransitions;
+	int jTransNumber = jCurGroup->NumberOfTransitions;
+	int iSiteNumber  = iSites->X.size();
+	int jSiteNumber  = jSites->X.size();
+	int Trans;
 	
-	// DEBUG OUTPUT
-	// printf ("iGroup %2d  iTrans %2d   (Mono %14.8f) - jGroup %2d  jTrans %2d   (Mono %14.8f)\n",
-	//          iGroup+1,     iTrans+1, iMonopoles->at(0).Charge, jGroup+1,     jTrans+1, jMonopoles->at(0).Charge);
+	InvR->resize  (iSiteNumber * jSiteNumber + 1);
+	Temp->resize  (jTransNumber * iSiteNumber + 1);
+	Block->resize (iTransNumber * jTransNumber + 1);
 	
-	Interaction = 0.0;
+	// the charges of all transitions as one array per group
+	vector<double> iCharges, jCharges;
+	
+	for (Trans = 0; Trans < iTransNumber; Trans++)
+		iCharges.insert (iCharges.end(), iCurGroup->CouplingCharges.at(Trans).begin(),
+		                                 iCurGroup->CouplingCharges.at(Trans).end());
+	
+	for (Trans = 0; Trans < jTransNumber; Trans++)
+		jCharges.insert (jCharges.end(), jCurGroup->CouplingCharges.at(Trans).begin(),
+		                                 jCurGroup->CouplingCharges.at(Trans).end());
 	
-	for (iMono = 0; iMono < iMonopoles->size(); iMono++) {
-		TempInt = 0.0;
+	InverseDistances (iSites->X.data(), iSites->Y.data(), iSites->Z.data(), iSiteNumber,
+	                  jSites->X.data(), jSites->Y.data(), jSites->Z.data(), jSiteNumber,
+	                  DC_DistanceThreshold, InvR->data(), Contacts, MinDistance);
+	
+	CoulombBlock (InvR->data(), iSiteNumber, jSiteNumber, iCharges.data(), iTransNumber,
+	              jCharges.data(), jTransNumber, Temp->data(), Block->data());
+} // of Dichro::CouplingBlock
+
+
+// ================================================================================
+
+
+void Dichro::MultipoleBlock ( int iGroup, int jGroup, vector<double>* Block, double* Error )
+// Approximates the interactions of all transitions of two distant groups by the multipole
+// expansion about their reference points, including all terms up to quadrupole-quadrupole (see
+// PackGroup for the moments). The largest quadrupole-quadrupole term is returned in Error as an
+// estimate of the truncation error, which it matched closely for peptides.
+{
+	SystemGroup* iCurGroup = &DC_System.Groups.at(iGroup);
+	SystemGroup* jCurGroup = &DC_System.Groups.at(jGroup);
+	
+	int iTransNumber = iCurGroup->NumberOfTransitions;
+	int jTransNumber = jCurGroup->NumberOfTransitions;
+	int iTrans, jTrans, a, b, c, e;
+	double d[3], R, R2, T0, T1[3], T2[9], T3[27], T4[81], Term;
+	
+	for (a = 0; a < 3; a++)
+		d[a] = iCurGroup->Reference.at(a) - jCurGroup->Reference.at(a);
+	
+	R2 = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+	R  = sqrt (R2);
+	
+	// the derivatives of 1/R with respect to the distance vector, as the expansion of
+	// 1 / |d + ri - rj| yields the products of these with the moments of both groups
+	T0 = 1.0 / R;
+	
+	for (a = 0; a < 3; a++) {
+		T1[a] = -d[a] / pow (R, 3);
 		
-		for (jMono = 0; jMono < jMonopoles->size(); jMono++) {
-			Distance = PointDistance ( &iMonopoles->at(iMono).Coord, &jMonopoles->at(jMono).Coord );
-			// printf ("jMono %2d  Charge %8.3f  Distance %8.3f\n",
-			//         jMono, jMonopoles->at(jMono).Charge, Distance);
+		for (b = 0; b < 3; b++) {
+			T2[3*a+b] = (3.0 * d[a]*d[b] - R2 * (a==b)) / pow (R, 5);
 			
-			if (Distance < DistanceThreshold) {
-				printf ("WARNING: Monopole distance below %f Angstrom for the calculation of\n",
-				        DistanceThreshold);
-				printf ("         the interaction on different groups. Skipped.\n");
-				printf ("         Group 1 = %4d, Trans 1 = %4d  -  Group 2 = %4d, Trans 2 = %4d\n",
-				        iGroup, iTrans, jGroup, jTrans);
-				printf ("         Distance %8.3f Angstrom\n", Distance);
+			for (c = 0; c < 3; c++) {
+				T3[9*a+3*b+c] = -(15.0 * d[a]*d[b]*d[c]
+				                  - 3.0 * R2 * (d[a] * (b==c) + d[b] * (a==c) + d[c] * (a==b)))
+				                / pow (R, 7);
+				
+				for (e = 0; e < 3; e++)
+					T4[27*a+9*b+3*c+e] = (105.0 * d[a]*d[b]*d[c]*d[e]
+					   - 15.0 * R2 * (d[a]*d[b] * (c==e) + d[a]*d[c] * (b==e) + d[a]*d[e] * (b==c)
+					                + d[b]*d[c] * (a==e) + d[b]*d[e] * (a==c) + d[c]*d[e] * (a==b))
+					   + 3.0 * R2 * R2 * ((a==b) * (c==e) + (a==c) * (b==e) + (a==e) * (b==c)))
+					   / pow (R, 9);
 			}
-			else
-				TempInt = TempInt + ( jMonopoles->at(jMono).Charge / Distance );
 		}
-		
-		Interaction = Interaction + ( iMonopoles->at(iMono).Charge * TempInt );
-		// printf ("Interaction = %12.8f    TempInt = %12.8f\n", Interaction, TempInt);
-		// printf ("iGroup %2d  iTrans %2d   jGroup %2d  jTrans %2d  Int %14.3f\n",
-		//          iGroup,     iTrans,      jGroup,     jTrans,     Interaction);
-		// printf ("iMono.Charge  %8.3f  *  TempInt %14.3f =  Interaction %14.3f\n\n",
-		//         iMonopoles->at(iMono).Charge, TempInt, iMonopoles->at(iMono).Charge * TempInt);
 	}
 	
-	return Interaction;
-} // of Dichro::DifferentGroupInteraction
+	Block->assign (iTransNumber * jTransNumber, 0.0);
+	*Error = 0.0;
+	
+	for (iTrans = 0; iTrans < iTransNumber; iTrans++) {
+		double  iQ = iCurGroup->NetCharge.at(iTrans);
+		double* ip = &iCurGroup->Dipole.at(iTrans).at(0);
+		double* iS = &iCurGroup->Quadrupole.at(iTrans).at(0);
+		
+		// the quadrupole of iTrans contracted with the derivatives
+		double iS2 = 0.0, iS3[3] = {0.0, 0.0, 0.0}, iS4[9];
+		
+		for (c = 0; c < 9; c++) iS4[c] = 0.0;
+		
+		for (a = 0; a < 9; a++) {
+			iS2 += iS[a] * T2[a];
+			
+			for (c = 0; c < 3; c++) iS3[c] += iS[a] * T3[3*a+c];
+			for (c = 0; c < 9; c++) iS4[c] += iS[a] * T4[9*a+c];
+		}
+		
+		for (jTrans = 0; jTrans < jTransNumber; jTrans++) {
+			double  jQ = jCurGroup->NetCharge.at(jTrans);
+			double* jp = &jCurGroup->Dipole.at(jTrans).at(0);
+			double* jS = &jCurGroup->Quadrupole.at(jTrans).at(0);
+			double  V, jS2 = 0.0, iS4jS = 0.0, Dipoles = 0.0;
+			
+			// charge-charge
+			V = iQ * jQ * T0;
+			
+			for (a = 0; a < 3; a++) {
+				// charge-dipole
+				V += jQ * ip[a] * T1[a] - iQ * jp[a] * T1[a];
+				
+				// dipole-quadrupole
+				double jS3 = 0.0;
+				for (b = 0; b < 9; b++) jS3 += T3[9*a+b] * jS[b];
+				V += 0.5 * ip[a] * jS3 - 0.5 * iS3[a] * jp[a];
+				
+				for (b = 0; b < 3; b++) Dipoles += ip[a] * T2[3*a+b] * jp[b];
+			}
+			
+			for (a = 0; a < 9; a++) {
+				jS2   += jS[a] * T2[a];
+				iS4jS += iS4[a] * jS[a];
+			}
+			
+			// dipole-dipole, charge-quadrupole and quadrupole-quadrupole
+			V += -Dipoles + 0.5 * jQ * iS2 + 0.5 * iQ * jS2 + 0.25 * iS4jS;
+			
+			Block->at(iTrans * jTransNumber + jTrans) = V;
+			
+			Term = fabs (0.25 * iS4jS);
+			if (Term > *Error) *Error = Term;
+		}
+	}
+} // of Dichro::MultipoleBlock
 
 
 // ================================================================================
 
 
-double Dichro::SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans )
-// calculates the interaction of transitions on the same group
+int Dichro::SameGroupTransition ( int iGroup, int iTrans, int jGroup, int jTrans, int* Group )
+// Returns the transition between two excited states of overlapping groups (e.g. 2->3), whose
+// density is interacted with the ground state of all other groups, and the group it belongs to.
+// -1 is returned for overlapping CT groups (different group numbers but sharing a peptide bond),
+// which do not interact.
 {
 	SystemGroup* iCurGroup = &DC_System.Groups.at(iGroup);
 	SystemGroup* jCurGroup = &DC_System.Groups.at(jGroup);
-	double Interaction;
-	int Group, Trans;
+	int Trans;
 	
 	// catch overlapping CT-groups (different group numbers but sharing a peptide bond)
 	if (iGroup != jGroup and
-	           (iCurGroup->ChargeTransfer and jCurGroup->ChargeTransfer) ) return 0.0;
+	           (iCurGroup->ChargeTransfer and jCurGroup->ChargeTransfer) ) return -1;
 	
-	Interaction = 0.0;
-
 	if (iCurGroup->ChargeTransfer) {
-		Group = iGroup;
+		*Group = iGroup;
 		Trans = iCurGroup->NumberOfTransitions + 4;
 	}
 	else if (jCurGroup->ChargeTransfer) {
-		Group = jGroup;
+		*Group = jGroup;
 		Trans = iCurGroup->NumberOfTransitions + 4; // no mistake, it's iGroup
 	}
 	else { // non-CT case, iGroup == jGroup
-		Group = iGroup;
+		*Group = iGroup;
 		Trans = iCurGroup->NumberOfTransitions;
 	}
-
+	
 	if (iCurGroup->ChargeTransfer) iTrans = iTrans + 4;
 	if (jCurGroup->ChargeTransfer) jTrans = jTrans + 4;
 	
-	
 	// the "+1" and --Transitions was necessary to deal with the fact that counting starts
 	// at 0 (this wasn't needed in the Fortran version)
 	int MinTrans    = min (iTrans+1, jTrans+1);
@@ -378,38 +1259,59 @@ double Dichro::SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jT
 	--Transitions;
 	
 	// printf ("Min %d    Max %d   Transitions %d\n", MinTrans, MaxTrans, Transitions);
-	// printf ("Same group:  "); //iGroup - iTrans / jGroup - jTrans");
-	// printf ("  %3d - %-3d  /  %3d - %-3d  =>  %3d Transitions\n",
-	//        iGroup+1, iTrans+1, jGroup+1, jTrans+1, Transitions);
+	return Transitions;
+} // of Dichro::SameGroupTransition
+
+
+// ================================================================================
+
+
+double Dichro::SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jTrans, int* Contacts,
+                                      double* MinDistance )
+// calculates the interaction of transitions on the same group
+{
+	int Group, Mono, Overlap;
+	double Interaction;
 	
-	// Now run over all other groups (not the same one of the actual transition, despite
-	// the function name) and interact the GS density with higher states (e.g. 2->3)
-	for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++) {
-		
-		if (DC_System.Groups.at(jGroup).ChargeTransfer) {
-			// CT groups are ignored here since the monomers will be considered later to
-			// represent the ground state
-			// if (DC_Debug > 3)
-				// fprintf (DC_DbgFile, "   Interaction (same group, CT):     %4d - %4d = %8.3f\n",
-				//                        iGroup, jGroup, 0.0);
+	int Transitions = Dichro::SameGroupTransition (iGroup, iTrans, jGroup, jTrans, &Group);
+	
+	if (Transitions < 0) return 0.0;
+	
+	SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+	vector<ParSetMonopole>* Monopoles = &CurGroup->Trans.at(Transitions).Monopoles;
+	vector<int>* SiteIndex = &CurGroup->SiteIndex.at(Transitions);
+	
+	// The transition density is interacted with the ground state density of all other groups
+	// (not the same one of the actual transition, despite the function name), e.g. 2->3. This
+	// is the potential of all permanent moments at the monopoles, see GroundStatePotential.
+	Interaction = 0.0;
+	
+	for (Mono = 0; Mono < (int) Monopoles->size(); Mono++)
+		Interaction += Monopoles->at(Mono).Charge * CurGroup->Potential.at(SiteIndex->at(Mono));
+	
+	// The potential leaves out the groups overlapping with Group, but for a local group
+	// overlapping with a CT group those overlapping with the local group (iGroup) are omitted.
+	// CT groups are ignored anyway, the monomers represent their ground state.
+	if (iGroup != Group) {
+		for (Overlap = 0; Overlap < (int) CurGroup->Overlapping.size(); Overlap++) {
+			jGroup = CurGroup->Overlapping.at(Overlap);
+			
+			if ( not DC_System.Groups.at(jGroup).ChargeTransfer and
+			     not GroupsOverlap (iGroup, jGroup) )
+				Interaction += Dichro::DifferentGroupInteraction (Group, Transitions, jGroup, 0, true,
+				                                                  Contacts, MinDistance);
 		}
-		else {
-			if (not GroupsOverlap (iGroup, jGroup)) {
-				Interaction = Interaction +
-				              Dichro::DifferentGroupInteraction (Group, Transitions, jGroup, 0, true);
-
-				// DEBUG OUTPUT
-				// printf ("& iGroup %2d  iTrans %2d  (Mono %8.3f)  -  jGroup %2d  jTrans %2d (Mono %8.3f)  =>  %12.8f (MinTrans = %d, MaxTrans = %d)\n",
-				//         Group+1, Transitions+1, DC_System.Groups.at(Group).Trans.at(Transitions).Monopoles.at(0).Charge,
-				// 		  jGroup+1, 0+1,           DC_System.Groups.at(jGroup).Perm.at(0).Monopoles.at(0).Charge,
-				// 		  Interaction, MinTrans, MaxTrans);
-			}
+		
+		for (Overlap = 0; Overlap < (int) DC_System.Groups.at(iGroup).Overlapping.size(); Overlap++) {
+			jGroup = DC_System.Groups.at(iGroup).Overlapping.at(Overlap);
+			
+			if ( not DC_System.Groups.at(jGroup).ChargeTransfer and
+			     not GroupsOverlap (Group, jGroup) )
+				Interaction -= Dichro::DifferentGroupInteraction (Group, Transitions, jGroup, 0, true,
+				                                                  Contacts, MinDistance);
 		}
 	}
 	
-	//printf ("iGroup %2d  iTrans %2d   jGroup %2d  Int %14.3f\n",
-	//         iGroup,     iTrans,      jGroup,     Interaction);
-	
 	// printf ("* Interaction = %12.8f\n", Interaction);
 	return Interaction;
 } // of Dichro::SameGroupInteraction
@@ -418,3 +1320,186 @@ double Dichro::SameGroupInteraction ( int iGroup, int iTrans, int jGroup, int jT
 // ================================================================================
 
 
+int Dichro::GroundStatePotential ( void )
+// Prepares the interactions of transitions on the same group with the ground state of all
+// other groups. The permanent moments of the other groups do not change, their potential is
+// calculated once at each monopole position of a group instead of once per matrix element.
+{
+	int Group, jGroup, Trans, iTrans, jTrans, Mono, Site, Overlap, Transitions;
+	unsigned int Atom;
+	SystemGroup* CurGroup;
+	
+	int NumberOfGroups = DC_System.NumberOfGroups;
+	int NumberOfSites  = 0;
+	
+	if (DC_Verbose) printf ("   Calculating ground-state potential\n");
+	
+	// the groups sharing atoms, found via the groups each atom belongs to
+	vector< vector<int> > AtomGroups (DC_Input.Coordinates.Number());
+	
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		CurGroup = &DC_System.Groups.at(Group);
+		CurGroup->Overlapping.clear();
+		
+		for (Atom = 0; Atom < CurGroup->AtomIndices.size(); Atom++)
+			AtomGroups.at(CurGroup->AtomIndices.at(Atom)).push_back (Group);
+	}
+	
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		CurGroup = &DC_System.Groups.at(Group);
+		vector<int> Overlapping (1, Group);
+		
+		for (Atom = 0; Atom < CurGroup->AtomIndices.size(); Atom++) {
+			vector<int>* Groups = &AtomGroups.at(CurGroup->AtomIndices.at(Atom));
+			Overlapping.insert (Overlapping.end(), Groups->begin(), Groups->end());
+		}
+		
+		sort (Overlapping.begin(), Overlapping.end());
+		Overlapping.erase (unique (Overlapping.begin(), Overlapping.end()), Overlapping.end());
+		CurGroup->Overlapping = Overlapping;
+	}
+	
+	// only the transitions between excited states which are actually used in the matrix
+	vector< vector<bool> > Needed (NumberOfGroups);
+	
+	for (Group = 0; Group < NumberOfGroups; Group++)
+		Needed.at(Group).resize (DC_System.Groups.at(Group).Trans.size(), false);
+	
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		CurGroup = &DC_System.Groups.at(Group);
+		
+		for (Overlap = 0; Overlap < (int) CurGroup->Overlapping.size(); Overlap++) {
+			jGroup = CurGroup->Overlapping.at(Overlap);
+			
+			for (iTrans = 0; iTrans < CurGroup->NumberOfTransitions; iTrans++) {
+				for (jTrans = 0; jTrans < DC_System.Groups.at(jGroup).NumberOfTransitions; jTrans++) {
+					if (Group == jGroup and iTrans == jTrans) continue;  // the diagonal
+					
+					int SiteGroup;
+					Transitions = SameGroupTransition (Group, iTrans, jGroup, jTrans, &SiteGroup);
+					if (Transitions >= 0) Needed.at(SiteGroup).at(Transitions) = true;
+				}
+			}
+		}
+	}
+	
+	// collect the distinct monopole positions of these transitions, most transitions of a
+	// parameter set share the same positions
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		CurGroup = &DC_System.Groups.at(Group);
+		CurGroup->Sites.clear();
+		CurGroup->SiteIndex.clear();
+		CurGroup->SiteIndex.resize (CurGroup->Trans.size());
+		
+		for (Trans = 0; Trans < (int) CurGroup->Trans.size(); Trans++) {
+			if (not Needed.at(Group).at(Trans)) continue;
+			
+			vector<ParSetMonopole>* Monopoles = &CurGroup->Trans.at(Trans).Monopoles;
+			
+			for (Mono = 0; Mono < (int) Monopoles->size(); Mono++) {
+				for (Site = 0; Site < (int) CurGroup->Sites.size(); Site++)
+					if (CurGroup->Sites.at(Site) == Monopoles->at(Mono).Coord) break;
+				
+				if (Site == (int) CurGroup->Sites.size())
+					CurGroup->Sites.push_back (Monopoles->at(Mono).Coord);
+				
+				CurGroup->SiteIndex.at(Trans).push_back (Site);
+			}
+		}
+		
+		NumberOfSites += CurGroup->Sites.size();
+	}
+	
+	// the potentials of the groups are independent of each other
+	GroundStateGroups Groups;
+	Groups.DC = this;
+	Groups.Contacts.assign (NumberOfGroups, 0);
+	Groups.MinDistance.assign (NumberOfGroups, DC_DistanceThreshold);
+	
+	RunParallel (&Groups, NumberOfGroups, DC_Options.Threads);
+	
+	// the skipped monopoles are reported after the loop, in the order of the groups
+	for (Group = 0; Group < NumberOfGroups; Group++) {
+		if (Groups.Contacts.at(Group) == 0) continue;
+		
+		printf ("WARNING: Monopole distance below %f Angstrom for the calculation of\n",
+		        DC_DistanceThreshold);
+		printf ("         the ground-state potential on the same group. Skipped.\n");
+		printf ("         Group %4d,  %d monopole pairs\n", Group, Groups.Contacts.at(Group));
+		printf ("         Distance %8.3f Angstrom\n", Groups.MinDistance.at(Group));
+	}
+	
+	if (DC_Debug > 2) {
+		fprintf (DC_DbgFile, "\n   Ground-state potential at the monopoles of each group:\n\n");
+		fprintf (DC_DbgFile, "   group   overlapping   sites\n");
+		
+		for (Group = 0; Group < NumberOfGroups; Group++)
+			fprintf (DC_DbgFile, "   %5d   %11lu   %5lu\n", Group,
+			         DC_System.Groups.at(Group).Overlapping.size(),
+			         DC_System.Groups.at(Group).Sites.size());
+		
+		fprintf (DC_DbgFile, "\n   %d sites in total\n\n", NumberOfSites);
+	}
+	
+	return 0;
+} // of Dichro::GroundStatePotential
+
+
+// ================================================================================
+
+
+void GroundStateGroups::Run ( int Group )
+{
+	DC->GroupPotential (Group, &Contacts.at(Group), &MinDistance.at(Group));
+} // of GroundStateGroups::Run
+
+
+// ================================================================================
+
+
+void Dichro::GroupPotential ( int Group, int* Contacts, double* MinDistance )
+// calculates the potential of the permanent moments of all non-overlapping groups at the
+// monopole positions of a group, counts the skipped monopole pairs in Contacts
+{
+	SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+	int jGroup, Site;
+	
+	CurGroup->Potential.assign (CurGroup->Sites.size(), 0.0);
+	
+	if (CurGroup->Sites.size() == 0) return;
+	
+	for (jGroup = 0; jGroup < DC_System.NumberOfGroups; jGroup++) {
+		// CT groups are ignored here since the monomers will be considered later to
+		// represent the ground state
+		if (DC_System.Groups.at(jGroup).ChargeTransfer) continue;
+		if (GroupsOverlap (Group, jGroup)) continue;
+		
+		for (Site = 0; Site < (int) CurGroup->Sites.size(); Site++)
+			CurGroup->Potential.at(Site) +=
+				Dichro::SitePotential (&CurGroup->Sites.at(Site), jGroup, Contacts, MinDistance);
+	}
+} // of Dichro::GroupPotential
+
+
+// ================================================================================
+
+
+double Dichro::SitePotential ( vector<double>* Site, int jGroup, int* Contacts, double* MinDistance )
+// the potential of the first permanent moment (the ground state) of jGroup at a position, the
+// skipped monopole pairs are counted in Contacts
+{
+	PackedMonopoles* jMonopoles = &DC_System.Groups.at(jGroup).Perm.at(0).Packed;
+	
+	double Charge = 1.0;
+	
+	return CoulombInteraction (&Site->at(0), &Site->at(1), &Site->at(2), &Charge, 1,
+	                           jMonopoles->X.data(), jMonopoles->Y.data(),
+	                           jMonopoles->Z.data(), jMonopoles->Charge.data(),
+	                           jMonopoles->X.size(),
+	                           DC_DistanceThreshold, Contacts, MinDistance);
+} // of Dichro::SitePotential
+
+
+// ================================================================================
+
+
@@ -0,0 +1,351 @@
+// #################################################################################################
+//
+//  Program:      parfile.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Single-pass parser of the parameter set files (.par)
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+
+// A parameter file is read into a single buffer at once. The lines and their fields are only
+// pointers into this buffer and the numbers are converted directly from it with strtod/strtol,
+// which give the same values as atof/atoi on the separate strings of ReadParameterSetLines.
+// As in NextLine, empty lines and lines starting with # are skipped.
+//
+// If the index of the set in the input file is given, only the monopoles of the transitions that
+// FitParameters uses are converted (TransitionUsed). All other transitions keep their energy and
+// dipole moments and the number of monopoles, but the vector of the monopoles remains empty.
+
+class ParFileReader {
+	public:
+		static const int MaxFields = 8;   // the fields of a line that are kept (all are counted)
+		
+		vector<char> Buffer;              // the complete file, terminated by '\0'
+		const char*  Pos;                 // the start of the next line
+		const char*  End;                 // the terminating '\0'
+		const char*  Line;                // the current line without leading/trailing blanks
+		const char*  LineEnd;
+		const char*  Field[MaxFields];    // the first character of each field
+		const char*  FieldEnd[MaxFields];
+		int          Fields;              // the number of fields of the current line
+		
+		bool   Read ( string Filename );
+		bool   NextLine ( void );
+		bool   Contains ( const char* Text, int InField = -1 );
+		string Text ( void ) { return string (Line, LineEnd); }
+		double Double ( int i ) { return strtod (Field[i], NULL); }
+		int    Int ( int i ) { return (int) strtol (Field[i], NULL, 10); }
+		
+		void   Monopole ( Dichro::ParSetMonopole* CurMono );
+};
+
+
+static inline bool IsBlank ( char c )
+{
+	return (c == ' ' or c == '\t' or c == '\r');
+}
+
+
+// ================================================================================
+
+
+bool ParFileReader::Read ( string Filename )
+// reads the complete file into the buffer, false if it could not be read
+{
+	FILE* File = fopen (Filename.c_str(), "rb");
+	long  Size;
+	
+	if (File == NULL) return false;
+	
+	fseek (File, 0, SEEK_END);
+	Size = ftell (File);
+	fseek (File, 0, SEEK_SET);
+	
+	if (Size < 0) { fclose (File); return false; }
+	
+	Buffer.resize (Size + 1);
+	
+	if ( (long) fread (&Buffer.at(0), 1, Size, File) != Size ) { fclose (File); return false; }
+	
+	fclose (File);
+	
+	Buffer.at(Size) = '\0';
+	Pos = &Buffer.at(0);
+	End = Pos + Size;
+	
+	return true;
+} // of ParFileReader::Read
+
+
+// ================================================================================
+
+
+bool ParFileReader::NextLine ( void )
+// moves to the next line that is neither empty nor a comment and splits it into its fields,
+// false if the end of the file is reached
+{
+	const char *Start, *Stop, *c;
+	
+	while (Pos < End) {
+		Start = Pos;
+		Stop  = (const char*) memchr (Pos, '\n', End - Pos);
+		
+		if (Stop == NULL) Stop = End;
+		Pos = (Stop < End) ? Stop + 1 : End;
+		
+		while (Start < Stop and IsBlank (*Start))      ++Start;
+		while (Stop > Start and IsBlank (*(Stop - 1))) --Stop;
+		
+		if (Start == Stop or *Start == '#') continue;
+		
+		Line    = Start;
+		LineEnd = Stop;
+		Fields  = 0;
+		
+		for (c = Line; c < LineEnd; ) {
+			while (c < LineEnd and IsBlank (*c)) ++c;
+			
+			if (c == LineEnd) break;
+			
+			if (Fields < MaxFields) Field[Fields] = c;
+			
+			while (c < LineEnd and not IsBlank (*c)) ++c;
+			
+			if (Fields < MaxFields) FieldEnd[Fields] = c;
+			++Fields;
+		}
+		
+		return true;
+	}
+	
+	return false;
+} // of ParFileReader::NextLine
+
+
+// ================================================================================
+
+
+bool ParFileReader::Contains ( const char* Text, int InField )
+// whether the current line (or only one of its fields) contains Text
+{
+	const char* From = Line;
+	const char* To   = LineEnd;
+	
+	if (InField >= 0) {
+		From = Field[InField];
+		To   = FieldEnd[InField];
+	}
+	
+	return search (From, To, Text, Text + strlen (Text)) != To;
+} // of ParFileReader::Contains
+
+
+// ================================================================================
+
+
+void ParFileReader::Monopole ( Dichro::ParSetMonopole* CurMono )
+// converts the current line into a monopole (x, y, z, charge)
+{
+	CurMono->Coord.resize (3);
+	
+	for (int i = 0; i < 3; i++) CurMono->Coord.at(i) = Double (i);
+	
+	CurMono->Charge = Double (3);
+} // of ParFileReader::Monopole
+
+
+// ================================================================================
+
+
+int Dichro::ReadParameterSet ( string Filename, ParSet* CurParSet, int Type )
+// reads and parses a parameter set file in a single pass, the name and the charge-transfer flag of
+// CurParSet have to be set, with Type (the index in DC_Input.Parameters) only the used monopoles
+// are read
+{
+	ParFileReader File;
+	bool   Permanent, More;
+	int    Atom, Mono, i;
+	unsigned int State, Trans;
+	double Weighting = 0;
+	vector< vector<const char*> > MonopoleLines;   // where the monopoles of each transition start
+	
+	// The matrix method parameter sets were created for the use with a FORTRAN
+	// program and are designed to be read on a line-by-line bases instead of
+	// a block-wise fashion.
+	
+	if ( not File.Read (Filename) or not File.NextLine () ) {
+		cerr << "\nERROR: Could not read file " << Filename.c_str() << "\n\n";
+		DC_Error = "Error reading in parameter set file";
+		DC_ErrorCode = 132;
+		return 132;
+	}
+	
+	// the first line should contain the filename (case-sensitive!)
+	if ( not File.Contains (CurParSet->Name.c_str(), 0) ) {
+		cerr << "\nERROR: In file " << Filename << " the first line does not contain\n"
+		     <<   "       the parameter set name " << CurParSet->Name << ".\n\n";
+		DC_Error = "Format error in parameter set file.";
+		DC_ErrorCode = 133;
+		return 133;
+	}
+	
+	// --------------------------------------------------------------------------------
+	
+	// the second line contains the number of atoms to be read in the following lines
+	if (File.NextLine ())
+		CurParSet->NumberOfAtoms = File.Int (0);
+	else
+		CurParSet->NumberOfAtoms = 0;
+	
+	if (CurParSet->NumberOfAtoms == 0) {
+		cerr << "\nERROR: In file " << Filename
+		     << " the number of atoms could not be interpreted in line\n"
+		     <<   File.Text() << "\n\n";
+		DC_Error = "Format error in parameter set file.";
+		DC_ErrorCode = 134;
+		return 134;
+	}
+	
+	// initialize the coordinates of the reference point
+	CurParSet->Reference.assign (3, 0.0);
+	CurParSet->Atoms.resize (CurParSet->NumberOfAtoms);
+	
+	// now read as many atoms as stated in the line before
+	for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++) {
+		if ( not File.NextLine () or File.Fields < 6 )
+			return ColumnError (CurParSet->Name, File.Text(), 6);
+		
+		ParSetAtom* CurAtom = &CurParSet->Atoms.at(Atom);
+		
+		CurAtom->Coord.resize (3);
+		CurAtom->Weighting = File.Double (3);
+		CurAtom->Label.assign (File.Field[5], File.FieldEnd[5]);
+		
+		for (i = 0; i < 3; i++) {
+			CurAtom->Coord.at(i) = File.Double (i);
+			CurParSet->Reference.at(i) += CurAtom->Coord.at(i) * CurAtom->Weighting;
+		}
+		
+		Weighting = Weighting + CurAtom->Weighting;
+	}
+	
+	// divide each coordinate of the reference point by the weighting factor
+	for (i = 0; i < 3; i++) CurParSet->Reference.at(i) /= Weighting;
+	
+	// --------------------------------------------------------------------------------
+	
+	// after the atoms, a state should follow, starting with &TRANSITION
+	if ( not File.NextLine () or not File.Contains ("&TRANSITION", 0) ) {
+		cerr << "\nERROR: Label &TRANSITION expected in file "
+		     << Filename << " in line\n       " << File.Text() << "\n\n";
+		DC_Error = "Format error in parameter set";
+		DC_ErrorCode = 137;
+		return 137;
+	}
+	
+	More = true;
+	
+	// this loop takes care of the states (started with a &TRANSITION or &PERMANENT label)
+	while ( More and ( File.Contains ("&TRANSITION") or File.Contains ("&PERMANENT") ) ) {
+		Permanent = File.Contains ("&PERMANENT");
+		
+		CurParSet->States.push_back (vector<ParSetTrans> ());
+		vector<ParSetTrans>* CurState = &CurParSet->States.back();
+		
+		MonopoleLines.push_back (vector<const char*> ());
+		
+		// this loop handles the single transitions until the next label
+		More = File.NextLine ();
+		
+		while ( More and not File.Contains ("&TRANSITION") and not File.Contains ("&PERMANENT") ) {
+			CurState->push_back (ParSetTrans ());
+			ParSetTrans* CurTrans = &CurState->back();
+			
+			// the first line of a transition contains the number of monopoles and the energy
+			if (File.Fields < 2) return ColumnError (CurParSet->Name, File.Text(), 2);
+			
+			CurTrans->NumberOfMonopoles = File.Int (0);
+			CurTrans->Energy            = File.Double (1);
+			
+			if (CurTrans->Energy != 0)
+				CurTrans->Wavelength = 1E7 / CurTrans->Energy;
+			else
+				CurTrans->Wavelength = 0;
+			
+			// the next line is the electric transition dipole moment and a scale factor
+			if ( not File.NextLine () or File.Fields < 3 )
+				return ColumnError (CurParSet->Name, File.Text(), 3);
+			
+			CurTrans->EDM.resize (3);
+			for (i = 0; i < 3; i++) CurTrans->EDM.at(i) = File.Double (i);
+			
+			// the permanent moment do not have scale factors and magnetic dipole moments
+			CurTrans->Permanent = Permanent;
+			
+			if ( not Permanent ) {
+				if (File.Fields < 4) return ColumnError (CurParSet->Name, File.Text(), 4);
+				
+				CurTrans->ScaleFactor = File.Double (3);
+				
+				// the next line is the magnetic transition dipole moment
+				if ( not File.NextLine () or File.Fields < 3 )
+					return ColumnError (CurParSet->Name, File.Text(), 3);
+				
+				CurTrans->MDM.resize (3);
+				for (i = 0; i < 3; i++) CurTrans->MDM.at(i) = File.Double (i);
+			}
+			
+			// now a monopole on each line, as many as specified before, without Type they are
+			// converted right away, otherwise only the lines are checked
+			MonopoleLines.back().push_back (File.Pos);
+			
+			if (Type < 0) CurTrans->Monopoles.resize (CurTrans->NumberOfMonopoles);
+			
+			for (Mono = 0; Mono < CurTrans->NumberOfMonopoles; Mono++) {
+				if ( not File.NextLine () or File.Fields < 4 )
+					return ColumnError (CurParSet->Name, File.Text(), 4);
+				
+				if (Type < 0) File.Monopole (&CurTrans->Monopoles.at(Mono));
+			}
+			
+			More = File.NextLine ();  // go to the next line for the while loop checks
+		}
+	}
+	
+	if (Type < 0) return 0;
+	
+	// now that the number of states is known (the last are the permanent moments), the monopoles
+	// of the used transitions are read
+	for (State = 0; State < CurParSet->States.size(); State++) {
+		for (Trans = 0; Trans < CurParSet->States.at(State).size(); Trans++) {
+			if ( not TransitionUsed (Type, CurParSet->States.size(), State, Trans) ) continue;
+			
+			ParSetTrans* CurTrans = &CurParSet->States.at(State).at(Trans);
+			
+			File.Pos = MonopoleLines.at(State).at(Trans);
+			CurTrans->Monopoles.resize (CurTrans->NumberOfMonopoles);
+			
+			for (Mono = 0; Mono < CurTrans->NumberOfMonopoles; Mono++) {
+				File.NextLine ();
+				File.Monopole (&CurTrans->Monopoles.at(Mono));
+			}
+		}
+	}
+	
+	return 0;
+} // of Dichro::ReadParameterSet
+
+
+// ================================================================================
+
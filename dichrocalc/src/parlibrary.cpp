@@ -0,0 +1,421 @@
+// #################################################################################################
+//
+//  Program:      parlibrary.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Binary library of all parameter sets of a directory, written once with
+//                --compile-params and then read instead of the .par files
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+
+// Layout of the library (native byte order, the version has to be increased on any change):
+//
+//    LibHeader                  magic, version, number of sets, checksum of the index
+//    LibIndex  [Sets]           sorted by name: position, size and checksum of each set
+//    for each set:
+//       LibSet                  numbers of atoms, states, transitions, monopoles, reference
+//       LibAtom  [Atoms]
+//       LibTrans [Transitions]  in the order of the file, with the index of their state
+//       double   [Monopoles][4] x, y, z, charge of all transitions, one after another
+//
+// The library is mapped into memory and only the sets of the input file are checked and copied
+// into DC_ParSets, no text is parsed. As in ReadParameterSet, only the monopoles of the
+// transitions used by FitParameters are copied.
+
+static const char     LibMagic[8] = { 'D', 'C', 'P', 'A', 'R', 'L', 'I', 'B' };
+static const uint32_t LibVersion  = 1;
+
+struct LibHeader {
+	char     Magic[8];
+	uint32_t Version;
+	uint32_t Sets;
+	uint64_t FileSize;
+	uint64_t IndexChecksum;
+};
+
+struct LibIndex {
+	char     Name[32];           // '\0'-terminated
+	uint64_t Offset;             // from the start of the file
+	uint64_t Size;
+	uint64_t Checksum;           // of the Size bytes at Offset
+};
+
+struct LibSet {
+	int32_t  Atoms;
+	int32_t  States;
+	int32_t  Transitions;
+	int32_t  Monopoles;
+	double   Reference[3];
+};
+
+struct LibAtom {
+	double   Coord[3];
+	double   Weighting;
+	char     Label[32];          // '\0'-terminated, only used for the debug output
+};
+
+struct LibTrans {
+	int32_t  State;
+	int32_t  Permanent;
+	int32_t  Monopoles;
+	int32_t  Unused;
+	double   Energy;
+	double   Wavelength;
+	double   ScaleFactor;
+	double   EDM[3];
+	double   MDM[3];
+};
+
+
+static bool IndexOrder ( const LibIndex& a, const LibIndex& b )
+{
+	return strcmp (a.Name, b.Name) < 0;
+}
+
+
+// ================================================================================
+
+
+int Dichro::WriteParameterLibrary ( string LibFile )
+// reads all parameter sets of the directory DC_Params and writes them to the library LibFile
+{
+	unsigned int CurFile, Atom, State, Trans, Mono;
+	vector<string> ParFiles, Names;
+	vector<LibIndex> Index;
+	vector< vector<char> > Data;
+	LibHeader Header;
+	uint64_t Offset;
+	
+	if (DC_Params.size() == 0) DC_Params = ".";
+	if (DC_Params.rfind("/") == DC_Params.size()-1) DC_Params.erase(DC_Params.size()-1, 1);
+	
+	if ( not ReadDir (DC_Params, ".par", &ParFiles) ) {
+		cerr << "\nERROR: Could not read directory " << DC_Params << "\n\n";
+		DC_Error = "Error reading directory with parameter files";
+		DC_ErrorCode = 130;
+		return 130;
+	}
+	
+	// the sets are stored in the order of the index, sorted by name
+	for (CurFile = 0; CurFile < ParFiles.size(); CurFile++)
+		Names.push_back (ParFiles.at(CurFile).substr (0, ParFiles.at(CurFile).size() - 4));
+	
+	sort (Names.begin(), Names.end());
+	
+	Index.resize (Names.size());
+	Data.resize (Names.size());
+	
+	for (CurFile = 0; CurFile < Names.size(); CurFile++) {
+		ParSet CurParSet;
+		LibSet Set;
+		vector<LibAtom>  Atoms;
+		vector<LibTrans> Transitions;
+		vector<double>   Monopoles;
+		
+		CurParSet.Name = Names.at(CurFile);
+		CurParSet.ChargeTransfer = (CurParSet.Name.substr (0, 2) == "CT");
+		
+		if (CurParSet.Name.size() >= sizeof (Index.at(CurFile).Name)) {
+			cerr << "\nERROR: The name of parameter set " << CurParSet.Name << " is too long.\n\n";
+			DC_Error = "Error writing parameter library";
+			DC_ErrorCode = 138;
+			return 138;
+		}
+		
+		if (ReadParameterSet (DC_Params + "/" + CurParSet.Name + ".par", &CurParSet) != 0)
+			return DC_ErrorCode;
+		
+		if (DC_Verbose)
+			printf ("   %-12s %3d atoms, %2d states\n", CurParSet.Name.c_str(),
+			        CurParSet.NumberOfAtoms, (int) CurParSet.States.size());
+		
+		// all fields are set, the padding of the structures is written as well
+		memset (&Set, 0, sizeof (Set));
+		
+		Set.Atoms  = CurParSet.Atoms.size();
+		Set.States = CurParSet.States.size();
+		for (Mono = 0; Mono < 3; Mono++) Set.Reference[Mono] = CurParSet.Reference.at(Mono);
+		
+		Atoms.resize (CurParSet.Atoms.size());   // zero-initialized
+		
+		for (Atom = 0; Atom < CurParSet.Atoms.size(); Atom++) {
+			ParSetAtom* CurAtom = &CurParSet.Atoms.at(Atom);
+			
+			for (Mono = 0; Mono < 3; Mono++) Atoms.at(Atom).Coord[Mono] = CurAtom->Coord.at(Mono);
+			Atoms.at(Atom).Weighting = CurAtom->Weighting;
+			strncpy (Atoms.at(Atom).Label, CurAtom->Label.c_str(), sizeof (Atoms.at(Atom).Label) - 1);
+		}
+		
+		for (State = 0; State < CurParSet.States.size(); State++) {
+			for (Trans = 0; Trans < CurParSet.States.at(State).size(); Trans++) {
+				ParSetTrans* CurTrans = &CurParSet.States.at(State).at(Trans);
+				LibTrans T;
+				
+				memset (&T, 0, sizeof (T));
+				
+				T.State       = State;
+				T.Permanent   = CurTrans->Permanent;
+				T.Monopoles   = CurTrans->Monopoles.size();
+				T.Energy      = CurTrans->Energy;
+				T.Wavelength  = CurTrans->Wavelength;
+				T.ScaleFactor = CurTrans->Permanent ? 0.0 : CurTrans->ScaleFactor;
+				
+				for (Mono = 0; Mono < 3; Mono++) {
+					T.EDM[Mono] = CurTrans->EDM.at(Mono);
+					if ( not CurTrans->Permanent ) T.MDM[Mono] = CurTrans->MDM.at(Mono);
+				}
+				
+				Transitions.push_back (T);
+				
+				for (Mono = 0; Mono < CurTrans->Monopoles.size(); Mono++) {
+					ParSetMonopole* CurMono = &CurTrans->Monopoles.at(Mono);
+					
+					Monopoles.push_back (CurMono->Coord.at(0));
+					Monopoles.push_back (CurMono->Coord.at(1));
+					Monopoles.push_back (CurMono->Coord.at(2));
+					Monopoles.push_back (CurMono->Charge);
+				}
+			}
+		}
+		
+		Set.Transitions = Transitions.size();
+		Set.Monopoles   = Monopoles.size() / 4;
+		
+		// the set as one block of bytes
+		vector<char>* Block = &Data.at(CurFile);
+		
+		Block->insert (Block->end(), (char*) &Set, (char*) (&Set + 1));
+		if (Atoms.size() > 0)
+			Block->insert (Block->end(), (char*) &Atoms.at(0), (char*) (&Atoms.at(0) + Atoms.size()));
+		if (Transitions.size() > 0)
+			Block->insert (Block->end(), (char*) &Transitions.at(0),
+			               (char*) (&Transitions.at(0) + Transitions.size()));
+		if (Monopoles.size() > 0)
+			Block->insert (Block->end(), (char*) &Monopoles.at(0),
+			               (char*) (&Monopoles.at(0) + Monopoles.size()));
+		
+		memset (&Index.at(CurFile), 0, sizeof (LibIndex));
+		strcpy (Index.at(CurFile).Name, CurParSet.Name.c_str());
+		Index.at(CurFile).Size     = Block->size();
+		Index.at(CurFile).Checksum = Checksum (&Block->at(0), Block->size());
+	}
+	
+	Offset = sizeof (LibHeader) + Index.size() * sizeof (LibIndex);
+	
+	for (CurFile = 0; CurFile < Index.size(); CurFile++) {
+		Index.at(CurFile).Offset = Offset;
+		Offset += Index.at(CurFile).Size;
+	}
+	
+	memset (&Header, 0, sizeof (Header));
+	memcpy (Header.Magic, LibMagic, sizeof (LibMagic));
+	Header.Version       = LibVersion;
+	Header.Sets          = Index.size();
+	Header.FileSize      = Offset;
+	Header.IndexChecksum = (Index.size() > 0) ?
+	                       Checksum ((char*) &Index.at(0), Index.size() * sizeof (LibIndex)) : 0;
+	
+	// --------------------------------------------------------------------------------
+	
+	FILE* File = fopen (LibFile.c_str(), "wb");
+	bool  Written;
+	
+	if (File == NULL) {
+		cerr << "\nERROR: Could not write the parameter library " << LibFile << ".\n\n";
+		DC_Error = "Error writing parameter library";
+		DC_ErrorCode = 138;
+		return 138;
+	}
+	
+	Written = (fwrite (&Header, sizeof (Header), 1, File) == 1);
+	
+	if (Index.size() > 0)
+		Written = Written and fwrite (&Index.at(0), sizeof (LibIndex), Index.size(), File) == Index.size();
+	
+	for (CurFile = 0; CurFile < Data.size(); CurFile++)
+		Written = Written and fwrite (&Data.at(CurFile).at(0), 1, Data.at(CurFile).size(), File) ==
+		                      Data.at(CurFile).size();
+	
+	if (fclose (File) != 0 or not Written) {
+		cerr << "\nERROR: Could not write the parameter library " << LibFile << ".\n\n";
+		DC_Error = "Error writing parameter library";
+		DC_ErrorCode = 138;
+		return 138;
+	}
+	
+	if (DC_Verbose)
+		printf ("\n   %d parameter sets written to %s (%lu bytes)\n", (int) Index.size(),
+		        LibFile.c_str(), (unsigned long) Offset);
+	
+	return 0;
+} // of Dichro::WriteParameterLibrary
+
+
+// ================================================================================
+
+
+int Dichro::ReadParameterLibrary ( void )
+// reads the parameter sets of the input file from the library DC_Params (see WriteParameterLibrary)
+{
+	unsigned int CurFile;
+	int Atom, Trans, Mono;
+	struct stat Status;
+	const char* Map;
+	int Error = 0;
+	
+	int File = open (DC_Params.c_str(), O_RDONLY);
+	
+	if (File < 0 or fstat (File, &Status) != 0 or Status.st_size < (off_t) sizeof (LibHeader)) {
+		if (File >= 0) close (File);
+		cerr << "\nERROR: Could not read the parameter library " << DC_Params << ".\n\n";
+		DC_Error = "Error reading parameter library";
+		DC_ErrorCode = 138;
+		return 138;
+	}
+	
+	Map = (const char*) mmap (NULL, Status.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close (File);
+	
+	if (Map == MAP_FAILED) {
+		cerr << "\nERROR: Could not read the parameter library " << DC_Params << ".\n\n";
+		DC_Error = "Error reading parameter library";
+		DC_ErrorCode = 138;
+		return 138;
+	}
+	
+	const LibHeader* Header = (const LibHeader*) Map;
+	const LibIndex*  Index  = (const LibIndex*) (Map + sizeof (LibHeader));
+	const LibIndex*  IndexEnd;
+	
+	if ( memcmp (Header->Magic, LibMagic, sizeof (LibMagic)) != 0 or
+	     Header->Version  != LibVersion or
+	     Header->FileSize != (uint64_t) Status.st_size or
+	     sizeof (LibHeader) + Header->Sets * sizeof (LibIndex) > (uint64_t) Status.st_size or
+	     Header->IndexChecksum != Checksum ((const char*) Index, Header->Sets * sizeof (LibIndex)) ) {
+		cerr << "\nERROR: " << DC_Params << " is not a parameter library of this version of\n"
+		     <<   "       DichroCalc or it is damaged, it has to be created again with --compile-params.\n\n";
+		munmap ((void*) Map, Status.st_size);
+		DC_Error = "Error reading parameter library";
+		DC_ErrorCode = 138;
+		return 138;
+	}
+	
+	IndexEnd = Index + Header->Sets;
+	
+	if (DC_Verbose) printf ("   Library %s with %d sets\n", DC_Params.c_str(), Header->Sets);
+	
+	for (CurFile = 0; CurFile < DC_Input.Parameters.Name.size() and Error == 0; CurFile++) {
+		LibIndex Key;
+		string Name = DC_Input.Parameters.Name.at(CurFile);
+		
+		memset (&Key, 0, sizeof (Key));
+		strncpy (Key.Name, Name.c_str(), sizeof (Key.Name) - 1);
+		
+		const LibIndex* Entry = lower_bound (Index, IndexEnd, Key, IndexOrder);
+		
+		if (Entry == IndexEnd or Name != Entry->Name) {
+			cerr << "\nERROR: Parameter set " << Name << " not found in library " << DC_Params << ".\n\n";
+			DC_Error = "Parameter set " + Name + " not found";
+			DC_ErrorCode = 131;
+			Error = 131;
+			break;
+		}
+		
+		const char*   Block = Map + Entry->Offset;
+		const LibSet* Set   = (const LibSet*) Block;
+		
+		if ( Entry->Offset + Entry->Size > Header->FileSize or Entry->Size < sizeof (LibSet) or
+		     Entry->Checksum != Checksum (Block, Entry->Size) ) {
+			cerr << "\nERROR: Parameter set " << Name << " in library " << DC_Params << " is damaged.\n\n";
+			DC_Error = "Error reading parameter library";
+			DC_ErrorCode = 138;
+			Error = 138;
+			break;
+		}
+		
+		if (DC_Verbose) printf ("   Reading %s\n", Name.c_str());
+		if (DC_Debug > 3) fprintf (DC_DbgFile, "   Reading %s from %s", Name.c_str(), DC_Params.c_str());
+		
+		const LibAtom*  Atoms       = (const LibAtom*)  (Block + sizeof (LibSet));
+		const LibTrans* Transitions = (const LibTrans*) (Atoms + Set->Atoms);
+		const double*   Monopoles   = (const double*)   (Transitions + Set->Transitions);
+		
+		// the same data as ReadParameterSet reads from the .par file
+		DC_ParSets.push_back (ParSet ());
+		ParSet* CurParSet = &DC_ParSets.back();
+		
+		CurParSet->Name           = Name;
+		CurParSet->ChargeTransfer = (Name.substr (0, 2) == "CT");
+		CurParSet->NumberOfAtoms  = Set->Atoms;
+		CurParSet->Reference.assign (Set->Reference, Set->Reference + 3);
+		CurParSet->Atoms.resize (Set->Atoms);
+		CurParSet->States.resize (Set->States);
+		
+		for (Atom = 0; Atom < Set->Atoms; Atom++) {
+			ParSetAtom* CurAtom = &CurParSet->Atoms.at(Atom);
+			
+			CurAtom->Coord.assign (Atoms[Atom].Coord, Atoms[Atom].Coord + 3);
+			CurAtom->Weighting = Atoms[Atom].Weighting;
+			CurAtom->Label     = Atoms[Atom].Label;
+		}
+		
+		for (Trans = 0; Trans < Set->Transitions; Trans++) {
+			const LibTrans* T = &Transitions[Trans];
+			const double* TransMonopoles = Monopoles;
+			vector<ParSetTrans>* CurState = &CurParSet->States.at(T->State);
+			
+			Monopoles += 4 * T->Monopoles;
+			
+			CurState->push_back (ParSetTrans ());
+			ParSetTrans* CurTrans = &CurState->back();
+			
+			CurTrans->Permanent         = T->Permanent;
+			CurTrans->NumberOfMonopoles = T->Monopoles;
+			CurTrans->Energy            = T->Energy;
+			CurTrans->Wavelength        = T->Wavelength;
+			CurTrans->EDM.assign (T->EDM, T->EDM + 3);
+			
+			if ( not T->Permanent ) {
+				CurTrans->ScaleFactor = T->ScaleFactor;
+				CurTrans->MDM.assign (T->MDM, T->MDM + 3);
+			}
+			
+			if ( not TransitionUsed (CurFile, Set->States, T->State, CurState->size() - 1) ) continue;
+			
+			CurTrans->Monopoles.resize (T->Monopoles);
+			
+			for (Mono = 0; Mono < T->Monopoles; Mono++) {
+				ParSetMonopole* CurMono = &CurTrans->Monopoles.at(Mono);
+				
+				CurMono->Coord.assign (TransMonopoles + 4*Mono, TransMonopoles + 4*Mono + 3);
+				CurMono->Charge = TransMonopoles[4*Mono + 3];
+			}
+		}
+		
+		// DEBUG OUPUT: print the complete data
+		if (DC_Debug > 4) Dichro::OutputParSetClass ( CurParSet );
+	}
+	
+	munmap ((void*) Map, Status.st_size);
+	
+	return Error;
+} // of Dichro::ReadParameterLibrary
+
+
+// ================================================================================
+
@@ -0,0 +1,195 @@
+// #################################################################################################
+//
+//  Program:      parsebench
+//
+//  Function:     Benchmark of the parameter file parsers: reads all parameter sets of a directory
+//                with the original line-table parser (ReadParameterSetLines) and the single-pass
+//                parser (ReadParameterSet), checks that both give the same data and compares
+//                the times
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <string.h>
+#include <vector>
+#include <sys/time.h>
+
+using namespace std;
+
+#include "../include/dichrocalc.h"
+
+// ================================================================================
+
+
+double Seconds ( void );
+bool   SameParSet ( Dichro::ParSet* a, Dichro::ParSet* b );
+int    ReadAll ( Dichro* DC, vector<string>* Names, bool Lines, vector<Dichro::ParSet>* ParSets );
+
+
+// ================================================================================
+
+
+double Seconds ( void )
+// the wall-clock time in seconds
+{
+	struct timeval Time;
+	
+	gettimeofday (&Time, NULL);
+	
+	return Time.tv_sec + 1E-6 * Time.tv_usec;
+} // of Seconds
+
+
+// ================================================================================
+
+
+bool SameParSet ( Dichro::ParSet* a, Dichro::ParSet* b )
+// whether two parameter sets contain exactly the same data
+{
+	unsigned int Atom, State, Trans, Mono;
+	
+	if (a->NumberOfAtoms != b->NumberOfAtoms or a->Atoms.size() != b->Atoms.size() or
+	    a->States.size() != b->States.size() or a->Reference != b->Reference)
+		return false;
+	
+	for (Atom = 0; Atom < a->Atoms.size(); Atom++) {
+		// the old parser keeps the carriage return of files with DOS line ends in the labels
+		string Label = a->Atoms.at(Atom).Label;
+		if (Label.size() > 0 and Label.at(Label.size() - 1) == '\r') Label.erase (Label.size() - 1);
+		
+		if (Label                       != b->Atoms.at(Atom).Label or
+		    a->Atoms.at(Atom).Weighting != b->Atoms.at(Atom).Weighting or
+		    a->Atoms.at(Atom).Coord     != b->Atoms.at(Atom).Coord)
+			return false;
+	}
+	
+	for (State = 0; State < a->States.size(); State++) {
+		if (a->States.at(State).size() != b->States.at(State).size()) return false;
+		
+		for (Trans = 0; Trans < a->States.at(State).size(); Trans++) {
+			Dichro::ParSetTrans* ta = &a->States.at(State).at(Trans);
+			Dichro::ParSetTrans* tb = &b->States.at(State).at(Trans);
+			
+			if (ta->Permanent         != tb->Permanent         or
+			    ta->NumberOfMonopoles != tb->NumberOfMonopoles or
+			    ta->Energy            != tb->Energy            or
+			    ta->Wavelength        != tb->Wavelength        or
+			    ta->Monopoles.size()  != tb->Monopoles.size()  or
+			    ta->EDM               != tb->EDM               or
+			    ta->MDM               != tb->MDM)
+				return false;
+			
+			if ( not ta->Permanent and ta->ScaleFactor != tb->ScaleFactor ) return false;
+			
+			for (Mono = 0; Mono < ta->Monopoles.size(); Mono++) {
+				if (ta->Monopoles.at(Mono).Charge != tb->Monopoles.at(Mono).Charge or
+				    ta->Monopoles.at(Mono).Coord  != tb->Monopoles.at(Mono).Coord)
+					return false;
+			}
+		}
+	}
+	
+	return true;
+} // of SameParSet
+
+
+// ================================================================================
+
+
+int ReadAll ( Dichro* DC, vector<string>* Names, bool Lines, vector<Dichro::ParSet>* ParSets )
+// reads all parameter sets with one of the parsers, returns the number of failed files
+{
+	unsigned int File;
+	int Failed = 0;
+	
+	ParSets->clear();
+	ParSets->resize (Names->size());
+	
+	for (File = 0; File < Names->size(); File++) {
+		Dichro::ParSet* CurParSet = &ParSets->at(File);
+		string Filename = DC->DC_Params + "/" + Names->at(File) + ".par";
+		
+		CurParSet->Name = Names->at(File);
+		CurParSet->ChargeTransfer = (CurParSet->Name.substr (0, 2) == "CT");
+		
+		if (Lines) {
+			if (DC->ReadParameterSetLines (Filename, CurParSet) != 0) ++Failed;
+		}
+		else {
+			if (DC->ReadParameterSet (Filename, CurParSet) != 0) ++Failed;
+		}
+	}
+	
+	return Failed;
+} // of ReadAll
+
+
+// ================================================================================
+
+
+int main ( int argc, char **argv )
+{
+	string Params = "../params";
+	int    Repeat = 20;
+	int    Run, Different = 0;
+	unsigned int File;
+	double Start, TimeLines, TimeSinglePass;
+	vector<string> Names;
+	vector<Dichro::ParSet> Lines, SinglePass;
+	
+	if (argc > 1) Params = argv[1];
+	if (argc > 2) Repeat = atoi (argv[2]);
+	
+	if (argc > 3 or Repeat < 1) {
+		cout << "\nUsage: parsebench [directory with the .par files] [repetitions]\n\n";
+		return 1;
+	}
+	
+	if ( not ReadDir (Params, ".par", &Names) or Names.size() == 0 ) {
+		cerr << "\nERROR: No parameter files found in " << Params << ".\n\n";
+		return 5;
+	}
+	
+	for (File = 0; File < Names.size(); File++)
+		Names.at(File).erase (Names.at(File).size() - 4);
+	
+	// the error messages of the parsers go to cerr
+	Dichro DC (Params);
+	
+	// both parsers have to give the same data
+	int FailedLines      = ReadAll (&DC, &Names, true,  &Lines);
+	int FailedSinglePass = ReadAll (&DC, &Names, false, &SinglePass);
+	
+	for (File = 0; File < Names.size(); File++) {
+		if ( not SameParSet (&Lines.at(File), &SinglePass.at(File)) ) {
+			cout << "   Different data read from " << Names.at(File) << ".par\n";
+			++Different;
+		}
+	}
+	
+	Start = Seconds ();
+	for (Run = 0; Run < Repeat; Run++) ReadAll (&DC, &Names, true, &Lines);
+	TimeLines = (Seconds () - Start) / Repeat;
+	
+	Start = Seconds ();
+	for (Run = 0; Run < Repeat; Run++) ReadAll (&DC, &Names, false, &SinglePass);
+	TimeSinglePass = (Seconds () - Start) / Repeat;
+	
+	printf ("\n   %d parameter files in %s, %d repetitions\n\n", (int) Names.size(),
+	        Params.c_str(), Repeat);
+	printf ("   Line tables (ReadParameterSetLines): %10.2f ms  (%d failed)\n",
+	        1000 * TimeLines, FailedLines);
+	printf ("   Single pass (ReadParameterSet):      %10.2f ms  (%d failed)\n",
+	        1000 * TimeSinglePass, FailedSinglePass);
+	printf ("   Speed-up:                            %10.1f\n", TimeLines / TimeSinglePass);
+	printf ("   Sets with different data:            %10d\n\n", Different);
+	
+	return (Different > 0) ? 1 : 0;
+} // of main
+
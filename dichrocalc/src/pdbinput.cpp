@@ -0,0 +1,1307 @@
+// #################################################################################################
+//
+//  Program:      pdbinput.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Reads a PDB file directly and assigns the chromophores like dcinput -dc does,
+//                the input data are built in DC_Input without writing a .inp file
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <map>
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+
+
+// The PDB is processed like ParsePDB.pm does it for dcinput: only the first model is read,
+// HETATM lines are ignored, superimposed (inserted) residues are removed, only the first of
+// alternate atom locations is kept, residues and atoms are renumbered and phi and psi are
+// calculated for the charge-transfer chromophores. The switches of dcinput are given with
+// --assign (e.g. --assign "-ct -sc") and chromophores.dat is read from the current directory
+// or ~/bin. The resulting DC_Input is the same as from the .inp file written by dcinput -dc.
+
+static const int PdbMaxAtoms = 10000;   // above, only the atoms needed are kept (deletepdbatoms)
+
+// the switches of dcinput understood by --assign, lists take all arguments up to the next switch
+static const string PdbSwitches    = " nma wdy nvb urea sc phe tyr trp scn asp glu asn gln nb"
+                                     " ade gua cyt thy ura nap ct term nobb ";
+static const string PdbIntegers    = " bbt ctt sct nbt trans bbtrans cttrans ";
+static const string PdbStrings     = " p ";
+static const string PdbLists       = " chrom nochrom bbignore ctignore scignore ";
+static const string PdbUnsupported = " lnk trt trtsel cyc ";
+
+struct PdbGroup {
+	const char* Key;        // the residue label, apart from the peptide and CT groups
+	const char* Atoms;      // the atom labels in the sequence of the parameter set
+};
+
+// all groups in the sequence of the $CHROMOPHORES block written by dcinput
+static const PdbGroup PdbGroups[] = {
+	{ "peptide", "C O N" },
+	{ "URE",     "N' O N" },
+	{ "CT",      "C O N C O N" },
+	{ "PHE",     "CG CD1 CE1 CZ CE2 CD2" },
+	{ "TYR",     "CZ CE1 CE2 CD1 CD2 CG OH" },
+	{ "TRP",     "CG CD2 CE2 CE3 CD1 NE1 CZ2 CZ3 CH2" },
+	{ "ASP",     "CG OD1 OD2" },
+	{ "GLU",     "CD OE1 OE2" },
+	{ "GLN",     "CD OE1 NE2" },
+	{ "ASN",     "CG OD1 ND2" },
+	{ "NAP",     "O1 N1 O4 C3 C10 C4 C9 O2 N2 O3" },
+	{ "A",       "N1 C2 N3 C4 C5 C6 N6 N7 C8 N9" },
+	{ "T",       "N1 C2 O2 N3 C4 O4 C5 C6" },
+	{ "G",       "N1 C2 N2 N3 C4 C5 C6 O6 N7 C8 N9" },
+	{ "C",       "N1 C2 O2 N3 C4 N4 C5 C6" },
+	{ "U",       "N1 C2 O2 N3 C4 O4 C5 C6" },
+	{ "TERM",    "C OT1 OT2" },
+	{ NULL,      NULL }
+};
+
+
+class PdbAtom {          // an ATOM or TER line of the first model
+	public:
+		bool   Ter;
+		char   Next;          // of a TER: the chain ID of an ATOM line directly after it, else '\0'
+		string Type;          // the atom label, e.g. CA
+		char   AltLoc;        // the alternate location indicator
+		string Label;         // the residue label, e.g. ALA
+		char   Chain;         // the chain ID
+		string ResNumber;     // the residue number as given in the file
+		char   Ins;           // the insertion code
+		double Coord[3];
+		int    Number;        // renumbered from 1 over all chains (TER lines are not counted)
+		int    Residue;       // the renumbered residue number
+		int    Record;        // the index among the ATOM and HETATM lines of the model
+};
+
+class PdbResidue {
+	public:
+		vector<int> Atoms;    // the indices in PdbChain.Atoms
+		string Label;
+		string ResNumber;     // as given in the file
+		char   Ins;
+		int    Number;        // renumbered
+		bool   Angles;        // whether phi and psi were calculated
+		double Phi, Psi;
+		vector<int> Peptide;  // the atom numbers of C, O (previous residue) and N, empty if no bond
+};
+
+class PdbChain {
+	public:
+		vector<PdbAtom>    Atoms;       // the ATOM lines and the closing TER line, if any
+		vector<PdbResidue> Residues;
+		bool               TerResidue;  // ParsePDB indexes the TER line as an additional residue
+};
+
+class PdbChromophore {   // a line of chromophores.dat
+	public:
+		string Type;
+		int    Trans;
+		double Phi, Psi;
+};
+
+
+// --------------------------------------------------------------------------------
+
+
+class PdbAssignment {
+	public:
+		PdbAssignment ( Dichro* DC );
+		
+		int  ReadOptions ( string Switches );
+		int  ReadChromophores ( void );
+		int  ReadPdb ( string Filename );
+		int  Assign ( void );
+	
+	private:
+		Dichro* DC;
+		
+		map<string, vector<string> > Options;       // the switches given with --assign
+		map<string, PdbChromophore>  ChromList;     // all chromophores of chromophores.dat by name
+		map<string, string>          ChromTypes;    // the first chromophore name of each type
+		map<string, int>             TypeIndex;     // the index of a type in DC_Input.Parameters
+		map<string, int>             CTIndex;       // the index of a CT chromophore in DC_Input.Parameters
+		map<string, vector<int> >    GroupTypes;    // the parameter indices of the groups of each key
+		map<string, vector< vector<int> > > Assigned;  // the atom numbers of the groups of each key
+		
+		vector<PdbAtom>  Lines;           // the ATOM and TER lines of the first model
+		vector<PdbChain> Chains;
+		int  AltLocIndicator;             // 0 none, 1 letters, 2 digits (ParsePDB)
+		bool MoreModels;
+		
+		int  Error ( int Code, string Message );
+		bool Option ( string Name ) { return Options.count (Name) > 0; }
+		int  IntOption ( string Name ) { return atoi (Options[Name].at(0).c_str()); }
+		bool InList ( string Name, string Value );
+		bool InList ( string Name, int Value );
+		
+		void SplitChains ( vector<PdbAtom>* Records );
+		void IndexResidues ( PdbChain* Chain );
+		void RemoveInsertedResidues ( void );
+		void RemoveAtomLocations ( void );
+		void Renumber ( void );
+		void Angles ( PdbChain* Chain );
+		void Prepare ( void );
+		void Prune ( void );
+		int  CountAtoms ( void );
+		
+		bool FindAtom ( PdbChain* Chain, PdbResidue* Residue, string Type, int* Atom );
+		void FindPeptideBonds ( PdbChain* Chain );
+		int  UseType ( string Type );
+		void AssignPeptide ( PdbChain* Chain, string Type );
+		void AssignChargeTransfer ( PdbChain* Chain );
+		void AssignGroups ( PdbChain* Chain, string Key );
+};
+
+
+static bool StartsWith ( const string& Line, const char* Start )
+{
+	return Line.compare (0, strlen (Start), Start) == 0;
+}
+
+
+static bool Contains ( const string& Line, const char* Part )
+{
+	return Line.find (Part) != string::npos;
+}
+
+
+static string Field ( const string& Line, int Start, int Length )
+// the columns of a PDB line without any blanks
+{
+	string Field = Line.substr (Start, Length);
+	
+	Field.erase (remove_if (Field.begin(), Field.end(), ::isspace), Field.end());
+	
+	return Field;
+}
+
+
+static string ResidueName ( const PdbResidue* Residue )
+// the residue number as given in the file with the insertion code, e.g. 52A
+{
+	if (Residue->Ins == ' ') return Residue->ResNumber;
+	
+	return Residue->ResNumber + Residue->Ins;
+}
+
+
+static double Rounded ( double Value )
+// the value rounded to three digits as printed with "%.3f"
+{
+	char Buffer[64];
+	
+	snprintf (Buffer, sizeof (Buffer), "%.3f", Value);
+	
+	return atof (Buffer);
+}
+
+
+static double Distance ( const PdbAtom* Atom1, const PdbAtom* Atom2 )
+{
+	double x = Atom1->Coord[0] - Atom2->Coord[0];
+	double y = Atom1->Coord[1] - Atom2->Coord[1];
+	double z = Atom1->Coord[2] - Atom2->Coord[2];
+	
+	return sqrt (x*x + y*y + z*z);
+}
+
+
+static vector<string> GroupAtoms ( string Key )
+// the atom labels of a group
+{
+	vector<string> Atoms;
+	
+	for (int Group = 0; PdbGroups[Group].Key != NULL; Group++)
+		if (Key == PdbGroups[Group].Key) SplitString (PdbGroups[Group].Atoms, Atoms, " ");
+	
+	return Atoms;
+}
+
+
+// ================================================================================
+
+
+PdbAssignment::PdbAssignment ( Dichro* DC )
+{
+	this->DC        = DC;
+	AltLocIndicator = 0;
+	MoreModels      = false;
+} // of PdbAssignment::PdbAssignment
+
+
+// ================================================================================
+
+
+int PdbAssignment::Error ( int Code, string Message )
+// reports an error in the PDB file (105) or the assignment options (106)
+{
+	cerr << "\nERROR: " << Message << "\n\n";
+	DC->DC_Error     = (Code == 105) ? "Error in PDB file" : "Error in chromophore assignment";
+	DC->DC_ErrorCode = Code;
+	return Code;
+} // of PdbAssignment::Error
+
+
+// ================================================================================
+
+
+bool PdbAssignment::InList ( string Name, string Value )
+{
+	if ( not Option (Name) ) return false;
+	
+	return find (Options[Name].begin(), Options[Name].end(), Value) != Options[Name].end();
+} // of PdbAssignment::InList
+
+
+bool PdbAssignment::InList ( string Name, int Value )
+{
+	if ( not Option (Name) ) return false;
+	
+	for (unsigned int i = 0; i < Options[Name].size(); i++)
+		if (atoi (Options[Name].at(i).c_str()) == Value) return true;
+	
+	return false;
+} // of PdbAssignment::InList
+
+
+// ================================================================================
+
+
+int PdbAssignment::ReadOptions ( string Switches )
+// reads the dcinput switches given with --assign and checks them like dcinput
+{
+	vector<string> Fields;
+	unsigned int i;
+	string Name;
+	
+	SplitString (Switches, Fields, " \t");
+	
+	for (i = 0; i < Fields.size(); i++) {
+		if (Fields.at(i).size() < 2 or Fields.at(i).at(0) != '-')
+			return Error (106, "Unexpected argument " + Fields.at(i) + " given with --assign.");
+		
+		Name = Fields.at(i).substr (Fields.at(i).find_first_not_of ("-"));
+		string Key = " " + Name + " ";
+		
+		if (PdbUnsupported.find (Key) != string::npos)
+			return Error (106, "-" + Name + " is not supported by --assign, use dcinput to create the .inp file.");
+		
+		if (PdbSwitches.find (Key) != string::npos) {
+			Options[Name].push_back ("1");
+		}
+		else if (PdbIntegers.find (Key) != string::npos or PdbStrings.find (Key) != string::npos) {
+			if (i + 1 >= Fields.size())
+				return Error (106, "No value given for -" + Name + " with --assign.");
+			
+			++i;
+			
+			if (PdbIntegers.find (Key) != string::npos and
+			    Fields.at(i).find_first_not_of ("-0123456789") != string::npos)
+				return Error (106, "-" + Name + " requires an integer value.");
+			
+			Options[Name].assign (1, Fields.at(i));
+		}
+		else if (PdbLists.find (Key) != string::npos) {
+			Options[Name];
+			
+			while (i + 1 < Fields.size() and Fields.at(i + 1).at(0) != '-')
+				Options[Name].push_back (Fields.at(++i));
+		}
+		else {
+			return Error (106, "Unknown option " + Fields.at(i) + " given with --assign.");
+		}
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	if (Option ("wdy") and Option ("urea"))
+		return Error (106, "The parameters -wdy and -urea cannot be combined.");
+	
+	// a particular CT transition implies the CT chromophores
+	if (Option ("cttrans")) Options["ct"].assign (1, "1");
+	
+	if (Option ("sc") and (Option ("phe") or Option ("trp") or Option ("tyr")))
+		return Error (106, "-sc must not be given in combination with -phe, -trp or -tyr.");
+	
+	if (Option ("nb") and (Option ("ade") or Option ("gua") or Option ("cyt") or
+	                       Option ("thy") or Option ("ura")))
+		return Error (106, "-nb must not be given in combination with -ade, -gua, -cyt, -thy, or -ura.");
+	
+	if (Option ("scn") and (Option ("asn") or Option ("gln") or Option ("asp") or Option ("glu")))
+		return Error (106, "-scn must not be given in combination with -asn, -gln, -asp or -glu.");
+	
+	if (Option ("sc"))  { Options["phe"].assign (1, "1"); Options["tyr"].assign (1, "1");
+	                      Options["trp"].assign (1, "1"); }
+	
+	if (Option ("scn")) { Options["asn"].assign (1, "1"); Options["gln"].assign (1, "1");
+	                      Options["asp"].assign (1, "1"); Options["glu"].assign (1, "1"); }
+	
+	if (Option ("nb"))  { Options["ade"].assign (1, "1"); Options["gua"].assign (1, "1");
+	                      Options["cyt"].assign (1, "1"); Options["thy"].assign (1, "1");
+	                      Options["ura"].assign (1, "1"); }
+	
+	const char* const Counts[] = { "bbt", "ctt", "sct", "nbt" };
+	
+	for (i = 0; i < 4; i++) {
+		if (Option (Counts[i]) and (IntOption (Counts[i]) < 1 or IntOption (Counts[i]) > 6))
+			return Error (106, "-" + string (Counts[i]) + " must be between 1 and 6.");
+	}
+	
+	if (Option ("nbt") and IntOption ("nbt") > 4)
+		return Error (106, "-nbt must be between 1 and 4.");
+	
+	return 0;
+} // of PdbAssignment::ReadOptions
+
+
+// ================================================================================
+
+
+int PdbAssignment::ReadChromophores ( void )
+// reads the available chromophores from chromophores.dat (in the current directory or ~/bin)
+{
+	vector<string> Content, Fields;
+	string Filename = "chromophores.dat";
+	string Line;
+	unsigned int i;
+	
+	if ( not FileExists (Filename) and getenv ("HOME") != NULL )
+		Filename = string (getenv ("HOME")) + "/bin/chromophores.dat";
+	
+	if (FileExists (Filename)) {
+		ifstream File (Filename.c_str(), ios::in);
+		
+		if ( not File ) return Error (106, "Could not open " + Filename + ".");
+		
+		while (getline (File, Line)) Content.push_back (Line);
+	}
+	// without chromophores.dat only the backbone can be assigned
+	else if ( not Option ("ct")  and not Option ("sc")  and not Option ("nb")  and
+	          not Option ("phe") and not Option ("tyr") and not Option ("trp") and
+	          not Option ("asp") and not Option ("glu") and not Option ("asn") and
+	          not Option ("gln") and not Option ("nap") and not Option ("ade") and
+	          not Option ("gua") and not Option ("cyt") and not Option ("ura") ) {
+		if      (Option ("p"))    Content.push_back (Options["p"].at(0) + "  NMA 2    0.0    0.0");
+		else if (Option ("nma"))  Content.push_back ("NMA4FIT2  NMA 2    0.0    0.0");
+		else if (Option ("urea")) Content.push_back ("UREA04C2  URE 3    0.0    0.0");
+		else if (Option ("wdy"))  Content.push_back ("NMA99WDY  WDY 2    0.0    0.0");
+		else if (Option ("nvb"))  Content.push_back ("NMAVIB00  NMA 6    0.0    0.0");
+		else                      Content.push_back ("NMA4FIT2  NMA 2    0.0    0.0");
+	}
+	else {
+		return Error (106, "chromophores.dat was not found and CT, side chains and/or nucleic bases\n"
+		                   "       were requested.");
+	}
+	
+	for (i = 0; i < Content.size(); i++) {
+		Line = Content.at(i);
+		TrimSpaces (&Line);
+		
+		if (Line.size() == 0 or Line.at(0) == '#') continue;
+		
+		// a backbone line is replaced if it does not fit the backbone chromophore requested
+		if ( (Contains (Line, " NMA ") or Contains (Line, " WDY ") or Contains (Line, " URE ")) and
+		     (Option ("nma") or Option ("wdy") or Option ("urea") or Option ("nvb")) ) {
+			if (Option ("p")) {
+				if ( not StartsWith (Line, Options["p"].at(0).c_str()) )
+					Line = Options["p"].at(0) + "  NMA 2    0.0    0.0";
+			}
+			else if (Option ("nma")) {
+				if ( not StartsWith (Line, "NMA") )  Line = "NMA4FIT2  NMA 2    0.0    0.0";
+			}
+			else if (Option ("urea")) {
+				if ( not StartsWith (Line, "UREA") ) Line = "UREA04C2  URE 3    0.0    0.0";
+			}
+			else if (Option ("wdy")) {
+				if ( not Contains (Line, "WDY") )    Line = "NMA99WDY  WDY 2    0.0    0.0";
+			}
+			else if (Option ("nvb")) {
+				if ( not Contains (Line, "NMAVIB") ) Line = "NMAVIB00  NMA 6    0.0    0.0";
+			}
+		}
+		
+		SplitString (Line, Fields, " \t");
+		
+		if (Fields.size() < 5)
+			return Error (106, "Entry " + Line + " in chromophores.dat could not be interpreted\n"
+			                   "       (at least 5 columns are expected).");
+		
+		string Name = Fields.at(0);
+		string Type = Fields.at(1);
+		
+		// only the chromophores requested
+		if ( not Option ("ct") and StartsWith (Name, "CT") ) continue;
+		if ( not Option ("phe") and StartsWith (Name, "PHE") ) continue;
+		if ( not Option ("tyr") and StartsWith (Name, "TYR") ) continue;
+		if ( not Option ("trp") and StartsWith (Name, "TRP") ) continue;
+		if ( not Option ("asn") and StartsWith (Name, "ASN") ) continue;
+		if ( not Option ("gln") and StartsWith (Name, "GLN") ) continue;
+		if ( not Option ("glu") and StartsWith (Name, "GLU") ) continue;
+		if ( not Option ("nap") and (StartsWith (Name, "NAP") or StartsWith (Name, "FCWEIGH")) ) continue;
+		if ( not Option ("asp") and not Option ("term") and StartsWith (Name, "ASP") ) continue;
+		if ( not Option ("ade") and StartsWith (Name, "ADE") ) continue;
+		if ( not Option ("gua") and StartsWith (Name, "GUA") ) continue;
+		if ( not Option ("cyt") and StartsWith (Name, "CYT") ) continue;
+		if ( not Option ("thy") and StartsWith (Name, "THY") ) continue;
+		if ( not Option ("ura") and StartsWith (Name, "URA") ) continue;
+		
+		bool Backbone = Contains (Type, "NMA") or Contains (Type, "WDY") or Contains (Type, "URE");
+		bool Aromatic = Contains (Type, "PHE") or Contains (Type, "TYR") or Contains (Type, "TRP") or
+		                Contains (Type, "TRT");
+		bool Base     = (Type == "A" or Type == "G" or Type == "C" or Type == "T" or Type == "U");
+		size_t Fit    = Name.find ("NMA");
+		
+		PdbChromophore Chromophore;
+		Chromophore.Type  = Type;
+		Chromophore.Trans = atoi (Fields.at(2).c_str());
+		Chromophore.Phi   = atof (Fields.at(3).c_str());
+		Chromophore.Psi   = atof (Fields.at(4).c_str());
+		
+		// a particular backbone or CT transition means only one transition
+		if (Backbone and Option ("bbtrans")) Chromophore.Trans = 1;
+		if (Contains (Type, "CTR") and Option ("cttrans")) Chromophore.Trans = 1;
+		
+		if (Backbone and Option ("bbt")) {
+			if (Contains (Name, "WDY") and IntOption ("bbt") > 2)
+				return Error (106, "The Woody set only supports up to 2 backbone transitions.");
+			
+			if (Fit != string::npos and Name.compare (Fit + 4, 3, "FIT") == 0 and IntOption ("bbt") > 4)
+				return Error (106, "The Hirst set only supports up to 4 backbone transitions.");
+			
+			Chromophore.Trans = IntOption ("bbt");
+		}
+		
+		if (Contains (Type, "CTR") and Option ("ctt")) Chromophore.Trans = IntOption ("ctt");
+		if (Aromatic and Option ("sct")) Chromophore.Trans = IntOption ("sct");
+		if (Base and Option ("nbt")) Chromophore.Trans = IntOption ("nbt");
+		
+		ChromList[Name] = Chromophore;
+		
+		// the first chromophore of a type is used for it
+		if (ChromTypes.count (Type) == 0) ChromTypes[Type] = Name;
+	}
+	
+	if (ChromList.size() == 0) return Error (106, "No chromophore names were found in " + Filename + ".");
+	
+	return 0;
+} // of PdbAssignment::ReadChromophores
+
+
+// ================================================================================
+
+
+int PdbAssignment::ReadPdb ( string Filename )
+// reads the ATOM and TER lines of the first model and processes them like ParsePDB
+{
+	vector<string> Content;
+	string Line;
+	unsigned int Pos;
+	vector<int> Records;
+	bool AtomFound = false;
+	int Model, Record = 0;
+	
+	ifstream File (Filename.c_str(), ios::in);
+	
+	if ( not File ) {
+		printf ("\nERROR: Could not open file %s.\n\n", Filename.c_str());
+		DC->DC_Error     = "Unable to open input file";
+		DC->DC_ErrorCode = 100;
+		return 100;
+	}
+	
+	while (getline (File, Line)) {
+		if (Line.size() < 80) {
+			if (Line.find ('\r') != string::npos) Line.erase (Line.find ('\r'), 1);
+			Line.resize (80, ' ');
+		}
+		
+		// the atoms of a trajectory frame are counted like this (trajectory.cpp)
+		if (StartsWith (Line, "MODEL")) Record = 0;
+		
+		if (StartsWith (Line, "ATOM") or StartsWith (Line, "HETATM")) {
+			AtomFound = true;
+			++Record;
+		}
+		
+		if (StartsWith (Line, "HETATM") or StartsWith (Line, "SIGATM") or
+		    StartsWith (Line, "SIGUIJ") or StartsWith (Line, "ANISOU")) continue;
+		
+		Content.push_back (Line);
+		Records.push_back (Record - 1);
+	}
+	
+	File.close();
+	
+	// the alternate location indicator of the first ATOM line that has one
+	for (Pos = 0; Pos < Content.size(); Pos++) {
+		if ( not StartsWith (Content.at(Pos), "ATOM") or Content.at(Pos).at(16) == ' ' ) continue;
+		
+		if (isalpha (Content.at(Pos).at(16))) { AltLocIndicator = 1; break; }
+		if (isdigit (Content.at(Pos).at(16))) { AltLocIndicator = 2; break; }
+	}
+	
+	for (Pos = 0; Pos < Content.size(); Pos++)
+		if (StartsWith (Content.at(Pos), "MODEL") or StartsWith (Content.at(Pos), "ATOM")) break;
+	
+	if ( not AtomFound or Pos >= Content.size() )
+		return Error (105, "No ATOM lines found in " + Filename + ".");
+	
+	Model = StartsWith (Content.at(Pos), "MODEL") ? -1 : 0;
+	
+	for ( ; Pos < Content.size(); Pos++) {
+		Line = Content.at(Pos);
+		
+		if (StartsWith (Line, "CONECT") or StartsWith (Line, "MASTER") or StartsWith (Line, "END ")) break;
+		
+		// only the first model is read
+		if (StartsWith (Line, "MODEL") and ++Model > 0) {
+			MoreModels = true;
+			break;
+		}
+		
+		if (StartsWith (Line, "ENDMDL")) {
+			while (++Pos < Content.size())
+				if (StartsWith (Content.at(Pos), "MODEL")) MoreModels = true;
+			
+			break;
+		}
+		
+		if ( not StartsWith (Line, "ATOM") and not StartsWith (Line, "TER") ) continue;
+		
+		PdbAtom Atom;
+		Atom.Ter       = StartsWith (Line, "TER");
+		Atom.Next      = '\0';
+		Atom.Type      = Field (Line, 12, 4);
+		Atom.AltLoc    = Line.at(16);
+		Atom.Label     = Field (Line, 17, 3);
+		Atom.Chain     = Line.at(21);
+		Atom.ResNumber = Field (Line, 22, 4);
+		Atom.Ins       = Line.at(26);
+		Atom.Coord[0]  = atof (Field (Line, 30, 8).c_str());
+		Atom.Coord[1]  = atof (Field (Line, 38, 8).c_str());
+		Atom.Coord[2]  = atof (Field (Line, 46, 8).c_str());
+		Atom.Number    = 0;
+		Atom.Residue   = 0;
+		Atom.Record    = Records.at(Pos);
+		
+		if (Atom.Ter and Pos + 1 < Content.size() and StartsWith (Content.at(Pos + 1), "ATOM"))
+			Atom.Next = Content.at(Pos + 1).at(21);
+		
+		Lines.push_back (Atom);
+	}
+	
+	SplitChains (&Lines);
+	Prepare ();
+	
+	// large proteins are reduced to the atoms needed for the chromophores
+	if (CountAtoms () > PdbMaxAtoms) {
+		DC->Warnings.push_back (tostring (CountAtoms ()) + " atoms in " + Filename +
+		                        ", only the atoms needed for the chromophores are kept");
+		Prune ();
+	}
+	
+	if (MoreModels)
+		DC->Warnings.push_back ("More than one model in " + Filename + ", only the first one is used");
+	
+	return 0;
+} // of PdbAssignment::ReadPdb
+
+
+// ================================================================================
+
+
+void PdbAssignment::SplitChains ( vector<PdbAtom>* Records )
+// divides the ATOM and TER lines into chains like ParsePDB: a new chain begins with a
+// different chain ID or after a TER, a TER followed by the same chain ID is ignored
+{
+	int Current = -1, Last = -2;
+	unsigned int Line;
+	
+	Chains.clear();
+	
+	for (Line = 0; Line < Records->size(); Line++) {
+		PdbAtom* Atom = &Records->at(Line);
+		
+		if ( not Atom->Ter ) Current = Atom->Chain;
+		
+		if (Current != Last) {
+			Chains.push_back (PdbChain ());
+			Last = Current;
+		}
+		
+		if (Atom->Ter) {
+			if (Atom->Next != '\0' and Current != ' ' and Atom->Next == Current) continue;
+			
+			Last = -2;
+		}
+		
+		Chains.back().Atoms.push_back (*Atom);
+	}
+	
+	for (Line = 0; Line < Chains.size(); Line++) IndexResidues (&Chains.at(Line));
+} // of PdbAssignment::SplitChains
+
+
+// ================================================================================
+
+
+void PdbAssignment::IndexResidues ( PdbChain* Chain )
+// divides the atoms of a chain into residues by their residue numbers and insertion codes
+{
+	unsigned int Atom;
+	
+	Chain->Residues.clear();
+	Chain->TerResidue = false;
+	
+	for (Atom = 0; Atom < Chain->Atoms.size(); Atom++) {
+		PdbAtom* CurAtom = &Chain->Atoms.at(Atom);
+		PdbResidue* Last = (Chain->Residues.size() > 0) ? &Chain->Residues.back() : NULL;
+		
+		if (Last == NULL or CurAtom->ResNumber != Last->ResNumber or CurAtom->Ins != Last->Ins) {
+			if (CurAtom->Ter) {
+				Chain->TerResidue = true;
+				continue;
+			}
+			
+			PdbResidue Residue;
+			Residue.Label     = CurAtom->Label;
+			Residue.ResNumber = CurAtom->ResNumber;
+			Residue.Ins       = CurAtom->Ins;
+			Residue.Number    = 0;
+			Residue.Angles    = false;
+			Residue.Phi       = 360.0;
+			Residue.Psi       = 360.0;
+			
+			Chain->Residues.push_back (Residue);
+		}
+		
+		if ( not CurAtom->Ter ) Chain->Residues.back().Atoms.push_back (Atom);
+	}
+} // of PdbAssignment::IndexResidues
+
+
+// ================================================================================
+
+
+void PdbAssignment::RemoveInsertedResidues ( void )
+// removes residues superimposed on the previous one (all backbone atoms closer than 1 A), the
+// atoms compared are kept from earlier residues if a residue lacks one (as in ParsePDB)
+{
+	const char* const Types[4] = { "C", "N", "O", "CA" };
+	const PdbAtom* Res1[4] = { NULL, NULL, NULL, NULL };
+	const PdbAtom* Res2[4] = { NULL, NULL, NULL, NULL };
+	PdbAtom Saved1[4], Saved2[4];
+	unsigned int Chain, Atom;
+	int Residue, Type, Remove;
+	
+	for (Chain = 0; Chain < Chains.size(); Chain++) {
+		PdbChain* CurChain = &Chains.at(Chain);
+		Residue = 0;
+		
+		while (Residue < (int) CurChain->Residues.size() + (CurChain->TerResidue ? 1 : 0) - 2) {
+			PdbResidue* First  = &CurChain->Residues.at(Residue);
+			PdbResidue* Second = &CurChain->Residues.at(Residue + 1);
+			bool Skip = false;
+			
+			for (Type = 0; Type < 4 and not Skip; Type++) {
+				for (Atom = 0; Atom < First->Atoms.size(); Atom++)
+					if (CurChain->Atoms.at(First->Atoms.at(Atom)).Type == Types[Type])
+						Res1[Type] = &CurChain->Atoms.at(First->Atoms.at(Atom));
+				
+				for (Atom = 0; Atom < Second->Atoms.size(); Atom++)
+					if (CurChain->Atoms.at(Second->Atoms.at(Atom)).Type == Types[Type])
+						Res2[Type] = &CurChain->Atoms.at(Second->Atoms.at(Atom));
+				
+				Skip = (Res1[Type] == NULL or Res2[Type] == NULL);
+			}
+			
+			Remove = -1;
+			
+			if ( not Skip and Distance (Res1[0], Res2[0]) < 1 and Distance (Res1[1], Res2[1]) < 1 and
+			     Distance (Res1[2], Res2[2]) < 1 and Distance (Res1[3], Res2[3]) < 1 ) {
+				Remove = (Second->Ins == ' ' and First->Ins != ' ') ? Residue : Residue + 1;
+				
+				DC->Warnings.push_back ("Residues " + ResidueName (First) + " and " +
+				                        ResidueName (Second) + " are superimposed, " +
+				                        ResidueName (&CurChain->Residues.at(Remove)) + " was removed");
+			}
+			
+			// the atoms compared have to survive the removal of their residue
+			for (Type = 0; Type < 4; Type++) {
+				if (Res1[Type] != NULL) { Saved1[Type] = *Res1[Type]; Res1[Type] = &Saved1[Type]; }
+				if (Res2[Type] != NULL) { Saved2[Type] = *Res2[Type]; Res2[Type] = &Saved2[Type]; }
+			}
+			
+			if (Remove > -1) {
+				vector<int> Atoms = CurChain->Residues.at(Remove).Atoms;
+				
+				CurChain->Atoms.erase (CurChain->Atoms.begin() + Atoms.front(),
+				                       CurChain->Atoms.begin() + Atoms.front() + Atoms.size());
+				CurChain->Residues.erase (CurChain->Residues.begin() + Remove);
+				
+				for (unsigned int Next = Remove; Next < CurChain->Residues.size(); Next++)
+					for (Atom = 0; Atom < CurChain->Residues.at(Next).Atoms.size(); Atom++)
+						CurChain->Residues.at(Next).Atoms.at(Atom) -= Atoms.size();
+			}
+			
+			++Residue;
+		}
+	}
+} // of PdbAssignment::RemoveInsertedResidues
+
+
+// ================================================================================
+
+
+void PdbAssignment::RemoveAtomLocations ( void )
+// keeps only the first of alternate atom locations (A or 1, depending on the file)
+{
+	unsigned int Chain, Atom;
+	
+	for (Chain = 0; Chain < Chains.size(); Chain++) {
+		vector<PdbAtom>* Atoms = &Chains.at(Chain).Atoms;
+		vector<PdbAtom> Kept;
+		
+		for (Atom = 0; Atom < Atoms->size(); Atom++) {
+			char AltLoc = Atoms->at(Atom).AltLoc;
+			
+			if ( AltLocIndicator == 0 or AltLoc == ' ' or
+			    (AltLocIndicator == 1 and AltLoc == 'A') or (AltLocIndicator == 2 and AltLoc == '1') )
+				Kept.push_back (Atoms->at(Atom));
+		}
+		
+		Atoms->swap (Kept);
+		IndexResidues (&Chains.at(Chain));
+	}
+} // of PdbAssignment::RemoveAtomLocations
+
+
+// ================================================================================
+
+
+void PdbAssignment::Renumber ( void )
+// renumbers the residues and atoms over all chains, starting from 1
+{
+	unsigned int Chain, Residue, Atom;
+	int Number = 0, AtomNumber = 0, OldIns = -1000;
+	double Old = -1000;
+	
+	for (Chain = 0; Chain < Chains.size(); Chain++) {
+		PdbChain* CurChain = &Chains.at(Chain);
+		
+		for (Residue = 0; Residue < CurChain->Residues.size(); Residue++) {
+			PdbResidue* CurResidue = &CurChain->Residues.at(Residue);
+			double ResNumber = atof (CurResidue->ResNumber.c_str());
+			
+			if (ResNumber != Old or CurResidue->Ins != OldIns) {
+				++Number;
+				Old    = ResNumber;
+				OldIns = CurResidue->Ins;
+				CurResidue->Number = Number;
+			}
+			else {
+				CurResidue->Number = (int) ResNumber;
+			}
+			
+			for (Atom = 0; Atom < CurResidue->Atoms.size(); Atom++)
+				CurChain->Atoms.at(CurResidue->Atoms.at(Atom)).Residue = Number;
+		}
+		
+		// the TER indexed as a residue takes a number as well
+		if (CurChain->TerResidue) {
+			++Number;
+			Old    = 0;
+			OldIns = -1;
+		}
+		
+		for (Atom = 0; Atom < CurChain->Atoms.size(); Atom++)
+			if ( not CurChain->Atoms.at(Atom).Ter ) CurChain->Atoms.at(Atom).Number = ++AtomNumber;
+	}
+} // of PdbAssignment::Renumber
+
+
+// ================================================================================
+
+
+void PdbAssignment::Angles ( PdbChain* Chain )
+// calculates phi and psi of all residues of a chain, the N, CA and C atoms of a residue are
+// the last ones found up to its end (as in ParsePDB)
+{
+	vector<const PdbAtom*> N, CA, C;
+	const PdbAtom *CurN = NULL, *CurCA = NULL, *CurC = NULL;
+	unsigned int Atom, Residue;
+	int Count = 0, Number = 0, Ins = 0;
+	
+	for (Atom = 0; Atom < Chain->Atoms.size(); Atom++) {
+		const PdbAtom* CurAtom = &Chain->Atoms.at(Atom);
+		
+		if (CurAtom->Ter) continue;
+		
+		if (Count++ > 0 and (CurAtom->Residue != Number or CurAtom->Ins != Ins)) {
+			N.push_back (CurN);
+			CA.push_back (CurCA);
+			C.push_back (CurC);
+		}
+		
+		Number = CurAtom->Residue;
+		Ins    = CurAtom->Ins;
+		
+		if (CurAtom->Type == "N")  CurN  = CurAtom;
+		if (CurAtom->Type == "CA") CurCA = CurAtom;
+		if (CurAtom->Type == "C")  CurC  = CurAtom;
+	}
+	
+	if (Count < 2) return;
+	
+	N.push_back (CurN);
+	CA.push_back (CurCA);
+	C.push_back (CurC);
+	
+	for (Residue = 0; Residue < N.size() and Residue < Chain->Residues.size(); Residue++) {
+		PdbResidue* CurResidue = &Chain->Residues.at(Residue);
+		
+		CurResidue->Angles = true;
+		CurResidue->Phi    = 360.0;
+		CurResidue->Psi    = 360.0;
+		
+		// no angle at the termini and at gaps in the chain
+		if (Residue > 0 and C.at(Residue - 1) != NULL and N.at(Residue) != NULL and
+		    Distance (C.at(Residue - 1), N.at(Residue)) <= 2) {
+			if (CA.at(Residue) == NULL or C.at(Residue) == NULL)
+				CurResidue->Phi = 364.0;
+			else
+				CurResidue->Phi = Rounded (DihedralAngle (C.at(Residue - 1)->Coord, N.at(Residue)->Coord,
+				                                           CA.at(Residue)->Coord, C.at(Residue)->Coord));
+		}
+		
+		if (Residue + 1 < N.size() and C.at(Residue) != NULL and N.at(Residue + 1) != NULL and
+		    Distance (C.at(Residue), N.at(Residue + 1)) <= 2 and
+		    N.at(Residue) != NULL and CA.at(Residue) != NULL)
+			CurResidue->Psi = Rounded (DihedralAngle (N.at(Residue)->Coord, CA.at(Residue)->Coord,
+			                                           C.at(Residue)->Coord, N.at(Residue + 1)->Coord));
+	}
+} // of PdbAssignment::Angles
+
+
+// ================================================================================
+
+
+void PdbAssignment::Prepare ( void )
+// removes superimposed residues and alternate locations, renumbers and calculates the angles
+{
+	RemoveInsertedResidues ();
+	RemoveAtomLocations ();
+	Renumber ();
+	
+	for (unsigned int Chain = 0; Chain < Chains.size(); Chain++) Angles (&Chains.at(Chain));
+} // of PdbAssignment::Prepare
+
+
+// ================================================================================
+
+
+int PdbAssignment::CountAtoms ( void )
+{
+	int Count = 0;
+	
+	for (unsigned int Chain = 0; Chain < Chains.size(); Chain++)
+		for (unsigned int Atom = 0; Atom < Chains.at(Chain).Atoms.size(); Atom++)
+			if ( not Chains.at(Chain).Atoms.at(Atom).Ter ) ++Count;
+	
+	return Count;
+} // of PdbAssignment::CountAtoms
+
+
+// ================================================================================
+
+
+void PdbAssignment::Prune ( void )
+// keeps only the backbone and the atoms of the requested groups and processes the PDB again,
+// like dcinput does with deletepdbatoms for more than PdbMaxAtoms atoms
+{
+	const char* const SideChains[] = { "phe", "tyr", "trp", "asn", "asp", "gln", "glu" };
+	const char* const Bases[]      = { "A", "T", "G", "C", "U" };
+	vector<PdbAtom> Records;
+	unsigned int Chain, Atom, Group;
+	
+	// the chains as read from the file, with only the first alternate locations
+	SplitChains (&Lines);
+	RemoveAtomLocations ();
+	
+	for (Chain = 0; Chain < Chains.size(); Chain++) {
+		for (Atom = 0; Atom < Chains.at(Chain).Atoms.size(); Atom++) {
+			PdbAtom* CurAtom = &Chains.at(Chain).Atoms.at(Atom);
+			vector<string> Types;
+			
+			if (CurAtom->Ter) continue;
+			
+			SplitString ("CA C O N", Types, " ");
+			
+			for (Group = 0; Group < 7; Group++) {
+				string Key = SideChains[Group];
+				transform (Key.begin(), Key.end(), Key.begin(), ::toupper);
+				
+				if (Option (SideChains[Group]) and CurAtom->Label == Key) {
+					vector<string> Add = GroupAtoms (Key);
+					Types.insert (Types.end(), Add.begin(), Add.end());
+				}
+			}
+			
+			for (Group = 0; Group < 5 and Option ("nb"); Group++) {
+				if (CurAtom->Label == Bases[Group]) {
+					vector<string> Add = GroupAtoms (Bases[Group]);
+					Types.insert (Types.end(), Add.begin(), Add.end());
+				}
+			}
+			
+			// deletepdbatoms adds an empty label with -term
+			if (Option ("term")) Types.push_back ("");
+			
+			if (find (Types.begin(), Types.end(), CurAtom->Type) != Types.end())
+				Records.push_back (*CurAtom);
+		}
+		
+		PdbAtom Ter;
+		Ter.Ter       = true;
+		Ter.Next      = '\0';
+		Ter.AltLoc    = ' ';
+		Ter.Chain     = ' ';
+		Ter.ResNumber = "";
+		Ter.Ins       = ' ';
+		Ter.Record    = -1;
+		Records.push_back (Ter);
+	}
+	
+	for (Atom = 0; Atom + 1 < Records.size(); Atom++)
+		if (Records.at(Atom).Ter and not Records.at(Atom + 1).Ter)
+			Records.at(Atom).Next = Records.at(Atom + 1).Chain;
+	
+	SplitChains (&Records);
+	Prepare ();
+} // of PdbAssignment::Prune
+
+
+// ================================================================================
+
+
+bool PdbAssignment::FindAtom ( PdbChain* Chain, PdbResidue* Residue, string Type, int* Atom )
+// finds the atom of the given type in a residue, which has to be there exactly once
+{
+	int Found = 0;
+	
+	for (unsigned int i = 0; i < Residue->Atoms.size(); i++) {
+		if (Chain->Atoms.at(Residue->Atoms.at(i)).Type == Type) {
+			*Atom = Residue->Atoms.at(i);
+			++Found;
+		}
+	}
+	
+	return (Found == 1);
+} // of PdbAssignment::FindAtom
+
+
+// ================================================================================
+
+
+void PdbAssignment::FindPeptideBonds ( PdbChain* Chain )
+// finds the C and O of a residue and the N of the next one, a missing or ambiguous atom
+// or a N-C distance of more than 1.5 A means a chain break
+{
+	int C = -1, O = -1, N = -1;
+	bool First = true;
+	char Message[256];
+	
+	for (unsigned int Residue = 0; Residue < Chain->Residues.size(); Residue++) {
+		PdbResidue* CurResidue = &Chain->Residues.at(Residue);
+		
+		CurResidue->Peptide.clear();
+		
+		if ( not First ) {
+			if ( not FindAtom (Chain, CurResidue, "N", &N) ) {
+				First = true;
+				continue;
+			}
+			
+			double Length = Distance (&Chain->Atoms.at(N), &Chain->Atoms.at(C));
+			
+			if (Length > 1.5) {
+				snprintf (Message, sizeof (Message), "N-C distance bigger than 1.5 Angstrom (%.2f), "
+				          "skipping residue %d", Length, CurResidue->Number);
+				DC->Warnings.push_back (Message);
+				First = true;
+				continue;
+			}
+			
+			CurResidue->Peptide.push_back (Chain->Atoms.at(C).Number);
+			CurResidue->Peptide.push_back (Chain->Atoms.at(O).Number);
+			CurResidue->Peptide.push_back (Chain->Atoms.at(N).Number);
+		}
+		
+		// the last residue has no bond to a next one
+		if (Residue + 1 == Chain->Residues.size()) break;
+		
+		First = not (FindAtom (Chain, CurResidue, "C", &C) and FindAtom (Chain, CurResidue, "O", &O));
+	}
+} // of PdbAssignment::FindPeptideBonds
+
+
+// ================================================================================
+
+
+int PdbAssignment::UseType ( string Type )
+// the index of the chromophore of a type in DC_Input.Parameters, added when first used
+{
+	if (TypeIndex.count (Type) == 0) {
+		TypeIndex[Type] = DC->DC_Input.Parameters.Name.size();
+		DC->DC_Input.Parameters.Name.push_back  (ChromTypes[Type]);
+		DC->DC_Input.Parameters.Trans.push_back (ChromList[ChromTypes[Type]].Trans);
+	}
+	
+	return TypeIndex[Type];
+} // of PdbAssignment::UseType
+
+
+// ================================================================================
+
+
+void PdbAssignment::AssignPeptide ( PdbChain* Chain, string Type )
+// assigns the backbone chromophores to the peptide bonds
+{
+	if (ChromTypes.count (Type) == 0 or InList ("nochrom", ChromTypes[Type])) return;
+	
+	for (unsigned int Residue = 0; Residue < Chain->Residues.size(); Residue++) {
+		PdbResidue* CurResidue = &Chain->Residues.at(Residue);
+		
+		if (CurResidue->Peptide.size() == 0) continue;
+		
+		int Index = UseType (Type);
+		
+		if (InList ("bbignore", CurResidue->Number)) continue;
+		
+		GroupTypes["peptide"].push_back (Index);
+		Assigned["peptide"].push_back (CurResidue->Peptide);
+	}
+} // of PdbAssignment::AssignPeptide
+
+
+// ================================================================================
+
+
+void PdbAssignment::AssignChargeTransfer ( PdbChain* Chain )
+// assigns the CT chromophore closest in phi and psi to each pair of successive peptide bonds
+{
+	map<string, PdbChromophore>::reverse_iterator Chromophore;
+	unsigned int Residue;
+	
+	for (Residue = 0; Residue + 1 < Chain->Residues.size(); Residue++) {
+		PdbResidue* CurResidue  = &Chain->Residues.at(Residue);
+		PdbResidue* NextResidue = &Chain->Residues.at(Residue + 1);
+		double Smallest = 100000;
+		string BestFit  = "";
+		
+		if ( not CurResidue->Angles or InList ("ctignore", CurResidue->Number) ) continue;
+		if ( CurResidue->Peptide.size() == 0 or NextResidue->Peptide.size() == 0 ) continue;
+		if ( CurResidue->Phi > 180 or CurResidue->Psi > 180 ) continue;
+		
+		// in reverse alphabetical order, the last one of equally close chromophores is taken
+		for (Chromophore = ChromList.rbegin(); Chromophore != ChromList.rend(); ++Chromophore) {
+			if (Chromophore->second.Type != "CTR") continue;
+			
+			double dPhi = fabs (CurResidue->Phi - Chromophore->second.Phi);
+			double dPsi = fabs (CurResidue->Psi - Chromophore->second.Psi);
+			
+			if (dPhi > 180) dPhi = 360 - dPhi;
+			if (dPsi > 180) dPsi = 360 - dPsi;
+			
+			if (dPhi + dPsi <= Smallest) {
+				Smallest = dPhi + dPsi;
+				BestFit  = Chromophore->first;
+			}
+		}
+		
+		if (BestFit == "") return;
+		
+		if ( Option ("chrom") and not InList ("chrom", BestFit) ) continue;
+		if ( InList ("nochrom", BestFit) ) continue;
+		
+		if (CTIndex.count (BestFit) == 0) {
+			CTIndex[BestFit] = DC->DC_Input.Parameters.Name.size();
+			DC->DC_Input.Parameters.Name.push_back  (BestFit);
+			DC->DC_Input.Parameters.Trans.push_back (ChromList[BestFit].Trans);
+		}
+		
+		vector<int> Atoms (CurResidue->Peptide);
+		Atoms.insert (Atoms.end(), NextResidue->Peptide.begin(), NextResidue->Peptide.end());
+		
+		GroupTypes["CT"].push_back (CTIndex[BestFit]);
+		Assigned["CT"].push_back (Atoms);
+	}
+} // of PdbAssignment::AssignChargeTransfer
+
+
+// ================================================================================
+
+
+void PdbAssignment::AssignGroups ( PdbChain* Chain, string Key )
+// assigns the chromophore of a residue type (side chains, nucleic bases, urea), TERM is the
+// last residue of the chain
+{
+	vector<string> Types = GroupAtoms (Key);
+	unsigned int Residue, Type;
+	int Atom;
+	
+	if (ChromTypes.count (Key) == 0) return;
+	
+	// the parameter set is used even if no residue is found (as by dcinput)
+	int Index = UseType (Key);
+	
+	for (Residue = 0; Residue < Chain->Residues.size(); Residue++) {
+		PdbResidue* CurResidue = &Chain->Residues.at(Residue);
+		vector<int> Atoms;
+		
+		if (Key == "TERM") {
+			if (Residue + 1 < Chain->Residues.size()) continue;
+		}
+		else {
+			if (Key != "URE" and InList ("scignore", CurResidue->Number)) continue;
+			if (CurResidue->Label != Key) continue;
+		}
+		
+		for (Type = 0; Type < Types.size(); Type++) {
+			if ( not FindAtom (Chain, CurResidue, Types.at(Type), &Atom) ) break;
+			
+			Atoms.push_back (Chain->Atoms.at(Atom).Number);
+		}
+		
+		if (Atoms.size() < Types.size()) continue;
+		
+		GroupTypes[Key].push_back (Index);
+		Assigned[Key].push_back (Atoms);
+	}
+} // of PdbAssignment::AssignGroups
+
+
+// ================================================================================
+
+
+int PdbAssignment::Assign ( void )
+// assigns the chromophores of all chains and writes the input data to DC_Input
+{
+	const char* const Groups[][2] = { { "phe", "PHE" }, { "tyr", "TYR" }, { "trp", "TRP" },
+	                                  { "asn", "ASN" }, { "gln", "GLN" }, { "asp", "ASP" },
+	                                  { "glu", "GLU" }, { "ade", "A" },   { "gua", "G" },
+	                                  { "cyt", "C" },   { "thy", "T" },   { "ura", "U" },
+	                                  { "nap", "NAP" }, { "term", "TERM" } };
+	Dichro::InputCoordinates* Coordinates = &DC->DC_Input.Coordinates;
+	unsigned int Chain, Residue, Atom, Group;
+	int Factor = 0;
+	
+	for (Chain = 0; Chain < Chains.size(); Chain++) {
+		PdbChain* CurChain = &Chains.at(Chain);
+		
+		FindPeptideBonds (CurChain);
+		
+		if ( not Option ("nobb") ) {
+			if      (Option ("urea")) AssignGroups  (CurChain, "URE");
+			else if (Option ("wdy"))  AssignPeptide (CurChain, "WDY");
+			else                      AssignPeptide (CurChain, "NMA");
+		}
+		
+		if (Option ("ct")) AssignChargeTransfer (CurChain);
+		
+		for (Group = 0; Group < 14; Group++)
+			if (Option (Groups[Group][0])) AssignGroups (CurChain, Groups[Group][1]);
+		
+		// the atom numbers of the coordinates are counted separately in each chain
+		int Counter = 0;
+		
+		for (Residue = 0; Residue < CurChain->Residues.size(); Residue++) {
+			PdbResidue* CurResidue = &CurChain->Residues.at(Residue);
+			
+			for (Atom = 0; Atom < CurResidue->Atoms.size(); Atom++) {
+				PdbAtom* CurAtom = &CurChain->Atoms.at(CurResidue->Atoms.at(Atom));
+				
+				for (int i = 0; i < 3; i++) Coordinates->XYZ.push_back (Rounded (CurAtom->Coord[i]));
+				
+				Coordinates->Atoms.push_back (Counter++);
+				Coordinates->Labels.push_back (CurAtom->Type);
+				DC->DC_FrameAtoms.push_back (CurAtom->Record);
+			}
+		}
+		
+		Factor += CurChain->Residues.size();
+	}
+	
+	// -------------------------------------------------------------------------------
+	
+	for (Group = 0; PdbGroups[Group].Key != NULL; Group++) {
+		string Key = PdbGroups[Group].Key;
+		
+		for (unsigned int i = 0; i < GroupTypes[Key].size(); i++) {
+			vector<int> Atoms (Assigned[Key].at(i));
+			
+			for (Atom = 0; Atom < Atoms.size(); Atom++) --Atoms.at(Atom);
+			
+			DC->DC_Input.Chromophores.Type.push_back (GroupTypes[Key].at(i));
+			DC->DC_Input.Chromophores.Atoms.push_back (Atoms);
+		}
+	}
+	
+	if (DC->DC_Input.Chromophores.Type.size() == 0)
+		return Error (105, "No groups have been found in " + DC->DC_InFile + ".\n\n"
+		                   "       Check whether the atom labels in the PDB are correct (e.g. C, N, O for a\n"
+		                   "       peptide group) and that the residue labels are valid (e.g. A, C, G, T, U\n"
+		                   "       for nucleic bases). Each atom label may only occur once per group.");
+	
+	if (Option ("trans"))
+		DC->DC_Input.Parameters.Trans.assign (DC->DC_Input.Parameters.Trans.size(), IntOption ("trans"));
+	
+	DC->DC_Input.Configuration.BBTrans = Option ("bbtrans") ? IntOption ("bbtrans") : -1;
+	DC->DC_Input.Configuration.CTTrans = Option ("cttrans") ? IntOption ("cttrans") : -1;
+	DC->DC_Input.Configuration.Factor  = Factor;
+	
+	return 0;
+} // of PdbAssignment::Assign
+
+
+// ================================================================================
+
+
+int Dichro::ReadPdbInput ( void )
+// reads the PDB file DC_InFile and assigns the chromophores with the dcinput switches given
+// in DC_Options.Assign, the result in DC_Input is the same as from the .inp file of dcinput
+{
+	PdbAssignment Assignment (this);
+	int ErrorCode;
+	
+	ErrorCode = Assignment.ReadOptions (DC_Options.Assign);
+	
+	if (ErrorCode == 0) ErrorCode = Assignment.ReadChromophores ();
+	if (ErrorCode == 0) ErrorCode = Assignment.ReadPdb (DC_InFile);
+	if (ErrorCode == 0) ErrorCode = Assignment.Assign ();
+	
+	if (ErrorCode != 0) return ErrorCode;
+	
+	if (DC_Verbose) {
+		printf ("   PDB file, %d parameter sets, %d chromophores, %d atoms\n",
+		        (int) DC_Input.Parameters.Name.size(), (int) DC_Input.Chromophores.Type.size(),
+		        DC_Input.Coordinates.Number());
+	}
+	
+	if (DC_Debug > 3) Dichro::OutputInputClass();
+	
+	return 0;
+} // of Dichro::ReadPdbInput
+
+
+// ================================================================================
+
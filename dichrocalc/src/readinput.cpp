@@ -22,13 +22,50 @@
 
 #include "../include/dichrocalc.h"
 
+#include <sys/stat.h>
+
 
 // ================================================================================
 
 
+// the default settings of the calculation
+Dichro::CalculationOptions::CalculationOptions ( void )
+{
+	Eigensolver    = "jacobi";
+	CompareSolvers = false;
+	Threads        = 1;
+	Cutoff         = 0.0;
+	OuterCutoff    = 0.0;
+	Window         = false;
+	Frames         = "";
+	SvdFit         = false;
+	Assign         = "";
+	CTSelect       = false;
+	Stride         = 1;
+	FirstFrame     = 0;
+	LastFrame      = -1;
+	Bandshape      = "";
+	Bandwidth      = 12.5;
+	BandStep       = 0.1;
+	BandTolerance  = 1.0E-9;
+	Average        = false;
+	Disorder       = 0.0;
+	Realizations   = 100;
+	Seed           = 1;
+	ShiftSet       = "";
+	ShiftTrans     = 0;
+	ShiftFirst     = 0.0;
+	ShiftLast      = 0.0;
+	ShiftStep      = 0.0;
+	Repeats        = 0;
+	Periodic       = false;
+	Components     = -1.0;
+} // of Dichro::CalculationOptions::CalculationOptions
+
+
 // the class constructor
 Dichro::Dichro ( string InFile, string Params, bool Verbose, int Debug,
-                 bool PrintVec, bool PrintPol, bool PrintMat )
+                 bool PrintVec, bool PrintPol, bool PrintMat, CalculationOptions Options )
 {
 	// ===================================================================
 	// Global configuration parameters
@@ -47,9 +84,13 @@ Dichro::Dichro ( string InFile, string Params, bool Verbose, int Debug,
 	DC_PrintVec = PrintVec;
 	DC_PrintPol = PrintPol;
 	DC_PrintMat = PrintMat;
+	DC_Options  = Options;
 	
 	DC_Input.Configuration.BBTrans = -1;
 	DC_Input.Configuration.CTTrans = -1;
+	DC_Input.Configuration.Factor  = 0;
+	DC_Input.Configuration.MinWL   = 0;
+	DC_Input.Configuration.MaxWL   = 0;
 	
 	DC_Error     = "";
 	DC_ErrorCode = 0;
@@ -66,7 +107,88 @@ Dichro::Dichro ( string InFile, string Params, bool Verbose, int Debug,
 		// delete everything      from the position of .inp to the total length of the string
 		DC_InFileBaseName.erase (DC_InFileBaseName.find (".inp"), DC_InFileBaseName.size());
 	}
+	else if (FileExtension (DC_InFileBaseName, ".inb")) {  // the binary input file
+		DC_InFileBaseName.erase (DC_InFileBaseName.size() - 4);
+	}
+	else if (FileExtension (DC_InFileBaseName, ".pdb")) {  // a PDB file (pdbinput.cpp)
+		DC_InFileBaseName.erase (DC_InFileBaseName.size() - 4);
+	}
+	
+	// in trajectory mode only the debug output of the topology goes to these files, the
+	// results of each frame are written to separate files (trajectory.cpp), as well as those of
+	// each member of an ensemble (ensemble.cpp)
+	bool Trajectory = (DC_Options.Frames.size() > 0);
+	bool Ensemble   = (DC_Options.Disorder > 0.0 or DC_Options.ShiftSet.size() > 0);
+	
+	if (Trajectory) DC_PrintXyzFiles = false;
+	
+	Dichro::OpenOutputFiles ( not Trajectory and not Ensemble );
+	
+	if (DC_Error == "") { ReadInput ();          }
 	
+	// all CT sets are read with the other parameter sets and chosen for each frame
+	if (DC_Error == "" and DC_Options.CTSelect) { PrepareChargeTransfer (); }
+	
+	if (Trajectory) {
+		if (DC_Error == "") { ReadParameters ();     }
+		
+		Dichro::PrintWarnings ();
+		
+		if (DC_Error == "") { TrajectoryCalculation (); }
+	}
+	else {
+		if (DC_Error == "" and DC_Options.CTSelect) { SelectChargeTransfer (); }
+		if (DC_Error == "") { CheckInputData ();     }
+		if (DC_Error == "") { ReadParameters ();     }
+		
+		if (Ensemble) {
+			Dichro::PrintWarnings ();
+			
+			if (DC_Error == "") { EnsembleCalculation (); }
+		}
+		else {
+			Dichro::Calculation ();
+		}
+	}
+	
+	Dichro::CloseOutputFiles ( not Trajectory and not Ensemble );
+} // of Dichro::Dichro
+
+// a constructor without input file, e.g. to read single parameter sets (parsebench.cpp) or to
+// convert an input file (--binary-input)
+Dichro::Dichro ( string Params )
+{
+	DC_PrintCdl      = false;
+	DC_PrintXyzFiles = false;
+	DC_PrintVec      = false;
+	DC_PrintPol      = false;
+	DC_PrintMat      = false;
+	DC_Verbose       = false;
+	DC_Debug         = 0;
+	DC_Params        = Params;
+	DC_Error         = "";
+	DC_ErrorCode     = 0;
+	
+	DC_Input.Configuration.BBTrans = -1;
+	DC_Input.Configuration.CTTrans = -1;
+	DC_Input.Configuration.Factor  = 0;
+	DC_Input.Configuration.MinWL   = 0;
+	DC_Input.Configuration.MaxWL   = 0;
+} // of Dichro::Dichro
+
+// the class destructor
+Dichro::~Dichro ( void )
+{
+} // of Dichro::~Dichro
+
+
+// ================================================================================
+
+
+void Dichro::OpenOutputFiles ( bool Results )
+// opens the files for DC_InFileBaseName, the debugging files and, if Results is set, the
+// requested result files
+{
 	if (DC_Debug > 0) {
 		DC_DbgFilename = DC_InFileBaseName + ".dbg";
 		DC_DbgFile = fopen (DC_DbgFilename.c_str(), "w");
@@ -77,6 +199,8 @@ Dichro::Dichro ( string InFile, string Params, bool Verbose, int Debug,
 		DC_FitFile = fopen (DC_FitFilename.c_str(), "w");
 	}
 	
+	if (not Results) return;
+	
 	if (DC_PrintVec) { // the polarization vectors for the absorbance/LD
 		DC_VecFilename = DC_InFileBaseName + ".vec";
 		DC_VecFile = fopen (DC_VecFilename.c_str(), "w");
@@ -96,31 +220,61 @@ Dichro::Dichro ( string InFile, string Params, bool Verbose, int Debug,
 		DC_CdlFilename = DC_InFileBaseName + ".cdl";
 		DC_CdlFile = fopen (DC_CdlFilename.c_str(), "w");
 	}
+} // of Dichro::OpenOutputFiles
+
+
+// ================================================================================
+
+
+void Dichro::CloseOutputFiles ( bool Results )
+// closes the files opened by OpenOutputFiles
+{
+	if (DC_Debug > 0) fclose (DC_DbgFile);
+	if (DC_Debug > 4) fclose (DC_FitFile);
 	
-	if (DC_Error == "") { ReadInput ();          }
-	if (DC_Error == "") { CheckInputData ();     }
-	if (DC_Error == "") { ReadParameters ();     }
+	if (not Results) return;
+	
+	if (DC_PrintCdl) fclose (DC_CdlFile);
+	if (DC_PrintPol) fclose (DC_PolFile);
+	if (DC_PrintVec) fclose (DC_VecFile);
+	if (DC_PrintMat) fclose (DC_MatFile);
+} // of Dichro::CloseOutputFiles
+
+
+// ================================================================================
+
+
+void Dichro::Calculation ( void )
+// the calculation of the spectra from the input data and the parameter sets
+{
 	if (DC_Error == "") { FitParameters ();      }
 	if (DC_Error == "") { HamiltonianMatrix ();  }
 	if (DC_Error == "") { CD_Calculation ();     }
 	if (DC_Error == "") { LD_Calculation ();     }
 	
+	if (DC_Error == "" and DC_Options.Bandshape.size() > 0) { BandshapeCalculation (); }
+	
 	if (DC_Debug > 1) Dichro::OutputSystemClass  ();
 	if (DC_Debug > 0) Dichro::OutputResultsClass ();
 	
-	if (DC_Debug > 0) fclose (DC_DbgFile);
-	if (DC_Debug > 4) fclose (DC_FitFile);
-	
-	if (DC_PrintCdl) fclose (DC_CdlFile);
-	if (DC_PrintPol) fclose (DC_PolFile);
-	if (DC_PrintVec) fclose (DC_VecFile);
-	if (DC_PrintMat) fclose (DC_MatFile);
-} // of Dichro::Dichro
+	Dichro::PrintWarnings ();
+} // of Dichro::Calculation
 
-// the class destructor
-Dichro::~Dichro ( void )
+
+// ================================================================================
+
+
+void Dichro::PrintWarnings ( void )
+// prints the non-fatal problems collected so far to stderr (also without -v, with the name of
+// the frame or the ensemble member) and clears them
 {
-} // of Dichro::~Dichro
+	unsigned int Warning;
+	
+	for (Warning = 0; Warning < Warnings.size(); Warning++)
+		fprintf (stderr, "WARNING: %s: %s\n", DC_InFileBaseName.c_str(), Warnings.at(Warning).c_str());
+	
+	Warnings.clear();
+} // of Dichro::PrintWarnings
 
 
 // ================================================================================
@@ -141,6 +295,12 @@ int Dichro::ReadInput ( void )
 		fprintf (DC_DbgFile, "   File: %s\n\n", DC_InFile.c_str());
 	}
 	
+	// a binary input file written with --binary-input (binaryinput.cpp)
+	if (FileExtension (DC_InFile, ".inb")) return Dichro::ReadBinaryInput ();
+	
+	// a PDB file, the chromophores are assigned like by dcinput (pdbinput.cpp)
+	if (FileExtension (DC_InFile, ".pdb")) return Dichro::ReadPdbInput ();
+	
 	InFile.open (DC_InFile.c_str(), ios::in);
 	
 	if ( not InFile ) {
@@ -293,15 +453,10 @@ int Dichro::ReadInputSection ( ifstream *InFile, string CurrentBlock )
 		{
 			if (Fields.size() < 3) { ColumnError (DC_InFile, Line, 3); return 116; }
 			
-			// create a new array for the coordinates
-			vector<double>  Coordinates;
-			
-			// add the coordinates one by one to the created array
+			// add the coordinates one by one to the contiguous array of all atoms
 			for (i = 0; i < 3; i++)
-				Coordinates.push_back ( atof (Fields.at(i).c_str() ) );
+				DC_Input.Coordinates.XYZ.push_back ( atof (Fields.at(i).c_str() ) );
 			
-			// add the array to the Groups vector (i.e. it is a vector of vectors!)
-			DC_Input.Coordinates.Groups.push_back ( Coordinates );
 			DC_Input.Coordinates.Atoms.push_back ( atoi(Fields.at(4).c_str())-1 ); // decreased by 1!
 			DC_Input.Coordinates.Labels.push_back ( Fields.at(5).c_str() );
 		} // of if (CurrentBlock.compare("$COORDINATES") == 0)
@@ -347,10 +502,10 @@ int Dichro::CheckInputData ( void )
 		for (Atom = 0; Atom < DC_Input.Chromophores.Atoms.at(Group).size(); Atom++) {
 			CurAtom = DC_Input.Chromophores.Atoms.at(Group).at(Atom);
 			
-			if (CurAtom > DC_Input.Coordinates.Groups.size()) {
+			if (CurAtom > DC_Input.Coordinates.Number()) {
 				cerr << "\nERROR: Atom number " << CurAtom
 				     << " is referenced in $CHROMOPHORES block, but only\n       "
-				     << DC_Input.Coordinates.Groups.size()
+				     << DC_Input.Coordinates.Number()
 				     << " atoms are present in $COORDINATES block.\n\n";
 				DC_Error = "Missing atom coordinates in input file";
 				DC_ErrorCode = 123;
@@ -406,12 +561,8 @@ int Dichro::CheckInputData ( void )
 int Dichro::ReadParameters ( void )
 // reads and parses all parameter sets specified in the input file
 {
-	unsigned int i, CurFile, State, Trans, FilePos;
-	bool Permanent;
-	string Filename, Line;
-	vector<string> Fields;
-	vector<string> FileLines;
-	vector< vector<string> > FileFields;
+	unsigned int i, CurFile;
+	string Filename;
 	
 	if (DC_Verbose)   Dichro::NewTask ( "Reading Parameter Files" );
 	if (DC_Debug > 3) Dichro::NewFileTask ( DC_DbgFile, "Reading Parameter Files" );
@@ -425,6 +576,12 @@ int Dichro::ReadParameters ( void )
 		// delete the last character of the string
 		DC_Params.erase(DC_Params.size()-1, 1);
 	
+	// a file instead of a directory is a library created with --compile-params (parlibrary.cpp)
+	struct stat Status;
+	
+	if (stat (DC_Params.c_str(), &Status) == 0 and S_ISREG (Status.st_mode))
+		return Dichro::ReadParameterLibrary ();
+	
 	vector<string> ParFiles;
 	
 	if (not ReadDir (DC_Params, ".par", &ParFiles)) {
@@ -483,159 +640,182 @@ int Dichro::ReadParameters ( void )
 		else
 			CurParSet.ChargeTransfer = false;
 		
-		ifstream File;          // reinitialize each time, otherwise File.eof() remains true on Linux
-		File.open (Filename.c_str(), ios::in);
-		FileLines.clear();      // all lines of the current file as strings
-		FileFields.clear();     // all lines of the current file as columns
-		
-		// The matrix method parameter sets were created for the use with a FORTRAN
-		// program and are designed to be read on a line-by-line bases instead of
-		// a block-wise fashion.
-		
-		// read and parse the complete file
-		while ( not File.eof() ) {
-			// split each line into columns and add to FileFields and FileLines
-			SplitNextLine (&File, Line, Fields, " ");
-			FileLines.push_back (Line);
-			FileFields.push_back (Fields);
-		}
+		// the parameter file is read into a buffer and parsed in a single pass (parfile.cpp)
+		// with only the monopoles of the transitions used by FitParameters
+		if (Dichro::ReadParameterSet (Filename, &CurParSet, CurFile) != 0) return DC_ErrorCode;
 		
-		File.close();   // only FileFields and FileLines are used from now on
-		
-		if (FileFields.size() == 0) {
-			cerr << "\nERROR: Could not read file " << Filename.c_str() << "\n\n";
-			DC_Error = "Error reading in parameter set file";
-			DC_ErrorCode = 132;
-			return 132;
-		}
-		
-		FilePos = 0;    // generally used to access a specific position in the file content
-		Fields = FileFields.at(FilePos);
-		
-		// the first line should contain the filename (case-sensitive!)
-		if (Fields.at(0).find (CurParSet.Name) == string::npos) {
-			cerr << "\nERROR: In file " << Filename << " the first line does not contain\n"
-			     <<   "       the parameter set name " << CurParSet.Name << ".\n\n";
-			DC_Error = "Format error in parameter set file.";
-			DC_ErrorCode = 133;
-			return 133;
-		}
-		
-		// --------------------------------------------------------------------------------
+		// DEBUG OUPUT: print the complete data
+		if (DC_Debug > 4) Dichro::OutputParSetClass ( &CurParSet );
 		
-		// the second line contains the number of atoms to be read in the following lines
+		// save the current set with the same index as in the input file
+		DC_ParSets.push_back (CurParSet);
+	} // of for (i = 0; i < DC_Input.Parameters.Name.size(); i++)
+	
+	return 0;
+} // of Dichro::ReadParameters
+
+
+// ================================================================================
+
+
+int Dichro::ReadParameterSetLines ( string Filename, ParSet* CurParSet )
+// The original parser of a parameter file, which first splits all lines into tables and then
+// copies them for every transition. ReadParameters uses ReadParameterSet, this version is only
+// kept as the reference of the benchmark (parsebench.cpp).
+{
+	unsigned int i, State, Trans, FilePos;
+	bool Permanent;
+	string Line;
+	vector<string> Fields;
+	vector<string> FileLines;
+	vector< vector<string> > FileFields;
+	
+	ifstream File;          // reinitialize each time, otherwise File.eof() remains true on Linux
+	File.open (Filename.c_str(), ios::in);
+	FileLines.clear();      // all lines of the current file as strings
+	FileFields.clear();     // all lines of the current file as columns
+	
+	// The matrix method parameter sets were created for the use with a FORTRAN
+	// program and are designed to be read on a line-by-line bases instead of
+	// a block-wise fashion.
+	
+	// read and parse the complete file
+	while ( not File.eof() ) {
+		// split each line into columns and add to FileFields and FileLines
+		SplitNextLine (&File, Line, Fields, " ");
+		FileLines.push_back (Line);
+		FileFields.push_back (Fields);
+	}
+	
+	File.close();   // only FileFields and FileLines are used from now on
+	
+	if (FileFields.size() == 0) {
+		cerr << "\nERROR: Could not read file " << Filename.c_str() << "\n\n";
+		DC_Error = "Error reading in parameter set file";
+		DC_ErrorCode = 132;
+		return 132;
+	}
+	
+	FilePos = 0;    // generally used to access a specific position in the file content
+	Fields = FileFields.at(FilePos);
+	
+	// the first line should contain the filename (case-sensitive!)
+	if (Fields.at(0).find (CurParSet->Name) == string::npos) {
+		cerr << "\nERROR: In file " << Filename << " the first line does not contain\n"
+		     <<   "       the parameter set name " << CurParSet->Name << ".\n\n";
+		DC_Error = "Format error in parameter set file.";
+		DC_ErrorCode = 133;
+		return 133;
+	}
+	
+	// --------------------------------------------------------------------------------
+	
+	// the second line contains the number of atoms to be read in the following lines
+	Fields = FileFields.at(++FilePos); // FIRST increase FilePos and THEN get the line
+	
+	CurParSet->NumberOfAtoms = atoi ( Fields.at(0).c_str() );
+	
+	if (CurParSet->NumberOfAtoms == 0) {
+		cerr << "\nERROR: In file " << Filename
+		     << " the number of atoms could not be interpreted in line\n"
+		     <<   FileLines.at(FilePos) << "\n\n";
+		DC_Error = "Format error in parameter set file.";
+		DC_ErrorCode = 134;
+		return 134;
+	}
+	
+	// initialize the coordinates of the reference point
+	for (i = 0; i < 3; i++) CurParSet->Reference.push_back (0);
+	double Weighting = 0;
+	int Atom;
+	
+	// now read as many atoms as stated in the line before
+	for (Atom = 0; Atom < CurParSet->NumberOfAtoms; Atom++) {
 		Fields = FileFields.at(++FilePos); // FIRST increase FilePos and THEN get the line
-		
-		CurParSet.NumberOfAtoms = atoi ( Fields.at(0).c_str() );
-		
-		if (CurParSet.NumberOfAtoms == 0) {
-			cerr << "\nERROR: In file " << Filename
-			     << " the number of atoms could not be interpreted in line\n"
-			     <<   FileLines.at(FilePos) << "\n\n";
-			DC_Error = "Format error in parameter set file.";
-			DC_ErrorCode = 134;
-			return 134;
+		if (Fields.size() < 6) {
+			ColumnError (CurParSet->Name, FileLines.at(FilePos), 6);
+			return 135;
 		}
 		
-		// initialize the coordinates of the reference point
-		for (i = 0; i < 3; i++) CurParSet.Reference.push_back (0);
-		double Weighting = 0;
-		int Atom;
-		
-		// now read as many atoms as stated in the line before
-		for (Atom = 0; Atom < CurParSet.NumberOfAtoms; Atom++) {
-			Fields = FileFields.at(++FilePos); // FIRST increase FilePos and THEN get the line
-			if (Fields.size() < 6) {
-				ColumnError (CurParSet.Name, FileLines.at(FilePos), 6);
-				return 135;
-			}
-			
-			ParSetAtom Atom;
-			Atom.Coord.push_back ( atof (Fields.at(0).c_str() ) );
-			Atom.Coord.push_back ( atof (Fields.at(1).c_str() ) );
-			Atom.Coord.push_back ( atof (Fields.at(2).c_str() ) );
-			Atom.Weighting =       atof (Fields.at(3).c_str() );
-			Atom.Label     = Fields.at(5);
-			CurParSet.Atoms.push_back (Atom);
-			
-			CurParSet.Reference.at(0) += Atom.Coord.at(0) * Atom.Weighting;
-			CurParSet.Reference.at(1) += Atom.Coord.at(1) * Atom.Weighting;
-			CurParSet.Reference.at(2) += Atom.Coord.at(2) * Atom.Weighting;
-			Weighting = Weighting + Atom.Weighting;
-		}
-		
-		// divide each coordinate of the reference point by the weighting factor
-		for (i = 0; i < 3; i++) CurParSet.Reference.at(i) /= Weighting;
+		ParSetAtom Atom;
+		Atom.Coord.push_back ( atof (Fields.at(0).c_str() ) );
+		Atom.Coord.push_back ( atof (Fields.at(1).c_str() ) );
+		Atom.Coord.push_back ( atof (Fields.at(2).c_str() ) );
+		Atom.Weighting =       atof (Fields.at(3).c_str() );
+		Atom.Label     = Fields.at(5);
+		CurParSet->Atoms.push_back (Atom);
+		
+		CurParSet->Reference.at(0) += Atom.Coord.at(0) * Atom.Weighting;
+		CurParSet->Reference.at(1) += Atom.Coord.at(1) * Atom.Weighting;
+		CurParSet->Reference.at(2) += Atom.Coord.at(2) * Atom.Weighting;
+		Weighting = Weighting + Atom.Weighting;
+	}
+	
+	// divide each coordinate of the reference point by the weighting factor
+	for (i = 0; i < 3; i++) CurParSet->Reference.at(i) /= Weighting;
+	
+	// --------------------------------------------------------------------------------
+	
+	Fields = FileFields.at(++FilePos); // FIRST increase FilePos and THEN get the line
+	
+	// after the atoms, a state should follow, starting with &TRANSITION
+	if (Fields.at(0).find ("&TRANSITION") == string::npos) {
+		cerr << "\nERROR: Label &TRANSITION expected in file "
+		     << Filename << " in line\n       " << FileLines.at(FilePos) << "\n\n";
+		DC_Error = "Format error in parameter set";
+		DC_ErrorCode = 137;
+		return 137;
+	}
+	
+	State = 0;
+	
+	// this loop takes care of the states (started with a &TRANSITION label)
+	while ( (FilePos+1 < FileFields.size() )     // 'EOF' not reached and
+	         and         // and current Line contains &TRANSITION or &PERMANENT
+		     ( (FileLines.at(FilePos).find ("&TRANSITION") != string::npos)
+		       or (FileLines.at(FilePos).find ("&PERMANENT") != string::npos) ) ) {
 		
-		// --------------------------------------------------------------------------------
+		if (FileLines.at(FilePos).find ("&PERMANENT") != string::npos)
+			Permanent = true;
+		else
+			Permanent = false;
 		
-		Fields = FileFields.at(++FilePos); // FIRST increase FilePos and THEN get the line
+		++FilePos; // advance to the next line, the start of the first transition of the state
 		
-		// after the atoms, a state should follow, starting with &TRANSITION
-		if (Fields.at(0).find ("&TRANSITION") == string::npos) {
-			cerr << "\nERROR: Label &TRANSITION expected in file "
-			     << Filename << " in line\n       " << FileLines.at(FilePos) << "\n\n";
-			DC_Error = "Format error in parameter set";
-			DC_ErrorCode = 137;
-			return 137;
-		}
+		vector<ParSetTrans> NewState;
+		CurParSet->States.push_back (NewState);
+		Trans = 0;
 		
-		State = 0;
+		// this loop handles single transitions within a state
+		while ( (FilePos+1 < FileFields.size() )  // 'EOF' not reached and
+		         and         // and current line contains neither &TRANSITION nor &PERMANENT
+		        ( (FileLines.at(FilePos).find ("&TRANSITION") == string::npos)
+		          and (FileLines.at(FilePos).find ("&PERMANENT") == string::npos) ) ) {
 		
-		// this loop takes care of the states (started with a &TRANSITION label)
-		while ( (FilePos+1 < FileFields.size() )     // 'EOF' not reached and
-		         and         // and current Line contains &TRANSITION or &PERMANENT
-			     ( (FileLines.at(FilePos).find ("&TRANSITION") != string::npos)
-			       or (FileLines.at(FilePos).find ("&PERMANENT") != string::npos) ) ) {
-			
-			if (FileLines.at(FilePos).find ("&PERMANENT") != string::npos)
-				Permanent = true;
-			else
-				Permanent = false;
-			
-			++FilePos; // advance to the next line, the start of the first transition of the state
-			
-			vector<ParSetTrans> NewState;
-			CurParSet.States.push_back (NewState);
-			Trans = 0;
+			++Trans;
 			
-			// this loop handles single transitions within a state
-			while ( (FilePos+1 < FileFields.size() )  // 'EOF' not reached and
-			         and         // and current line contains neither &TRANSITION nor &PERMANENT
-			        ( (FileLines.at(FilePos).find ("&TRANSITION") == string::npos)
-			          and (FileLines.at(FilePos).find ("&PERMANENT") == string::npos) ) ) {
+			// DEBUG OUTPUT
+			// if (DC_Debug > 5) {
+			// 	if (Permanent)
+			// 		printf ("      - permanent moments of state %d\n", Trans);
+			// 	else
+			// 		printf ("      - state %d, transition %d\n", State, Trans);
+			// }
 			
-				++Trans;
-				
-				// DEBUG OUTPUT
-				// if (DC_Debug > 5) {
-				// 	if (Permanent)
-				// 		printf ("      - permanent moments of state %d\n", Trans);
-				// 	else
-				// 		printf ("      - state %d, transition %d\n", State, Trans);
-				// }
-				
-				// create a new instance of the transition class and read the next transition
-				ParSetTrans CurTrans;
-				Dichro::ReadTransition ( FileLines, FileFields, CurParSet.Name,
-				                         &FilePos, &CurTrans, Trans, Permanent );
-				CurParSet.States.at(State).push_back ( CurTrans );
-				
-				++FilePos;  // go to the next line for the while loop checks
-			} // of inner while loop
+			// create a new instance of the transition class and read the next transition
+			ParSetTrans CurTrans;
+			Dichro::ReadTransition ( FileLines, FileFields, CurParSet->Name,
+			                         &FilePos, &CurTrans, Trans, Permanent );
+			CurParSet->States.at(State).push_back ( CurTrans );
 			
-			++State;
-		} // of outer while loop
-		
-		// DEBUG OUPUT: print the complete data
-		if (DC_Debug > 4) Dichro::OutputParSetClass ( &CurParSet );
+			++FilePos;  // go to the next line for the while loop checks
+		} // of inner while loop
 		
-		// save the current set with the same index as in the input file
-		DC_ParSets.push_back (CurParSet);
-	} // of for (i = 0; i < DC_Input.Parameters.Name.size(); i++)
+		++State;
+	} // of outer while loop
 	
 	return 0;
-} // of Dichro::ReadParameters
+} // of Dichro::ReadParameterSetLines
 
 
 // ================================================================================
@@ -0,0 +1,471 @@
+// #################################################################################################
+//
+//  Program:      sparse.cpp
+//
+//  Function:     Part of DichroCalc:
+//                A sparse symmetric matrix and the calculation of the eigenpairs within an
+//                energy window
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <math.h>
+#include <algorithm>
+
+
+// WindowEigensystem calculates only the eigenpairs with eigenvalues within [Lower, Upper], using
+// the sparse matrix solely for matrix-vector products. A block of vectors is repeatedly multiplied
+// with a polynomial of the matrix that approximates 1 within the window and 0 outside (a Chebyshev
+// expansion of the step function with Jackson damping), which filters out all other eigenvectors.
+// The eigenpairs are then extracted from the filtered block by a Rayleigh-Ritz step. The blocks
+// are column-major arrays of the vectors, i.e. element r of vector j is found at X[r + j*n].
+
+// the maximum number of filter iterations
+const int WindowMaxIterations = 100;
+
+// the eigenpairs are converged if |Hv - ev| is below this fraction of the spectral radius
+const double WindowTolerance = 1.0E-10;
+
+
+// ================================================================================
+
+
+void SparseMatrix::Build ( vector< vector<int> >* Columns, vector< vector<double> >* Values )
+// Creates the matrix from the lower triangle, given as the columns (ascending, col <= row) and
+// values of each row. The upper triangle is added by symmetry.
+{
+	int Row, Col, Element, Position;
+	
+	Dimension = Columns->size();
+	RowStart.assign (Dimension+1, 0);
+	
+	// the number of elements in each row, shifted by one
+	for (Row = 0; Row < Dimension; Row++) {
+		for (Element = 0; Element < (int) Columns->at(Row).size(); Element++) {
+			Col = Columns->at(Row).at(Element);
+			
+			++RowStart.at(Row+1);
+			if (Col != Row) ++RowStart.at(Col+1);
+		}
+	}
+	
+	for (Row = 0; Row < Dimension; Row++)
+		RowStart.at(Row+1) += RowStart.at(Row);
+	
+	Column.resize (RowStart.at(Dimension));
+	Value.resize  (RowStart.at(Dimension));
+	
+	vector<int> Next (RowStart.begin(), RowStart.end() - 1);
+	
+	// first the lower triangle of each row, then the mirrored elements, which are found in
+	// ascending order of the rows and are all right of the diagonal
+	for (Row = 0; Row < Dimension; Row++) {
+		for (Element = 0; Element < (int) Columns->at(Row).size(); Element++) {
+			Position = Next.at(Row)++;
+			Column.at(Position) = Columns->at(Row).at(Element);
+			Value.at(Position)  = Values->at(Row).at(Element);
+		}
+	}
+	
+	for (Row = 0; Row < Dimension; Row++) {
+		for (Element = 0; Element < (int) Columns->at(Row).size(); Element++) {
+			Col = Columns->at(Row).at(Element);
+			if (Col == Row) continue;
+			
+			Position = Next.at(Col)++;
+			Column.at(Position) = Row;
+			Value.at(Position)  = Values->at(Row).at(Element);
+		}
+	}
+} // of SparseMatrix::Build
+
+
+// ================================================================================
+
+
+double SparseMatrix::Element ( int Row, int Col )
+// returns an element of the matrix (0 if it is not stored)
+{
+	vector<int>::iterator First = Column.begin() + RowStart.at(Row);
+	vector<int>::iterator Last  = Column.begin() + RowStart.at(Row+1);
+	vector<int>::iterator Found = lower_bound (First, Last, Col);
+	
+	if (Found == Last or *Found != Col) return 0.0;
+	
+	return Value.at(Found - Column.begin());
+} // of SparseMatrix::Element
+
+
+// ================================================================================
+
+
+void SparseMatrix::Multiply ( const double* In, double* Out, int Vectors )
+// multiplies the matrix with a block of column-major vectors, four vectors are processed at
+// once to read the matrix elements only once for all of them
+{
+	int Row, Element, Vector, Col;
+	double Sum0, Sum1, Sum2, Sum3, a;
+	int n = Dimension;
+	
+	for (Vector = 0; Vector + 4 <= Vectors; Vector += 4) {
+		const double* x = &In[Vector * n];
+		double*       y = &Out[Vector * n];
+		
+		for (Row = 0; Row < n; Row++) {
+			Sum0 = Sum1 = Sum2 = Sum3 = 0.0;
+			
+			for (Element = RowStart[Row]; Element < RowStart[Row+1]; Element++) {
+				a   = Value[Element];
+				Col = Column[Element];
+				
+				Sum0 += a * x[Col];
+				Sum1 += a * x[Col + n];
+				Sum2 += a * x[Col + 2*n];
+				Sum3 += a * x[Col + 3*n];
+			}
+			
+			y[Row]       = Sum0;
+			y[Row + n]   = Sum1;
+			y[Row + 2*n] = Sum2;
+			y[Row + 3*n] = Sum3;
+		}
+	}
+	
+	for (; Vector < Vectors; Vector++) {
+		const double* x = &In[Vector * n];
+		double*       y = &Out[Vector * n];
+		
+		for (Row = 0; Row < n; Row++) {
+			Sum0 = 0.0;
+			
+			for (Element = RowStart[Row]; Element < RowStart[Row+1]; Element++)
+				Sum0 += Value[Element] * x[Column[Element]];
+			
+			y[Row] = Sum0;
+		}
+	}
+} // of SparseMatrix::Multiply
+
+
+// ================================================================================
+
+
+void SparseMatrix::Dense ( SymmetricMatrix* Out )
+// copies the matrix into a dense NewMat matrix
+{
+	int Row, Element;
+	
+	Out->ReSize (Dimension);
+	*Out = 0.0;
+	
+	for (Row = 0; Row < Dimension; Row++)
+		for (Element = RowStart.at(Row); Element < RowStart.at(Row+1); Element++)
+			if (Column.at(Element) <= Row)
+				Out->element (Row, Column.at(Element)) = Value.at(Element);
+} // of SparseMatrix::Dense
+
+
+// ================================================================================
+
+
+static double RandomNumber ( unsigned long long* Seed )
+// a reproducible pseudo-random number between -0.5 and 0.5 (linear congruential generator)
+{
+	*Seed = *Seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (double) (*Seed >> 11) / 9007199254740992.0 - 0.5;
+} // of RandomNumber
+
+
+// ================================================================================
+
+
+static int Orthonormalize ( int n, int m, double* X, unsigned long long* Seed )
+// orthonormalizes the m column vectors of X by modified Gram-Schmidt (applied twice), vectors
+// which are linearly dependent on the previous ones are replaced by random vectors
+{
+	int i, j, r, Pass, Attempt;
+	double Dot, Norm;
+	
+	for (j = 0; j < m; j++) {
+		double* v = &X[j*n];
+		
+		for (Attempt = 0; Attempt < 3; Attempt++) {
+			double Before = 0.0;
+			for (r = 0; r < n; r++) Before += v[r] * v[r];
+			
+			for (Pass = 0; Pass < 2; Pass++) {
+				for (i = 0; i < j; i++) {
+					double* u = &X[i*n];
+					
+					Dot = 0.0;
+					for (r = 0; r < n; r++) Dot += u[r] * v[r];
+					for (r = 0; r < n; r++) v[r] -= Dot * u[r];
+				}
+			}
+			
+			Norm = 0.0;
+			for (r = 0; r < n; r++) Norm += v[r] * v[r];
+			
+			if (Norm > 1.0E-20 * Before and Norm > 0.0) break;
+			
+			for (r = 0; r < n; r++) v[r] = RandomNumber (Seed);
+		}
+		
+		if (Attempt == 3) return 1;
+		
+		Norm = sqrt (Norm);
+		for (r = 0; r < n; r++) v[r] /= Norm;
+	}
+	
+	return 0;
+} // of Orthonormalize
+
+
+// ================================================================================
+
+
+int WindowEigensystem ( SparseMatrix* H, double Lower, double Upper, string Method,
+                        DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors,
+                        WindowStatistics* Statistics )
+// Calculates the eigenpairs of H with eigenvalues within [Lower, Upper], in ascending order. The
+// eigenvectors of the small Rayleigh-Ritz matrices are calculated with the given method. Returns
+// 0 on success, 1 if the iteration did not converge and 2 if the window contains too large a part
+// of the spectrum for the filter to be faster than the diagonalization of the dense matrix.
+{
+	int n = H->Dimension;
+	int Row, Element, i, j, k, r, Iteration;
+	double Min, Max, Diagonal, Radius;
+	unsigned long long Seed = 20091006ULL;
+	
+	// the bounds of the spectrum from the Gershgorin circles, the number of circles touching
+	// the window is an estimate of the number of eigenvalues within it
+	int Circles = 0;
+	Min =  1.0E300;
+	Max = -1.0E300;
+	
+	for (Row = 0; Row < n; Row++) {
+		Diagonal = 0.0;
+		Radius   = 0.0;
+		
+		for (Element = H->RowStart.at(Row); Element < H->RowStart.at(Row+1); Element++) {
+			if (H->Column.at(Element) == Row) Diagonal = H->Value.at(Element);
+			else                              Radius  += fabs (H->Value.at(Element));
+		}
+		
+		Min = min (Min, Diagonal - Radius);
+		Max = max (Max, Diagonal + Radius);
+		
+		if (Diagonal + Radius >= Lower and Diagonal - Radius <= Upper) ++Circles;
+	}
+	
+	Statistics->Lower        = Min;
+	Statistics->Upper        = Max;
+	Statistics->Iterations   = 0;
+	Statistics->Residual     = 0.0;
+	Statistics->SubspaceSize = min (n, Circles + 10);
+	Statistics->Degree       = 0;
+	
+	if (n == 0 or Statistics->SubspaceSize > n / 2) return 2;
+	
+	// map the spectrum to [-1, 1], where the Chebyshev polynomials are defined
+	double Center    = 0.5 * (Max + Min);
+	double HalfWidth = 0.5 * (Max - Min) + 1.0E-6 * max (1.0, fabs (Center));
+	double Alpha     = max (-1.0, min (1.0, (Lower - Center) / HalfWidth));
+	double Beta      = max (-1.0, min (1.0, (Upper - Center) / HalfWidth));
+	
+	// the resolution of the filter is about pi/Degree, it has to be well below the window width
+	int Degree = (int) ceil (10.0 * M_PI / max (Beta - Alpha, 1.0E-6));
+	Degree = max (20, min (2000, Degree));
+	Statistics->Degree = Degree;
+	
+	// the expansion coefficients of the step function, damped with the Jackson kernel
+	vector<double> Coefficient (Degree+1);
+	double ThetaAlpha = acos (Alpha);
+	double ThetaBeta  = acos (Beta);
+	double Angle      = M_PI / (Degree + 1);
+	
+	for (k = 0; k <= Degree; k++) {
+		double Jackson = ( (Degree - k + 1) * cos (k * Angle)
+		                   + sin (k * Angle) / tan (Angle) ) / (Degree + 1);
+		
+		if (k == 0)
+			Coefficient.at(k) = (ThetaAlpha - ThetaBeta) / M_PI;
+		else
+			Coefficient.at(k) = 2.0 * (sin (k * ThetaAlpha) - sin (k * ThetaBeta)) / (k * M_PI);
+		
+		Coefficient.at(k) *= Jackson;
+	}
+	
+	double Tolerance = WindowTolerance * max (fabs (Min), fabs (Max));
+	int m = Statistics->SubspaceSize;
+	
+	vector<double> X (n * m), Y, T0, T1, T2, HX;
+	vector<double> Values;
+	vector<int> Inside;
+	int PreviousFound = -1, Stable = 0;
+	
+	for (i = 0; i < n * m; i++) X[i] = RandomNumber (&Seed);
+	
+	for (Iteration = 1; Iteration <= WindowMaxIterations; Iteration++) {
+		Statistics->Iterations = Iteration;
+		
+		// Y = p(H) X with the three-term recurrence T(k+1) = 2 H' T(k) - T(k-1), H' = mapped H
+		Y.assign (n * m, 0.0);
+		T0 = X;
+		T1.resize (n * m);
+		T2.resize (n * m);
+		
+		H->Multiply (&T0[0], &T1[0], m);
+		
+		for (i = 0; i < n * m; i++) {
+			T1[i] = (T1[i] - Center * T0[i]) / HalfWidth;
+			Y[i]  = Coefficient.at(0) * T0[i] + Coefficient.at(1) * T1[i];
+		}
+		
+		for (k = 2; k <= Degree; k++) {
+			H->Multiply (&T1[0], &T2[0], m);
+			
+			for (i = 0; i < n * m; i++) {
+				T2[i] = 2.0 * (T2[i] - Center * T1[i]) / HalfWidth - T0[i];
+				Y[i] += Coefficient.at(k) * T2[i];
+			}
+			
+			T0.swap (T1);
+			T1.swap (T2);
+		}
+		
+		if (Orthonormalize (n, m, &Y[0], &Seed) != 0) return 1;
+		
+		// Rayleigh-Ritz: the eigenpairs of Y^T H Y give the approximations X = Y V
+		HX.resize (n * m);
+		H->Multiply (&Y[0], &HX[0], m);
+		
+		SymmetricMatrix Projected (m);
+		
+		for (i = 0; i < m; i++) {
+			for (j = 0; j <= i; j++) {
+				double Dot = 0.0;
+				for (r = 0; r < n; r++) Dot += Y[r + i*n] * HX[r + j*n];
+				Projected.element (i, j) = Dot;
+			}
+		}
+		
+		DiagonalMatrix RitzValues (m);
+		Matrix RitzVectors (m, m);
+		
+		if (SymmetricEigensystem (Method, &Projected, &RitzValues, &RitzVectors) != 0) return 1;
+		
+		vector<double> HY (HX);
+		X.assign  (n * m, 0.0);
+		HX.assign (n * m, 0.0);
+		
+		for (j = 0; j < m; j++) {
+			for (i = 0; i < m; i++) {
+				double Factor = RitzVectors.element (i, j);
+				
+				for (r = 0; r < n; r++) {
+					X[r + j*n]  += Factor * Y[r + i*n];
+					HX[r + j*n] += Factor * HY[r + i*n];
+				}
+			}
+		}
+		
+		// The Ritz pairs within the window with a small residual are accepted. The subspace also
+		// contains mixtures of damped eigenvectors outside the window, whose Ritz values may fall
+		// into the window but which never converge ("ghosts", residual about the window width).
+		Values.clear();
+		Inside.clear();
+		Statistics->Residual = 0.0;
+		int Candidates = 0;
+		
+		for (j = 0; j < m; j++) {
+			double Value = RitzValues.element (j);
+			if (Value < Lower or Value > Upper) continue;
+			
+			double Norm = 0.0;
+			for (r = 0; r < n; r++) Norm += pow (HX[r + j*n] - Value * X[r + j*n], 2);
+			
+			++Candidates;
+			if (sqrt (Norm) >= Tolerance) continue;
+			
+			Statistics->Residual = max (Statistics->Residual, sqrt (Norm));
+			Values.push_back (Value);
+			Inside.push_back (j);
+		}
+		
+		// if (almost) the whole subspace falls into the window, eigenvectors may be missing
+		if (Candidates > m - 3 and m < n) {
+			int Added = min (n - m, max (10, m / 2));
+			
+			X.resize (n * (m + Added));
+			for (i = n * m; i < n * (m + Added); i++) X[i] = RandomNumber (&Seed);
+			
+			m += Added;
+			Statistics->SubspaceSize = m;
+			Stable = 0;
+			continue;
+		}
+		
+		// converged if all candidates are accepted or the accepted ones do not change any more
+		if ((int) Inside.size() == PreviousFound) ++Stable;
+		else                                     Stable = 0;
+		
+		if (Stable >= 1 and Candidates == (int) Inside.size()) break;
+		if (Stable >= 3) break;
+		
+		PreviousFound = Inside.size();
+	}
+	
+	if (Iteration > WindowMaxIterations) return 1;
+	
+	int Found = Inside.size();
+	
+	Eigenvalues->ReSize (Found);
+	Eigenvectors->ReSize (n, Found);
+	
+	for (j = 0; j < Found; j++) {
+		Eigenvalues->element (j) = Values.at(j);
+		
+		for (r = 0; r < n; r++)
+			Eigenvectors->element (r, j) = X[r + Inside.at(j)*n];
+	}
+	
+	return 0;
+} // of WindowEigensystem
+
+
+// ================================================================================
+
+
+void WindowSelection ( DiagonalMatrix* AllEigenvalues, Matrix* AllEigenvectors,
+                       double Lower, double Upper,
+                       DiagonalMatrix* Eigenvalues, Matrix* Eigenvectors )
+// copies the eigenpairs of a complete eigensystem with eigenvalues within [Lower, Upper]
+{
+	int n = AllEigenvalues->Nrows();
+	int State, Row, Found = 0;
+	vector<int> Inside;
+	
+	for (State = 0; State < n; State++)
+		if (AllEigenvalues->element (State) >= Lower and AllEigenvalues->element (State) <= Upper)
+			Inside.push_back (State);
+	
+	Eigenvalues->ReSize (Inside.size());
+	Eigenvectors->ReSize (n, Inside.size());
+	
+	for (Found = 0; Found < (int) Inside.size(); Found++) {
+		Eigenvalues->element (Found) = AllEigenvalues->element (Inside.at(Found));
+		
+		for (Row = 0; Row < n; Row++)
+			Eigenvectors->element (Row, Found) = AllEigenvectors->element (Row, Inside.at(Found));
+	}
+} // of WindowSelection
+
+
+// ================================================================================
@@ -0,0 +1,137 @@
+// #################################################################################################
+//
+//  Program:      superpose.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Superposition of two sets of atoms with the quaternion method
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <math.h>
+
+
+// The rotation that superimposes two centered sets of atoms with the least squared deviation is
+// given by the eigenvector of the largest eigenvalue of a symmetric 4x4 matrix built from their
+// 3x3 correlation matrix (B. K. P. Horn, J. Opt. Soc. Am. A 4, 629 (1987)). FitParameters passes
+// the correlation of the pseudo inverse of the parameter set atoms with the chromophore atoms,
+// which gives the same rotation as the two SVDs of RotationMatrix. Everything is kept in
+// fixed-size arrays on the stack, nothing is allocated.
+
+
+// ================================================================================
+
+
+static void Jacobi4 ( double A[4][4], double V[4][4] )
+// diagonalizes the symmetric 4x4 matrix A with Jacobi rotations, the eigenvalues are left on the
+// diagonal of A and the eigenvectors in the columns of V
+{
+	int    Sweep, p, q, k;
+	double Off, Theta, t, c, s, Apk, Aqk;
+	
+	for (p = 0; p < 4; p++)
+		for (q = 0; q < 4; q++)
+			V[p][q] = (p == q) ? 1.0 : 0.0;
+	
+	for (Sweep = 0; Sweep < 50; Sweep++) {
+		Off = 0.0;
+		
+		for (p = 0; p < 3; p++)
+			for (q = p + 1; q < 4; q++)
+				Off += A[p][q] * A[p][q];
+		
+		if (Off < 1e-30) return;
+		
+		for (p = 0; p < 3; p++) {
+			for (q = p + 1; q < 4; q++) {
+				if (A[p][q] == 0.0) continue;
+				
+				// the rotation that annihilates A[p][q]
+				Theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+				t = 1.0 / (fabs (Theta) + sqrt (Theta * Theta + 1.0));
+				if (Theta < 0.0) t = -t;
+				c = 1.0 / sqrt (t * t + 1.0);
+				s = t * c;
+				
+				for (k = 0; k < 4; k++) {      // columns p and q
+					Apk = A[k][p];
+					Aqk = A[k][q];
+					A[k][p] = c * Apk - s * Aqk;
+					A[k][q] = s * Apk + c * Aqk;
+				}
+				
+				for (k = 0; k < 4; k++) {      // rows p and q
+					Apk = A[p][k];
+					Aqk = A[q][k];
+					A[p][k] = c * Apk - s * Aqk;
+					A[q][k] = s * Apk + c * Aqk;
+				}
+				
+				for (k = 0; k < 4; k++) {      // the eigenvectors
+					Apk = V[k][p];
+					Aqk = V[k][q];
+					V[k][p] = c * Apk - s * Aqk;
+					V[k][q] = s * Apk + c * Aqk;
+				}
+			}
+		}
+	}
+} // of Jacobi4
+
+
+// ================================================================================
+
+
+void QuaternionRotation ( const double* Correlation, double* Rotation )
+// Calculates the proper rotation R (3x3, row-major) that maximizes trace(R * C) for the correlation
+// matrix C (3x3, row-major). For C[a][b] = sum From_a * To_b of two centered sets of atoms, R
+// turns From onto To (To = R * From) with the least squared deviation. R is also the rotation of
+// the polar decomposition of C^T (U * V^T of its SVD, if its determinant is positive).
+{
+	double N[4][4], V[4][4];
+	double q0, q1, q2, q3;
+	int    a, Largest;
+	const double* S = Correlation;
+	
+	N[0][0] =  S[0] + S[4] + S[8];
+	N[1][1] =  S[0] - S[4] - S[8];
+	N[2][2] = -S[0] + S[4] - S[8];
+	N[3][3] = -S[0] - S[4] + S[8];
+	N[0][1] = N[1][0] = S[5] - S[7];
+	N[0][2] = N[2][0] = S[6] - S[2];
+	N[0][3] = N[3][0] = S[1] - S[3];
+	N[1][2] = N[2][1] = S[1] + S[3];
+	N[1][3] = N[3][1] = S[6] + S[2];
+	N[2][3] = N[3][2] = S[5] + S[7];
+	
+	Jacobi4 (N, V);
+	
+	// the quaternion is the eigenvector of the largest eigenvalue
+	Largest = 0;
+	for (a = 1; a < 4; a++)
+		if (N[a][a] > N[Largest][Largest]) Largest = a;
+	
+	q0 = V[0][Largest];
+	q1 = V[1][Largest];
+	q2 = V[2][Largest];
+	q3 = V[3][Largest];
+	
+	Rotation[0] = q0*q0 + q1*q1 - q2*q2 - q3*q3;
+	Rotation[1] = 2.0 * (q1*q2 - q0*q3);
+	Rotation[2] = 2.0 * (q1*q3 + q0*q2);
+	Rotation[3] = 2.0 * (q1*q2 + q0*q3);
+	Rotation[4] = q0*q0 - q1*q1 + q2*q2 - q3*q3;
+	Rotation[5] = 2.0 * (q2*q3 - q0*q1);
+	Rotation[6] = 2.0 * (q1*q3 - q0*q2);
+	Rotation[7] = 2.0 * (q2*q3 + q0*q1);
+	Rotation[8] = q0*q0 - q1*q1 - q2*q2 + q3*q3;
+} // of QuaternionRotation
+
+
+// ================================================================================
@@ -0,0 +1,511 @@
+// #################################################################################################
+//
+//  Program:      symmetry.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Systems of identical repeat units (rings, helices, fibrils, --repeats): the
+//                couplings of one unit, the Hamiltonian assembled from them and, for a ring, its
+//                diagonalization in blocks of the wave vectors (FFT of NewMat)
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+// The groups are divided into DC_Options.Repeats consecutive units with the same chromophores in
+// the same order, i.e. each unit has the same m transitions and unit a covers the rows a*m to
+// a*m+m-1 of the Hamiltonian. If one symmetry operation (a rotation, possibly combined with a
+// translation along its axis) turns each unit into the next one, the couplings of two different
+// groups only depend on b-a for the units a and b.
+//
+// If the operation also turns the last unit into the first one (a closed ring, cyclic symmetry),
+// all units are equivalent and the blocks H(a,b) = C(b-a) form a block-circulant matrix: only the
+// couplings of the central unit with itself and the following half of the units are calculated
+// (HamiltonianMatrix), the remaining blocks are copies.
+//
+// An open helix or fibril has ends. The couplings of the first unit with all other units give all
+// blocks H(b,a) = H(b-a,0) between different units (a block-Toeplitz matrix, RepeatToeplitz), but
+// the blocks of each unit with itself contain the ground-state potential of all other groups and
+// are calculated for every unit. This matrix is diagonalized as a whole. It belongs to the
+// symmetrized structure: the deviations of the units within the tolerance (e.g. the rounding of
+// the coordinates to three decimals) are neglected, which shifts the spectrum slightly from that of
+// the full calculation. Only with --periodic the last unit is coupled to the first one as if the
+// system continued periodically (Born-von Karman boundary conditions) and the matrix of the central
+// unit is treated like that of a ring, which approximates a long helix without end effects (e.g.
+// without the helix band).
+//
+// Such a block-circulant matrix with the blocks C(d) = H(a,a+d) is block-diagonalized by a
+// Fourier transform over d. For the wave vector k (theta = 2 pi k / n), the vectors
+//
+//    sqrt(2/n) ( cos(theta a) v + sin(theta a) w )     (v, w: the m transitions of each unit a)
+//
+// span an invariant subspace, in which the Hamiltonian is the real symmetric 2m x 2m matrix
+//
+//    |  A   B |     with  A = sum_d C(d) cos(theta d)  and  B = sum_d C(d) sin(theta d),
+//    | -B   A |
+//
+// whose eigenvalues come in degenerate pairs (k and n-k). For k = 0 and k = n/2 only the m x m
+// block A is left (with 1/sqrt(n) and the signs (-1)^a). The n/2+1 small blocks are diagonalized
+// independently with the selected eigensolver, their eigenvectors are turned into those of the
+// complete matrix, so that everything after the diagonalization is unchanged.
+
+
+// the largest deviation of the atoms of a unit from those of the previous unit turned by the
+// symmetry operation, in units of the last decimal place of the input coordinates (rounding both
+// atoms moves them apart by up to sqrt(3) of it, the fit of the parameter sets a little more)
+static const double RepeatTolerance = 5.0;
+
+// elements of the Hamiltonian that differ by more than this fraction of the largest one from the
+// block-circulant pattern (e.g. with disorder) prevent the diagonalization in blocks
+static const double CirculantTolerance = 1.0E-12;
+
+
+class RepeatBlocks : public ParallelTask {   // the blocks of the wave vectors, one part per block
+	public:
+		string                  Method;      // the eigensolver
+		vector<SymmetricMatrix> Block;       // the Hamiltonian of each wave vector
+		vector<DiagonalMatrix>  Values;      // its eigenvalues
+		vector<Matrix>          Vectors;     // and eigenvectors
+		vector<int>             Failed;      // the return value of the eigensolver
+		
+		void Run ( int k );
+};
+
+
+static void   UnitAtoms ( Dichro* DC, int Unit, vector<double>* Coords );
+static double CoordinatePrecision ( vector<double>* XYZ );
+static double RepeatCoupling ( Matrix* Stripe, int Repeats, int d, int i, int j );
+
+
+// ================================================================================
+
+
+int Dichro::RepeatSymmetry ( int* Central, bool* Periodic )
+// checks that the groups consist of DC_Options.Repeats identical units related by one symmetry
+// operation and returns the central unit and whether the matrix is assembled from its couplings
+// as a block-circulant one (a closed ring or --periodic)
+{
+	int Repeats        = DC_Options.Repeats;
+	int NumberOfGroups = DC_System.NumberOfGroups;
+	int Group, Unit, Atom, a, b;
+	
+	if (DC_Options.Window) {
+		cerr << "\nERROR: The repeat units (--repeats) cannot be used in window mode.\n\n";
+		DC_Error = "Repeat units in window mode";
+		DC_ErrorCode = 200;
+		return 200;
+	}
+	
+	if (Repeats < 2 or NumberOfGroups % Repeats != 0) {
+		cerr << "\nERROR: The " << NumberOfGroups << " groups cannot be divided into " << Repeats
+		     << " repeat units.\n\n";
+		DC_Error = "Invalid repeat units";
+		DC_ErrorCode = 200;
+		return 200;
+	}
+	
+	int UnitGroups = NumberOfGroups / Repeats;
+	
+	for (Group = UnitGroups; Group < NumberOfGroups; Group++) {
+		SystemGroup* CurGroup = &DC_System.Groups.at(Group);
+		SystemGroup* First    = &DC_System.Groups.at(Group % UnitGroups);
+		
+		if (CurGroup->ParameterSet != First->ParameterSet or
+		    CurGroup->NumberOfTransitions != First->NumberOfTransitions or
+		    CurGroup->Atoms.size() != First->Atoms.size()) {
+			cerr << "\nERROR: Group " << Group << " (" << CurGroup->ParameterSet << ") differs from group "
+			     << Group % UnitGroups << " (" << First->ParameterSet << ") of the first repeat unit.\n\n";
+			DC_Error = "Invalid repeat units";
+			DC_ErrorCode = 200;
+			return 200;
+		}
+	}
+	
+	// the symmetry operation superimposes each unit on the next one, To = R From + t, fitted to
+	// all pairs of consecutive units at once (least squares), so that the rounding errors of the
+	// coordinates average out instead of growing with the distance from one pair
+	*Central = (Repeats - 1) / 2;
+	
+	vector<double> From, To, Coords;
+	double Correlation[9], Rotation[9], Translation[3];
+	double FromCenter[3] = {0.0, 0.0, 0.0}, ToCenter[3] = {0.0, 0.0, 0.0};
+	
+	for (Unit = 0; Unit < Repeats; Unit++) {
+		UnitAtoms (this, Unit, &Coords);
+		
+		if (Unit < Repeats - 1) From.insert (From.end(), Coords.begin(), Coords.end());
+		if (Unit > 0)           To.insert (To.end(), Coords.begin(), Coords.end());
+	}
+	
+	int Atoms = From.size() / 3;
+	
+	for (Atom = 0; Atom < Atoms; Atom++) {
+		for (a = 0; a < 3; a++) {
+			FromCenter[a] += From.at(3*Atom + a) / Atoms;
+			ToCenter[a]   += To.at(3*Atom + a) / Atoms;
+		}
+	}
+	
+	for (a = 0; a < 3; a++) {
+		for (b = 0; b < 3; b++) {
+			Correlation[3*a + b] = 0.0;
+			
+			for (Atom = 0; Atom < Atoms; Atom++)
+				Correlation[3*a + b] += (From.at(3*Atom + a) - FromCenter[a])
+				                      * (To.at(3*Atom + b) - ToCenter[b]);
+		}
+	}
+	
+	QuaternionRotation (Correlation, Rotation);
+	
+	for (a = 0; a < 3; a++) {
+		Translation[a] = ToCenter[a];
+		
+		for (b = 0; b < 3; b++) Translation[a] -= Rotation[3*a + b] * FromCenter[b];
+	}
+	
+	// the operation has to turn every unit into the next one, the last one into the first one
+	// only for a closed ring
+	double Tolerance = RepeatTolerance * CoordinatePrecision (&DC_Input.Coordinates.XYZ);
+	double MaxDeviation = 0.0, Closure = 0.0;
+	
+	Atoms = Coords.size() / 3;
+	
+	for (Unit = 0; Unit < Repeats; Unit++) {
+		double Deviation = 0.0;
+		
+		UnitAtoms (this, Unit, &From);
+		UnitAtoms (this, (Unit + 1) % Repeats, &To);
+		
+		for (Atom = 0; Atom < Atoms; Atom++) {
+			double Distance = 0.0;
+			
+			for (a = 0; a < 3; a++) {
+				double Turned = Translation[a];
+				
+				for (b = 0; b < 3; b++) Turned += Rotation[3*a + b] * From.at(3*Atom + b);
+				
+				Distance += pow (Turned - To.at(3*Atom + a), 2);
+			}
+			
+			Deviation = max (Deviation, sqrt (Distance));
+		}
+		
+		if (Unit == Repeats - 1) {
+			Closure = Deviation;
+		}
+		else if (Deviation > Tolerance) {
+			cerr << "\nERROR: The repeat units " << Unit << " and " << Unit + 1 << " are not related by"
+			     << " the symmetry operation of all units (deviation " << Deviation << " Angstrom, "
+			     << Tolerance << " Angstrom allowed).\n\n";
+			DC_Error = "No symmetry of the repeat units";
+			DC_ErrorCode = 201;
+			return 201;
+		}
+		else {
+			MaxDeviation = max (MaxDeviation, Deviation);
+		}
+	}
+	
+	bool Closed = (Closure <= Tolerance);
+	
+	*Periodic = Closed or DC_Options.Periodic;
+	
+	if ( not Closed and DC_Options.Periodic )
+		Warnings.push_back ("--periodic: open repeat units with periodic boundary conditions, "
+		                    "the end effects are missing");
+	
+	if (DC_Verbose) {
+		// the angle and the axis of the rotation, the rise is the translation along the axis
+		double Trace = Rotation[0] + Rotation[4] + Rotation[8];
+		double Angle = acos (max (-1.0, min (1.0, 0.5 * (Trace - 1.0))));
+		double Axis[3] = { Rotation[7] - Rotation[5], Rotation[2] - Rotation[6], Rotation[3] - Rotation[1] };
+		double Norm = sqrt (Axis[0]*Axis[0] + Axis[1]*Axis[1] + Axis[2]*Axis[2]);
+		double Rise = 0.0;
+		
+		for (a = 0; a < 3; a++) {
+			if (Norm > 1.0E-8) Rise += Translation[a] * Axis[a] / Norm;
+			else               Rise += Translation[a] * Translation[a];
+		}
+		
+		if (Norm <= 1.0E-8) Rise = sqrt (Rise);
+		
+		printf ("   %d repeat units of %d group(s), central unit %d\n", Repeats, UnitGroups, *Central);
+		printf ("      Rotation %.2f degrees, rise %.3f Angstrom (max. deviation %.2g of %.2g Angstrom)\n",
+		        Angle * 180.0 / M_PI, fabs (Rise), MaxDeviation, Tolerance);
+		
+		if (Closed)
+			printf ("      Closed ring\n");
+		else if (*Periodic)
+			printf ("      Open (deviation %.3f Angstrom), periodic boundary conditions\n", Closure);
+		else
+			printf ("      Open (deviation %.3f Angstrom), couplings of the first unit\n", Closure);
+	}
+	
+	return 0;
+} // of Dichro::RepeatSymmetry
+
+
+// ================================================================================
+
+
+static void UnitAtoms ( Dichro* DC, int Unit, vector<double>* Coords )
+// the coordinates of the atoms of all groups of a repeat unit, x, y, z one atom after another
+{
+	int UnitGroups = DC->DC_System.NumberOfGroups / DC->DC_Options.Repeats;
+	int Group;
+	unsigned int Atom;
+	
+	Coords->clear();
+	
+	for (Group = Unit * UnitGroups; Group < (Unit + 1) * UnitGroups; Group++) {
+		vector< vector<double> >* Atoms = &DC->DC_System.Groups.at(Group).Atoms;
+		
+		for (Atom = 0; Atom < Atoms->size(); Atom++)
+			Coords->insert (Coords->end(), Atoms->at(Atom).begin(), Atoms->at(Atom).begin() + 3);
+	}
+} // of UnitAtoms
+
+
+// ================================================================================
+
+
+static double CoordinatePrecision ( vector<double>* XYZ )
+// the last decimal place of the input coordinates, i.e. 0.001 Angstrom for the three decimals of
+// the input files (at most six decimals are distinguished)
+{
+	int Decimals;
+	unsigned int i;
+	double Scale = 1.0;
+	
+	for (Decimals = 0; Decimals < 6; Decimals++, Scale *= 10.0) {
+		for (i = 0; i < XYZ->size(); i++)
+			if (fabs (XYZ->at(i) * Scale - floor (XYZ->at(i) * Scale + 0.5)) > 1.0E-3) break;
+		
+		if (i == XYZ->size()) break;
+	}
+	
+	return 1.0 / Scale;
+} // of CoordinatePrecision
+
+
+// ================================================================================
+
+
+void Dichro::RepeatHamiltonian ( Matrix* Stripe, SymmetricMatrix* Hamiltonian )
+// fills the lower triangle of the Hamiltonian with the couplings of the central unit: the rows
+// of Stripe are the transitions of the central unit and the following Repeats/2 units, the
+// columns those of the central unit (the block of the central unit itself only its lower triangle)
+{
+	int Repeats = DC_Options.Repeats;
+	int Unit    = Stripe->Ncols();
+	int Row, Col;
+	
+	for (Row = 0; Row < Hamiltonian->Nrows(); Row++)
+		for (Col = 0; Col <= Row; Col++)
+			Hamiltonian->element (Row, Col) = RepeatCoupling (Stripe, Repeats,
+			                                  (Col / Unit - Row / Unit + Repeats) % Repeats,
+			                                  Row % Unit, Col % Unit);
+} // of Dichro::RepeatHamiltonian
+
+
+// ================================================================================
+
+
+void Dichro::RepeatToeplitz ( SymmetricMatrix* Hamiltonian )
+// fills the blocks of an open system that were not calculated, the couplings of the unit b with
+// the unit a (0 < a < b) are those of the unit b-a with the first one, H(b,a) = H(b-a,0), the
+// blocks of the first unit with all others and of each unit with itself are already there
+{
+	int N    = Hamiltonian->Nrows();
+	int Unit = N / DC_Options.Repeats;
+	int Row, Col, Shift;
+	Real* Packed = Hamiltonian->Store();
+	
+	for (Row = 2 * Unit; Row < N; Row++) {
+		for (Col = Unit; Col < (Row / Unit) * Unit; Col++) {
+			Shift = (Col / Unit) * Unit;
+			Packed[Row*(Row+1)/2 + Col] = Packed[(Row - Shift)*(Row - Shift + 1)/2 + Col - Shift];
+		}
+	}
+} // of Dichro::RepeatToeplitz
+
+
+// ================================================================================
+
+
+static double RepeatCoupling ( Matrix* Stripe, int Repeats, int d, int i, int j )
+// the element (i,j) of the coupling block C(d) of a unit with the unit d further on in the
+// ring (or the periodic system), C(-d) is the transposed C(d), and for an even number of units the unit half
+// way round is reached from both sides (the average of both, which is the same for a ring)
+{
+	int Unit = Stripe->Ncols();
+	
+	if (2*d > Repeats) {
+		d = Repeats - d;
+		swap (i, j);
+	}
+	
+	if (d == 0) return Stripe->element (max (i, j), min (i, j));
+	
+	if (2*d == Repeats)
+		return 0.5 * (Stripe->element (d*Unit + j, i) + Stripe->element (d*Unit + i, j));
+	
+	return Stripe->element (d*Unit + j, i);
+} // of RepeatCoupling
+
+
+// ================================================================================
+
+
+int Dichro::RepeatEigensystem ( SymmetricMatrix* Hamiltonian, DiagonalMatrix* Eigenvalues,
+                                Matrix* Eigenvectors )
+// diagonalizes a block-circulant Hamiltonian in the blocks of the wave vectors, returns 1 if
+// the matrix is not block-circulant (then it has to be diagonalized as a whole)
+{
+	int n = DC_Options.Repeats;
+	int N = Hamiltonian->Nrows();
+	int Row, Col, i, j, d, k, a;
+	
+	if (n < 2 or N == 0 or N % n != 0) return 1;
+	
+	int m = N / n;
+	Real* Packed = Hamiltonian->Store();
+	
+	// the blocks C(d) = H(0,d) of the first unit, C[(d*m + i)*m + j]
+	vector<double> C (n * m * m);
+	double Largest = 0.0;
+	
+	for (i = 0; i < m; i++) {
+		for (Col = 0; Col < N; Col++) {
+			double Element = (Col <= i) ? Packed[i*(i+1)/2 + Col] : Packed[Col*(Col+1)/2 + i];
+			
+			C[((Col / m) * m + i) * m + Col % m] = Element;
+			Largest = max (Largest, fabs (Element));
+		}
+	}
+	
+	// all other blocks have to be copies, H(a,b) = C(b-a)
+	for (Row = m; Row < N; Row++) {
+		for (Col = 0; Col <= Row; Col++) {
+			d = (Col / m - Row / m + n) % n;
+			
+			if (fabs (Packed[Row*(Row+1)/2 + Col] - C[(d*m + Row % m)*m + Col % m])
+			    > CirculantTolerance * Largest) return 1;
+		}
+	}
+	
+	// the Fourier transform of each element over d, X + iY = sum_d C(d) exp(-2 pi i k d / n),
+	// gives A = X and B = -Y
+	int Blocks = n / 2 + 1;
+	vector<double> A (Blocks * m * m), B (Blocks * m * m);
+	ColumnVector U (n), V (n), X (n), Y (n);
+	
+	V = 0.0;
+	
+	for (i = 0; i < m; i++) {
+		for (j = 0; j < m; j++) {
+			for (d = 0; d < n; d++) U(d+1) = C[(d*m + i)*m + j];
+			
+			FFT (U, V, X, Y);
+			
+			for (k = 0; k < Blocks; k++) {
+				A[(k*m + i)*m + j] =  X(k+1);
+				B[(k*m + i)*m + j] = -Y(k+1);
+			}
+		}
+	}
+	
+	RepeatBlocks Task;
+	Task.Method = DC_Options.Eigensolver;
+	Task.Block.resize (Blocks);
+	Task.Values.resize (Blocks);
+	Task.Vectors.resize (Blocks);
+	Task.Failed.assign (Blocks, 0);
+	
+	for (k = 0; k < Blocks; k++) {
+		bool Single = (k == 0 or 2*k == n);   // only the block A
+		SymmetricMatrix* Block = &Task.Block.at(k);
+		
+		Block->ReSize (Single ? m : 2*m);
+		
+		for (i = 0; i < m; i++) {
+			for (j = 0; j <= i; j++) {
+				Block->element (i, j) = A[(k*m + i)*m + j];
+				if ( not Single ) Block->element (m + i, m + j) = A[(k*m + i)*m + j];
+			}
+			
+			if ( not Single )
+				for (j = 0; j < m; j++) Block->element (m + i, j) = -B[(k*m + i)*m + j];
+		}
+	}
+	
+	int Threads = RunParallel (&Task, Blocks, DC_Options.Threads);
+	
+	for (k = 0; k < Blocks; k++)
+		if (Task.Failed.at(k) != 0) return Task.Failed.at(k);
+	
+	if (DC_Verbose)
+		printf ("      %d repeat units: %d blocks of up to %d states (FFT), %d thread(s)\n",
+		        n, Blocks, (n > 2) ? 2*m : m, Threads);
+	
+	// all eigenvalues in ascending order, ties in the order of the wave vectors
+	vector< pair<double, int> > Order;
+	
+	for (k = 0; k < Blocks; k++)
+		for (i = 0; i < Task.Values.at(k).Nrows(); i++)
+			Order.push_back (make_pair ((double) Task.Values.at(k).element(i), k * 2*m + i));
+	
+	stable_sort (Order.begin(), Order.end());
+	
+	Eigenvalues->ReSize (N);
+	Eigenvectors->ReSize (N, N);
+	
+	Real* Out = Eigenvectors->Store();
+	vector<double> Cosine (n), Sine (n);
+	
+	for (Col = 0; Col < N; Col++) {
+		k = Order.at(Col).second / (2*m);
+		i = Order.at(Col).second % (2*m);
+		
+		Matrix* Vectors = &Task.Vectors.at(k);
+		Eigenvalues->element(Col) = Order.at(Col).first;
+		
+		if (k == 0 or 2*k == n) {
+			for (a = 0; a < n; a++)
+				for (j = 0; j < m; j++)
+					Out[(a*m + j)*N + Col] = ((k == 0 or a % 2 == 0) ? 1.0 : -1.0)
+					                       * Vectors->element (j, i) / sqrt ((double) n);
+			continue;
+		}
+		
+		for (a = 0; a < n; a++) {
+			Cosine.at(a) = sqrt (2.0 / n) * cos (2.0 * M_PI * k * a / n);
+			Sine.at(a)   = sqrt (2.0 / n) * sin (2.0 * M_PI * k * a / n);
+		}
+		
+		for (a = 0; a < n; a++)
+			for (j = 0; j < m; j++)
+				Out[(a*m + j)*N + Col] = Cosine.at(a) * Vectors->element (j, i)
+				                       + Sine.at(a)   * Vectors->element (m + j, i);
+	}
+	
+	return 0;
+} // of Dichro::RepeatEigensystem
+
+
+// ================================================================================
+
+
+void RepeatBlocks::Run ( int k )
+{
+	Failed.at(k) = SymmetricEigensystem (Method, &Block.at(k), &Values.at(k), &Vectors.at(k));
+} // of RepeatBlocks::Run
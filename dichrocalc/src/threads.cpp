@@ -0,0 +1,125 @@
+// #################################################################################################
+//
+//  Program:      threads.cpp
+//
+//  Function:     Part of DichroCalc:
+//                A minimal pool of POSIX threads to process independent parts of a calculation
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+
+// The parts of a task are handed out one by one from a shared counter, i.e. a thread that is
+// done with a cheap part simply takes the next one. Which thread processes which part differs
+// from run to run, the parts themselves therefore must not depend on each other and must write
+// their results to separate places. Then the result is identical for any number of threads.
+
+class ThreadPool {
+	public:
+		ParallelTask*   Task;      // the job to run
+		int             Parts;     // the total number of parts
+		int             Next;      // the next part to be processed
+		pthread_mutex_t Lock;      // protects Next
+};
+
+
+// ================================================================================
+
+
+static void* ThreadWorker ( void* Argument )
+// processes parts of the task until none are left
+{
+	ThreadPool* Pool = (ThreadPool*) Argument;
+	int Part;
+	
+	while (true) {
+		pthread_mutex_lock (&Pool->Lock);
+		Part = Pool->Next++;
+		pthread_mutex_unlock (&Pool->Lock);
+		
+		if (Part >= Pool->Parts) break;
+		
+		Pool->Task->Run (Part);
+	}
+	
+	return NULL;
+} // of ThreadWorker
+
+
+// ================================================================================
+
+
+int AvailableThreads ( void )
+// returns the number of processors which are online
+{
+	long Processors = sysconf (_SC_NPROCESSORS_ONLN);
+	
+	if (Processors < 1) return 1;
+	return (int) Processors;
+} // of AvailableThreads
+
+
+// ================================================================================
+
+
+int NumberOfThreads ( int Requested, int Parts )
+// the number of threads actually used: 0 (or less) requests one thread per processor, more
+// threads than parts are never started
+{
+	int Threads = Requested;
+	
+	if (Threads < 1)     Threads = AvailableThreads ();
+	if (Threads > Parts) Threads = Parts;
+	if (Threads < 1)     Threads = 1;
+	
+	return Threads;
+} // of NumberOfThreads
+
+
+// ================================================================================
+
+
+int RunParallel ( ParallelTask* Task, int Parts, int Threads )
+// runs Task->Run (0 ... Parts-1) on the given number of threads (0 = all processors) and
+// returns after all parts have been processed
+{
+	int i, Started;
+	ThreadPool Pool;
+	
+	Threads = NumberOfThreads (Threads, Parts);
+	
+	Pool.Task  = Task;
+	Pool.Parts = Parts;
+	Pool.Next  = 0;
+	pthread_mutex_init (&Pool.Lock, NULL);
+	
+	// the calling thread is the first worker, no thread is created for a single one
+	vector<pthread_t> Workers (Threads);
+	Started = 0;
+	
+	for (i = 1; i < Threads; i++) {
+		if (pthread_create (&Workers.at(Started), NULL, ThreadWorker, &Pool) != 0) break;
+		++Started;
+	}
+	
+	ThreadWorker (&Pool);
+	
+	for (i = 0; i < Started; i++)
+		pthread_join (Workers.at(i), NULL);
+	
+	pthread_mutex_destroy (&Pool.Lock);
+	
+	return Started + 1;
+} // of RunParallel
+
+
+// ================================================================================
@@ -0,0 +1,664 @@
+// #################################################################################################
+//
+//  Program:      trajectory.cpp
+//
+//  Function:     Part of DichroCalc:
+//                Calculation of the spectra of many frames (e.g. of an MD trajectory) of the
+//                same system
+//
+//  Version:      $Revision$, $Date$
+//
+//  Date:         October 2026
+//
+// #################################################################################################
+
+
+#include "../include/dichrocalc.h"
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <climits>
+
+
+// The topology (the $CONFIGURATION, $PARAMETERS and $CHROMOPHORES blocks of the input file and
+// the parameter sets) is read once. The frames are read one after another from a file with a
+// series of $COORDINATES blocks, from a directory of .inp files, of which only the
+// $COORDINATES blocks are used, from a PDB file with several models or from a DCD file
+// (CHARMM, NAMD, X-PLOR). Only one frame is held in memory at a time and the frames skipped by
+// DC_Options.Stride, FirstFrame and LastFrame are not parsed (DCD frames are not even read).
+// Each thread calculates frames on its own copy of the object, which is reused for all of its
+// frames.
+//
+// The atoms of a PDB model or DCD frame are those of the input file in the same sequence. If the
+// input file is a PDB itself, it can be the first model of the trajectory: DC_FrameAtoms then
+// holds the position of each atom among the ATOM and HETATM lines (pdbinput.cpp), i.e. among
+// the atoms of the DCD frames.
+
+class DcdLayout { // the layout of a DCD file, the frames all have the same size
+	public:
+		bool  Swap;          // written with the other byte order
+		bool  UnitCell;      // CHARMM: each frame starts with the unit cell (6 doubles)
+		bool  FourDims;      // CHARMM: each frame has a fourth coordinate
+		int   Atoms;         // the number of atoms
+		off_t Start;         // the offset of the first frame
+		off_t Size;          // the size of a frame in bytes
+		int   Frames;        // the number of frames in the file
+		int   Next;          // the next frame to read
+};
+
+class TrajectoryFrames : public ParallelTask { // the frames, one part per thread
+	public:
+		Dichro*         DC;           // the object with the topology
+		string          BaseName;     // the output files are BaseName.frame.cdl etc.
+		vector<string>  Files;        // the files with the frames
+		unsigned int    File;         // the next file to open
+		string          FileName;     // the file being read
+		ifstream        Stream;       // the stream of the file being read (text)
+		FILE*           Binary;       // the DCD file being read, NULL if none
+		int             Format;       // of the file being read (FrameFormat)
+		DcdLayout       Dcd;          // the layout of the DCD file being read
+		vector<double>  Coord;        // x, y, z of all atoms of the current PDB model or DCD frame
+		vector<float>   Buffer;       // one coordinate of all atoms of a DCD frame
+		int             Threads;      // the number of threads calculating frames
+		int             NextFrame;    // the index of the next frame in the trajectory
+		int             Processed;    // the number of frames calculated
+		int             ErrorFrame;   // the frame which failed (-1 = none)
+		int             WarmStarts;   // the frames diagonalized with a warm start (-e warm)
+		int             SavedSweeps;  // the Jacobi sweeps saved by the warm starts
+		pthread_mutex_t Lock;         // protects the frame files, counters, and DC
+		
+		void Run ( int Part );
+		int  ReadFrame ( Dichro* Worker );
+	
+	private:
+		enum FrameFormat { CoordinatesFile, PdbFile, DcdFile };
+		
+		int  Wanted ( int Frame );
+		int  OpenFile ( void );
+		void CloseFile ( void );
+		int  NextBlock ( Dichro* Worker, bool Read );
+		int  NextModel ( bool Read );
+		int  ReadDcdHeader ( void );
+		int  ReadDcdFrame ( void );
+		int  CopyFrame ( Dichro* Worker );
+		int  Fail ( int Code, string Error, string Message );
+};
+
+
+static bool StartsWith ( const string& Line, const char* Start )
+{
+	return Line.compare (0, strlen (Start), Start) == 0;
+}
+
+
+static int32_t SwapBytes ( int32_t Value )
+{
+	uint32_t Bytes = (uint32_t) Value;
+	
+	return (int32_t) ( (Bytes >> 24) | ((Bytes >> 8) & 0xff00) | ((Bytes << 8) & 0xff0000) | (Bytes << 24) );
+}
+
+
+static bool ReadInt ( FILE* File, bool Swap, int32_t* Value )
+{
+	if (fread (Value, sizeof (int32_t), 1, File) != 1) return false;
+	
+	if (Swap) *Value = SwapBytes (*Value);
+	
+	return true;
+}
+
+
+// ================================================================================
+
+
+int Dichro::TrajectoryCalculation ( void )
+// calculates the spectra of all frames in DC_Options.Frames
+{
+	TrajectoryFrames Frames;
+	struct stat Status;
+	string Path = DC_Options.Frames;
+	unsigned int File;
+	
+	if (DC_Verbose) Dichro::NewTask ( "Trajectory" );
+	
+	if (DC_Options.Stride < 1 or DC_Options.FirstFrame < 0 or
+	    (DC_Options.LastFrame >= 0 and DC_Options.LastFrame < DC_Options.FirstFrame)) {
+		cerr << "\nERROR: Invalid frame selection (stride " << DC_Options.Stride << ", frames "
+		     << DC_Options.FirstFrame << " to " << DC_Options.LastFrame << ").\n\n";
+		DC_Error = "Invalid frame selection";
+		DC_ErrorCode = 162;
+		return 162;
+	}
+	
+	// the average is taken of the band spectra, Gaussian bands if none are given
+	if (DC_Options.Average and DC_Options.Bandshape.size() == 0) DC_Options.Bandshape = "gauss";
+	
+	DC_Average = SpectrumAverage ();
+	
+	if (stat (Path.c_str(), &Status) == 0 and S_ISDIR (Status.st_mode)) {
+		ReadDir (Path, ".inp", &Frames.Files);
+		sort (Frames.Files.begin(), Frames.Files.end());
+		
+		for (File = 0; File < Frames.Files.size(); File++)
+			Frames.Files.at(File) = Path + "/" + Frames.Files.at(File);
+	}
+	else {
+		Frames.Files.push_back (Path);
+	}
+	
+	Frames.DC         = this;
+	Frames.BaseName   = DC_InFileBaseName;
+	Frames.File       = 0;
+	Frames.Binary     = NULL;
+	Frames.Threads    = NumberOfThreads (DC_Options.Threads, INT_MAX);  // frames are not counted
+	Frames.NextFrame  = 0;
+	Frames.Processed  = 0;
+	Frames.ErrorFrame = -1;
+	Frames.WarmStarts  = 0;
+	Frames.SavedSweeps = 0;
+	pthread_mutex_init (&Frames.Lock, NULL);
+	
+	if (DC_Verbose) {
+		printf ("   %d frame file(s), %d thread(s)\n", (int) Frames.Files.size(), Frames.Threads);
+		
+		if (DC_Options.Stride > 1 or DC_Options.FirstFrame > 0 or DC_Options.LastFrame >= 0)
+			printf ("   Frames %d to %s, every %d. frame\n", DC_Options.FirstFrame,
+			        (DC_Options.LastFrame < 0) ? "the end" : tostring (DC_Options.LastFrame).c_str(),
+			        DC_Options.Stride);
+	}
+	
+	RunParallel (&Frames, Frames.Threads, Frames.Threads);
+	
+	pthread_mutex_destroy (&Frames.Lock);
+	
+	if (Frames.ErrorFrame >= 0) {
+		cerr << "\nERROR: Calculation of frame " << Frames.ErrorFrame << " failed ("
+		     << DC_Error << "), " << Frames.Processed << " frames calculated before.\n\n";
+		return DC_ErrorCode;
+	}
+	
+	if (Frames.Processed == 0) {
+		cerr << "\nERROR: No frames found in " << Path << ".\n\n";
+		DC_Error = "No frames found";
+		DC_ErrorCode = 161;
+		return 161;
+	}
+	
+	if (DC_Verbose) printf ("   %d frames calculated\n", Frames.Processed);
+	
+	if (DC_Verbose and DC_Options.Eigensolver == "warm")
+		printf ("   %d frames with a warm start, %d Jacobi sweeps saved\n", Frames.WarmStarts,
+		        Frames.SavedSweeps);
+	
+	if (DC_Options.Average) return WriteAverage ();
+	
+	return 0;
+} // of Dichro::TrajectoryCalculation
+
+
+// ================================================================================
+
+
+void TrajectoryFrames::Run ( int Part )
+// calculates frames until none are left, the parameter sets are copied only once per thread
+{
+	int Frame;
+	
+	// DC is only read under the lock, another thread may already report an error
+	pthread_mutex_lock (&Lock);
+	Dichro* Worker = new Dichro (*DC);
+	pthread_mutex_unlock (&Lock);
+	
+	Worker->DC_Verbose = false;
+	
+	// the matrix of a frame is set up on a single thread if the frames run in parallel
+	if (Threads > 1) Worker->DC_Options.Threads = 1;
+	
+	while (true) {
+		pthread_mutex_lock (&Lock);
+		Frame = ReadFrame (Worker);
+		pthread_mutex_unlock (&Lock);
+		
+		if (Frame < 0) break;
+		
+		Worker->TrajectoryFrame (Frame, BaseName);
+		
+		pthread_mutex_lock (&Lock);
+		
+		if (Worker->DC_Error == "") {
+			++Processed;
+			
+			if (Worker->DC_Options.Eigensolver == "warm" and Worker->DC_WarmStart.Warm) {
+				++WarmStarts;
+				SavedSweeps += Worker->DC_WarmStart.ColdSweeps - Worker->DC_WarmStart.Sweeps;
+			}
+			
+			string Report = Worker->WarmStartReport ();
+			
+			if (Report.size() > 0) Report = ", " + Report;
+			
+			if (DC->DC_Verbose)
+				printf ("      Frame %5d: %d states%s\n", Frame, Worker->DC_Results.Eigenvalues.Nrows(),
+				        Report.c_str());
+		}
+		else if (ErrorFrame < 0) {
+			ErrorFrame = Frame;
+			DC->DC_Error     = Worker->DC_Error;
+			DC->DC_ErrorCode = Worker->DC_ErrorCode;
+		}
+		
+		pthread_mutex_unlock (&Lock);
+	}
+	
+	// the averages of the threads are combined, the order does not matter (up to rounding)
+	pthread_mutex_lock (&Lock);
+	DC->DC_Average.Merge (&Worker->DC_Average);
+	pthread_mutex_unlock (&Lock);
+	
+	delete Worker;
+} // of TrajectoryFrames::Run
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::ReadFrame ( Dichro* Worker )
+// reads the next frame selected into the DC_Input of the worker and returns its index in the
+// trajectory, -1 if there are no frames left (or a frame has failed), must be called with Lock held
+{
+	int Found, Next;
+	
+	while (ErrorFrame < 0) {
+		Next = Wanted (NextFrame);
+		
+		if (Next < 0) break;
+		
+		if ( not Stream.is_open() and Binary == NULL ) {
+			if (File >= Files.size()) break;
+			
+			if (OpenFile () != 0) break;
+		}
+		
+		if (Format == DcdFile) {
+			// the frames before the next one selected are skipped without reading them
+			if (Dcd.Next + Next - NextFrame >= Dcd.Frames) {
+				NextFrame += Dcd.Frames - Dcd.Next;
+				CloseFile ();
+				continue;
+			}
+			
+			Dcd.Next += Next - NextFrame;
+			NextFrame = Next;
+			Found = ReadDcdFrame ();
+		}
+		else if (Format == PdbFile) {
+			Found = NextModel (Next == NextFrame);
+		}
+		else {
+			Found = NextBlock (Worker, Next == NextFrame);
+		}
+		
+		if (Found < 0) break;
+		
+		if (Found == 0) {
+			CloseFile ();
+			continue;
+		}
+		
+		if (Next != NextFrame) {
+			++NextFrame;
+			continue;
+		}
+		
+		if (Format != CoordinatesFile and CopyFrame (Worker) != 0) break;
+		
+		Worker->DC_InFile = FileName;
+		
+		return NextFrame++;
+	}
+	
+	CloseFile ();
+	
+	return -1;
+} // of TrajectoryFrames::ReadFrame
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::Wanted ( int Frame )
+// the index of the first frame selected from Frame on, -1 if there are none
+{
+	Dichro::CalculationOptions* Options = &DC->DC_Options;
+	
+	if (Frame < Options->FirstFrame) {
+		Frame = Options->FirstFrame;
+	}
+	else if ((Frame - Options->FirstFrame) % Options->Stride != 0) {
+		Frame += Options->Stride - (Frame - Options->FirstFrame) % Options->Stride;
+	}
+	
+	if (Options->LastFrame >= 0 and Frame > Options->LastFrame) return -1;
+	
+	return Frame;
+} // of TrajectoryFrames::Wanted
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::OpenFile ( void )
+// opens the next file, the format is taken from the extension (.pdb, .dcd, otherwise text
+// with $COORDINATES blocks)
+{
+	FileName = Files.at(File++);
+	
+	if (FileExtension (FileName, ".dcd")) {
+		Format = DcdFile;
+		Binary = fopen (FileName.c_str(), "rb");
+		
+		if (Binary == NULL)
+			return Fail (160, "Unable to open frame file", "Could not open frame file " + FileName + ".");
+		
+		return ReadDcdHeader ();
+	}
+	
+	Format = FileExtension (FileName, ".pdb") ? PdbFile : CoordinatesFile;
+	
+	Stream.clear();
+	Stream.open (FileName.c_str(), ios::in);
+	
+	if ( not Stream )
+		return Fail (160, "Unable to open frame file", "Could not open frame file " + FileName + ".");
+	
+	return 0;
+} // of TrajectoryFrames::OpenFile
+
+
+// ================================================================================
+
+
+void TrajectoryFrames::CloseFile ( void )
+{
+	if (Stream.is_open()) Stream.close();
+	
+	if (Binary != NULL) {
+		fclose (Binary);
+		Binary = NULL;
+	}
+} // of TrajectoryFrames::CloseFile
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::Fail ( int Code, string Error, string Message )
+// reports an error of the frame being read
+{
+	cerr << "\nERROR: " << Message << "\n\n";
+	ErrorFrame       = NextFrame;
+	DC->DC_Error     = Error;
+	DC->DC_ErrorCode = Code;
+	return Code;
+} // of TrajectoryFrames::Fail
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::NextBlock ( Dichro* Worker, bool Read )
+// finds the next $COORDINATES block and reads it into the DC_Input of the worker if Read is
+// true, returns 1 if a block was found, 0 at the end of the file, and -1 on errors
+{
+	string Line;
+	
+	while ( not Stream.eof() ) {
+		Line = NextLine (&Stream);
+		
+		if (Read and Line.substr (0, 12) == "$COORDINATES") {
+			Worker->DC_Input.Coordinates.XYZ.clear();
+			Worker->DC_Input.Coordinates.Labels.clear();
+			Worker->DC_Input.Coordinates.Atoms.clear();
+			
+			if (Worker->ReadInputSection (&Stream, "$COORDINATES") != 0) {
+				ErrorFrame       = NextFrame;
+				DC->DC_Error     = Worker->DC_Error;
+				DC->DC_ErrorCode = Worker->DC_ErrorCode;
+				return -1;
+			}
+			
+			return 1;
+		}
+		
+		// all other blocks are skipped, the topology is taken from the input file, as well as
+		// the frames not selected
+		if (Line.substr (0, 1) == "$") {
+			while ( not Stream.eof() and NextLine (&Stream).substr (0, 4) != "$END" ) ;
+			
+			if (Line.substr (0, 12) == "$COORDINATES") return 1;
+		}
+	}
+	
+	return 0;
+} // of TrajectoryFrames::NextBlock
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::NextModel ( bool Read )
+// reads the ATOM and HETATM lines of the next model of a PDB file into Coord (if Read is true),
+// a file without MODEL lines is a single frame, returns 1 if a model was found and 0 if not
+{
+	string Line;
+	int Atoms = 0;
+	
+	if (Read) Coord.clear();
+	
+	while (getline (Stream, Line)) {
+		if (StartsWith (Line, "ATOM") or StartsWith (Line, "HETATM")) {
+			if (Read) {
+				if (Line.size() < 54) {
+					Fail (162, "Invalid frame", "Line without coordinates in " + FileName + ":\n       " + Line);
+					return -1;
+				}
+				
+				Coord.push_back (atof (Line.substr (30, 8).c_str()));
+				Coord.push_back (atof (Line.substr (38, 8).c_str()));
+				Coord.push_back (atof (Line.substr (46, 8).c_str()));
+			}
+			
+			++Atoms;
+			continue;
+		}
+		
+		// ENDMDL and END, or a MODEL line if ENDMDL is missing
+		if (Atoms > 0 and (StartsWith (Line, "END") or StartsWith (Line, "MODEL"))) return 1;
+	}
+	
+	return (Atoms > 0) ? 1 : 0;
+} // of TrajectoryFrames::NextModel
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::ReadDcdHeader ( void )
+// reads the header of a DCD file, the title is skipped
+{
+	int32_t Marker, Control[20], Length, Atoms;
+	char Magic[4];
+	off_t End;
+	
+	Dcd.Swap = false;
+	
+	if ( not ReadInt (Binary, false, &Marker) or (Marker != 84 and SwapBytes (Marker) != 84) or
+	     fread (Magic, 1, 4, Binary) != 4 or strncmp (Magic, "CORD", 4) != 0 )
+		return Fail (163, "Invalid DCD file", FileName + " is not a DCD file.");
+	
+	Dcd.Swap = (Marker != 84);
+	
+	for (int i = 0; i < 20; i++)
+		if ( not ReadInt (Binary, Dcd.Swap, &Control[i]) )
+			return Fail (163, "Invalid DCD file", "The header of " + FileName + " is incomplete.");
+	
+	// the number of fixed atoms, their coordinates are only in the first frame
+	if (Control[8] != 0)
+		return Fail (163, "Invalid DCD file", FileName + " has fixed atoms, which are not supported.");
+	
+	// the CHARMM version is 0 in X-PLOR files, which have no unit cell and fourth dimension
+	Dcd.UnitCell = (Control[19] != 0 and Control[10] != 0);
+	Dcd.FourDims = (Control[19] != 0 and Control[11] != 0);
+	
+	if ( not ReadInt (Binary, Dcd.Swap, &Marker) or not ReadInt (Binary, Dcd.Swap, &Length) or
+	     fseeko (Binary, Length + 4, SEEK_CUR) != 0 or
+	     not ReadInt (Binary, Dcd.Swap, &Marker) or Marker != 4 or
+	     not ReadInt (Binary, Dcd.Swap, &Atoms) or not ReadInt (Binary, Dcd.Swap, &Marker) )
+		return Fail (163, "Invalid DCD file", "The header of " + FileName + " is incomplete.");
+	
+	Dcd.Atoms = Atoms;
+	Dcd.Start = ftello (Binary);
+	Dcd.Size  = (Dcd.UnitCell ? 56 : 0) + (Dcd.FourDims ? 4 : 3) * (8 + 4 * (off_t) Atoms);
+	Dcd.Next  = 0;
+	
+	// the number of frames in the header is not always updated by the MD programs
+	fseeko (Binary, 0, SEEK_END);
+	End = ftello (Binary);
+	Dcd.Frames = (End - Dcd.Start) / Dcd.Size;
+	
+	return 0;
+} // of TrajectoryFrames::ReadDcdHeader
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::ReadDcdFrame ( void )
+// reads frame Dcd.Next of the DCD file into Coord
+{
+	int32_t Marker;
+	int Dim, Atom;
+	
+	Coord.resize (3 * Dcd.Atoms);
+	Buffer.resize (Dcd.Atoms);
+	
+	if (fseeko (Binary, Dcd.Start + Dcd.Next * Dcd.Size + (Dcd.UnitCell ? 56 : 0), SEEK_SET) != 0) {
+		Fail (163, "Invalid DCD file", "Frame " + tostring (NextFrame) + " of " + FileName + " could not be read.");
+		return -1;
+	}
+	
+	for (Dim = 0; Dim < 3; Dim++) {
+		if ( not ReadInt (Binary, Dcd.Swap, &Marker) or Marker != 4 * Dcd.Atoms or
+		     fread (&Buffer[0], sizeof (float), Dcd.Atoms, Binary) != (size_t) Dcd.Atoms or
+		     not ReadInt (Binary, Dcd.Swap, &Marker) ) {
+			Fail (163, "Invalid DCD file", "Frame " + tostring (NextFrame) + " of " + FileName + " could not be read.");
+			return -1;
+		}
+		
+		for (Atom = 0; Atom < Dcd.Atoms; Atom++) {
+			if (Dcd.Swap) {
+				int32_t* Value = (int32_t*) &Buffer[Atom];
+				*Value = SwapBytes (*Value);
+			}
+			
+			Coord[3 * Atom + Dim] = Buffer[Atom];
+		}
+	}
+	
+	++Dcd.Next;
+	
+	return 1;
+} // of TrajectoryFrames::ReadDcdFrame
+
+
+// ================================================================================
+
+
+int TrajectoryFrames::CopyFrame ( Dichro* Worker )
+// copies the atoms of the input file from Coord to the DC_Input of the worker
+{
+	Dichro::InputCoordinates* Topology = &DC->DC_Input.Coordinates;
+	Dichro::InputCoordinates* Frame    = &Worker->DC_Input.Coordinates;
+	vector<int>* Map = &DC->DC_FrameAtoms;
+	unsigned int Atoms = Coord.size() / 3;
+	unsigned int Atom;
+	int Source;
+	
+	if ( (Map->size() == 0 and Atoms != Topology->Number()) or
+	     (Map->size() > 0  and (unsigned int) *max_element (Map->begin(), Map->end()) >= Atoms) )
+		return Fail (162, "Invalid frame", "Frame " + tostring (NextFrame) + " in " + FileName + " has "
+		             + tostring (Atoms) + " atoms, which do not match the "
+		             + tostring (Topology->Number()) + " atoms of the input file.");
+	
+	// the atom numbers and labels are those of the input file
+	if (Frame->Number() != Topology->Number()) {
+		Frame->Atoms  = Topology->Atoms;
+		Frame->Labels = Topology->Labels;
+	}
+	
+	Frame->XYZ.resize (3 * Topology->Number());
+	
+	for (Atom = 0; Atom < Topology->Number(); Atom++) {
+		Source = (Map->size() > 0) ? Map->at(Atom) : Atom;
+		
+		Frame->XYZ[3 * Atom]     = Coord[3 * Source];
+		Frame->XYZ[3 * Atom + 1] = Coord[3 * Source + 1];
+		Frame->XYZ[3 * Atom + 2] = Coord[3 * Source + 2];
+	}
+	
+	return 0;
+} // of TrajectoryFrames::CopyFrame
+
+
+// ================================================================================
+
+
+int Dichro::TrajectoryFrame ( int Frame, string BaseName )
+// calculates the spectra of one frame, whose coordinates are in DC_Input.Coordinates, the data of
+// the previous frame is overwritten (the vectors are cleared and keep their memory)
+{
+	char Suffix[20];
+	
+	sprintf (Suffix, ".%05d", Frame);
+	DC_InFileBaseName = BaseName + Suffix;
+	
+	DC_Error     = "";
+	DC_ErrorCode = 0;
+	Warnings.clear();
+	
+	DC_System.Atoms.clear();
+	DC_System.Groups.clear();
+	
+	DC_Results.Groups.clear();
+	DC_Results.Trans.Energy.clear();
+	DC_Results.Trans.Wavelength.clear();
+	DC_Results.Trans.DipoleStrength.clear();
+	DC_Results.Trans.RotationalStrength.clear();
+	DC_Results.Trans.OscillatorStrength.clear();
+	DC_Results.Trans.GroupSequence.clear();
+	DC_Results.Trans.TransSequence.clear();
+	DC_Results.Trans.ParSetSequence.clear();
+	DC_Results.Trans.EDM.clear();
+	DC_Results.Trans.MDM.clear();
+	DC_Results.Trans.MDMconv.clear();
+	DC_Results.Trans.Reference.clear();
+	DC_Results.Trans.PolarizationVector.clear();
+	DC_Results.PolTensor.clear();
+	
+	Dichro::OpenOutputFiles (true);
+	
+	if (DC_Error == "" and DC_Options.CTSelect) { SelectChargeTransfer (); }
+	if (DC_Error == "") { CheckInputData ();     }
+	
+	Dichro::Calculation ();
+	Dichro::CloseOutputFiles (true);
+	
+	if (DC_Error == "" and DC_Options.Average) DC_Average.Add (&DC_Results.Spectra);
+	
+	return DC_ErrorCode;
+} // of Dichro::TrajectoryFrame
+
+
+// ================================================================================